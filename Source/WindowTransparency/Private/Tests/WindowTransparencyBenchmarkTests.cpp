@@ -0,0 +1,96 @@
+﻿// WindowTransparencyBenchmarkTests.cpp
+
+#include "Misc/AutomationTest.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Misc/Paths.h"
+#include "WindowTransparencyBenchmarks.h"
+
+#if WITH_DEV_AUTOMATION_TESTS && !UE_BUILD_SHIPPING
+
+namespace WindowTransparencyBenchmarkTests
+{
+    // 計測には時間がかかるので、通常のテストとは分けて Perf フィルタで実行する。-nullrhi のヘッドレス実行でも動く
+    constexpr EAutomationTestFlags TestFlags = EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter;
+
+    // コンポーネントを生成するケース用の一時的なゲームワールド
+    struct FBenchmarkWorld
+    {
+        UWorld* World = nullptr;
+
+        FBenchmarkWorld()
+        {
+            if (!GEngine)
+            {
+                return;
+            }
+            World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("WindowTransparencyBenchmarkWorld"));
+            FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+            WorldContext.SetCurrentWorld(World);
+            World->InitializeActorsForPlay(FURL());
+            World->BeginPlay();
+        }
+
+        ~FBenchmarkWorld()
+        {
+            if (World)
+            {
+                GEngine->DestroyWorldContext(World);
+                World->DestroyWorld(false);
+            }
+        }
+    };
+}
+
+using namespace WindowTransparencyBenchmarkTests;
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FWindowTransparencyPerfTest, "WindowTransparency.Perf", TestFlags)
+
+void FWindowTransparencyPerfTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+    for (const FString& CaseName : FWindowTransparencyBenchmarks::GetCaseNames())
+    {
+        OutBeautifiedNames.Add(CaseName);
+        OutTestCommands.Add(CaseName);
+    }
+}
+
+bool FWindowTransparencyPerfTest::RunTest(const FString& Parameters)
+{
+    TUniquePtr<FBenchmarkWorld> BenchmarkWorld;
+    if (FWindowTransparencyBenchmarks::NeedsWorld(Parameters))
+    {
+        BenchmarkWorld = MakeUnique<FBenchmarkWorld>();
+    }
+
+    TArray<FWindowBenchmarkResult> Results;
+    double Checksum = 0.0;
+    if (!FWindowTransparencyBenchmarks::RunCase(Parameters, FWindowTransparencyBenchmarks::DefaultIterations, BenchmarkWorld.IsValid() ? BenchmarkWorld->World : nullptr, Results, Checksum))
+    {
+        AddError(FString::Printf(TEXT("Could not run benchmark case %s."), *Parameters));
+        return false;
+    }
+
+    // 結果はケースごとのJSONに書き、wt.Bench.Run と同じベースラインより許容範囲を超えて遅ければ失敗にする
+    const FString OutputPath = FPaths::Combine(FWindowTransparencyBenchmarks::GetDefaultDirectory(), FString::Printf(TEXT("Perf-%s.json"), *Parameters));
+    FWindowTransparencyBenchmarks::SaveResults(Results, OutputPath);
+
+    TMap<FString, double> Baseline;
+    const FString BaselinePath = FWindowTransparencyBenchmarks::GetDefaultBaselinePath();
+    const bool bHasBaseline = FWindowTransparencyBenchmarks::LoadBaseline(BaselinePath, Baseline);
+    for (const FWindowBenchmarkResult& Result : Results)
+    {
+        AddInfo(FString::Printf(TEXT("%s: %.4f ms/iter, %.0f items/sec"), *Result.GetKey(), Result.MillisecondsPerIteration, Result.ItemsPerSecond));
+        AddTelemetryData(Result.GetKey(), Result.MillisecondsPerIteration, TEXT("ms_per_iteration"));
+
+        double DeltaPercent = 0.0;
+        if (bHasBaseline && FWindowTransparencyBenchmarks::GetBaselineDelta(Result, Baseline, DeltaPercent) && DeltaPercent > FWindowTransparencyBenchmarks::DefaultTolerancePercent)
+        {
+            AddError(FString::Printf(TEXT("%s is %.1f%% slower than %s (tolerance %.1f%%)."),
+                *Result.GetKey(), DeltaPercent, *BaselinePath, FWindowTransparencyBenchmarks::DefaultTolerancePercent));
+        }
+    }
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS && !UE_BUILD_SHIPPING
@@ -0,0 +1,459 @@
+﻿// WindowTransparencyHelperTests.cpp
+
+#include "Misc/AutomationTest.h"
+#include "Tests/AutomationCommon.h"
+#include "UObject/StrongObjectPtr.h"
+#include "WindowTransparencyHelper.h"
+#include "WindowTransparencyOSBackend.h"
+#include "WindowTransparencyOSTypes.h"
+#include "Engine/Engine.h"
+#include "Engine/GameViewportClient.h"
+#include "GameFramework/PlayerController.h"
+#include "Widgets/Layout/SBox.h"
+#include "Widgets/Layout/SBorder.h"
+#include "Engine/LocalPlayer.h"
+#include "SceneView.h"
+#include "SceneViewExtension.h"
+#include "WindowAutoFitExtension.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+using namespace WindowTransparencyOS;
+
+namespace WindowTransparencyHelperTests
+{
+    // 模擬バックエンドだけを使うので、-nullrhi のヘッドレス実行や Windows 以外の CI でも動く
+    constexpr EAutomationTestFlags TestFlags = EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter;
+
+    constexpr LONG_PTR OriginalStyle = WS_OVERLAPPEDWINDOW | WS_VISIBLE;
+    constexpr LONG_PTR OriginalExStyle = WS_EX_APPWINDOW;
+
+    struct FSimulatedHelper
+    {
+        TStrongObjectPtr<UWindowTransparencyHelper> Helper;
+        TSharedPtr<FWindowTransparencySimulatedBackend> Backend;
+
+        FSimulatedHelper()
+            : Helper(NewObject<UWindowTransparencyHelper>())
+            , Backend(MakeShared<FWindowTransparencySimulatedBackend>())
+        {
+            Helper->SetOSBackend(Backend);
+            Helper->Initialize();
+            Backend->ResetCallCounts();
+        }
+
+        const FWindowTransparencySimulatedBackend::FSimulatedWindow& GameWindow() const
+        {
+            return *Backend->FindSimulatedWindow(Backend->GetSimulatedGameWindow());
+        }
+
+        FWindowTransparencyOSCallCounts Calls() const { return Backend->GetCallCounts(); }
+    };
+
+    void TestStyle(FAutomationTestBase& Test, const TCHAR* What, LONG_PTR Actual, LONG_PTR Expected)
+    {
+        Test.TestEqual(What, static_cast<int64>(Actual), static_cast<int64>(Expected));
+    }
+
+    // WorkerW の探索はワーカーで行われ、結果はゲームスレッドに戻ってくるので、終わるまでフレームをまたいで待つ
+    void WaitForWorkerWDiscovery(FAutomationTestBase* Test, TSharedRef<FSimulatedHelper> Fixture, TFunction<void()> Then)
+    {
+        const double StartTime = FPlatformTime::Seconds();
+        ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([Test, Fixture, Then, StartTime]()
+        {
+            if (Fixture->Helper->IsWorkerWDiscoveryPending())
+            {
+                if (FPlatformTime::Seconds() - StartTime > 5.0)
+                {
+                    Test->AddError(TEXT("WorkerW discovery did not finish within 5 seconds."));
+                    return true;
+                }
+                return false;
+            }
+            Then();
+            return true;
+        }));
+    }
+}
+
+using namespace WindowTransparencyHelperTests;
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWindowTransparencyHelperTransparencyTest, "WindowTransparency.Helper.Transparency", TestFlags)
+
+bool FWindowTransparencyHelperTransparencyTest::RunTest(const FString& Parameters)
+{
+    FSimulatedHelper Fixture;
+    TestTrue(TEXT("Initialized on the simulated game window"), Fixture.Helper->IsInitialized());
+    TestTrue(TEXT("GameHWnd is the simulated game window"), Fixture.Helper->GetGameHWnd() == Fixture.Backend->GetSimulatedGameWindow());
+
+    Fixture.Helper->SetDWMTransparency(true);
+    TestEqual(TEXT("Frame extended over the whole client area"), Fixture.GameWindow().Frame.cxLeftWidth, -1);
+
+    // 同じ状態の再指定では OS を呼ばない
+    Fixture.Helper->SetDWMTransparency(true);
+    TestEqual(TEXT("ExtendFrame calls after a redundant enable"), Fixture.Calls().ExtendFrame, 1);
+
+    Fixture.Helper->SetDWMTransparency(false);
+    TestEqual(TEXT("Frame reset"), Fixture.GameWindow().Frame.cxLeftWidth, 0);
+    TestEqual(TEXT("ExtendFrame calls"), Fixture.Calls().ExtendFrame, 2);
+    TestEqual(TEXT("Repaint calls"), Fixture.Calls().Repaint, 2);
+    TestEqual(TEXT("Mutating calls"), Fixture.Calls().GetMutatingCallCount(), 4);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWindowTransparencyHelperClickThroughTest, "WindowTransparency.Helper.ClickThrough", TestFlags)
+
+bool FWindowTransparencyHelperClickThroughTest::RunTest(const FString& Parameters)
+{
+    FSimulatedHelper Fixture;
+
+    Fixture.Helper->EnableClickThrough(true);
+    TestStyle(*this, TEXT("ExStyle after enable"), Fixture.GameWindow().ExStyle, OriginalExStyle | WS_EX_LAYERED | WS_EX_TRANSPARENT);
+
+    Fixture.Helper->EnableClickThrough(true);
+    TestEqual(TEXT("SetStyle calls after a redundant enable"), Fixture.Calls().SetStyle, 1);
+
+    // DWM の透過が無効で元のスタイルに WS_EX_LAYERED がなければ、LAYERED も外す
+    Fixture.Helper->EnableClickThrough(false);
+    TestStyle(*this, TEXT("ExStyle after disable"), Fixture.GameWindow().ExStyle, OriginalExStyle);
+    TestEqual(TEXT("SetStyle calls"), Fixture.Calls().SetStyle, 2);
+    TestEqual(TEXT("SetPosition calls"), Fixture.Calls().SetPosition, 2);
+    TestEqual(TEXT("SetParent calls"), Fixture.Calls().SetParent, 0);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWindowTransparencyHelperTickTest, "WindowTransparency.Helper.Tick", TestFlags)
+
+bool FWindowTransparencyHelperTickTest::RunTest(const FString& Parameters)
+{
+    FSimulatedHelper Fixture;
+    // ワールドがないのでヒットテストは常に透明と判定される
+    AddExpectedError(TEXT("PlayerController not found"), EAutomationExpectedErrorFlags::Contains, 0);
+    Fixture.Helper->SetDWMTransparency(true);
+    Fixture.Helper->SetHitTestEnabled(true);
+    Fixture.Helper->SetHitTestType(EWindowHitTestType::GameRaycast);
+    Fixture.Backend->ResetCallCounts();
+
+    // カーソルもウィンドウ矩形もバックエンドから読む
+    Fixture.Backend->SetCursorScreenPosition(400, 300);
+    Fixture.Helper->Tick(1.0f / 60.0f);
+    bool bMousePosSuccess = false;
+    const FVector2D MousePosInWindow = Fixture.Helper->GetMousePositionInWindow(bMousePosSuccess);
+    TestTrue(TEXT("Cursor read through the backend"), bMousePosSuccess);
+    TestEqual(TEXT("Cursor X relative to the simulated window"), MousePosInWindow.X, 300.0);
+    TestEqual(TEXT("Cursor Y relative to the simulated window"), MousePosInWindow.Y, 200.0);
+    TestFalse(TEXT("Transparent without content under the cursor"), Fixture.Helper->IsMouseConsideredOverOpaqueArea());
+    TestStyle(*this, TEXT("ExStyle after the first tick"), Fixture.GameWindow().ExStyle, OriginalExStyle | WS_EX_LAYERED | WS_EX_TRANSPARENT);
+
+    // 判定が変わらない間は OS のスタイルに触れない
+    for (int32 TickIndex = 0; TickIndex < 4; ++TickIndex)
+    {
+        Fixture.Backend->SetCursorScreenPosition(400 + TickIndex * 50, 300);
+        Fixture.Helper->Tick(1.0f / 60.0f);
+    }
+    TestEqual(TEXT("SetStyle calls over five ticks"), Fixture.Calls().SetStyle, 1);
+    TestTrue(TEXT("Geometry queried on every tick"), Fixture.Calls().QueryGeometry >= 10);
+
+    // 透過を切ると、次の Tick でクリックスルーも外れる
+    Fixture.Helper->SetDWMTransparency(false);
+    Fixture.Helper->Tick(1.0f / 60.0f);
+    TestStyle(*this, TEXT("ExStyle after transparency is disabled"), Fixture.GameWindow().ExStyle, OriginalExStyle);
+    TestEqual(TEXT("SetStyle calls"), Fixture.Calls().SetStyle, 2);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWindowTransparencyHelperHitTestToggleTest, "WindowTransparency.Helper.HitTestToggle", TestFlags)
+
+bool FWindowTransparencyHelperHitTestToggleTest::RunTest(const FString& Parameters)
+{
+    FSimulatedHelper Fixture;
+    AddExpectedError(TEXT("PlayerController not found"), EAutomationExpectedErrorFlags::Contains, 0);
+    Fixture.Helper->SetDWMTransparency(true);
+    Fixture.Helper->SetHitTestType(EWindowHitTestType::GameRaycast);
+    Fixture.Backend->SetCursorScreenPosition(400, 300);
+
+    // ヒットテストが無効の間は Tick でクリックスルーにしない
+    Fixture.Helper->SetHitTestEnabled(false);
+    Fixture.Helper->Tick(1.0f / 60.0f);
+    TestTrue(TEXT("Opaque while hit testing is disabled"), Fixture.Helper->IsMouseConsideredOverOpaqueArea());
+    TestEqual(TEXT("SetStyle calls while disabled"), Fixture.Calls().SetStyle, 0);
+
+    Fixture.Helper->SetHitTestEnabled(true);
+    Fixture.Helper->Tick(1.0f / 60.0f);
+    TestStyle(*this, TEXT("ExStyle after enabling hit testing"), Fixture.GameWindow().ExStyle, OriginalExStyle | WS_EX_LAYERED | WS_EX_TRANSPARENT);
+
+    // 無効にするとその場で操作できる状態に戻る
+    Fixture.Helper->SetHitTestEnabled(false);
+    TestStyle(*this, TEXT("ExStyle right after disabling hit testing"), Fixture.GameWindow().ExStyle & WS_EX_TRANSPARENT, 0);
+    Fixture.Helper->Tick(1.0f / 60.0f);
+    TestStyle(*this, TEXT("ExStyle after a tick with hit testing disabled"), Fixture.GameWindow().ExStyle & WS_EX_TRANSPARENT, 0);
+
+    // None も同じく判定しない。再び有効な種類にすると次の Tick で判定が戻る
+    Fixture.Helper->SetHitTestEnabled(true);
+    Fixture.Helper->SetHitTestType(EWindowHitTestType::None);
+    Fixture.Helper->Tick(1.0f / 60.0f);
+    TestTrue(TEXT("Opaque with hit test type None"), Fixture.Helper->IsMouseConsideredOverOpaqueArea());
+    TestEqual(TEXT("SetStyle calls with hit test type None"), Fixture.Calls().SetStyle, 2);
+    Fixture.Helper->SetHitTestType(EWindowHitTestType::GameRaycast);
+    Fixture.Helper->Tick(1.0f / 60.0f);
+    TestStyle(*this, TEXT("ExStyle after switching back to GameRaycast"), Fixture.GameWindow().ExStyle, OriginalExStyle | WS_EX_LAYERED | WS_EX_TRANSPARENT);
+    TestEqual(TEXT("SetStyle calls"), Fixture.Calls().SetStyle, 3);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWindowTransparencyHelperInputThreadTest, "WindowTransparency.Helper.InputThread", TestFlags)
+
+bool FWindowTransparencyHelperInputThreadTest::RunTest(const FString& Parameters)
+{
+    if (!FPlatformProcess::SupportsMultithreading())
+    {
+        AddInfo(TEXT("Skipped: the input thread needs multithreading."));
+        return true;
+    }
+    FSimulatedHelper Fixture;
+    AddExpectedError(TEXT("PlayerController not found"), EAutomationExpectedErrorFlags::Contains, 0);
+    Fixture.Helper->SetDWMTransparency(true);
+    Fixture.Helper->SetHitTestEnabled(true);
+    Fixture.Helper->SetHitTestType(EWindowHitTestType::GameRaycast);
+    Fixture.Backend->SetCursorScreenPosition(400, 300);
+    Fixture.Helper->SetInputThreadEnabled(true, 1000.0f);
+    TestTrue(TEXT("Input thread runs on the simulated backend"), Fixture.Helper->IsInputThreadRunning());
+    Fixture.Backend->ResetCallCounts();
+
+    // Tick は判定材料を渡すだけ。その後ゲームスレッドは Tick もメッセージ処理もせずに待つ
+    Fixture.Helper->Tick(1.0f / 60.0f);
+    const HWND GameWindow = Fixture.Backend->GetSimulatedGameWindow();
+    const double StartTime = FPlatformTime::Seconds();
+    while ((Fixture.Backend->GetWindowStyle(GameWindow, GWL_EXSTYLE) & WS_EX_TRANSPARENT) == 0 && FPlatformTime::Seconds() - StartTime < 2.0)
+    {
+        FPlatformProcess::Sleep(0.001f);
+    }
+    TestStyle(*this, TEXT("ExStyle written by the input thread"), Fixture.Backend->GetWindowStyle(GameWindow, GWL_EXSTYLE), OriginalExStyle | WS_EX_LAYERED | WS_EX_TRANSPARENT);
+
+    // 次の Tick でゲームスレッドの状態が追いつくので、スレッドを止めてもスタイルを書き直さない
+    Fixture.Helper->Tick(1.0f / 60.0f);
+    Fixture.Helper->SetInputThreadEnabled(false);
+    Fixture.Helper->Tick(1.0f / 60.0f);
+    TestEqual(TEXT("SetStyle calls"), Fixture.Calls().SetStyle, 1);
+    const UINT AsyncFlags = SWP_NOSENDCHANGING | SWP_ASYNCWINDOWPOS;
+    TestTrue(TEXT("Frame change does not wait for the game thread"), (Fixture.GameWindow().LastPositionFlags & AsyncFlags) == AsyncFlags);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWindowTransparencyHelperWidgetHitCacheTest, "WindowTransparency.Helper.WidgetHitCache", TestFlags)
+
+bool FWindowTransparencyHelperWidgetHitCacheTest::RunTest(const FString& Parameters)
+{
+    // ウィジェットの配置はゲームビューポートに描画されて決まるので、ゲームとして起動したときだけ実行する
+    const TWeakObjectPtr<UGameViewportClient> GameViewport = GEngine ? GEngine->GameViewport : nullptr;
+    const TWeakObjectPtr<APlayerController> PC = GameViewport.IsValid() ? GEngine->GetFirstLocalPlayerController(GameViewport->GetWorld()) : nullptr;
+    if (!PC.IsValid())
+    {
+        AddInfo(TEXT("Skipped: needs a game viewport with a local player (run with -game)."));
+        return true;
+    }
+
+    const TStrongObjectPtr<UWindowTransparencyHelper> Helper(NewObject<UWindowTransparencyHelper>());
+    FVector2D ViewportSize;
+    GameViewport->GetViewportSize(ViewportSize);
+    const FVector2D ViewportCenter = ViewportSize * 0.5;
+    Helper->HitTestWidgetsUnderCursor(PC.Get(), ViewportCenter);
+    const int32 FirstRebuildCount = Helper->GetWidgetHitCacheRebuildCount();
+    TestEqual(TEXT("First hit test builds the cache"), FirstRebuildCount, 1);
+
+    // 最初のヒットテストの後にビューポート全体を覆うウィジェットを足す。キャッシュの無効化は呼ばない
+    const TSharedRef<SWidget> Blocker = SNew(SBox)[SNew(SBorder)];
+    GameViewport->AddViewportWidgetContent(Blocker, 1000);
+    const uint64 AddedFrame = GFrameCounter;
+
+    ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, Helper, GameViewport, PC, Blocker, ViewportCenter, FirstRebuildCount, AddedFrame]()
+    {
+        // 追加したウィジェットが描画されて配置が決まるまで待つ
+        if (GFrameCounter < AddedFrame + 2)
+        {
+            return false;
+        }
+        if (GameViewport.IsValid() && PC.IsValid())
+        {
+            TestTrue(TEXT("Added widget blocks the cursor"), Helper->HitTestWidgetsUnderCursor(PC.Get(), ViewportCenter));
+            TestTrue(TEXT("Cache rebuilt after the widget was added"), Helper->GetWidgetHitCacheRebuildCount() > FirstRebuildCount);
+            GameViewport->RemoveViewportWidgetContent(Blocker);
+        }
+        return true;
+    }));
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWindowTransparencyHelperAutoFitProjectionTest, "WindowTransparency.Helper.AutoFitProjection", TestFlags)
+
+bool FWindowTransparencyHelperAutoFitProjectionTest::RunTest(const FString& Parameters)
+{
+    // 投影はローカルプレイヤーのビューポートから作るので、ゲームとして起動したときだけ実行する
+    APlayerController* PC = GEngine && GEngine->GameViewport ? GEngine->GetFirstLocalPlayerController(GEngine->GameViewport->GetWorld()) : nullptr;
+    ULocalPlayer* LocalPlayer = PC ? PC->GetLocalPlayer() : nullptr;
+    FViewport* Viewport = LocalPlayer && LocalPlayer->ViewportClient ? LocalPlayer->ViewportClient->Viewport : nullptr;
+    if (!Viewport)
+    {
+        AddInfo(TEXT("Skipped: needs a game viewport with a local player (run with -game)."));
+        return true;
+    }
+
+    // 切り出しなしの投影で、画面中央に映る点を決める
+    TSharedRef<FWindowAutoFitExtension, ESPMode::ThreadSafe> Extension = FSceneViewExtensions::NewExtension<FWindowAutoFitExtension>();
+    const FIntRect HomeRect(FIntPoint::ZeroValue, Viewport->GetSizeXY());
+    Extension->SetCrop(Viewport, HomeRect, HomeRect);
+    FSceneViewProjectionData HomeProjection;
+    if (!TestTrue(TEXT("Projection before fitting"), LocalPlayer->GetProjectionData(Viewport, HomeProjection)))
+    {
+        return false;
+    }
+    const FIntRect HomeViewRect = HomeProjection.GetConstrainedViewRect();
+    const FVector2D HomeCenter = FVector2D(HomeViewRect.Min + HomeViewRect.Max) * 0.5;
+    FVector RayOrigin;
+    FVector RayDirection;
+    FSceneView::DeprojectScreenToWorld(HomeCenter, HomeViewRect, HomeProjection.ComputeViewProjectionMatrix().InverseFast(), RayOrigin, RayDirection);
+    const FVector KnownPoint = RayOrigin + RayDirection * 1000.0;
+
+    // ウィンドウを右下にずらしたのと同じ切り出し。点は同じスクリーン位置に残るので、ビューポート内では逆向きにずれる
+    const FIntPoint FitOffset(100, 50);
+    Extension->SetCrop(Viewport, HomeRect, FIntRect(HomeRect.Min + FitOffset, HomeRect.Max + FitOffset));
+    FSceneViewProjectionData FittedProjection;
+    if (!TestTrue(TEXT("Projection while fitted"), LocalPlayer->GetProjectionData(Viewport, FittedProjection)))
+    {
+        return false;
+    }
+    FVector2D FittedPos;
+    TestTrue(TEXT("Known point is in front of the camera"),
+        FSceneView::ProjectWorldToScreen(KnownPoint, FittedProjection.GetConstrainedViewRect(), FittedProjection.ComputeViewProjectionMatrix(), FittedPos));
+    // 切り出しが二重にかかると、ずれが倍になる
+    TestEqual(TEXT("Projected X is offset once"), FittedPos.X, HomeCenter.X - FitOffset.X, 0.5);
+    TestEqual(TEXT("Projected Y is offset once"), FittedPos.Y, HomeCenter.Y - FitOffset.Y, 0.5);
+    Extension->ClearCrop();
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWindowTransparencyHelperBorderlessTest, "WindowTransparency.Helper.Borderless", TestFlags)
+
+bool FWindowTransparencyHelperBorderlessTest::RunTest(const FString& Parameters)
+{
+    FSimulatedHelper Fixture;
+
+    Fixture.Helper->EnableBorderless(true);
+    TestStyle(*this, TEXT("Style after enable"), Fixture.GameWindow().Style, WS_POPUP | WS_VISIBLE);
+    Fixture.Helper->EnableBorderless(true);
+    TestEqual(TEXT("SetStyle calls after a redundant enable"), Fixture.Calls().SetStyle, 1);
+
+    Fixture.Helper->SetWindowTopmost(true);
+    TestTrue(TEXT("Topmost"), Fixture.GameWindow().bTopmost);
+
+    Fixture.Helper->RestoreDefaultWindowSettings();
+    TestStyle(*this, TEXT("Style after restore"), Fixture.GameWindow().Style, OriginalStyle);
+    TestStyle(*this, TEXT("ExStyle after restore"), Fixture.GameWindow().ExStyle, OriginalExStyle);
+    TestFalse(TEXT("Topmost cleared"), Fixture.GameWindow().bTopmost);
+    TestEqual(TEXT("SetStyle calls"), Fixture.Calls().SetStyle, 2);
+    TestEqual(TEXT("SetPosition calls"), Fixture.Calls().SetPosition, 4);
+    TestEqual(TEXT("Repaint calls"), Fixture.Calls().Repaint, 2);
+    TestEqual(TEXT("ExtendFrame calls"), Fixture.Calls().ExtendFrame, 0);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWindowTransparencyHelperDesktopBackgroundTest, "WindowTransparency.Helper.DesktopBackground", TestFlags)
+
+bool FWindowTransparencyHelperDesktopBackgroundTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FSimulatedHelper> Fixture = MakeShared<FSimulatedHelper>();
+
+    // キャッシュがないので最初の有効化は探索を始めて戻る。完了の通知は探索の後に届く
+    TSharedRef<TOptional<bool>> Completion = MakeShared<TOptional<bool>>();
+    Fixture->Helper->SetAsDesktopBackground(true, [Completion](bool bActive) { *Completion = bActive; });
+    TestTrue(TEXT("Discovery started"), Fixture->Helper->IsWorkerWDiscoveryPending());
+    TestFalse(TEXT("Not active before the WorkerW is found"), Fixture->Helper->IsDesktopBackgroundActive());
+    TestFalse(TEXT("Not completed before the WorkerW is found"), Completion->IsSet());
+
+    WaitForWorkerWDiscovery(this, Fixture, [this, Fixture, Completion]()
+    {
+        const HWND WorkerW = Fixture->Backend->GetSimulatedWorkerW();
+        const FWindowTransparencySimulatedBackend::FSimulatedWindow& Window = Fixture->GameWindow();
+        TestTrue(TEXT("Active after discovery"), Fixture->Helper->IsDesktopBackgroundActive());
+        TestTrue(TEXT("Completion reported active"), Completion->IsSet() && Completion->GetValue());
+        TestTrue(TEXT("Parented to the WorkerW"), Window.Parent == WorkerW);
+        TestStyle(*this, TEXT("Style while active"), Window.Style, (OriginalStyle & ~(WS_CAPTION | WS_THICKFRAME | WS_SYSMENU)) | WS_POPUP);
+        TestStyle(*this, TEXT("ExStyle while active"), Window.ExStyle, OriginalExStyle | WS_EX_LAYERED | WS_EX_TRANSPARENT);
+        TestEqual(TEXT("Covers the WorkerW client area"), Window.Rect.right - Window.Rect.left, 1920);
+        TestEqual(TEXT("FindWorkerW calls"), Fixture->Calls().FindWorkerW, 1);
+        TestEqual(TEXT("SetParent calls"), Fixture->Calls().SetParent, 1);
+
+        Fixture->Helper->SetAsDesktopBackground(false);
+        TestFalse(TEXT("Inactive after disable"), Fixture->Helper->IsDesktopBackgroundActive());
+        TestTrue(TEXT("Parent restored"), Fixture->GameWindow().Parent == nullptr);
+        TestStyle(*this, TEXT("Style restored"), Fixture->GameWindow().Style, OriginalStyle);
+        TestStyle(*this, TEXT("ExStyle restored"), Fixture->GameWindow().ExStyle, OriginalExStyle);
+        TestEqual(TEXT("SetParent calls after disable"), Fixture->Calls().SetParent, 2);
+
+        // 二回目はキャッシュした WorkerW を使い、その場で切り替わる
+        Fixture->Helper->SetAsDesktopBackground(true);
+        TestTrue(TEXT("Active without a second discovery"), Fixture->Helper->IsDesktopBackgroundActive());
+        TestFalse(TEXT("No discovery pending"), Fixture->Helper->IsWorkerWDiscoveryPending());
+        TestEqual(TEXT("FindWorkerW calls after re-enable"), Fixture->Calls().FindWorkerW, 1);
+        Fixture->Helper->SetAsDesktopBackground(false);
+        TestTrue(TEXT("Parent restored again"), Fixture->GameWindow().Parent == nullptr);
+        TestEqual(TEXT("SetParent calls"), Fixture->Calls().SetParent, 4);
+    });
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWindowTransparencyHelperSetParentFailureTest, "WindowTransparency.Helper.SetParentFailure", TestFlags)
+
+bool FWindowTransparencyHelperSetParentFailureTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FSimulatedHelper> Fixture = MakeShared<FSimulatedHelper>();
+    Fixture->Backend->SetFailSetParent(true);
+    AddExpectedError(TEXT("SetParent of GameHWnd"), EAutomationExpectedErrorFlags::Contains, 1);
+
+    Fixture->Helper->SetAsDesktopBackground(true);
+    WaitForWorkerWDiscovery(this, Fixture, [this, Fixture]()
+    {
+        const FWindowTransparencySimulatedBackend::FSimulatedWindow& Window = Fixture->GameWindow();
+        TestFalse(TEXT("Not active after a failed SetParent"), Fixture->Helper->IsDesktopBackgroundActive());
+        TestTrue(TEXT("Still top-level"), Window.Parent == nullptr);
+        TestStyle(*this, TEXT("Style rolled back"), Window.Style, OriginalStyle);
+        TestStyle(*this, TEXT("ExStyle rolled back"), Window.ExStyle, OriginalExStyle);
+        TestEqual(TEXT("Error reported through the backend"), static_cast<int64>(Fixture->Backend->GetLastErrorCode()), static_cast<int64>(ERROR_ACCESS_DENIED));
+        TestEqual(TEXT("SetParent calls"), Fixture->Calls().SetParent, 1);
+    });
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWindowTransparencyHelperSetOSBackendTest, "WindowTransparency.Helper.SetOSBackend", TestFlags)
+
+bool FWindowTransparencyHelperSetOSBackendTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FSimulatedHelper> Fixture = MakeShared<FSimulatedHelper>();
+    const TSharedPtr<FWindowTransparencySimulatedBackend> OldBackend = Fixture->Backend;
+
+    // 探索中に差し替えると、古いバックエンドの結果は捨てられ、新しいウィンドウは壁紙モードにならない
+    Fixture->Helper->SetDWMTransparency(true);
+    Fixture->Helper->SetAsDesktopBackground(true);
+    Fixture->Backend = MakeShared<FWindowTransparencySimulatedBackend>();
+    Fixture->Helper->SetOSBackend(Fixture->Backend);
+    TestFalse(TEXT("Not initialized after the backend changed"), Fixture->Helper->IsInitialized());
+    TestTrue(TEXT("GameHWnd follows the new backend"), Fixture->Helper->GetGameHWnd() == Fixture->Backend->GetSimulatedGameWindow());
+
+    WaitForWorkerWDiscovery(this, Fixture, [this, Fixture, OldBackend]()
+    {
+        TestFalse(TEXT("Stale discovery did not activate desktop background"), Fixture->Helper->IsDesktopBackgroundActive());
+        TestTrue(TEXT("Old window never reparented"), OldBackend->FindSimulatedWindow(OldBackend->GetSimulatedGameWindow())->Parent == nullptr);
+        TestEqual(TEXT("Old backend SetParent calls"), OldBackend->GetCallCounts().SetParent, 0);
+        TestEqual(TEXT("New backend untouched"), Fixture->Calls().GetMutatingCallCount(), 0);
+
+        // 新しいバックエンドで一からやり直せる
+        TestTrue(TEXT("Initialize on the new backend"), Fixture->Helper->Initialize());
+        Fixture->Helper->SetDWMTransparency(true);
+        TestEqual(TEXT("New window frame extended"), Fixture->GameWindow().Frame.cxLeftWidth, -1);
+        TestEqual(TEXT("New backend ExtendFrame calls"), Fixture->Calls().ExtendFrame, 1);
+        TestEqual(TEXT("Old backend ExtendFrame calls"), OldBackend->GetCallCounts().ExtendFrame, 1);
+    });
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,75 @@
+﻿// WindowAutoFitExtension.cpp
+#include "WindowAutoFitExtension.h"
+#include "SceneView.h"
+
+FWindowAutoFitExtension::FWindowAutoFitExtension(const FAutoRegister& AutoRegister)
+    : FSceneViewExtensionBase(AutoRegister)
+    , CropViewport(nullptr)
+    , bHasCrop(false)
+    , HomeScaleX(1.0)
+    , HomeScaleY(1.0)
+    , bHomeScaleCaptured(false)
+{
+}
+
+void FWindowAutoFitExtension::SetCrop(FViewport* InViewport, const FIntRect& InHomeRect, const FIntRect& InWindowRect)
+{
+    CropViewport = InViewport;
+    HomeRect = InHomeRect;
+    WindowRect = InWindowRect;
+    bHasCrop = InWindowRect != InHomeRect && InHomeRect.Width() > 0 && InHomeRect.Height() > 0;
+}
+
+void FWindowAutoFitExtension::ClearCrop()
+{
+    CropViewport = nullptr;
+    bHasCrop = false;
+}
+
+bool FWindowAutoFitExtension::IsActiveThisFrame_Internal(const FSceneViewExtensionContext& Context) const
+{
+    return CropViewport != nullptr && Context.Viewport == CropViewport;
+}
+
+void FWindowAutoFitExtension::SetupViewProjectionMatrix(FSceneViewProjectionData& InOutProjectionData)
+{
+    ApplyCrop(InOutProjectionData);
+}
+
+void FWindowAutoFitExtension::ApplyCrop(FSceneViewProjectionData& InOutProjectionData)
+{
+    FMatrix& Projection = InOutProjectionData.ProjectionMatrix;
+    if (!bHasCrop)
+    {
+        HomeScaleX = Projection.M[0][0];
+        HomeScaleY = Projection.M[1][1];
+        bHomeScaleCaptured = true;
+        return;
+    }
+    if (!bHomeScaleCaptured)
+    {
+        return;
+    }
+
+    // リサイズ直後はビューポートがまだ古いサイズのことがあるので、実際に描画する大きさで切り出す
+    const FIntPoint ViewSize = InOutProjectionData.GetViewRect().Size();
+    const double CropWidth = ViewSize.X > 0 ? ViewSize.X : WindowRect.Width();
+    const double CropHeight = ViewSize.Y > 0 ? ViewSize.Y : WindowRect.Height();
+    const double HalfHomeWidth = HomeRect.Width() * 0.5;
+    const double HalfHomeHeight = HomeRect.Height() * 0.5;
+
+    // 元の画面の NDC で見た切り出し範囲の中心（Y は上向き）と、その範囲を NDC 全体に広げる倍率
+    const double CenterX = (WindowRect.Min.X + CropWidth * 0.5 - HomeRect.Min.X - HalfHomeWidth) / HalfHomeWidth;
+    const double CenterY = -(WindowRect.Min.Y + CropHeight * 0.5 - HomeRect.Min.Y - HalfHomeHeight) / HalfHomeHeight;
+    const double ScaleX = HomeRect.Width() / CropWidth;
+    const double ScaleY = HomeRect.Height() / CropHeight;
+
+    // 元のサイズでの投影に戻してから、クリップ座標を x' = (x - cx * w) * sx のように変換する
+    Projection.M[0][0] = HomeScaleX;
+    Projection.M[1][1] = HomeScaleY;
+    for (int32 Row = 0; Row < 4; ++Row)
+    {
+        Projection.M[Row][0] = (Projection.M[Row][0] - CenterX * Projection.M[Row][3]) * ScaleX;
+        Projection.M[Row][1] = (Projection.M[Row][1] - CenterY * Projection.M[Row][3]) * ScaleY;
+    }
+}
@@ -0,0 +1,49 @@
+﻿// WindowAutoFitExtension.h
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SceneViewExtension.h"
+
+class FViewport;
+
+/**
+ * Keeps the scene where it was on screen while the game window is fitted to its content. The window shows a sub-rect of
+ * the rect it had before fitting, so the projection is scaled and shifted to render exactly that part of the original
+ * view. Game thread only.
+ */
+class FWindowAutoFitExtension : public FSceneViewExtensionBase
+{
+public:
+    FWindowAutoFitExtension(const FAutoRegister& AutoRegister);
+
+    /** HomeRect is the window rect before fitting and WindowRect the fitted one, both in screen pixels. */
+    void SetCrop(FViewport* InViewport, const FIntRect& InHomeRect, const FIntRect& InWindowRect);
+    void ClearCrop();
+    bool HasCrop() const { return bHasCrop; }
+
+    /**
+     * Applies the crop to projection data computed for the fitted viewport. While the window is not fitted the projection
+     * scale is recorded instead, so the crop keeps the field of view the camera had at the original size.
+     */
+    void ApplyCrop(FSceneViewProjectionData& InOutProjectionData);
+
+    // ISceneViewExtension
+    virtual void SetupViewFamily(FSceneViewFamily& InViewFamily) override {}
+    virtual void SetupView(FSceneViewFamily& InViewFamily, FSceneView& InView) override {}
+    virtual void BeginRenderViewFamily(FSceneViewFamily& InViewFamily) override {}
+    virtual void SetupViewProjectionMatrix(FSceneViewProjectionData& InOutProjectionData) override;
+
+protected:
+    virtual bool IsActiveThisFrame_Internal(const FSceneViewExtensionContext& Context) const override;
+
+private:
+    FViewport* CropViewport;
+    FIntRect HomeRect;
+    FIntRect WindowRect;
+    bool bHasCrop;
+
+    // フィット前の投影行列の X/Y スケール
+    double HomeScaleX;
+    double HomeScaleY;
+    bool bHomeScaleCaptured;
+};
@@ -0,0 +1,186 @@
+﻿// WindowClickThroughThread.cpp
+#include "WindowClickThroughThread.h"
+#include "WindowTransparencyOSTypes.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/ScopeLock.h"
+
+using namespace WindowTransparencyOS;
+
+DEFINE_LOG_CATEGORY_STATIC(LogWindowInputThread, Log, All);
+
+namespace
+{
+    bool IsInsideRect(const FBox2D& Rect, const FVector2D& Pos)
+    {
+        return Pos.X >= Rect.Min.X && Pos.X <= Rect.Max.X && Pos.Y >= Rect.Min.Y && Pos.Y <= Rect.Max.Y;
+    }
+}
+
+bool FWindowClickThroughCoverage::IsInCandidateRects(const FVector2D& Pos) const
+{
+    if (bCoversAll)
+    {
+        return true;
+    }
+    for (const FBox2D& Rect : CandidateRects)
+    {
+        if (IsInsideRect(Rect, Pos))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FWindowClickThroughCoverage::IsOpaqueAt(const FVector2D& Pos) const
+{
+    // ゲームスレッドが予測で先に不透明にしたなら、カーソルが候補矩形に入る前でも期限までは戻さない
+    if (PredictedOpaqueUntil >= 0.0 && FPlatformTime::Seconds() <= PredictedOpaqueUntil)
+    {
+        return true;
+    }
+
+    // 最前面のウィジェットがブロックするなら確実に不透明
+    for (int32 Index = WidgetRects.Num() - 1; Index >= 0; --Index)
+    {
+        if (IsInsideRect(WidgetRects[Index].Key, Pos))
+        {
+            if (WidgetRects[Index].Value)
+            {
+                return true;
+            }
+            break;
+        }
+    }
+
+    // 候補矩形の外なら確実に透明
+    if (!IsInCandidateRects(Pos))
+    {
+        return false;
+    }
+
+    // 候補矩形の中はゲームスレッドの判定を使う。判定時のカーソルが候補の外だった場合は古いので、次の判定までは不透明とみなす
+    return bGameVerdictInCandidates ? bGameVerdictOpaque : true;
+}
+
+FWindowClickThroughThread::FWindowClickThroughThread(const TSharedPtr<IWindowTransparencyOSBackend>& InBackend, float InRateHz, bool bInitialClickThrough)
+    : Thread(nullptr)
+    , WakeEvent(FPlatformProcess::GetSynchEventFromPool(false))
+    , Backend(InBackend)
+    , RateHz(FMath::Clamp(InRateHz, 1.0f, 1000.0f))
+    , bStopRequested(false)
+    , bClickThrough(bInitialClickThrough)
+    , AppliedSerial(0)
+    , IterationCount(0)
+    , ApplyCount(0)
+{
+    Thread = FRunnableThread::Create(this, TEXT("WindowTransparencyInput"), 0, TPri_AboveNormal);
+    if (!Thread)
+    {
+        UE_LOG(LogWindowInputThread, Warning, TEXT("Failed to create the click-through input thread."));
+    }
+}
+
+FWindowClickThroughThread::~FWindowClickThroughThread()
+{
+    if (Thread)
+    {
+        Thread->Kill(true);
+        delete Thread;
+        Thread = nullptr;
+    }
+    FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+    WakeEvent = nullptr;
+}
+
+void FWindowClickThroughThread::SetRate(float InRateHz)
+{
+    RateHz.store(FMath::Clamp(InRateHz, 1.0f, 1000.0f));
+}
+
+bool FWindowClickThroughThread::ConsumeAppliedSerial(uint32& InOutSerial) const
+{
+    const uint32 Serial = AppliedSerial.load();
+    if (Serial == InOutSerial)
+    {
+        return false;
+    }
+    InOutSerial = Serial;
+    return true;
+}
+
+void FWindowClickThroughThread::SyncClickThroughState(bool bInClickThrough)
+{
+    bClickThrough.store(bInClickThrough);
+}
+
+void FWindowClickThroughThread::PublishCoverage(const TSharedPtr<const FWindowClickThroughCoverage>& InCoverage)
+{
+    FScopeLock Lock(&CoverageLock);
+    Coverage = InCoverage;
+}
+
+uint32 FWindowClickThroughThread::Run()
+{
+    while (!bStopRequested.load())
+    {
+        const double StartTime = FPlatformTime::Seconds();
+        Step();
+        IterationCount.fetch_add(1);
+
+        const double RemainingMs = 1000.0 / RateHz.load() - (FPlatformTime::Seconds() - StartTime) * 1000.0;
+        WakeEvent->Wait(static_cast<uint32>(FMath::Max(1.0, RemainingMs)));
+    }
+    return 0;
+}
+
+void FWindowClickThroughThread::Stop()
+{
+    bStopRequested.store(true);
+    WakeEvent->Trigger();
+}
+
+void FWindowClickThroughThread::Step()
+{
+    TSharedPtr<const FWindowClickThroughCoverage> CurrentCoverage;
+    {
+        FScopeLock Lock(&CoverageLock);
+        CurrentCoverage = Coverage;
+    }
+    if (!CurrentCoverage.IsValid() || !CurrentCoverage->bActive || !Backend->IsValidWindow(CurrentCoverage->GameHWnd))
+    {
+        return;
+    }
+
+    POINT CursorPosScreen;
+    RECT WindowRect;
+    if (!Backend->GetCursorScreenPosition(CursorPosScreen) || !Backend->GetWindowScreenRect(CurrentCoverage->GameHWnd, WindowRect))
+    {
+        return;
+    }
+    const FVector2D MousePosInWindow(CursorPosScreen.x - WindowRect.left, CursorPosScreen.y - WindowRect.top);
+
+    const bool bShouldBeClickThrough = !CurrentCoverage->IsOpaqueAt(MousePosInWindow);
+    if (bShouldBeClickThrough == bClickThrough.load())
+    {
+        return;
+    }
+
+    const HWND GameHWnd = CurrentCoverage->GameHWnd;
+    const LONG_PTR CurrentExStyle = Backend->GetWindowStyle(GameHWnd, GWL_EXSTYLE);
+    // DWM 透過中にしか動かないので WS_EX_LAYERED は残す
+    const LONG_PTR NewExStyle = bShouldBeClickThrough ? (CurrentExStyle | WS_EX_LAYERED | WS_EX_TRANSPARENT) : (CurrentExStyle & ~WS_EX_TRANSPARENT);
+    if (NewExStyle != CurrentExStyle)
+    {
+        Backend->SetWindowStyle(GameHWnd, GWL_EXSTYLE, NewExStyle);
+        // 枠の再計算はゲームスレッドのメッセージ処理を待たずに非同期で反映する
+        Backend->SetWindowPosition(GameHWnd, nullptr, 0, 0, 0, 0,
+            SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE | SWP_FRAMECHANGED | SWP_NOSENDCHANGING | SWP_ASYNCWINDOWPOS);
+        ApplyCount.fetch_add(1);
+    }
+    bClickThrough.store(bShouldBeClickThrough);
+    // ゲームスレッドは番号が進んだのを見て自分の状態を合わせる
+    AppliedSerial.fetch_add(1);
+}
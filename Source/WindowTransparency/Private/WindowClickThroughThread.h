@@ -0,0 +1,99 @@
+﻿// WindowClickThroughThread.h
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/CriticalSection.h"
+#include "WindowTransparencyOSBackend.h"
+#include <atomic>
+
+class FRunnableThread;
+class FEvent;
+
+/**
+ * Snapshot of the hit-test state published by the game thread each frame. Coordinates are window-relative pixels, the same
+ * space as UWindowTransparencyHelper::GetMousePositionInWindow.
+ */
+struct FWindowClickThroughCoverage
+{
+    WindowTransparencyOS::HWND GameHWnd = nullptr;
+
+    /** If false, the input thread leaves the OS state alone. */
+    bool bActive = false;
+
+    /** If true, the candidate rects cannot bound the opaque area and only the game thread's verdict is used. */
+    bool bCoversAll = true;
+
+    /** Screen rects that may contain opaque content (3D bounds and UI). Outside of them the window is click-through. */
+    TArray<FBox2D> CandidateRects;
+
+    /** Cached widget rects in paint order. The topmost one under the cursor decides if it is blocking. */
+    TArray<TPair<FBox2D, bool>> WidgetRects;
+
+    /** Result of the last game-thread hit test and the cursor position it was made at. */
+    bool bGameVerdictOpaque = true;
+    bool bGameVerdictInCandidates = true;
+    FVector2D GameVerdictPos = FVector2D::ZeroVector;
+
+    /**
+     * FPlatformTime::Seconds until which the game thread's cursor prediction holds the window opaque (the predicted path
+     * enters content the cursor has not reached yet), or negative if there is no such prediction.
+     */
+    double PredictedOpaqueUntil = -1.0;
+
+    bool IsInCandidateRects(const FVector2D& Pos) const;
+    bool IsOpaqueAt(const FVector2D& Pos) const;
+};
+
+/**
+ * Decides and applies click-through at a fixed rate from its own thread, so the window changes as soon as the cursor crosses
+ * an edge instead of at the next hit test. It reads the coverage published by the game thread and writes only
+ * WS_EX_TRANSPARENT (and WS_EX_LAYERED) through the helper's backend, followed by a SetWindowPos with SWP_NOSENDCHANGING and
+ * SWP_ASYNCWINDOWPOS so the frame change does not wait for the game thread. Every write advances a serial the game thread
+ * checks each tick to sync its own copy of the state (see ConsumeAppliedSerial).
+ */
+class FWindowClickThroughThread : public FRunnable
+{
+public:
+    FWindowClickThroughThread(const TSharedPtr<IWindowTransparencyOSBackend>& InBackend, float InRateHz, bool bInitialClickThrough);
+    virtual ~FWindowClickThroughThread();
+
+    bool IsRunning() const { return Thread != nullptr; }
+    void SetRate(float InRateHz);
+    float GetRate() const { return RateHz.load(); }
+
+    void PublishCoverage(const TSharedPtr<const FWindowClickThroughCoverage>& Coverage);
+
+    /** Called on the game thread. True if the thread wrote the style since InOutSerial was last consumed, which is then updated. */
+    bool ConsumeAppliedSerial(uint32& InOutSerial) const;
+
+    /** Click-through state last applied by either thread. */
+    bool IsClickThrough() const { return bClickThrough.load(); }
+
+    /** Called by the game thread after every click-through style write of its own, so the thread decides against it. */
+    void SyncClickThroughState(bool bInClickThrough);
+
+    uint32 GetIterationCount() const { return IterationCount.load(); }
+    uint32 GetApplyCount() const { return ApplyCount.load(); }
+
+    // FRunnable
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    void Step();
+
+    FRunnableThread* Thread;
+    FEvent* WakeEvent;
+    TSharedPtr<IWindowTransparencyOSBackend> Backend;
+
+    FCriticalSection CoverageLock;
+    TSharedPtr<const FWindowClickThroughCoverage> Coverage;
+
+    std::atomic<float> RateHz;
+    std::atomic<bool> bStopRequested;
+    std::atomic<bool> bClickThrough;
+    std::atomic<uint32> AppliedSerial;
+    std::atomic<uint32> IterationCount;
+    std::atomic<uint32> ApplyCount;
+};
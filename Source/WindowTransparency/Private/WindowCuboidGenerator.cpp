@@ -0,0 +1,109 @@
+﻿// WindowCuboidGenerator.cpp
+#include "WindowCuboidGenerator.h"
+
+// 8頂点（0-3: 前面 TL,TR,BR,BL / 4-7: 背面）から各面の4頂点を取り出すテンプレート
+static constexpr int32 CuboidFaceCorners[FWindowCuboidGenerator::NumFaces][4] =
+{
+    { 0, 1, 2, 3 }, // Front
+    { 4, 7, 6, 5 }, // Back
+    { 0, 4, 5, 1 }, // Top Edge P1-P2
+    { 1, 5, 6, 2 }, // Right Edge P2-P3
+    { 2, 6, 7, 3 }, // Bottom Edge P3-P4
+    { 3, 7, 4, 0 }  // Left Edge P4-P1
+};
+
+static constexpr int32 QuadIndexTemplate[6] = { 0, 3, 2, 0, 2, 1 };
+
+static constexpr float QuadUVTemplate[4][2] = { { 0.f, 0.f }, { 1.f, 0.f }, { 1.f, 1.f }, { 0.f, 1.f } };
+
+void FWindowCuboidGenerator::Build(const FWindowPoints& Points, float CuboidThickness, bool bWithVertexColors, FWindowCuboidBuffers& OutBuffers)
+{
+    const FVector& P1_TL = Points.Point1_TL; // Top-Left
+    const FVector& P2_TR = Points.Point2_TR; // Top-Right
+    const FVector& P3_BR = Points.Point3_BR; // Bottom-Right
+    const FVector& P4_BL = Points.Point4_BL; // Bottom-Left
+
+    FVector SurfaceNormal = FVector::CrossProduct(P2_TR - P1_TL, P4_BL - P1_TL).GetSafeNormal();
+    if (SurfaceNormal.IsNearlyZero())
+    {
+        SurfaceNormal = FVector::CrossProduct(P3_BR - P2_TR, P1_TL - P2_TR).GetSafeNormal();
+        if (SurfaceNormal.IsNearlyZero()) {
+            UE_LOG(LogTemp, Warning, TEXT("Window points for '%s' are degenerate, cannot calculate normal reliably. Using UpVector as fallback."), *Points.WindowName.ToString());
+            SurfaceNormal = FVector::UpVector;
+        }
+    }
+
+    const FVector BackOffset = SurfaceNormal * CuboidThickness;
+    const FVector Corners[NumConvexVertices] =
+    {
+        P1_TL, P2_TR, P3_BR, P4_BL,
+        P1_TL - BackOffset, P2_TR - BackOffset, P3_BR - BackOffset, P4_BL - BackOffset
+    };
+
+    OutBuffers.Vertices.SetNumUninitialized(NumVertices);
+    OutBuffers.Normals.SetNumUninitialized(NumVertices);
+    OutBuffers.UVs0.SetNumUninitialized(NumVertices);
+    OutBuffers.Tangents.SetNumUninitialized(NumVertices);
+    OutBuffers.ConvexVertices.SetNumUninitialized(NumConvexVertices);
+
+    // インデックスはトポロジが固定なので、バッファを使い回す場合は書き直さない
+    if (OutBuffers.Triangles.Num() != NumIndices)
+    {
+        OutBuffers.Triangles.SetNumUninitialized(NumIndices);
+        for (int32 Face = 0; Face < NumFaces; ++Face)
+        {
+            for (int32 i = 0; i < 6; ++i)
+            {
+                OutBuffers.Triangles[Face * 6 + i] = Face * 4 + QuadIndexTemplate[i];
+            }
+        }
+    }
+
+    if (bWithVertexColors)
+    {
+        OutBuffers.VertexColors.Init(FLinearColor::White, NumVertices);
+    }
+    else
+    {
+        OutBuffers.VertexColors.Reset();
+    }
+
+    FVector* RESTRICT Vertices = OutBuffers.Vertices.GetData();
+    FVector* RESTRICT Normals = OutBuffers.Normals.GetData();
+    FVector2D* RESTRICT UVs = OutBuffers.UVs0.GetData();
+    FProcMeshTangent* RESTRICT Tangents = OutBuffers.Tangents.GetData();
+
+    for (int32 Face = 0; Face < NumFaces; ++Face)
+    {
+        const int32* FaceCorners = CuboidFaceCorners[Face];
+
+        // 法線・接線は面ごとに一度だけ求める
+        FVector FaceNormal;
+        if (Face == 0)
+        {
+            FaceNormal = SurfaceNormal;
+        }
+        else if (Face == 1)
+        {
+            FaceNormal = -SurfaceNormal;
+        }
+        else
+        {
+            const FVector& A = Corners[FaceCorners[0]];
+            FaceNormal = FVector::CrossProduct(Corners[FaceCorners[1]] - A, Corners[FaceCorners[3]] - A).GetSafeNormal();
+        }
+        const FVector CrossVec = (FMath::Abs(FaceNormal.Z) < (1.f - KINDA_SMALL_NUMBER)) ? FVector::UpVector : FVector::RightVector;
+        const FProcMeshTangent FaceTangent(FVector::CrossProduct(FaceNormal, CrossVec).GetSafeNormal(), false);
+
+        for (int32 Corner = 0; Corner < 4; ++Corner)
+        {
+            const int32 VertexIndex = Face * 4 + Corner;
+            Vertices[VertexIndex] = Corners[FaceCorners[Corner]];
+            Normals[VertexIndex] = FaceNormal;
+            UVs[VertexIndex] = FVector2D(QuadUVTemplate[Corner][0], QuadUVTemplate[Corner][1]);
+            Tangents[VertexIndex] = FaceTangent;
+        }
+    }
+
+    FMemory::Memcpy(OutBuffers.ConvexVertices.GetData(), Corners, sizeof(Corners));
+}
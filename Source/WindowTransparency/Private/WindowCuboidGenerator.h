@@ -0,0 +1,33 @@
+﻿// WindowCuboidGenerator.h
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProceduralMeshComponent.h"
+#include "WindowsRepresentationComponent.h"
+
+// 直方体1つ分のメッシュデータ。呼び出し側で保持して使い回すことで再確保を避ける
+struct FWindowCuboidBuffers
+{
+    TArray<FVector> Vertices;
+    TArray<int32> Triangles;
+    TArray<FVector> Normals;
+    TArray<FVector2D> UVs0;
+    TArray<FLinearColor> VertexColors;
+    TArray<FProcMeshTangent> Tangents;
+    TArray<FVector> ConvexVertices;
+};
+
+struct FWindowCuboidGenerator
+{
+    static constexpr int32 NumFaces = 6;
+    static constexpr int32 NumVertices = NumFaces * 4;
+    static constexpr int32 NumIndices = NumFaces * 6;
+    static constexpr int32 NumConvexVertices = 8;
+
+    /**
+     * Writes the 24 vertices / 36 indices of the cuboid spanned by the window quad and its thickness into OutBuffers.
+     * Buffers are resized in place, so reusing the same FWindowCuboidBuffers across calls does not allocate.
+     * Vertex colors are only written when bWithVertexColors is set; otherwise the array is left empty.
+     */
+    static void Build(const FWindowPoints& Points, float CuboidThickness, bool bWithVertexColors, FWindowCuboidBuffers& OutBuffers);
+};
@@ -0,0 +1,330 @@
+﻿// WindowHitTestBVH.cpp
+#include "WindowHitTestBVH.h"
+#include "Algo/Sort.h"
+
+namespace WindowHitTestBVH
+{
+    // 葉に入れる形状の最大数
+    constexpr int32 MaxLeafSize = 4;
+    // リフィットで木の表面積がこの倍率を超えたら作り直す
+    constexpr double RebuildSurfaceAreaRatio = 2.0;
+
+    static double BoxSurfaceArea(const FBox& Box)
+    {
+        if (!Box.IsValid)
+        {
+            return 0.0;
+        }
+        const FVector Size = Box.GetSize();
+        return 2.0 * (Size.X * Size.Y + Size.Y * Size.Z + Size.Z * Size.X);
+    }
+
+    static bool RayBoxSlab(const FVector& Origin, const FVector& InvDirection, const FVector& Min, const FVector& Max, double MaxDistance, double& OutEntry)
+    {
+        double Entry = 0.0;
+        double Exit = MaxDistance;
+        for (int32 Axis = 0; Axis < 3; ++Axis)
+        {
+            double T0 = (Min[Axis] - Origin[Axis]) * InvDirection[Axis];
+            double T1 = (Max[Axis] - Origin[Axis]) * InvDirection[Axis];
+            if (T0 > T1)
+            {
+                Swap(T0, T1);
+            }
+            Entry = FMath::Max(Entry, T0);
+            Exit = FMath::Min(Exit, T1);
+            if (Entry > Exit)
+            {
+                return false;
+            }
+        }
+        OutEntry = Entry;
+        return true;
+    }
+
+    static FVector SafeInverse(const FVector& Direction)
+    {
+        return FVector(
+            FMath::IsNearlyZero(Direction.X) ? BIG_NUMBER : 1.0 / Direction.X,
+            FMath::IsNearlyZero(Direction.Y) ? BIG_NUMBER : 1.0 / Direction.Y,
+            FMath::IsNearlyZero(Direction.Z) ? BIG_NUMBER : 1.0 / Direction.Z);
+    }
+}
+
+FBox FWindowHitTestProxy::CalcBounds() const
+{
+    switch (Shape)
+    {
+    case EWindowHitTestProxyShape::Box:
+        return FBox(-Extent, Extent).TransformBy(FTransform(Transform.GetRotation(), Transform.GetTranslation()));
+    case EWindowHitTestProxyShape::Capsule:
+    {
+        FBox Bounds(ForceInit);
+        Bounds += Start;
+        Bounds += End;
+        return Bounds.ExpandBy(Radius);
+    }
+    case EWindowHitTestProxyShape::Sphere:
+    default:
+        return FBox(Start - FVector(Radius), Start + FVector(Radius));
+    }
+}
+
+bool FWindowHitTestProxy::RayCast(const FVector& Origin, const FVector& Direction, double MaxDistance, double& OutDistance) const
+{
+    switch (Shape)
+    {
+    case EWindowHitTestProxyShape::Box:
+    {
+        // ボックスのローカル空間でスラブ判定する
+        const FTransform Unscaled(Transform.GetRotation(), Transform.GetTranslation());
+        const FVector LocalOrigin = Unscaled.InverseTransformPositionNoScale(Origin);
+        const FVector LocalDirection = Unscaled.InverseTransformVectorNoScale(Direction);
+        return WindowHitTestBVH::RayBoxSlab(LocalOrigin, WindowHitTestBVH::SafeInverse(LocalDirection), -Extent, Extent, MaxDistance, OutDistance);
+    }
+    case EWindowHitTestProxyShape::Capsule:
+    {
+        FVector PointOnRay;
+        FVector PointOnSegment;
+        FMath::SegmentDistToSegmentSafe(Origin, Origin + Direction * MaxDistance, Start, End, PointOnRay, PointOnSegment);
+        if (FVector::DistSquared(PointOnRay, PointOnSegment) > FMath::Square(Radius))
+        {
+            return false;
+        }
+        // 最接近点までの距離で近似する（最も近い形状を選ぶ用途には十分）
+        OutDistance = FVector::Dist(Origin, PointOnRay);
+        return true;
+    }
+    case EWindowHitTestProxyShape::Sphere:
+    default:
+    {
+        const FVector ToCenter = Start - Origin;
+        const double Projection = FVector::DotProduct(ToCenter, Direction);
+        const double DistSquaredToRay = ToCenter.SizeSquared() - FMath::Square(Projection);
+        const double RadiusSquared = FMath::Square(Radius);
+        if (DistSquaredToRay > RadiusSquared)
+        {
+            return false;
+        }
+        const double HalfChord = FMath::Sqrt(RadiusSquared - DistSquaredToRay);
+        double Distance = Projection - HalfChord;
+        if (Distance < 0.0)
+        {
+            Distance = Projection + HalfChord;
+        }
+        if (Distance < 0.0 || Distance > MaxDistance)
+        {
+            return false;
+        }
+        OutDistance = Distance;
+        return true;
+    }
+    }
+}
+
+FWindowHitTestBVH::FWindowHitTestBVH()
+    : BuiltSurfaceArea(0.0)
+    , bNeedsRebuild(false)
+    , bNeedsRefit(false)
+    , RebuildCount(0)
+    , RefitCount(0)
+{
+}
+
+int32 FWindowHitTestBVH::AddProxy(const FWindowHitTestProxy& Proxy)
+{
+    FProxyEntry Entry;
+    Entry.Proxy = Proxy;
+    Entry.Bounds = Proxy.CalcBounds();
+    bNeedsRebuild = true;
+    return Proxies.Add(MoveTemp(Entry));
+}
+
+void FWindowHitTestBVH::UpdateProxy(int32 ProxyId, const FWindowHitTestProxy& Proxy)
+{
+    if (!Proxies.IsValidIndex(ProxyId))
+    {
+        return;
+    }
+    FProxyEntry& Entry = Proxies[ProxyId];
+    Entry.Proxy = Proxy;
+    Entry.Bounds = Proxy.CalcBounds();
+    bNeedsRefit = true;
+}
+
+void FWindowHitTestBVH::RemoveProxy(int32 ProxyId)
+{
+    if (Proxies.IsValidIndex(ProxyId))
+    {
+        Proxies.RemoveAt(ProxyId);
+        bNeedsRebuild = true;
+    }
+}
+
+void FWindowHitTestBVH::Refresh()
+{
+    if (bNeedsRebuild)
+    {
+        Rebuild();
+    }
+    else if (bNeedsRefit)
+    {
+        Refit();
+        if (CalcTreeSurfaceArea() > BuiltSurfaceArea * WindowHitTestBVH::RebuildSurfaceAreaRatio)
+        {
+            Rebuild();
+        }
+    }
+}
+
+void FWindowHitTestBVH::Rebuild()
+{
+    LeafProxyIds.Reset(Proxies.Num());
+    for (auto It = Proxies.CreateConstIterator(); It; ++It)
+    {
+        LeafProxyIds.Add(It.GetIndex());
+    }
+
+    Nodes.Reset();
+    if (LeafProxyIds.Num() > 0)
+    {
+        Nodes.Reserve(LeafProxyIds.Num() * 2 / WindowHitTestBVH::MaxLeafSize + 1);
+        BuildNode(0, LeafProxyIds.Num());
+    }
+
+    BuiltSurfaceArea = CalcTreeSurfaceArea();
+    bNeedsRebuild = false;
+    bNeedsRefit = false;
+    ++RebuildCount;
+}
+
+int32 FWindowHitTestBVH::BuildNode(int32 FirstLeaf, int32 LeafCount)
+{
+    const int32 NodeIndex = Nodes.AddDefaulted();
+
+    FBox Bounds(ForceInit);
+    FBox CentroidBounds(ForceInit);
+    for (int32 Index = FirstLeaf; Index < FirstLeaf + LeafCount; ++Index)
+    {
+        const FBox& ProxyBounds = Proxies[LeafProxyIds[Index]].Bounds;
+        Bounds += ProxyBounds;
+        CentroidBounds += ProxyBounds.GetCenter();
+    }
+    Nodes[NodeIndex].Bounds = Bounds;
+
+    if (LeafCount <= WindowHitTestBVH::MaxLeafSize)
+    {
+        Nodes[NodeIndex].FirstLeaf = FirstLeaf;
+        Nodes[NodeIndex].LeafCount = LeafCount;
+        return NodeIndex;
+    }
+
+    // 重心の広がりが最大の軸で中央値分割する
+    const FVector Extent = CentroidBounds.GetSize();
+    const int32 Axis = Extent.X >= Extent.Y && Extent.X >= Extent.Z ? 0 : (Extent.Y >= Extent.Z ? 1 : 2);
+    TArrayView<int32> Range(LeafProxyIds.GetData() + FirstLeaf, LeafCount);
+    Algo::Sort(Range, [this, Axis](int32 A, int32 B)
+    {
+        return Proxies[A].Bounds.GetCenter()[Axis] < Proxies[B].Bounds.GetCenter()[Axis];
+    });
+
+    const int32 LeftCount = LeafCount / 2;
+    const int32 Left = BuildNode(FirstLeaf, LeftCount);
+    const int32 Right = BuildNode(FirstLeaf + LeftCount, LeafCount - LeftCount);
+    Nodes[NodeIndex].Left = Left;
+    Nodes[NodeIndex].Right = Right;
+    return NodeIndex;
+}
+
+void FWindowHitTestBVH::Refit()
+{
+    // 子ノードは必ず親より後ろにあるので、逆順に辿れば下から更新できる
+    for (int32 NodeIndex = Nodes.Num() - 1; NodeIndex >= 0; --NodeIndex)
+    {
+        FNode& Node = Nodes[NodeIndex];
+        if (Node.LeafCount > 0)
+        {
+            Node.Bounds = FBox(ForceInit);
+            for (int32 Index = Node.FirstLeaf; Index < Node.FirstLeaf + Node.LeafCount; ++Index)
+            {
+                Node.Bounds += Proxies[LeafProxyIds[Index]].Bounds;
+            }
+        }
+        else
+        {
+            Node.Bounds = Nodes[Node.Left].Bounds + Nodes[Node.Right].Bounds;
+        }
+    }
+    bNeedsRefit = false;
+    ++RefitCount;
+}
+
+double FWindowHitTestBVH::CalcTreeSurfaceArea() const
+{
+    double Total = 0.0;
+    for (const FNode& Node : Nodes)
+    {
+        Total += WindowHitTestBVH::BoxSurfaceArea(Node.Bounds);
+    }
+    return Total;
+}
+
+bool FWindowHitTestBVH::RayCast(const FVector& Origin, const FVector& Direction, double MaxDistance, FWindowHitTestBVHHit& OutHit) const
+{
+    if (Nodes.Num() == 0)
+    {
+        return false;
+    }
+
+    const FVector InvDirection = WindowHitTestBVH::SafeInverse(Direction);
+    double ClosestDistance = MaxDistance;
+    int32 ClosestProxyId = INDEX_NONE;
+
+    TArray<int32, TInlineAllocator<64>> NodeStack;
+    NodeStack.Add(0);
+    while (NodeStack.Num() > 0)
+    {
+        const FNode& Node = Nodes[NodeStack.Pop()];
+        double Entry;
+        if (!WindowHitTestBVH::RayBoxSlab(Origin, InvDirection, Node.Bounds.Min, Node.Bounds.Max, ClosestDistance, Entry))
+        {
+            continue;
+        }
+
+        if (Node.LeafCount > 0)
+        {
+            for (int32 Index = Node.FirstLeaf; Index < Node.FirstLeaf + Node.LeafCount; ++Index)
+            {
+                const int32 ProxyId = LeafProxyIds[Index];
+                double Distance;
+                if (Proxies[ProxyId].Proxy.RayCast(Origin, Direction, ClosestDistance, Distance))
+                {
+                    ClosestDistance = Distance;
+                    ClosestProxyId = ProxyId;
+                }
+            }
+        }
+        else
+        {
+            NodeStack.Add(Node.Left);
+            NodeStack.Add(Node.Right);
+        }
+    }
+
+    if (ClosestProxyId == INDEX_NONE)
+    {
+        return false;
+    }
+    OutHit.ProxyId = ClosestProxyId;
+    OutHit.Distance = ClosestDistance;
+    OutHit.Owner = Proxies[ClosestProxyId].Proxy.Owner;
+    return true;
+}
+
+void FWindowHitTestBVH::ForEachProxyBounds(TFunctionRef<void(const FBox&)> Visitor) const
+{
+    for (const FProxyEntry& Entry : Proxies)
+    {
+        Visitor(Entry.Bounds);
+    }
+}
@@ -0,0 +1,183 @@
+﻿// WindowHitTestStrategy.cpp
+#include "WindowHitTestStrategy.h"
+#include "WindowTransparency.h"
+#include "WindowTransparencyHelper.h"
+#include "Engine/Engine.h"
+#include "Engine/GameViewportClient.h"
+#include "UnrealClient.h"
+
+namespace WindowHitTestStrategy
+{
+    // 実測値で並べ替えるのに必要な評価回数
+    constexpr int32 MinMeasuredEvaluations = 32;
+    // 決着率がほぼ0の戦略でも無限大にならないようにする下限
+    constexpr double MinDecisiveRate = 0.05;
+}
+
+UWindowHitTestStrategy::UWindowHitTestStrategy()
+    : Cost(1.0f)
+    , Confidence(1.0f)
+{
+}
+
+EWindowHitTestVerdict UWindowHitTestStrategy::Evaluate_Implementation(APlayerController* PlayerController, FVector2D MousePosInWindow)
+{
+    return EWindowHitTestVerdict::Undecided;
+}
+
+FWindowHitTestStrategyStats UWindowHitTestStrategy::GetStats() const
+{
+    FWindowHitTestStrategyStats Result = Stats;
+    Result.StrategyName = GetClass()->GetDisplayNameText().ToString();
+    return Result;
+}
+
+void UWindowHitTestStrategy::RecordEvaluation(double Milliseconds, EWindowHitTestVerdict Verdict)
+{
+    ++Stats.Evaluations;
+    if (Verdict != EWindowHitTestVerdict::Undecided)
+    {
+        ++Stats.DecisiveCount;
+    }
+    if (Verdict == EWindowHitTestVerdict::Opaque)
+    {
+        ++Stats.OpaqueCount;
+    }
+    Stats.TotalMs += static_cast<float>(Milliseconds);
+    Stats.MeanMs = Stats.TotalMs / Stats.Evaluations;
+}
+
+void UWindowHitTestStrategy::ResetStats()
+{
+    Stats = FWindowHitTestStrategyStats();
+}
+
+double UWindowHitTestStrategy::GetOrderingCost(bool bUseMeasuredCost) const
+{
+    if (!bUseMeasuredCost || Stats.Evaluations < WindowHitTestStrategy::MinMeasuredEvaluations)
+    {
+        return Cost;
+    }
+    const double DecisiveRate = FMath::Max(static_cast<double>(Stats.DecisiveCount) / Stats.Evaluations, WindowHitTestStrategy::MinDecisiveRate);
+    return Stats.MeanMs / DecisiveRate;
+}
+
+UWindowTransparencyHelper* UWindowHitTestStrategy::GetHelper() const
+{
+    if (UWindowTransparencyHelper* OuterHelper = GetTypedOuter<UWindowTransparencyHelper>())
+    {
+        return OuterHelper;
+    }
+    return FWindowTransparencyModule::GetHelper();
+}
+
+// ---------------------------------------------------------------------------
+// Built-in strategies
+// ---------------------------------------------------------------------------
+
+UWindowHitTestStrategy_BroadPhase::UWindowHitTestStrategy_BroadPhase()
+{
+    Cost = 0.02f;
+}
+
+EWindowHitTestVerdict UWindowHitTestStrategy_BroadPhase::Evaluate_Implementation(APlayerController* PlayerController, FVector2D MousePosInWindow)
+{
+    UWindowTransparencyHelper* Helper = GetHelper();
+    if (!Helper || !PlayerController)
+    {
+        return EWindowHitTestVerdict::Undecided;
+    }
+    return Helper->IsCursorInHitTestBroadPhase(PlayerController, MousePosInWindow) ? EWindowHitTestVerdict::Undecided : EWindowHitTestVerdict::Transparent;
+}
+
+UWindowHitTestStrategy_WidgetRects::UWindowHitTestStrategy_WidgetRects()
+{
+    Cost = 0.01f;
+}
+
+EWindowHitTestVerdict UWindowHitTestStrategy_WidgetRects::Evaluate_Implementation(APlayerController* PlayerController, FVector2D MousePosInWindow)
+{
+    UWindowTransparencyHelper* Helper = GetHelper();
+    if (!Helper || !PlayerController)
+    {
+        return EWindowHitTestVerdict::Undecided;
+    }
+    return Helper->HitTestWidgetsUnderCursor(PlayerController, MousePosInWindow) ? EWindowHitTestVerdict::Opaque : EWindowHitTestVerdict::Undecided;
+}
+
+UWindowHitTestStrategy_PhysicsTrace::UWindowHitTestStrategy_PhysicsTrace()
+{
+    Cost = 0.1f;
+}
+
+EWindowHitTestVerdict UWindowHitTestStrategy_PhysicsTrace::Evaluate_Implementation(APlayerController* PlayerController, FVector2D MousePosInWindow)
+{
+    UWindowTransparencyHelper* Helper = GetHelper();
+    if (!Helper || !PlayerController)
+    {
+        return EWindowHitTestVerdict::Undecided;
+    }
+    return Helper->TraceUnderCursor(PlayerController, MousePosInWindow, false) ? EWindowHitTestVerdict::Opaque : EWindowHitTestVerdict::Undecided;
+}
+
+UWindowHitTestStrategy_RegisteredTargets::UWindowHitTestStrategy_RegisteredTargets()
+{
+    Cost = 0.02f;
+}
+
+EWindowHitTestVerdict UWindowHitTestStrategy_RegisteredTargets::Evaluate_Implementation(APlayerController* PlayerController, FVector2D MousePosInWindow)
+{
+    UWindowTransparencyHelper* Helper = GetHelper();
+    if (!Helper || !PlayerController)
+    {
+        return EWindowHitTestVerdict::Undecided;
+    }
+    return Helper->TraceUnderCursor(PlayerController, MousePosInWindow, true) ? EWindowHitTestVerdict::Opaque : EWindowHitTestVerdict::Undecided;
+}
+
+UWindowHitTestStrategy_StencilPick::UWindowHitTestStrategy_StencilPick()
+{
+    Cost = 0.01f;
+}
+
+EWindowHitTestVerdict UWindowHitTestStrategy_StencilPick::Evaluate_Implementation(APlayerController* PlayerController, FVector2D MousePosInWindow)
+{
+    UWindowTransparencyHelper* Helper = GetHelper();
+    FWindowStencilPickResult PickResult;
+    if (!Helper || !Helper->PickStencilUnderCursor(PlayerController, MousePosInWindow, PickResult))
+    {
+        return EWindowHitTestVerdict::Undecided;
+    }
+    return PickResult.bOpaque ? EWindowHitTestVerdict::Opaque : EWindowHitTestVerdict::Transparent;
+}
+
+UWindowHitTestStrategy_PixelAlpha::UWindowHitTestStrategy_PixelAlpha()
+    : AlphaThreshold(128)
+{
+    Cost = 0.01f;
+}
+
+EWindowHitTestVerdict UWindowHitTestStrategy_PixelAlpha::Evaluate_Implementation(APlayerController* PlayerController, FVector2D MousePosInWindow)
+{
+    FViewport* Viewport = (GEngine && GEngine->GameViewport) ? GEngine->GameViewport->Viewport : nullptr;
+    if (!Viewport)
+    {
+        return EWindowHitTestVerdict::Undecided;
+    }
+
+    const FIntPoint ViewportSize = Viewport->GetSizeXY();
+    const FIntPoint Pixel(FMath::FloorToInt32(MousePosInWindow.X), FMath::FloorToInt32(MousePosInWindow.Y));
+    if (Pixel.X < 0 || Pixel.Y < 0 || Pixel.X >= ViewportSize.X || Pixel.Y >= ViewportSize.Y)
+    {
+        return EWindowHitTestVerdict::Transparent;
+    }
+
+    // 1ピクセルを非同期に読み戻す。結果が届くまでは判定しない
+    UWindowTransparencyHelper* Helper = GetHelper();
+    uint8 Alpha = 0;
+    if (!Helper || !Helper->ProbePixelAlphaUnderCursor(PlayerController, MousePosInWindow, Alpha))
+    {
+        return EWindowHitTestVerdict::Undecided;
+    }
+    return Alpha >= AlphaThreshold ? EWindowHitTestVerdict::Opaque : EWindowHitTestVerdict::Transparent;
+}
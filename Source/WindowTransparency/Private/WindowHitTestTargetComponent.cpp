@@ -0,0 +1,212 @@
+﻿// WindowHitTestTargetComponent.cpp
+#include "WindowHitTestTargetComponent.h"
+#include "WindowHitTestBVH.h"
+#include "WindowTransparency.h"
+#include "WindowTransparencyHelper.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+UWindowHitTestTargetComponent::UWindowHitTestTargetComponent()
+    : Shape(EWindowHitTestTargetShape::Sphere)
+    , SphereRadius(50.0f)
+    , BoxExtent(50.0f, 50.0f, 50.0f)
+    , CapsuleRadius(30.0f)
+    , CapsuleHalfHeight(90.0f)
+    , BoneRadius(8.0f)
+    , bHitTestTargetEnabled(true)
+{
+    // ボーンはトランスフォーム更新なしで動くので、SkeletalBones のときだけ毎フレーム更新する
+    PrimaryComponentTick.bCanEverTick = true;
+    PrimaryComponentTick.bStartWithTickEnabled = false;
+    PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
+}
+
+void UWindowHitTestTargetComponent::OnRegister()
+{
+    Super::OnRegister();
+    RegisterProxies();
+}
+
+void UWindowHitTestTargetComponent::OnUnregister()
+{
+    UnregisterProxies();
+    Super::OnUnregister();
+}
+
+void UWindowHitTestTargetComponent::OnUpdateTransform(EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+    Super::OnUpdateTransform(UpdateTransformFlags, Teleport);
+    UpdateProxies();
+}
+
+void UWindowHitTestTargetComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+    UpdateProxies();
+}
+
+void UWindowHitTestTargetComponent::SetHitTestTargetEnabled(bool bEnable)
+{
+    if (bHitTestTargetEnabled != bEnable)
+    {
+        bHitTestTargetEnabled = bEnable;
+        RefreshHitTestShapes();
+    }
+}
+
+void UWindowHitTestTargetComponent::RefreshHitTestShapes()
+{
+    UnregisterProxies();
+    if (IsRegistered())
+    {
+        RegisterProxies();
+    }
+}
+
+void UWindowHitTestTargetComponent::RegisterProxies()
+{
+    UWorld* World = GetWorld();
+    if (!bHitTestTargetEnabled || !World || !World->IsGameWorld() || ProxyIds.Num() > 0)
+    {
+        return;
+    }
+
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (!Helper)
+    {
+        return;
+    }
+
+    TArray<FWindowHitTestProxy> Proxies;
+    BuildProxies(Proxies);
+    FWindowHitTestBVH& Targets = Helper->GetHitTestTargets();
+    for (const FWindowHitTestProxy& Proxy : Proxies)
+    {
+        ProxyIds.Add(Targets.AddProxy(Proxy));
+    }
+    RegisteredHelper = Helper;
+    SetComponentTickEnabled(Shape == EWindowHitTestTargetShape::SkeletalBones);
+}
+
+void UWindowHitTestTargetComponent::UnregisterProxies()
+{
+    if (UWindowTransparencyHelper* Helper = RegisteredHelper.Get())
+    {
+        FWindowHitTestBVH& Targets = Helper->GetHitTestTargets();
+        for (int32 ProxyId : ProxyIds)
+        {
+            Targets.RemoveProxy(ProxyId);
+        }
+    }
+    ProxyIds.Reset();
+    RegisteredHelper.Reset();
+    SetComponentTickEnabled(false);
+}
+
+void UWindowHitTestTargetComponent::UpdateProxies()
+{
+    UWindowTransparencyHelper* Helper = RegisteredHelper.Get();
+    if (!Helper || ProxyIds.Num() == 0)
+    {
+        return;
+    }
+
+    TArray<FWindowHitTestProxy> Proxies;
+    BuildProxies(Proxies);
+    if (Proxies.Num() != ProxyIds.Num())
+    {
+        // ボーン数が変わった（メッシュの差し替えなど）ときは登録し直す
+        RefreshHitTestShapes();
+        return;
+    }
+
+    FWindowHitTestBVH& Targets = Helper->GetHitTestTargets();
+    for (int32 Index = 0; Index < Proxies.Num(); ++Index)
+    {
+        Targets.UpdateProxy(ProxyIds[Index], Proxies[Index]);
+    }
+}
+
+USkinnedMeshComponent* UWindowHitTestTargetComponent::FindSkinnedMesh() const
+{
+    if (USkinnedMeshComponent* ParentMesh = Cast<USkinnedMeshComponent>(GetAttachParent()))
+    {
+        return ParentMesh;
+    }
+    const AActor* Owner = GetOwner();
+    return Owner ? Owner->FindComponentByClass<USkinnedMeshComponent>() : nullptr;
+}
+
+void UWindowHitTestTargetComponent::BuildProxies(TArray<FWindowHitTestProxy>& OutProxies) const
+{
+    const FTransform& WorldTransform = GetComponentTransform();
+    const FVector Scale = WorldTransform.GetScale3D().GetAbs();
+
+    FWindowHitTestProxy Proxy;
+    Proxy.Owner = const_cast<UWindowHitTestTargetComponent*>(this);
+
+    switch (Shape)
+    {
+    case EWindowHitTestTargetShape::Sphere:
+        Proxy.Shape = EWindowHitTestProxyShape::Sphere;
+        Proxy.Start = WorldTransform.GetLocation();
+        Proxy.Radius = SphereRadius * Scale.GetMax();
+        OutProxies.Add(Proxy);
+        break;
+
+    case EWindowHitTestTargetShape::Box:
+        Proxy.Shape = EWindowHitTestProxyShape::Box;
+        Proxy.Transform = WorldTransform;
+        Proxy.Extent = BoxExtent * Scale;
+        OutProxies.Add(Proxy);
+        break;
+
+    case EWindowHitTestTargetShape::Capsule:
+    {
+        const double Radius = CapsuleRadius * FMath::Max(Scale.X, Scale.Y);
+        const double SegmentHalfLength = FMath::Max(0.0, CapsuleHalfHeight * Scale.Z - Radius);
+        const FVector Axis = WorldTransform.GetUnitAxis(EAxis::Z);
+        Proxy.Shape = EWindowHitTestProxyShape::Capsule;
+        Proxy.Start = WorldTransform.GetLocation() - Axis * SegmentHalfLength;
+        Proxy.End = WorldTransform.GetLocation() + Axis * SegmentHalfLength;
+        Proxy.Radius = Radius;
+        OutProxies.Add(Proxy);
+        break;
+    }
+
+    case EWindowHitTestTargetShape::SkeletalBones:
+    {
+        USkinnedMeshComponent* SkinnedMesh = FindSkinnedMesh();
+        if (!SkinnedMesh)
+        {
+            break;
+        }
+
+        TArray<FName> Bones = BoneNames;
+        if (Bones.Num() == 0)
+        {
+            for (int32 BoneIndex = 0; BoneIndex < SkinnedMesh->GetNumBones(); ++BoneIndex)
+            {
+                Bones.Add(SkinnedMesh->GetBoneName(BoneIndex));
+            }
+        }
+
+        Proxy.Shape = EWindowHitTestProxyShape::Capsule;
+        Proxy.Radius = BoneRadius;
+        for (const FName& BoneName : Bones)
+        {
+            if (SkinnedMesh->GetBoneIndex(BoneName) == INDEX_NONE)
+            {
+                continue;
+            }
+            // 親ボーンがない（ルート）場合は長さ0のカプセル＝球になる
+            const FName ParentBone = SkinnedMesh->GetParentBone(BoneName);
+            Proxy.Start = SkinnedMesh->GetBoneLocation(BoneName);
+            Proxy.End = ParentBone.IsNone() ? Proxy.Start : SkinnedMesh->GetBoneLocation(ParentBone);
+            OutProxies.Add(Proxy);
+        }
+        break;
+    }
+    }
+}
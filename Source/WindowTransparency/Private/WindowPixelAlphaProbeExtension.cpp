@@ -0,0 +1,111 @@
+﻿// WindowPixelAlphaProbeExtension.cpp
+#include "WindowPixelAlphaProbeExtension.h"
+#include "SceneView.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "UnrealClient.h"
+#include "Math/Float16.h"
+#include "Misc/ScopeLock.h"
+
+FWindowPixelAlphaProbeExtension::FWindowPixelAlphaProbeExtension(const FAutoRegister& AutoRegister)
+    : FSceneViewExtensionBase(AutoRegister)
+    , Readbacks(TEXT("WindowPixelAlphaProbeReadback"))
+    , ProbeViewport(nullptr)
+    , ProbePosition(FIntPoint::ZeroValue)
+    , bEnabled(false)
+{
+}
+
+void FWindowPixelAlphaProbeExtension::SetProbeTarget(FViewport* InViewport, const FIntPoint& InProbePosition)
+{
+    FScopeLock ScopeLock(&Lock);
+    ProbeViewport = InViewport;
+    ProbePosition = InProbePosition;
+}
+
+FWindowPixelAlphaSample FWindowPixelAlphaProbeExtension::GetLatestSample() const
+{
+    FScopeLock ScopeLock(&Lock);
+    return LatestSample;
+}
+
+bool FWindowPixelAlphaProbeExtension::IsActiveThisFrame_Internal(const FSceneViewExtensionContext& Context) const
+{
+    if (!bEnabled.load())
+    {
+        return false;
+    }
+    FScopeLock ScopeLock(&Lock);
+    return ProbeViewport != nullptr && Context.Viewport == ProbeViewport;
+}
+
+void FWindowPixelAlphaProbeExtension::PostRenderViewFamily_RenderThread(FRDGBuilder& GraphBuilder, FSceneViewFamily& InViewFamily)
+{
+    PollReadbacks();
+
+    FIntPoint Position;
+    {
+        FScopeLock ScopeLock(&Lock);
+        Position = ProbePosition;
+    }
+
+    // ビューファミリーの出力先はビューポートのレンダーターゲットなので、ウィンドウ座標のピクセルをそのまま読む
+    FRHITexture* RenderTarget = InViewFamily.RenderTarget ? InViewFamily.RenderTarget->GetRenderTargetTexture().GetReference() : nullptr;
+    FRHIGPUTextureReadback* Readback = Readbacks.GetFreeReadback();
+    if (!RenderTarget || !Readback)
+    {
+        return;
+    }
+    const FIntPoint Size = RenderTarget->GetSizeXY();
+    if (Position.X < 0 || Position.Y < 0 || Position.X >= Size.X || Position.Y >= Size.Y)
+    {
+        return;
+    }
+
+    FRDGTextureRef SourceTexture = RegisterExternalTexture(GraphBuilder, RenderTarget, TEXT("WindowPixelAlphaProbeSource"));
+    AddEnqueueCopyPass(GraphBuilder, Readback, SourceTexture, FResolveRect(Position.X, Position.Y, Position.X + 1, Position.Y + 1));
+    Readbacks.Commit({ Position, RenderTarget->GetFormat() });
+}
+
+void FWindowPixelAlphaProbeExtension::PollReadbacks()
+{
+    // 古いものから順に、完了した読み出しだけを取り込む（待たない）
+    Readbacks.Poll([this](FRHIGPUTextureReadback& Readback, const FProbePayload& Payload)
+    {
+        int32 RowPitchInPixels = 0;
+        const uint8* Texel = static_cast<const uint8*>(Readback.Lock(RowPitchInPixels));
+        uint8 Alpha = 0;
+        const bool bDecoded = Texel && DecodeAlpha(Payload.Format, Texel, Alpha);
+        Readback.Unlock();
+        if (!bDecoded)
+        {
+            return;
+        }
+
+        FScopeLock ScopeLock(&Lock);
+        LatestSample.bValid = true;
+        LatestSample.Alpha = Alpha;
+        LatestSample.Position = Payload.Position;
+        LatestSample.Time = FPlatformTime::Seconds();
+    });
+}
+
+bool FWindowPixelAlphaProbeExtension::DecodeAlpha(EPixelFormat Format, const uint8* Texel, uint8& OutAlpha)
+{
+    switch (Format)
+    {
+    case PF_B8G8R8A8:
+    case PF_R8G8B8A8:
+        OutAlpha = Texel[3];
+        return true;
+    case PF_A2B10G10R10:
+        OutAlpha = static_cast<uint8>((*reinterpret_cast<const uint32*>(Texel) >> 30) * 85);
+        return true;
+    case PF_FloatRGBA:
+        OutAlpha = static_cast<uint8>(FMath::Clamp(reinterpret_cast<const FFloat16*>(Texel)[3].GetFloat(), 0.0f, 1.0f) * 255.0f + 0.5f);
+        return true;
+    default:
+        // バックバッファ以外の形式（HDR出力など）はアルファを持たないか解釈できない
+        return false;
+    }
+}
@@ -0,0 +1,64 @@
+﻿// WindowPixelAlphaProbeExtension.h
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SceneViewExtension.h"
+#include "HAL/CriticalSection.h"
+#include "WindowReadbackRing.h"
+#include <atomic>
+
+class FViewport;
+
+// 読み出しが完了したアルファ値と、その読み出し位置
+struct FWindowPixelAlphaSample
+{
+    bool bValid = false;
+    uint8 Alpha = 0;
+    FIntPoint Position = FIntPoint::ZeroValue;
+    double Time = 0.0;
+};
+
+/**
+ * Reads the alpha of one pixel of the game viewport's render target after the view family has rendered. Like
+ * FWindowStencilPickExtension the texel is copied into a readback that is polled without waiting, so the result lags the
+ * cursor by a few frames but never stalls the render thread.
+ */
+class FWindowPixelAlphaProbeExtension : public FSceneViewExtensionBase
+{
+public:
+    FWindowPixelAlphaProbeExtension(const FAutoRegister& AutoRegister);
+
+    // ゲームスレッドから呼ぶ
+    void SetEnabled(bool bInEnabled) { bEnabled.store(bInEnabled); }
+    bool IsEnabled() const { return bEnabled.load(); }
+    void SetProbeTarget(FViewport* InViewport, const FIntPoint& InProbePosition);
+    FWindowPixelAlphaSample GetLatestSample() const;
+
+    /** Reads the 8-bit alpha of one texel of a back buffer format. False for formats without a usable alpha. */
+    static bool DecodeAlpha(EPixelFormat Format, const uint8* Texel, uint8& OutAlpha);
+
+    // ISceneViewExtension
+    virtual void SetupViewFamily(FSceneViewFamily& InViewFamily) override {}
+    virtual void SetupView(FSceneViewFamily& InViewFamily, FSceneView& InView) override {}
+    virtual void BeginRenderViewFamily(FSceneViewFamily& InViewFamily) override {}
+    virtual void PostRenderViewFamily_RenderThread(FRDGBuilder& GraphBuilder, FSceneViewFamily& InViewFamily) override;
+
+protected:
+    virtual bool IsActiveThisFrame_Internal(const FSceneViewExtensionContext& Context) const override;
+
+private:
+    void PollReadbacks();
+
+    struct FProbePayload
+    {
+        FIntPoint Position = FIntPoint::ZeroValue;
+        EPixelFormat Format = PF_Unknown;
+    };
+    TWindowReadbackRing<FRHIGPUTextureReadback, FProbePayload> Readbacks;
+
+    mutable FCriticalSection Lock;
+    FViewport* ProbeViewport;
+    FIntPoint ProbePosition;
+    FWindowPixelAlphaSample LatestSample;
+    std::atomic<bool> bEnabled;
+};
@@ -0,0 +1,278 @@
+﻿// WindowRawInputThread.cpp
+#include "WindowRawInputThread.h"
+
+#if PLATFORM_WINDOWS
+
+#include "HAL/RunnableThread.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/ScopeLock.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogWindowRawInput, Log, All);
+
+namespace
+{
+    const TCHAR* RawInputWindowClassName = TEXT("WindowTransparencyRawInput");
+
+    // ゲームスレッドが止まっている間に溜まりすぎないようにする
+    constexpr int32 MaxPendingEvents = 256;
+
+    // 移動時のデスクトップ判定を使い回す時間
+    constexpr double DesktopCheckIntervalSeconds = 0.008;
+
+    constexpr int32 NumButtons = 5;
+    constexpr USHORT ButtonDownFlags[NumButtons] = { RI_MOUSE_LEFT_BUTTON_DOWN, RI_MOUSE_RIGHT_BUTTON_DOWN, RI_MOUSE_MIDDLE_BUTTON_DOWN, RI_MOUSE_BUTTON_4_DOWN, RI_MOUSE_BUTTON_5_DOWN };
+    constexpr USHORT ButtonUpFlags[NumButtons] = { RI_MOUSE_LEFT_BUTTON_UP, RI_MOUSE_RIGHT_BUTTON_UP, RI_MOUSE_MIDDLE_BUTTON_UP, RI_MOUSE_BUTTON_4_UP, RI_MOUSE_BUTTON_5_UP };
+}
+
+FWindowRawInputThread::FWindowRawInputThread(TFunction<void()> InOnEventsPending)
+    : Thread(nullptr)
+    , OnEventsPending(MoveTemp(InOnEventsPending))
+    , bBatchScheduled(false)
+    , DesktopPressedButtons(0)
+    , bCursorOverDesktop(false)
+    , LastDesktopCheckTime(0.0)
+    , MessageWindow(nullptr)
+    , bStopRequested(false)
+    , bFailed(false)
+    , ReceivedCount(0)
+    , QueuedCount(0)
+    , BatchCount(0)
+{
+    Thread = FRunnableThread::Create(this, TEXT("WindowTransparencyRawInput"), 0, TPri_AboveNormal);
+    if (!Thread)
+    {
+        UE_LOG(LogWindowRawInput, Warning, TEXT("Failed to create the raw input thread."));
+    }
+}
+
+FWindowRawInputThread::~FWindowRawInputThread()
+{
+    if (Thread)
+    {
+        Thread->Kill(true);
+        delete Thread;
+        Thread = nullptr;
+    }
+}
+
+void FWindowRawInputThread::DrainEvents(TArray<FWindowRawMouseEvent>& OutEvents)
+{
+    FScopeLock Lock(&EventLock);
+    OutEvents = MoveTemp(PendingEvents);
+    PendingEvents.Reset();
+    bBatchScheduled = false;
+}
+
+bool FWindowRawInputThread::IsDesktopAtScreenPosition(const POINT& ScreenPosition)
+{
+    // 壁紙の子ウィンドウは WS_EX_TRANSPARENT なので、デスクトップ上ならアイコンの ListView か WorkerW/Progman が返る
+    const HWND HitWindow = WindowFromPoint(ScreenPosition);
+    const HWND RootWindow = HitWindow ? GetAncestor(HitWindow, GA_ROOT) : nullptr;
+    if (!RootWindow)
+    {
+        return false;
+    }
+    WCHAR ClassName[32];
+    if (GetClassNameW(RootWindow, ClassName, UE_ARRAY_COUNT(ClassName)) == 0)
+    {
+        return false;
+    }
+    return FCString::Strcmp(ClassName, TEXT("Progman")) == 0 || FCString::Strcmp(ClassName, TEXT("WorkerW")) == 0;
+}
+
+uint32 FWindowRawInputThread::Run()
+{
+    // ウィンドウクラスはこのモジュールのものとして登録する。exe のインスタンスだとモジュールを入れ替えたときに古い WndProc が残る
+    HINSTANCE Instance = nullptr;
+    if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+        reinterpret_cast<LPCWSTR>(&FWindowRawInputThread::MessageWindowProc), &Instance))
+    {
+        UE_LOG(LogWindowRawInput, Warning, TEXT("Failed to get the module handle. Error: %d"), GetLastError());
+        bFailed.store(true);
+        return 1;
+    }
+
+    WNDCLASSEXW WindowClass = {};
+    WindowClass.cbSize = sizeof(WindowClass);
+    WindowClass.lpfnWndProc = &FWindowRawInputThread::MessageWindowProc;
+    WindowClass.hInstance = Instance;
+    WindowClass.lpszClassName = RawInputWindowClassName;
+    if (!RegisterClassExW(&WindowClass) && GetLastError() != ERROR_CLASS_ALREADY_EXISTS)
+    {
+        UE_LOG(LogWindowRawInput, Warning, TEXT("Failed to register the raw input window class. Error: %d"), GetLastError());
+        bFailed.store(true);
+        return 1;
+    }
+
+    // メッセージ専用ウィンドウなので、表示もフォーカスの移動もしない
+    const HWND Hwnd = CreateWindowExW(0, RawInputWindowClassName, TEXT(""), 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, Instance, nullptr);
+    if (!Hwnd)
+    {
+        UE_LOG(LogWindowRawInput, Warning, TEXT("Failed to create the raw input window. Error: %d"), GetLastError());
+        bFailed.store(true);
+        UnregisterClassW(RawInputWindowClassName, Instance);
+        return 1;
+    }
+    SetWindowLongPtrW(Hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+
+    // RIDEV_INPUTSINK: フォアグラウンドでなくても受け取る
+    RAWINPUTDEVICE Device;
+    Device.usUsagePage = 0x01; // HID_USAGE_PAGE_GENERIC
+    Device.usUsage = 0x02;     // HID_USAGE_GENERIC_MOUSE
+    Device.dwFlags = RIDEV_INPUTSINK;
+    Device.hwndTarget = Hwnd;
+    if (!RegisterRawInputDevices(&Device, 1, sizeof(Device)))
+    {
+        UE_LOG(LogWindowRawInput, Warning, TEXT("Failed to register for raw mouse input. Error: %d"), GetLastError());
+        bFailed.store(true);
+        DestroyWindow(Hwnd);
+        UnregisterClassW(RawInputWindowClassName, Instance);
+        return 1;
+    }
+
+    // 作成前に Stop されていた場合は、ここで気付いてループに入らない。作成後の Stop は WM_CLOSE で届く
+    MessageWindow.store(Hwnd);
+    if (!bStopRequested.load())
+    {
+        MSG Msg;
+        while (GetMessageW(&Msg, nullptr, 0, 0) > 0)
+        {
+            DispatchMessageW(&Msg);
+        }
+    }
+    MessageWindow.store(nullptr);
+
+    Device.dwFlags = RIDEV_REMOVE;
+    Device.hwndTarget = nullptr;
+    RegisterRawInputDevices(&Device, 1, sizeof(Device));
+    DestroyWindow(Hwnd);
+    // モジュールのアンロード後にクラスが残らないようにする
+    UnregisterClassW(RawInputWindowClassName, Instance);
+    return 0;
+}
+
+void FWindowRawInputThread::Stop()
+{
+    bStopRequested.store(true);
+    if (const HWND Hwnd = MessageWindow.load())
+    {
+        PostMessageW(Hwnd, WM_CLOSE, 0, 0);
+    }
+}
+
+LRESULT CALLBACK FWindowRawInputThread::MessageWindowProc(HWND Hwnd, UINT Msg, WPARAM WParam, LPARAM LParam)
+{
+    if (Msg == WM_INPUT)
+    {
+        if (FWindowRawInputThread* This = reinterpret_cast<FWindowRawInputThread*>(GetWindowLongPtrW(Hwnd, GWLP_USERDATA)))
+        {
+            This->HandleRawInput(reinterpret_cast<HRAWINPUT>(LParam));
+        }
+        // RIM_INPUT のときは DefWindowProc がバッファを解放する
+        return DefWindowProcW(Hwnd, Msg, WParam, LParam);
+    }
+    if (Msg == WM_CLOSE)
+    {
+        PostQuitMessage(0);
+        return 0;
+    }
+    return DefWindowProcW(Hwnd, Msg, WParam, LParam);
+}
+
+void FWindowRawInputThread::HandleRawInput(HRAWINPUT RawInputHandle)
+{
+    RAWINPUT RawInput;
+    UINT Size = sizeof(RawInput);
+    if (GetRawInputData(RawInputHandle, RID_INPUT, &RawInput, &Size, sizeof(RAWINPUTHEADER)) == static_cast<UINT>(-1) || RawInput.header.dwType != RIM_TYPEMOUSE)
+    {
+        return;
+    }
+    ReceivedCount.fetch_add(1);
+
+    // 生の移動量は加速やスケーリング前の値なので、位置は OS のカーソルから取る
+    FWindowRawMouseEvent Event;
+    if (!GetCursorPos(&Event.ScreenPosition))
+    {
+        return;
+    }
+    Event.Time = FPlatformTime::Seconds();
+
+    const RAWMOUSE& Mouse = RawInput.data.mouse;
+    const USHORT ButtonFlags = Mouse.usButtonFlags;
+    const bool bMoved = Mouse.lLastX != 0 || Mouse.lLastY != 0 || (Mouse.usFlags & MOUSE_MOVE_ABSOLUTE) != 0;
+    // 押下とホイールはその位置で判定し直す
+    const bool bPressed = (ButtonFlags & (RI_MOUSE_LEFT_BUTTON_DOWN | RI_MOUSE_RIGHT_BUTTON_DOWN | RI_MOUSE_MIDDLE_BUTTON_DOWN | RI_MOUSE_BUTTON_4_DOWN | RI_MOUSE_BUTTON_5_DOWN | RI_MOUSE_WHEEL)) != 0;
+    if (bPressed || Event.Time - LastDesktopCheckTime >= DesktopCheckIntervalSeconds)
+    {
+        bCursorOverDesktop = IsDesktopAtScreenPosition(Event.ScreenPosition);
+        LastDesktopCheckTime = Event.Time;
+    }
+
+    if (bMoved && bCursorOverDesktop)
+    {
+        Event.Type = FWindowRawMouseEvent::EType::Move;
+        QueueEvent(Event);
+    }
+
+    for (int32 Button = 0; Button < NumButtons; ++Button)
+    {
+        const uint8 ButtonBit = static_cast<uint8>(1 << Button);
+        if ((ButtonFlags & ButtonDownFlags[Button]) && bCursorOverDesktop)
+        {
+            DesktopPressedButtons |= ButtonBit;
+            Event.Type = FWindowRawMouseEvent::EType::ButtonDown;
+            Event.Button = Button;
+            QueueEvent(Event);
+        }
+        if ((ButtonFlags & ButtonUpFlags[Button]) && (DesktopPressedButtons & ButtonBit))
+        {
+            DesktopPressedButtons &= ~ButtonBit;
+            Event.Type = FWindowRawMouseEvent::EType::ButtonUp;
+            Event.Button = Button;
+            QueueEvent(Event);
+        }
+    }
+
+    if ((ButtonFlags & RI_MOUSE_WHEEL) && bCursorOverDesktop)
+    {
+        Event.Type = FWindowRawMouseEvent::EType::Wheel;
+        Event.Button = 0;
+        Event.WheelDelta = static_cast<float>(static_cast<SHORT>(Mouse.usButtonData)) / WHEEL_DELTA;
+        QueueEvent(Event);
+    }
+}
+
+void FWindowRawInputThread::QueueEvent(const FWindowRawMouseEvent& Event)
+{
+    bool bScheduleBatch = false;
+    {
+        FScopeLock Lock(&EventLock);
+        const bool bMergeMove = Event.Type == FWindowRawMouseEvent::EType::Move && PendingEvents.Num() > 0 && PendingEvents.Last().Type == FWindowRawMouseEvent::EType::Move;
+        if (bMergeMove)
+        {
+            PendingEvents.Last() = Event;
+        }
+        else
+        {
+            if (PendingEvents.Num() >= MaxPendingEvents)
+            {
+                PendingEvents.RemoveAt(0, 1, EAllowShrinking::No);
+            }
+            PendingEvents.Add(Event);
+        }
+        if (!bBatchScheduled)
+        {
+            bBatchScheduled = true;
+            bScheduleBatch = true;
+        }
+    }
+    QueuedCount.fetch_add(1);
+
+    if (bScheduleBatch && OnEventsPending)
+    {
+        BatchCount.fetch_add(1);
+        OnEventsPending();
+    }
+}
+
+#endif // PLATFORM_WINDOWS
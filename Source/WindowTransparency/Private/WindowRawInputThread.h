@@ -0,0 +1,100 @@
+﻿// WindowRawInputThread.h
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if PLATFORM_WINDOWS
+
+#include "HAL/Runnable.h"
+#include "HAL/CriticalSection.h"
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include <WinUser.h>
+#include "Windows/HideWindowsPlatformTypes.h"
+#include <atomic>
+
+class FRunnableThread;
+
+// 入力スレッドが受け取ったマウス入力（スクリーン座標）
+struct FWindowRawMouseEvent
+{
+    enum class EType : uint8
+    {
+        Move,
+        ButtonDown,
+        ButtonUp,
+        Wheel
+    };
+
+    EType Type = EType::Move;
+
+    /** 0 left, 1 right, 2 middle, 3 and 4 the thumb buttons. */
+    int32 Button = 0;
+
+    POINT ScreenPosition = { 0, 0 };
+
+    /** Wheel notches, positive away from the user. */
+    float WheelDelta = 0.0f;
+
+    double Time = 0.0;
+};
+
+/**
+ * Receives mouse input for the desktop background window, which never gets mouse messages of its own because it sits
+ * under WorkerW with WS_EX_TRANSPARENT. A message-only window on this thread registers for background raw mouse input,
+ * and the events are queued here. OnEventsPending is called from this thread once per batch, when the first event is
+ * queued after the last DrainEvents, so the game thread is only woken while the mouse is in use.
+ *
+ * Raw input registration is per process and per device type, so while this thread runs it replaces any other raw mouse
+ * registration in the process (the engine only uses one for captured high-precision mouse input).
+ */
+class FWindowRawInputThread : public FRunnable
+{
+public:
+    explicit FWindowRawInputThread(TFunction<void()> InOnEventsPending);
+    virtual ~FWindowRawInputThread();
+
+    /** False if the thread could not be created or failed to set up its window or raw input registration. */
+    bool IsRunning() const { return Thread != nullptr && !bFailed.load(); }
+
+    /** Moves the queued events into OutEvents. Consecutive moves are merged into the last one. */
+    void DrainEvents(TArray<FWindowRawMouseEvent>& OutEvents);
+
+    uint32 GetReceivedCount() const { return ReceivedCount.load(); }
+    uint32 GetQueuedCount() const { return QueuedCount.load(); }
+    uint32 GetBatchCount() const { return BatchCount.load(); }
+
+    /** True if the desktop (not another application's window) is under the screen position. */
+    static bool IsDesktopAtScreenPosition(const POINT& ScreenPosition);
+
+    // FRunnable
+    virtual uint32 Run() override;
+    virtual void Stop() override;
+
+private:
+    static LRESULT CALLBACK MessageWindowProc(HWND Hwnd, UINT Msg, WPARAM WParam, LPARAM LParam);
+    void HandleRawInput(HRAWINPUT RawInputHandle);
+    void QueueEvent(const FWindowRawMouseEvent& Event);
+
+    FRunnableThread* Thread;
+    TFunction<void()> OnEventsPending;
+
+    FCriticalSection EventLock;
+    TArray<FWindowRawMouseEvent> PendingEvents;
+    bool bBatchScheduled;
+
+    // 以下は入力スレッドだけが触る
+    // デスクトップ上で押されたボタン。離したときはデスクトップの外でも通知する
+    uint8 DesktopPressedButtons;
+    // 移動ごとの判定は重いので、前回の結果を短い間使い回す
+    bool bCursorOverDesktop;
+    double LastDesktopCheckTime;
+
+    std::atomic<HWND> MessageWindow;
+    std::atomic<bool> bStopRequested;
+    std::atomic<bool> bFailed;
+    std::atomic<uint32> ReceivedCount;
+    std::atomic<uint32> QueuedCount;
+    std::atomic<uint32> BatchCount;
+};
+
+#endif // PLATFORM_WINDOWS
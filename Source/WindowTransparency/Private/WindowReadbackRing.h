@@ -0,0 +1,73 @@
+﻿// WindowReadbackRing.h
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RHIGPUReadback.h"
+
+/**
+ * A few GPU readbacks used round-robin on the render thread. A copy is only enqueued into a slot whose previous readback
+ * has been consumed, and completed readbacks are consumed oldest first without waiting, so a pick never stalls the GPU.
+ * PayloadType is what the caller needs to interpret the result (the pick position, the source format, ...).
+ */
+template<typename ReadbackType, typename PayloadType>
+class TWindowReadbackRing
+{
+public:
+    static constexpr int32 NumReadbacks = 4;
+
+    explicit TWindowReadbackRing(const TCHAR* Name)
+        : NextReadback(0)
+    {
+        for (FSlot& Slot : Slots)
+        {
+            Slot.Readback = MakeUnique<ReadbackType>(Name);
+        }
+    }
+
+    /** The readback to copy into this frame, or nullptr while every slot is still in flight. */
+    ReadbackType* GetFreeReadback()
+    {
+        FSlot& Slot = Slots[NextReadback];
+        return Slot.bInFlight ? nullptr : Slot.Readback.Get();
+    }
+
+    /** Marks the readback returned by GetFreeReadback as in flight. */
+    void Commit(const PayloadType& Payload)
+    {
+        FSlot& Slot = Slots[NextReadback];
+        Slot.Payload = Payload;
+        Slot.bInFlight = true;
+        NextReadback = (NextReadback + 1) % NumReadbacks;
+    }
+
+    /** Calls OnReady(Readback, Payload) for every completed readback, oldest first. OnReady locks and unlocks the readback. */
+    template<typename FunctorType>
+    void Poll(FunctorType&& OnReady)
+    {
+        for (int32 Offset = 0; Offset < NumReadbacks; ++Offset)
+        {
+            FSlot& Slot = Slots[(NextReadback + Offset) % NumReadbacks];
+            if (!Slot.bInFlight)
+            {
+                continue;
+            }
+            // 新しい結果を古い結果で上書きしないよう、未完了のものがあればそこで止める
+            if (!Slot.Readback->IsReady())
+            {
+                break;
+            }
+            OnReady(*Slot.Readback, Slot.Payload);
+            Slot.bInFlight = false;
+        }
+    }
+
+private:
+    struct FSlot
+    {
+        TUniquePtr<ReadbackType> Readback;
+        PayloadType Payload = PayloadType();
+        bool bInFlight = false;
+    };
+    FSlot Slots[NumReadbacks];
+    int32 NextReadback;
+};
@@ -0,0 +1,104 @@
+﻿// WindowStencilPickExtension.cpp
+#include "WindowStencilPickExtension.h"
+#include "WindowStencilPickPass.h"
+#include "PostProcess/PostProcessMaterialInputs.h"
+#include "SceneTexturesConfig.h"
+#include "SceneView.h"
+#include "ScreenPass.h"
+#include "GlobalShader.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+#include "Misc/ScopeLock.h"
+
+FWindowStencilPickExtension::FWindowStencilPickExtension(const FAutoRegister& AutoRegister)
+    : FSceneViewExtensionBase(AutoRegister)
+    , Readbacks(TEXT("WindowStencilPickReadback"))
+    , PickViewport(nullptr)
+    , PickPosition(FIntPoint::ZeroValue)
+    , bEnabled(false)
+{
+}
+
+FWindowStencilPickExtension::~FWindowStencilPickExtension()
+{
+}
+
+void FWindowStencilPickExtension::SetPickTarget(FViewport* InViewport, const FIntPoint& InPickPosition)
+{
+    FScopeLock ScopeLock(&Lock);
+    PickViewport = InViewport;
+    PickPosition = InPickPosition;
+}
+
+FWindowStencilPickSample FWindowStencilPickExtension::GetLatestSample() const
+{
+    FScopeLock ScopeLock(&Lock);
+    return LatestSample;
+}
+
+bool FWindowStencilPickExtension::IsActiveThisFrame_Internal(const FSceneViewExtensionContext& Context) const
+{
+    if (!bEnabled.load())
+    {
+        return false;
+    }
+    FScopeLock ScopeLock(&Lock);
+    return PickViewport != nullptr && Context.Viewport == PickViewport;
+}
+
+void FWindowStencilPickExtension::SubscribeToPostProcessingPass(EPostProcessingPass Pass, const FSceneView& View, FAfterPassCallbackDelegateArray& InOutPassCallbacks, bool bIsPassEnabled)
+{
+    // アップスケール前（カスタムステンシルと同じ解像度）のパスに差し込む
+    if (Pass == EPostProcessingPass::SSRInput && View.bIsGameView)
+    {
+        InOutPassCallbacks.Add(FAfterPassCallbackDelegate::CreateRaw(this, &FWindowStencilPickExtension::PickAfterPass));
+    }
+}
+
+FScreenPassTexture FWindowStencilPickExtension::PickAfterPass(FRDGBuilder& GraphBuilder, const FSceneView& View, const FPostProcessMaterialInputs& Inputs)
+{
+    PollReadbacks();
+
+    FIntPoint Position;
+    {
+        FScopeLock ScopeLock(&Lock);
+        Position = PickPosition;
+    }
+
+    // ウィンドウ座標をレンダー解像度のビュー内座標に変換する
+    const FIntRect OutputRect = View.UnscaledViewRect;
+    const FScreenPassTextureSlice SceneColor = Inputs.GetInput(EPostProcessMaterialInput::SceneColor);
+    const FIntRect RenderRect = SceneColor.ViewRect;
+    FRDGTextureSRVRef CustomStencilTexture = Inputs.SceneTextures.SceneTextures ? Inputs.SceneTextures.SceneTextures->GetParameters()->CustomStencilTexture : nullptr;
+    FRHIGPUBufferReadback* Readback = Readbacks.GetFreeReadback();
+    if (CustomStencilTexture && Readback && OutputRect.Width() > 0 && OutputRect.Height() > 0 && OutputRect.Contains(Position))
+    {
+        const FIntPoint RenderPosition(
+            RenderRect.Min.X + FMath::Clamp(FMath::FloorToInt((Position.X - OutputRect.Min.X) * static_cast<double>(RenderRect.Width()) / OutputRect.Width()), 0, RenderRect.Width() - 1),
+            RenderRect.Min.Y + FMath::Clamp(FMath::FloorToInt((Position.Y - OutputRect.Min.Y) * static_cast<double>(RenderRect.Height()) / OutputRect.Height()), 0, RenderRect.Height() - 1));
+
+        FRDGBufferRef StencilBuffer = GraphBuilder.CreateBuffer(FRDGBufferDesc::CreateBufferDesc(sizeof(uint32), 1), TEXT("WindowStencilPick"));
+        AddWindowStencilPickPass(GraphBuilder, GetGlobalShaderMap(View.GetFeatureLevel()), CustomStencilTexture, RenderPosition, StencilBuffer);
+        AddEnqueueCopyPass(GraphBuilder, Readback, StencilBuffer, sizeof(uint32));
+        Readbacks.Commit(Position);
+    }
+
+    return Inputs.ReturnUntouchedSceneColorForPostProcessing(GraphBuilder);
+}
+
+void FWindowStencilPickExtension::PollReadbacks()
+{
+    // 古いものから順に、完了した読み出しだけを取り込む（待たない）
+    Readbacks.Poll([this](FRHIGPUBufferReadback& Readback, const FIntPoint& Position)
+    {
+        const uint32* Data = static_cast<const uint32*>(Readback.Lock(sizeof(uint32)));
+        const uint32 StencilValue = Data ? *Data : 0;
+        Readback.Unlock();
+
+        FScopeLock ScopeLock(&Lock);
+        LatestSample.bValid = true;
+        LatestSample.StencilValue = StencilValue;
+        LatestSample.Position = Position;
+        LatestSample.Time = FPlatformTime::Seconds();
+    });
+}
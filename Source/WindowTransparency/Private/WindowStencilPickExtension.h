@@ -0,0 +1,61 @@
+﻿// WindowStencilPickExtension.h
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SceneViewExtension.h"
+#include "HAL/CriticalSection.h"
+#include "WindowReadbackRing.h"
+#include <atomic>
+
+class FViewport;
+struct FPostProcessMaterialInputs;
+struct FScreenPassTexture;
+
+// 読み出しが完了したステンシル値と、その読み出し位置
+struct FWindowStencilPickSample
+{
+    bool bValid = false;
+    uint32 StencilValue = 0;
+    FIntPoint Position = FIntPoint::ZeroValue;
+    double Time = 0.0;
+};
+
+/**
+ * Reads the CustomStencil value under a pick position of the game viewport. Each frame a one-texel compute pass writes
+ * the value into a small buffer that is read back asynchronously, so the result lags the cursor by a few frames but never
+ * stalls the render thread.
+ */
+class FWindowStencilPickExtension : public FSceneViewExtensionBase
+{
+public:
+    FWindowStencilPickExtension(const FAutoRegister& AutoRegister);
+    virtual ~FWindowStencilPickExtension();
+
+    // ゲームスレッドから呼ぶ
+    void SetEnabled(bool bInEnabled) { bEnabled.store(bInEnabled); }
+    bool IsEnabled() const { return bEnabled.load(); }
+    void SetPickTarget(FViewport* InViewport, const FIntPoint& InPickPosition);
+    FWindowStencilPickSample GetLatestSample() const;
+
+    // ISceneViewExtension
+    virtual void SetupViewFamily(FSceneViewFamily& InViewFamily) override {}
+    virtual void SetupView(FSceneViewFamily& InViewFamily, FSceneView& InView) override {}
+    virtual void BeginRenderViewFamily(FSceneViewFamily& InViewFamily) override {}
+    virtual void SubscribeToPostProcessingPass(EPostProcessingPass Pass, const FSceneView& View, FAfterPassCallbackDelegateArray& InOutPassCallbacks, bool bIsPassEnabled) override;
+
+protected:
+    virtual bool IsActiveThisFrame_Internal(const FSceneViewExtensionContext& Context) const override;
+
+private:
+    FScreenPassTexture PickAfterPass(FRDGBuilder& GraphBuilder, const FSceneView& View, const FPostProcessMaterialInputs& Inputs);
+    void PollReadbacks();
+
+    // ペイロードは読み出し位置
+    TWindowReadbackRing<FRHIGPUBufferReadback, FIntPoint> Readbacks;
+
+    mutable FCriticalSection Lock;
+    FViewport* PickViewport;
+    FIntPoint PickPosition;
+    FWindowStencilPickSample LatestSample;
+    std::atomic<bool> bEnabled;
+};
@@ -1,10 +1,28 @@
 ﻿#include "WindowTransparency.h"
 #include "WindowTransparencyHelper.h"
+#include "WindowTransparencyStats.h"
 #include "CoreGlobals.h"
 #include "Engine/Engine.h"
 
 DEFINE_LOG_CATEGORY_STATIC(LogWindowTransparency, Log, All);
 
+DEFINE_STAT(STAT_WindowTransparency_HelperTick);
+DEFINE_STAT(STAT_WindowTransparency_HitTest3D);
+DEFINE_STAT(STAT_WindowTransparency_HitTestWidget);
+DEFINE_STAT(STAT_WindowTransparency_HitTestBroadPhase);
+DEFINE_STAT(STAT_WindowTransparency_EnumerateWindows);
+DEFINE_STAT(STAT_WindowTransparency_RegenerateMesh);
+DEFINE_STAT(STAT_WindowTransparency_BuildMeshes);
+DEFINE_STAT(STAT_WindowTransparency_ApplyMeshes);
+DEFINE_STAT(STAT_WindowTransparency_StyleChanges);
+DEFINE_STAT(STAT_WindowTransparency_SetWindowPosCalls);
+DEFINE_STAT(STAT_WindowTransparency_WindowsEnumerated);
+DEFINE_STAT(STAT_WindowTransparency_SectionsRebuilt);
+DEFINE_STAT(STAT_WindowTransparency_HitTestKernelTraces);
+DEFINE_STAT(STAT_WindowTransparency_HitTestBroadPhaseRejects);
+
+CSV_DEFINE_CATEGORY_MODULE(WINDOWTRANSPARENCY_API, WindowTransparency, true);
+
 #define LOCTEXT_NAMESPACE "FWindowTransparencyModule"
 
 void FWindowTransparencyModule::StartupModule()
@@ -44,6 +62,7 @@ void FWindowTransparencyModule::ShutdownModule()
     if (IsValid(HelperInstance))
     {
 #if PLATFORM_WINDOWS
+        HelperInstance->DumpClickThroughStats();
         UE_LOG(LogWindowTransparency, Log, TEXT("HelperInstance is valid, attempting to restore settings."));
         HelperInstance->RestoreDefaultWindowSettings();
 #endif
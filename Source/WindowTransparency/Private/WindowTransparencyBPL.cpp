@@ -3,9 +3,59 @@
 #include "WindowTransparencyBPL.h"
 #include "WindowTransparency.h" // For FWindowTransparencyModule
 #include "WindowTransparencyHelper.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Engine/LatentActionManager.h"
+#include "LatentActions.h"
 
 DEFINE_LOG_CATEGORY_STATIC(LogWindowBPL, Log, All);
 
+// デスクトップ背景モードの切り替えが終わるまで待つ
+class FWindowDesktopBackgroundLatentAction : public FPendingLatentAction
+{
+public:
+    FWindowDesktopBackgroundLatentAction(const FLatentActionInfo& LatentInfo, bool& InIsActive, UWindowTransparencyHelper* InHelper)
+        : ExecutionFunction(LatentInfo.ExecutionFunction)
+        , OutputLink(LatentInfo.Linkage)
+        , CallbackTarget(LatentInfo.CallbackTarget)
+        , IsActive(InIsActive)
+        , Helper(InHelper)
+        , Result(MakeShared<TOptional<bool>>())
+    {
+    }
+
+    TFunction<void(bool)> MakeCompletionCallback() const
+    {
+        TSharedRef<TOptional<bool>> SharedResult = Result;
+        return [SharedResult](bool bActive) { *SharedResult = bActive; };
+    }
+
+    /** Finishes right away, for when there is nothing to wait for. */
+    void Complete(bool bActive) { *Result = bActive; }
+
+    virtual void UpdateOperation(FLatentResponse& Response) override
+    {
+        // ヘルパーが先に破棄されたらコールバックは呼ばれないので、その時点の状態で終える
+        if (!Result->IsSet() && !Helper.IsValid())
+        {
+            *Result = false;
+        }
+        if (Result->IsSet())
+        {
+            IsActive = Result->GetValue();
+        }
+        Response.FinishAndTriggerIf(Result->IsSet(), ExecutionFunction, OutputLink, CallbackTarget);
+    }
+
+private:
+    FName ExecutionFunction;
+    int32 OutputLink;
+    FWeakObjectPtr CallbackTarget;
+    bool& IsActive;
+    TWeakObjectPtr<UWindowTransparencyHelper> Helper;
+    TSharedRef<TOptional<bool>> Result;
+};
+
 bool UWindowTransparencyBPL::InitializeWindowTransparency()
 {
 #if PLATFORM_WINDOWS
@@ -121,6 +171,195 @@ void UWindowTransparencyBPL::SetGameRaycastTraceChannel(ECollisionChannel TraceC
 #endif
 }
 
+void UWindowTransparencyBPL::SetHitTestKernel(EWindowHitTestKernel Kernel, float RadiusPixels)
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        Helper->SetHitTestKernel(Kernel, RadiusPixels);
+    }
+#else
+    UE_LOG(LogWindowBPL, Log, TEXT("SetHitTestKernel: Not supported on this platform."));
+#endif
+}
+
+void UWindowTransparencyBPL::SetHitTestCombineRule(EWindowHitTestCombineRule Rule, float WeightedThreshold)
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        Helper->SetHitTestCombineRule(Rule, WeightedThreshold);
+    }
+#else
+    UE_LOG(LogWindowBPL, Log, TEXT("SetHitTestCombineRule: Not supported on this platform."));
+#endif
+}
+
+float UWindowTransparencyBPL::GetHitTestBroadPhaseRejectRate(int32& CandidateCount)
+{
+    CandidateCount = 0;
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        CandidateCount = Helper->GetHitTestBroadPhaseCandidateCount();
+        return Helper->GetHitTestBroadPhaseRejectRate();
+    }
+#else
+    UE_LOG(LogWindowBPL, Log, TEXT("GetHitTestBroadPhaseRejectRate: Not supported on this platform."));
+#endif
+    return 0.0f;
+}
+
+void UWindowTransparencyBPL::InvalidateWidgetHitCache()
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        Helper->InvalidateWidgetHitCache();
+    }
+#else
+    UE_LOG(LogWindowBPL, Log, TEXT("InvalidateWidgetHitCache: Not supported on this platform."));
+#endif
+}
+
+UWindowHitTestStrategy* UWindowTransparencyBPL::AddHitTestStrategy(TSubclassOf<UWindowHitTestStrategy> StrategyClass)
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        return Helper->AddHitTestStrategy(StrategyClass);
+    }
+#else
+    UE_LOG(LogWindowBPL, Log, TEXT("AddHitTestStrategy: Not supported on this platform."));
+#endif
+    return nullptr;
+}
+
+void UWindowTransparencyBPL::ClearHitTestStrategies()
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        Helper->ClearHitTestStrategies();
+    }
+#else
+    UE_LOG(LogWindowBPL, Log, TEXT("ClearHitTestStrategies: Not supported on this platform."));
+#endif
+}
+
+void UWindowTransparencyBPL::SetHitTestStrategyOrdering(bool bAutoOrder, float MinConfidence)
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        Helper->SetHitTestStrategyOrdering(bAutoOrder, MinConfidence);
+    }
+#else
+    UE_LOG(LogWindowBPL, Log, TEXT("SetHitTestStrategyOrdering: Not supported on this platform."));
+#endif
+}
+
+TArray<FWindowHitTestStrategyStats> UWindowTransparencyBPL::GetHitTestStrategyStats()
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        return Helper->GetHitTestStrategyStats();
+    }
+#else
+    UE_LOG(LogWindowBPL, Log, TEXT("GetHitTestStrategyStats: Not supported on this platform."));
+#endif
+    return TArray<FWindowHitTestStrategyStats>();
+}
+
+void UWindowTransparencyBPL::SetInputThreadEnabled(bool bEnable, float RateHz)
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        Helper->SetInputThreadEnabled(bEnable, RateHz);
+    }
+#else
+    UE_LOG(LogWindowBPL, Log, TEXT("SetInputThreadEnabled: Not supported on this platform."));
+#endif
+}
+
+void UWindowTransparencyBPL::SetCursorPrediction(bool bEnable, float MaxHorizonMs)
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        Helper->SetCursorPrediction(bEnable, MaxHorizonMs);
+    }
+#else
+    UE_LOG(LogWindowBPL, Log, TEXT("SetCursorPrediction: Not supported on this platform."));
+#endif
+}
+
+FWindowCursorPredictionStats UWindowTransparencyBPL::GetCursorPredictionStats()
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        return Helper->GetCursorPredictionStats();
+    }
+#else
+    UE_LOG(LogWindowBPL, Log, TEXT("GetCursorPredictionStats: Not supported on this platform."));
+#endif
+    return FWindowCursorPredictionStats();
+}
+
+void UWindowTransparencyBPL::RegisterStencilActor(AActor* Actor, int32 StencilValue)
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        Helper->RegisterStencilActor(Actor, StencilValue);
+    }
+#else
+    UE_LOG(LogWindowBPL, Log, TEXT("RegisterStencilActor: Not supported on this platform."));
+#endif
+}
+
+void UWindowTransparencyBPL::UnregisterStencilActor(AActor* Actor, bool bClearCustomDepth)
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        Helper->UnregisterStencilActor(Actor, bClearCustomDepth);
+    }
+#else
+    UE_LOG(LogWindowBPL, Log, TEXT("UnregisterStencilActor: Not supported on this platform."));
+#endif
+}
+
+FWindowStencilPickResult UWindowTransparencyBPL::GetStencilPickResult()
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        return Helper->GetLastStencilPickResult();
+    }
+#else
+    UE_LOG(LogWindowBPL, Log, TEXT("GetStencilPickResult: Not supported on this platform."));
+#endif
+    return FWindowStencilPickResult();
+}
+
 bool UWindowTransparencyBPL::GetIsMouseOverOpaqueArea(bool& bIsOverOpaqueArea)
 {
     bIsOverOpaqueArea = true; // Default to true (interactive) if helper unavailable
@@ -208,4 +447,196 @@ void UWindowTransparencyBPL::SetWindowAsDesktopBackground(bool bEnable)
 #else
     UE_LOG(LogWindowBPL, Log, TEXT("SetWindowAsDesktopBackground: Window Transparency features are not supported on this platform."));
 #endif
+}
+
+void UWindowTransparencyBPL::SetWindowAsDesktopBackgroundAndWait(UObject* WorldContextObject, bool bEnable, bool& bIsActive, FLatentActionInfo LatentInfo)
+{
+    UWorld* World = GEngine ? GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull) : nullptr;
+    if (!World)
+    {
+        return;
+    }
+    FLatentActionManager& LatentActionManager = World->GetLatentActionManager();
+    if (LatentActionManager.FindExistingAction<FWindowDesktopBackgroundLatentAction>(LatentInfo.CallbackTarget, LatentInfo.UUID))
+    {
+        return;
+    }
+
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    FWindowDesktopBackgroundLatentAction* Action = new FWindowDesktopBackgroundLatentAction(LatentInfo, bIsActive, Helper);
+#if PLATFORM_WINDOWS
+    if (Helper)
+    {
+        Helper->SetAsDesktopBackground(bEnable, Action->MakeCompletionCallback());
+    }
+    else
+    {
+        UE_LOG(LogWindowBPL, Warning, TEXT("SetWindowAsDesktopBackgroundAndWait: Could not get WindowTransparencyHelper instance. System may not be available."));
+        Action->Complete(false);
+    }
+#else
+    UE_LOG(LogWindowBPL, Log, TEXT("SetWindowAsDesktopBackgroundAndWait: Window Transparency features are not supported on this platform."));
+    Action->Complete(false);
+#endif
+    LatentActionManager.AddNewAction(LatentInfo.CallbackTarget, LatentInfo.UUID, Action);
+}
+
+void UWindowTransparencyBPL::SetAutoFitToContent(bool bEnable, float MarginPixels, float ShrinkDelaySeconds)
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        Helper->SetAutoFitToContent(bEnable, MarginPixels, ShrinkDelaySeconds);
+    }
+#else
+    UE_LOG(LogWindowBPL, Log, TEXT("SetAutoFitToContent: Not supported on this platform."));
+#endif
+}
+
+float UWindowTransparencyBPL::GetAutoFitAreaRatio()
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        return Helper->GetAutoFitAreaRatio();
+    }
+#endif
+    return 1.0f;
+}
+
+void UWindowTransparencyBPL::SetIdleThrottle(bool bEnable, float IdleFPS, bool bSuspendRendering, float IdleDelaySeconds)
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        Helper->SetIdleThrottle(bEnable, IdleFPS, bSuspendRendering, IdleDelaySeconds);
+    }
+#else
+    UE_LOG(LogWindowBPL, Log, TEXT("SetIdleThrottle: Not supported on this platform."));
+#endif
+}
+
+FWindowIdleStats UWindowTransparencyBPL::GetIdleStats()
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        return Helper->GetIdleStats();
+    }
+#endif
+    return FWindowIdleStats();
+}
+
+void UWindowTransparencyBPL::SetWallpaperGovernor(bool bEnable, float WallpaperFPS, float OccludedFPS, bool bPauseWhenOccluded)
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        Helper->SetWallpaperGovernor(bEnable, WallpaperFPS, OccludedFPS, bPauseWhenOccluded);
+    }
+#else
+    UE_LOG(LogWindowBPL, Log, TEXT("SetWallpaperGovernor: Not supported on this platform."));
+#endif
+}
+
+FWindowWallpaperGovernorStats UWindowTransparencyBPL::GetWallpaperGovernorStats()
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        return Helper->GetWallpaperGovernorStats();
+    }
+#endif
+    return FWindowWallpaperGovernorStats();
+}
+
+void UWindowTransparencyBPL::SetWallpaperMouseInputEnabled(bool bEnable)
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        Helper->SetWallpaperMouseInputEnabled(bEnable);
+    }
+#else
+    UE_LOG(LogWindowBPL, Log, TEXT("SetWallpaperMouseInputEnabled: Not supported on this platform."));
+#endif
+}
+
+bool UWindowTransparencyBPL::IsWallpaperMouseInputActive()
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        return Helper->IsWallpaperMouseInputActive();
+    }
+#endif
+    return false;
+}
+
+FWindowTransparencyHistogramSummary UWindowTransparencyBPL::GetClickThroughLatencyStats()
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        return Helper->GetClickThroughLatencySummary();
+    }
+    UE_LOG(LogWindowBPL, Warning, TEXT("GetClickThroughLatencyStats: Could not get WindowTransparencyHelper instance. System may not be available."));
+#endif
+    return FWindowTransparencyHistogramSummary();
+}
+
+FWindowTransparencyHistogramSummary UWindowTransparencyBPL::GetClickThroughFlickerStats(int32& RapidFlipCount, int32& TotalFlipCount)
+{
+    RapidFlipCount = 0;
+    TotalFlipCount = 0;
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        RapidFlipCount = Helper->GetClickThroughRapidFlipCount();
+        TotalFlipCount = Helper->GetClickThroughFlipCount();
+        return Helper->GetClickThroughFlipIntervalSummary();
+    }
+    UE_LOG(LogWindowBPL, Warning, TEXT("GetClickThroughFlickerStats: Could not get WindowTransparencyHelper instance. System may not be available."));
+#endif
+    return FWindowTransparencyHistogramSummary();
+}
+
+void UWindowTransparencyBPL::SetClickThroughFlickerWindow(float FlickerWindowMs)
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        Helper->SetFlickerWindowMs(FlickerWindowMs);
+    }
+    else
+    {
+        UE_LOG(LogWindowBPL, Warning, TEXT("SetClickThroughFlickerWindow: Could not get WindowTransparencyHelper instance. System may not be available."));
+    }
+#endif
+}
+
+void UWindowTransparencyBPL::ResetClickThroughStats()
+{
+#if PLATFORM_WINDOWS
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (Helper)
+    {
+        Helper->ResetClickThroughStats();
+    }
+    else
+    {
+        UE_LOG(LogWindowBPL, Warning, TEXT("ResetClickThroughStats: Could not get WindowTransparencyHelper instance. System may not be available."));
+    }
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,749 @@
+﻿// WindowTransparencyBenchmarks.cpp
+#include "WindowTransparencyBenchmarks.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+#include "WindowCuboidGenerator.h"
+#include "WindowsRepresentationComponent.h"
+#include "WindowTransparencyHelper.h"
+#include "WindowTransparencyKernels.h"
+#include "WindowTransparencyOSBackend.h"
+#include "WindowHitTestStrategy.h"
+#include "WindowPixelAlphaProbeExtension.h"
+#include "UObject/StrongObjectPtr.h"
+#include "Math/PerspectiveMatrix.h"
+#include "Math/Float16.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "GameFramework/PlayerController.h"
+#include "Components/SceneComponent.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+#if !UE_BUILD_SHIPPING
+
+DEFINE_LOG_CATEGORY_STATIC(LogWindowBenchmark, Log, All);
+
+// 比較用: テンプレート化する前の AddCuboidFromPoints の実装
+static void LegacyAddCuboidFromPoints(
+    const FWindowPoints& Points,
+    float CuboidThickness,
+    TArray<FVector>& Vertices,
+    TArray<int32>& Triangles,
+    TArray<FVector>& Normals,
+    TArray<FVector2D>& UVs0,
+    TArray<FLinearColor>& VertexColors,
+    TArray<FProcMeshTangent>& Tangents,
+    TArray<FVector>& OutConvexVertices)
+{
+    Vertices.Empty();
+    Triangles.Empty();
+    Normals.Empty();
+    UVs0.Empty();
+    VertexColors.Empty();
+    Tangents.Empty();
+    OutConvexVertices.Empty();
+
+    const FVector& P1_TL = Points.Point1_TL;
+    const FVector& P2_TR = Points.Point2_TR;
+    const FVector& P3_BR = Points.Point3_BR;
+    const FVector& P4_BL = Points.Point4_BL;
+
+    FVector SurfaceNormal = FVector::CrossProduct(P2_TR - P1_TL, P4_BL - P1_TL).GetSafeNormal();
+    if (SurfaceNormal.IsNearlyZero())
+    {
+        SurfaceNormal = FVector::CrossProduct(P3_BR - P2_TR, P1_TL - P2_TR).GetSafeNormal();
+        if (SurfaceNormal.IsNearlyZero()) {
+            SurfaceNormal = FVector::UpVector;
+        }
+    }
+
+    FVector P1_TL_Back = P1_TL - SurfaceNormal * CuboidThickness;
+    FVector P2_TR_Back = P2_TR - SurfaceNormal * CuboidThickness;
+    FVector P3_BR_Back = P3_BR - SurfaceNormal * CuboidThickness;
+    FVector P4_BL_Back = P4_BL - SurfaceNormal * CuboidThickness;
+
+    FLinearColor DefaultColor = FLinearColor::White;
+
+    OutConvexVertices.Add(P1_TL);
+    OutConvexVertices.Add(P2_TR);
+    OutConvexVertices.Add(P3_BR);
+    OutConvexVertices.Add(P4_BL);
+    OutConvexVertices.Add(P1_TL_Back);
+    OutConvexVertices.Add(P2_TR_Back);
+    OutConvexVertices.Add(P3_BR_Back);
+    OutConvexVertices.Add(P4_BL_Back);
+
+    int32 V0 = Vertices.Add(P1_TL); UVs0.Add(FVector2D(0, 0)); Normals.Add(SurfaceNormal); VertexColors.Add(DefaultColor);
+    int32 V1 = Vertices.Add(P2_TR); UVs0.Add(FVector2D(1, 0)); Normals.Add(SurfaceNormal); VertexColors.Add(DefaultColor);
+    int32 V2 = Vertices.Add(P3_BR); UVs0.Add(FVector2D(1, 1)); Normals.Add(SurfaceNormal); VertexColors.Add(DefaultColor);
+    int32 V3 = Vertices.Add(P4_BL); UVs0.Add(FVector2D(0, 1)); Normals.Add(SurfaceNormal); VertexColors.Add(DefaultColor);
+    Triangles.Append({ V0, V3, V2, V0, V2, V1 });
+
+    FVector BackNormal = -SurfaceNormal;
+    int32 V4 = Vertices.Add(P1_TL_Back); UVs0.Add(FVector2D(0, 0)); Normals.Add(BackNormal); VertexColors.Add(DefaultColor);
+    int32 V5 = Vertices.Add(P4_BL_Back); UVs0.Add(FVector2D(1, 0)); Normals.Add(BackNormal); VertexColors.Add(DefaultColor);
+    int32 V6 = Vertices.Add(P3_BR_Back); UVs0.Add(FVector2D(1, 1)); Normals.Add(BackNormal); VertexColors.Add(DefaultColor);
+    int32 V7 = Vertices.Add(P2_TR_Back); UVs0.Add(FVector2D(0, 1)); Normals.Add(BackNormal); VertexColors.Add(DefaultColor);
+    Triangles.Append({ V4, V7, V6, V4, V6, V5 });
+
+    auto AddSideFace = [&](const FVector& A, const FVector& B, const FVector& C, const FVector& D) {
+        FVector SideNormal = FVector::CrossProduct(B - A, D - A).GetSafeNormal();
+        int32 SV0 = Vertices.Add(A); UVs0.Add(FVector2D(0, 0)); Normals.Add(SideNormal); VertexColors.Add(DefaultColor);
+        int32 SV1 = Vertices.Add(B); UVs0.Add(FVector2D(1, 0)); Normals.Add(SideNormal); VertexColors.Add(DefaultColor);
+        int32 SV2 = Vertices.Add(C); UVs0.Add(FVector2D(1, 1)); Normals.Add(SideNormal); VertexColors.Add(DefaultColor);
+        int32 SV3 = Vertices.Add(D); UVs0.Add(FVector2D(0, 1)); Normals.Add(SideNormal); VertexColors.Add(DefaultColor);
+        Triangles.Append({ SV0, SV3, SV2, SV0, SV2, SV1 });
+        };
+
+    AddSideFace(P1_TL, P1_TL_Back, P2_TR_Back, P2_TR);
+    AddSideFace(P2_TR, P2_TR_Back, P3_BR_Back, P3_BR);
+    AddSideFace(P3_BR, P3_BR_Back, P4_BL_Back, P4_BL);
+    AddSideFace(P4_BL, P4_BL_Back, P1_TL_Back, P1_TL);
+
+    for (int32 i = 0; i < Vertices.Num(); ++i)
+    {
+        const FVector& N = Normals[i];
+        const FVector CrossVec = (FMath::Abs(N.Z) < (1.f - KINDA_SMALL_NUMBER)) ? FVector::UpVector : FVector::RightVector;
+        FVector TangentX = FVector::CrossProduct(N, CrossVec).GetSafeNormal();
+        Tangents.Add(FProcMeshTangent(TangentX, false));
+    }
+}
+
+static TArray<FWindowPoints> MakeBenchmarkWindows(int32 Count)
+{
+    FRandomStream Random(1234);
+    TArray<FWindowPoints> Windows;
+    Windows.SetNum(Count);
+    for (int32 i = 0; i < Count; ++i)
+    {
+        const FVector Origin(Random.FRandRange(-2000.f, 2000.f), Random.FRandRange(-2000.f, 2000.f), 0.f);
+        const float Width = Random.FRandRange(50.f, 800.f);
+        const float Height = Random.FRandRange(50.f, 600.f);
+        Windows[i].WindowName = FName(TEXT("BenchWindow"), i + 1);
+        Windows[i].Point1_TL = Origin;
+        Windows[i].Point2_TR = Origin + FVector(Width, 0.f, 0.f);
+        Windows[i].Point3_BR = Origin + FVector(Width, 0.f, -Height);
+        Windows[i].Point4_BL = Origin + FVector(0.f, 0.f, -Height);
+    }
+    return Windows;
+}
+
+static void RunCuboidBenchmark(const TArray<FString>& Args)
+{
+    const int32 WindowCount = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 10000;
+    const int32 Iterations = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 10;
+    const TArray<FWindowPoints> Windows = MakeBenchmarkWindows(WindowCount);
+    const float BenchThickness = 10.0f;
+
+    // 最適化で計算が消えないように結果を集計する
+    double Checksum = 0.0;
+
+    double StartTime = FPlatformTime::Seconds();
+    for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+    {
+        for (const FWindowPoints& Points : Windows)
+        {
+            // 旧実装と同様に、ウィンドウごとにローカル配列を確保する
+            TArray<FVector> Vertices;
+            TArray<int32> Triangles;
+            TArray<FVector> Normals;
+            TArray<FVector2D> UVs0;
+            TArray<FLinearColor> VertexColors;
+            TArray<FProcMeshTangent> Tangents;
+            TArray<FVector> ConvexVertices;
+            LegacyAddCuboidFromPoints(Points, BenchThickness, Vertices, Triangles, Normals, UVs0, VertexColors, Tangents, ConvexVertices);
+            Checksum += Vertices.Last().X + Tangents.Last().TangentX.Y;
+        }
+    }
+    const double LegacySeconds = FPlatformTime::Seconds() - StartTime;
+
+    FWindowCuboidBuffers Buffers;
+    StartTime = FPlatformTime::Seconds();
+    for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+    {
+        for (const FWindowPoints& Points : Windows)
+        {
+            FWindowCuboidGenerator::Build(Points, BenchThickness, false, Buffers);
+            Checksum += Buffers.Vertices.Last().X + Buffers.Tangents.Last().TangentX.Y;
+        }
+    }
+    const double TemplateSeconds = FPlatformTime::Seconds() - StartTime;
+
+    const double TotalCuboids = static_cast<double>(WindowCount) * Iterations;
+    const double LegacyRate = TotalCuboids / FMath::Max(LegacySeconds, UE_DOUBLE_SMALL_NUMBER);
+    const double TemplateRate = TotalCuboids / FMath::Max(TemplateSeconds, UE_DOUBLE_SMALL_NUMBER);
+
+    UE_LOG(LogWindowBenchmark, Display, TEXT("wt.Bench.Cuboids: %d windows x %d iterations (checksum %.3f)"), WindowCount, Iterations, Checksum);
+    UE_LOG(LogWindowBenchmark, Display, TEXT("  Legacy AddCuboidFromPoints : %12.0f cuboids/sec (%.3f ms)"), LegacyRate, LegacySeconds * 1000.0);
+    UE_LOG(LogWindowBenchmark, Display, TEXT("  FWindowCuboidGenerator     : %12.0f cuboids/sec (%.3f ms)"), TemplateRate, TemplateSeconds * 1000.0);
+    UE_LOG(LogWindowBenchmark, Display, TEXT("  Speedup                    : %.2fx"), TemplateRate / FMath::Max(LegacyRate, UE_DOUBLE_SMALL_NUMBER));
+}
+
+static FAutoConsoleCommand CuboidBenchmarkCommand(
+    TEXT("wt.Bench.Cuboids"),
+    TEXT("Measures window cuboid generation throughput before and after the template generator. Usage: wt.Bench.Cuboids [WindowCount] [Iterations]"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&RunCuboidBenchmark));
+
+// 全ウィンドウを移動させたときの更新コストを描画モードごとに計測する
+static double MeasureWindowMoves(UWindowsRepresentationComponent* Component, EWindowRenderMode Mode, const TArray<FWindowPoints>& Windows, int32 Iterations, double& OutInstanceMilliseconds)
+{
+    Component->RenderMode = Mode;
+    Component->WindowPointSets = Windows;
+    Component->RegenerateMesh();
+
+    OutInstanceMilliseconds = 0.0;
+    const double StartTime = FPlatformTime::Seconds();
+    for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+    {
+        const FVector Offset(0.f, 0.f, (Iteration % 2 == 0) ? 5.f : -5.f);
+        for (FWindowPoints& Points : Component->WindowPointSets)
+        {
+            Points.Point1_TL += Offset;
+            Points.Point2_TR += Offset;
+            Points.Point3_BR += Offset;
+            Points.Point4_BL += Offset;
+        }
+        Component->RegenerateMesh();
+        OutInstanceMilliseconds += Component->GetLastInstanceUpdateMilliseconds();
+    }
+    const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+    Component->WindowPointSets.Reset();
+    Component->RegenerateMesh();
+    return Seconds;
+}
+
+// 計測用の一時アクターとコンポーネントを生成する（同期・コリジョンなし）
+static UWindowsRepresentationComponent* SpawnBenchmarkComponent(UWorld* World)
+{
+    FActorSpawnParameters SpawnParams;
+    SpawnParams.ObjectFlags |= RF_Transient;
+    AActor* BenchActor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+    if (!BenchActor)
+    {
+        return nullptr;
+    }
+    USceneComponent* Root = NewObject<USceneComponent>(BenchActor, TEXT("BenchRoot"), RF_Transient);
+    BenchActor->SetRootComponent(Root);
+    Root->RegisterComponent();
+
+    UWindowsRepresentationComponent* Component = NewObject<UWindowsRepresentationComponent>(BenchActor, TEXT("BenchWindows"), RF_Transient);
+    Component->bCreateCollision = false;
+    Component->bCoalesceUpdates = false;
+    Component->bAsyncMeshGeneration = false;
+    Component->Thickness = 10.0f;
+    Component->RegisterComponent();
+    return Component;
+}
+
+static bool CanRunWorldBenchmarks(const UWorld* World)
+{
+    return World && World->IsGameWorld() && World->HasBegunPlay();
+}
+
+static void RunInstanceBenchmark(const TArray<FString>& Args, UWorld* World)
+{
+    if (!CanRunWorldBenchmarks(World))
+    {
+        UE_LOG(LogWindowBenchmark, Warning, TEXT("wt.Bench.Instances must be run in a game world that has begun play."));
+        return;
+    }
+
+    const int32 WindowCount = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 500;
+    const int32 Iterations = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 20;
+    const TArray<FWindowPoints> Windows = MakeBenchmarkWindows(WindowCount);
+
+    UWindowsRepresentationComponent* Component = SpawnBenchmarkComponent(World);
+    if (!Component)
+    {
+        return;
+    }
+    AActor* BenchActor = Component->GetOwner();
+
+    double ProceduralInstanceMs = 0.0;
+    double InstancedInstanceMs = 0.0;
+    const double ProceduralSeconds = MeasureWindowMoves(Component, EWindowRenderMode::ProceduralMesh, Windows, Iterations, ProceduralInstanceMs);
+    const double InstancedSeconds = MeasureWindowMoves(Component, EWindowRenderMode::InstancedCube, Windows, Iterations, InstancedInstanceMs);
+
+    BenchActor->Destroy();
+
+    UE_LOG(LogWindowBenchmark, Display, TEXT("wt.Bench.Instances: moving %d windows x %d iterations"), WindowCount, Iterations);
+    UE_LOG(LogWindowBenchmark, Display, TEXT("  ProceduralMesh : %8.3f ms/update"), ProceduralSeconds * 1000.0 / Iterations);
+    UE_LOG(LogWindowBenchmark, Display, TEXT("  InstancedCube  : %8.3f ms/update (instance updates %.3f ms/update)"), InstancedSeconds * 1000.0 / Iterations, InstancedInstanceMs / Iterations);
+    UE_LOG(LogWindowBenchmark, Display, TEXT("  Speedup        : %.2fx"), ProceduralSeconds / FMath::Max(InstancedSeconds, UE_DOUBLE_SMALL_NUMBER));
+}
+
+static FAutoConsoleCommandWithWorldAndArgs InstanceBenchmarkCommand(
+    TEXT("wt.Bench.Instances"),
+    TEXT("Measures the cost of moving every window with the procedural mesh and instanced cube render modes. Usage: wt.Bench.Instances [WindowCount] [Iterations]"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunInstanceBenchmark));
+
+// ---------------------------------------------------------------------------
+// ベンチマークスイート (wt.Bench.Run と WindowTransparency.Perf.* の自動テスト)
+// 結果をJSONで保存し、ベースラインと比較して許容範囲を超えた劣化を失敗として報告する
+// ---------------------------------------------------------------------------
+
+// 1回分の処理時間（秒）を返すカーネル。Size は処理する要素数
+// World はワールドが必要なケースにだけ渡される（それ以外は nullptr）
+typedef TFunction<double(UWorld* World, int32 Size, int32 Iterations, double& Checksum)> FWindowBenchmarkKernel;
+
+struct FWindowBenchmarkCase
+{
+    const TCHAR* Name;
+    TArray<int32> Sizes;
+    bool bNeedsWorld;
+    FWindowBenchmarkKernel Kernel;
+};
+
+static double BenchCuboidGenerator(UWorld* World, int32 Size, int32 Iterations, double& Checksum)
+{
+    const TArray<FWindowPoints> Windows = MakeBenchmarkWindows(Size);
+    FWindowCuboidBuffers Buffers;
+    const double StartTime = FPlatformTime::Seconds();
+    for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+    {
+        for (const FWindowPoints& Points : Windows)
+        {
+            FWindowCuboidGenerator::Build(Points, 10.0f, false, Buffers);
+            Checksum += Buffers.Vertices.Last().X;
+        }
+    }
+    return FPlatformTime::Seconds() - StartTime;
+}
+
+// UWindowsRepresentationComponent の外部ウィンドウ差分。毎回およそ1割のウィンドウが移動する
+static double BenchSnapshotDiff(UWorld* World, int32 Size, int32 Iterations, double& Checksum)
+{
+    UWindowsRepresentationComponent* Component = SpawnBenchmarkComponent(World);
+    if (!Component)
+    {
+        return 0.0;
+    }
+
+    FRandomStream Random(5678);
+    TArray<FOtherWindowInfo> Snapshot;
+    Snapshot.SetNum(Size);
+    for (int32 i = 0; i < Size; ++i)
+    {
+        Snapshot[i].WindowHandleStr = FString::Printf(TEXT("0x%08X"), 0x10000 + i * 4);
+        Snapshot[i].PosX = Random.RandRange(0, 3000);
+        Snapshot[i].PosY = Random.RandRange(0, 2000);
+        Snapshot[i].Width = Random.RandRange(100, 1200);
+        Snapshot[i].Height = Random.RandRange(100, 900);
+    }
+
+    // 原点から +X を向いた 1920x1080 のビュー（FSceneView と同じ軸の入れ替え）
+    const FIntRect GameWindowRect(0, 0, 1920, 1080);
+    const FMatrix ViewMatrix(FPlane(0, 0, 1, 0), FPlane(1, 0, 0, 0), FPlane(0, 1, 0, 0), FPlane(0, 0, 0, 1));
+    const FMatrix ViewProjectionMatrix = ViewMatrix * FReversedZPerspectiveMatrix(UE_PI / 4.0, 1920.0, 1080.0, 10.0);
+    const FPlane ProjectionPlane(FVector(1000.0, 0.0, 0.0), FVector::ForwardVector);
+
+    // 最初の適用は全ウィンドウの投影なので計測に含めない
+    Component->ApplyExternalWindowsSnapshotWithView(Snapshot, GameWindowRect, GameWindowRect, ViewProjectionMatrix, ProjectionPlane);
+
+    const double StartTime = FPlatformTime::Seconds();
+    for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+    {
+        for (int32 i = Iteration % 10; i < Size; i += 10)
+        {
+            Snapshot[i].PosX += (Iteration % 2 == 0) ? 3 : -3;
+        }
+        Checksum += Component->ApplyExternalWindowsSnapshotWithView(Snapshot, GameWindowRect, GameWindowRect, ViewProjectionMatrix, ProjectionPlane) ? Component->WindowPointSets.Num() : 0;
+    }
+    const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+    Component->GetOwner()->Destroy();
+    return Seconds;
+}
+
+// RegenerateMesh: 全ウィンドウが毎回移動する最悪ケース
+static double BenchRegenerateMesh(UWorld* World, int32 Size, int32 Iterations, double& Checksum)
+{
+    UWindowsRepresentationComponent* Component = SpawnBenchmarkComponent(World);
+    if (!Component)
+    {
+        return 0.0;
+    }
+    double InstanceMilliseconds = 0.0;
+    const double Seconds = MeasureWindowMoves(Component, EWindowRenderMode::ProceduralMesh, MakeBenchmarkWindows(Size), Iterations, InstanceMilliseconds);
+    Checksum += Component->GetLastRebuiltWindowCount();
+    Component->GetOwner()->Destroy();
+    return Seconds;
+}
+
+// 壁紙の遮蔽判定: 2画面の作業領域から Size 個のウィンドウ矩形を引く
+static double BenchRectOps(UWorld* World, int32 Size, int32 Iterations, double& Checksum)
+{
+    const TArray<FIntRect> Regions = { FIntRect(0, 0, 1920, 1040), FIntRect(1920, 0, 4480, 1400) };
+    FRandomStream Random(2468);
+    TArray<FIntRect> Occluders;
+    Occluders.Reserve(Size);
+    for (int32 i = 0; i < Size; ++i)
+    {
+        const FIntPoint Min(Random.RandRange(-200, 4300), Random.RandRange(-100, 1300));
+        Occluders.Emplace(Min, Min + FIntPoint(Random.RandRange(200, 1600), Random.RandRange(150, 1000)));
+    }
+
+    const double StartTime = FPlatformTime::Seconds();
+    for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+    {
+        Checksum += static_cast<double>(FWindowTransparencyKernels::ComputeUncoveredArea(Regions, Occluders));
+    }
+    return FPlatformTime::Seconds() - StartTime;
+}
+
+// ピクセルアルファの判定: 読み戻しの形式ごとにデコードし、PixelAlpha 戦略の既定のしきい値と比べる
+static double BenchAlphaCoverage(UWorld* World, int32 Size, int32 Iterations, double& Checksum)
+{
+    struct FTexelRow
+    {
+        EPixelFormat Format;
+        int32 BytesPerTexel;
+        TArray<uint8> Data;
+    };
+    FRandomStream Random(1357);
+    TArray<FTexelRow> Rows = { { PF_B8G8R8A8, 4, {} }, { PF_A2B10G10R10, 4, {} }, { PF_FloatRGBA, 8, {} } };
+    for (FTexelRow& Row : Rows)
+    {
+        Row.Data.SetNumUninitialized(Size * Row.BytesPerTexel);
+        for (int32 Texel = 0; Texel < Size; ++Texel)
+        {
+            uint8* Bytes = &Row.Data[Texel * Row.BytesPerTexel];
+            if (Row.Format == PF_FloatRGBA)
+            {
+                FFloat16* Channels = reinterpret_cast<FFloat16*>(Bytes);
+                for (int32 Channel = 0; Channel < 4; ++Channel)
+                {
+                    Channels[Channel] = FFloat16(Random.GetFraction());
+                }
+            }
+            else
+            {
+                const uint32 Value = static_cast<uint32>(Random.GetUnsignedInt());
+                FMemory::Memcpy(Bytes, &Value, sizeof(Value));
+            }
+        }
+    }
+    const int32 AlphaThreshold = GetDefault<UWindowHitTestStrategy_PixelAlpha>()->AlphaThreshold;
+
+    const double StartTime = FPlatformTime::Seconds();
+    for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+    {
+        const FTexelRow& Row = Rows[Iteration % Rows.Num()];
+        int32 OpaqueCount = 0;
+        for (int32 Texel = 0; Texel < Size; ++Texel)
+        {
+            uint8 Alpha = 0;
+            if (FWindowPixelAlphaProbeExtension::DecodeAlpha(Row.Format, &Row.Data[Texel * Row.BytesPerTexel], Alpha) && Alpha >= AlphaThreshold)
+            {
+                ++OpaqueCount;
+            }
+        }
+        Checksum += OpaqueCount;
+    }
+    return FPlatformTime::Seconds() - StartTime;
+}
+
+// ウィジェットキャッシュの構築時に行う、ブロックするウィジェットかどうかの分類
+static double BenchWidgetClassification(UWorld* World, int32 Size, int32 Iterations, double& Checksum)
+{
+    static const FName WidgetTypes[] =
+    {
+        FName(TEXT("SWindow")), FName(TEXT("SViewport")), FName(TEXT("SGameLayerManager")), FName(TEXT("SOverlay")),
+        FName(TEXT("SCanvasPanel")), FName(TEXT("SBorder")), FName(TEXT("SObjectWidget")), FName(TEXT("SButton")),
+        FName(TEXT("STextBlock")), FName(TEXT("SImage")), FName(TEXT("SScaleBox")), FName(TEXT("SVerticalBox"))
+    };
+    FRandomStream Random(9753);
+    TArray<TPair<FName, int32>> Widgets;
+    Widgets.Reserve(Size);
+    for (int32 i = 0; i < Size; ++i)
+    {
+        Widgets.Emplace(WidgetTypes[Random.RandHelper(static_cast<int32>(UE_ARRAY_COUNT(WidgetTypes)))], Random.RandRange(1, 12));
+    }
+
+    const double StartTime = FPlatformTime::Seconds();
+    for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+    {
+        int32 BlockingCount = 0;
+        for (const TPair<FName, int32>& Widget : Widgets)
+        {
+            BlockingCount += FWindowTransparencyKernels::IsBlockingHitTestWidget(Widget.Key, Widget.Value) ? 1 : 0;
+        }
+        Checksum += BlockingCount;
+    }
+    return FPlatformTime::Seconds() - StartTime;
+}
+
+// 模擬バックエンド上のヘルパーの Tick。透過・クリック透過・ヒットテストを有効にし、カーソルは Tick ごとにゲームウィンドウの内外を動かす。
+// Tick はどのプラットフォームでもヒットテストまで進むので、パイプラインが走るようヘルパーをワールドに属させ、
+// プレイヤーコントローラーがなければ一時的に置く
+static double BenchHelperTick(UWorld* World, int32 Size, int32 Iterations, double& Checksum)
+{
+    APlayerController* SpawnedController = nullptr;
+    if (!World->GetFirstPlayerController())
+    {
+        FActorSpawnParameters SpawnParams;
+        SpawnParams.ObjectFlags |= RF_Transient;
+        SpawnedController = World->SpawnActor<APlayerController>(APlayerController::StaticClass(), FTransform::Identity, SpawnParams);
+    }
+    TStrongObjectPtr<UWindowTransparencyHelper> Helper(NewObject<UWindowTransparencyHelper>(World));
+    const TSharedPtr<FWindowTransparencySimulatedBackend> Backend = MakeShared<FWindowTransparencySimulatedBackend>();
+    Helper->SetOSBackend(Backend);
+    Helper->Initialize();
+    Helper->SetDWMTransparency(true);
+    Helper->SetHitTestEnabled(true);
+    Helper->SetHitTestType(EWindowHitTestType::GameRaycast);
+    Backend->ResetCallCounts();
+
+    const double StartTime = FPlatformTime::Seconds();
+    for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+    {
+        for (int32 TickIndex = 0; TickIndex < Size; ++TickIndex)
+        {
+            Backend->SetCursorScreenPosition((Iteration * 37 + TickIndex * 13) % 2560, (Iteration * 11 + TickIndex * 7) % 1440);
+            Helper->Tick(1.0f / 60.0f);
+        }
+    }
+    const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+    const FWindowTransparencyOSCallCounts Calls = Backend->GetCallCounts();
+    Checksum += Calls.GetStyle + Calls.SetStyle;
+    Helper->RestoreDefaultWindowSettings();
+    if (SpawnedController)
+    {
+        SpawnedController->Destroy();
+    }
+    return Seconds;
+}
+
+static const TArray<FWindowBenchmarkCase>& GetBenchmarkCases()
+{
+    static const TArray<FWindowBenchmarkCase> Cases =
+    {
+        { TEXT("CuboidGenerator"), { 1, 10, 100, 1000, 10000 }, false, &BenchCuboidGenerator },
+        { TEXT("SnapshotDiff"), { 10, 100, 1000 }, true, &BenchSnapshotDiff },
+        { TEXT("RegenerateMesh"), { 1, 10, 100, 1000, 10000 }, true, &BenchRegenerateMesh },
+        { TEXT("RectOps"), { 1, 10, 100 }, false, &BenchRectOps },
+        { TEXT("AlphaCoverage"), { 1, 64, 4096, 65536 }, false, &BenchAlphaCoverage },
+        { TEXT("WidgetClassification"), { 10, 100, 1000 }, false, &BenchWidgetClassification },
+        { TEXT("HelperTick"), { 1, 100 }, true, &BenchHelperTick },
+    };
+    return Cases;
+}
+
+static const FWindowBenchmarkCase* FindBenchmarkCase(const FString& CaseName)
+{
+    return GetBenchmarkCases().FindByPredicate([&CaseName](const FWindowBenchmarkCase& Case) { return CaseName == Case.Name; });
+}
+
+TArray<FString> FWindowTransparencyBenchmarks::GetCaseNames()
+{
+    TArray<FString> Names;
+    for (const FWindowBenchmarkCase& Case : GetBenchmarkCases())
+    {
+        Names.Add(Case.Name);
+    }
+    return Names;
+}
+
+bool FWindowTransparencyBenchmarks::NeedsWorld(const FString& CaseName)
+{
+    const FWindowBenchmarkCase* Case = FindBenchmarkCase(CaseName);
+    return Case && Case->bNeedsWorld;
+}
+
+bool FWindowTransparencyBenchmarks::RunCase(const FString& CaseName, int32 Iterations, UWorld* World, TArray<FWindowBenchmarkResult>& OutResults, double& InOutChecksum)
+{
+    const FWindowBenchmarkCase* Case = FindBenchmarkCase(CaseName);
+    if (!Case || (Case->bNeedsWorld && !CanRunWorldBenchmarks(World)))
+    {
+        return false;
+    }
+
+    UWorld* CaseWorld = Case->bNeedsWorld ? World : nullptr;
+    for (const int32 Size : Case->Sizes)
+    {
+        // 大きいサイズは反復回数を減らして実行時間を揃える
+        const int32 CaseIterations = FMath::Max(1, Iterations * 100 / FMath::Max(100, Size));
+        double WarmupChecksum = 0.0;
+        Case->Kernel(CaseWorld, Size, 1, WarmupChecksum);
+
+        const double Seconds = Case->Kernel(CaseWorld, Size, CaseIterations, InOutChecksum);
+
+        FWindowBenchmarkResult& Result = OutResults.AddDefaulted_GetRef();
+        Result.Name = Case->Name;
+        Result.Size = Size;
+        Result.Iterations = CaseIterations;
+        Result.MillisecondsPerIteration = Seconds * 1000.0 / CaseIterations;
+        Result.ItemsPerSecond = static_cast<double>(Size) * CaseIterations / FMath::Max(Seconds, UE_DOUBLE_SMALL_NUMBER);
+    }
+    return true;
+}
+
+FString FWindowTransparencyBenchmarks::GetDefaultDirectory()
+{
+    return FPaths::Combine(FPaths::ProfilingDir(), TEXT("WindowTransparency"));
+}
+
+FString FWindowTransparencyBenchmarks::GetDefaultBaselinePath()
+{
+    return FPaths::Combine(GetDefaultDirectory(), TEXT("Baseline.json"));
+}
+
+bool FWindowTransparencyBenchmarks::SaveResults(const TArray<FWindowBenchmarkResult>& Results, const FString& FilePath)
+{
+    TArray<TSharedPtr<FJsonValue>> ResultValues;
+    for (const FWindowBenchmarkResult& Result : Results)
+    {
+        TSharedRef<FJsonObject> ResultObject = MakeShared<FJsonObject>();
+        ResultObject->SetStringField(TEXT("name"), Result.Name);
+        ResultObject->SetNumberField(TEXT("size"), Result.Size);
+        ResultObject->SetNumberField(TEXT("iterations"), Result.Iterations);
+        ResultObject->SetNumberField(TEXT("ms_per_iteration"), Result.MillisecondsPerIteration);
+        ResultObject->SetNumberField(TEXT("items_per_second"), Result.ItemsPerSecond);
+        ResultValues.Add(MakeShared<FJsonValueObject>(ResultObject));
+    }
+
+    TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+    Root->SetStringField(TEXT("timestamp"), FDateTime::UtcNow().ToIso8601());
+    Root->SetStringField(TEXT("platform"), FPlatformProperties::IniPlatformName());
+    Root->SetArrayField(TEXT("results"), ResultValues);
+
+    FString JsonText;
+    const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonText);
+    FJsonSerializer::Serialize(Root, Writer);
+    return FFileHelper::SaveStringToFile(JsonText, *FilePath);
+}
+
+bool FWindowTransparencyBenchmarks::LoadBaseline(const FString& FilePath, TMap<FString, double>& OutMillisecondsByKey)
+{
+    FString JsonText;
+    if (!FFileHelper::LoadFileToString(JsonText, *FilePath))
+    {
+        return false;
+    }
+
+    TSharedPtr<FJsonObject> Root;
+    if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(JsonText), Root) || !Root.IsValid())
+    {
+        UE_LOG(LogWindowBenchmark, Warning, TEXT("Failed to parse benchmark baseline '%s'."), *FilePath);
+        return false;
+    }
+
+    const TArray<TSharedPtr<FJsonValue>>* ResultValues = nullptr;
+    if (!Root->TryGetArrayField(TEXT("results"), ResultValues))
+    {
+        return false;
+    }
+    for (const TSharedPtr<FJsonValue>& Value : *ResultValues)
+    {
+        const TSharedPtr<FJsonObject> ResultObject = Value->AsObject();
+        if (ResultObject.IsValid())
+        {
+            const FString Key = FString::Printf(TEXT("%s/%d"), *ResultObject->GetStringField(TEXT("name")), static_cast<int32>(ResultObject->GetNumberField(TEXT("size"))));
+            OutMillisecondsByKey.Add(Key, ResultObject->GetNumberField(TEXT("ms_per_iteration")));
+        }
+    }
+    return true;
+}
+
+bool FWindowTransparencyBenchmarks::GetBaselineDelta(const FWindowBenchmarkResult& Result, const TMap<FString, double>& Baseline, double& OutDeltaPercent)
+{
+    const double* BaselineMs = Baseline.Find(Result.GetKey());
+    if (!BaselineMs)
+    {
+        OutDeltaPercent = 0.0;
+        return false;
+    }
+    OutDeltaPercent = *BaselineMs > 0.0 ? (Result.MillisecondsPerIteration / *BaselineMs - 1.0) * 100.0 : 0.0;
+    return true;
+}
+
+/**
+ * Runs every benchmark case and writes the results as JSON to Saved/Profiling/WindowTransparency.
+ * Usage: wt.Bench.Run [Iterations] [-filter=Name] [-baseline=Path] [-tolerance=Percent] [-writebaseline] [-exit]
+ * Headless: UnrealEditor-Cmd <Project> <Map> -game -nullrhi -unattended -ExecCmds="wt.Bench.Run -exit"
+ * With -exit the process exits with a non-zero code when any case is slower than the baseline by more than the tolerance.
+ * The same cases run as the WindowTransparency.Perf.* automation tests.
+ */
+static void RunBenchmarkSuite(const TArray<FString>& Args, UWorld* World)
+{
+    const FString ArgString = FString::Join(Args, TEXT(" "));
+    const int32 Iterations = (Args.Num() > 0 && Args[0].IsNumeric()) ? FMath::Max(1, FCString::Atoi(*Args[0])) : FWindowTransparencyBenchmarks::DefaultIterations;
+
+    FString Filter;
+    FParse::Value(*ArgString, TEXT("-filter="), Filter);
+    FString BaselinePath = FWindowTransparencyBenchmarks::GetDefaultBaselinePath();
+    FParse::Value(*ArgString, TEXT("-baseline="), BaselinePath);
+    float TolerancePercent = FWindowTransparencyBenchmarks::DefaultTolerancePercent;
+    FParse::Value(*ArgString, TEXT("-tolerance="), TolerancePercent);
+    const bool bWriteBaseline = FParse::Param(*ArgString, TEXT("writebaseline"));
+    const bool bExitWhenDone = FParse::Param(*ArgString, TEXT("exit"));
+
+    const bool bHasWorld = CanRunWorldBenchmarks(World);
+
+    TArray<FWindowBenchmarkResult> Results;
+    double Checksum = 0.0;
+    for (const FString& CaseName : FWindowTransparencyBenchmarks::GetCaseNames())
+    {
+        if (!Filter.IsEmpty() && !CaseName.Contains(Filter))
+        {
+            continue;
+        }
+        if (FWindowTransparencyBenchmarks::NeedsWorld(CaseName) && !bHasWorld)
+        {
+            UE_LOG(LogWindowBenchmark, Display, TEXT("Skipping %s: no game world has begun play."), *CaseName);
+            continue;
+        }
+        FWindowTransparencyBenchmarks::RunCase(CaseName, Iterations, World, Results, Checksum);
+    }
+
+    const FString OutputPath = FPaths::Combine(FWindowTransparencyBenchmarks::GetDefaultDirectory(), FString::Printf(TEXT("Bench-%s.json"), *FDateTime::Now().ToString()));
+    FWindowTransparencyBenchmarks::SaveResults(Results, OutputPath);
+    if (bWriteBaseline)
+    {
+        FWindowTransparencyBenchmarks::SaveResults(Results, BaselinePath);
+    }
+
+    TMap<FString, double> Baseline;
+    const bool bHasBaseline = !bWriteBaseline && FWindowTransparencyBenchmarks::LoadBaseline(BaselinePath, Baseline);
+
+    int32 RegressionCount = 0;
+    UE_LOG(LogWindowBenchmark, Display, TEXT("wt.Bench.Run: %d results (checksum %.3f) -> %s"), Results.Num(), Checksum, *OutputPath);
+    for (const FWindowBenchmarkResult& Result : Results)
+    {
+        double DeltaPercent = 0.0;
+        const bool bInBaseline = bHasBaseline && FWindowTransparencyBenchmarks::GetBaselineDelta(Result, Baseline, DeltaPercent);
+        const bool bRegressed = bInBaseline && DeltaPercent > TolerancePercent;
+        RegressionCount += bRegressed ? 1 : 0;
+
+        UE_LOG(LogWindowBenchmark, Display, TEXT("  %-28s %10.4f ms/iter %14.0f items/sec %s"),
+            *Result.GetKey(), Result.MillisecondsPerIteration, Result.ItemsPerSecond,
+            bInBaseline ? *FString::Printf(TEXT("(%+.1f%% vs baseline%s)"), DeltaPercent, bRegressed ? TEXT(", REGRESSION") : TEXT("")) : TEXT(""));
+    }
+
+    if (RegressionCount > 0)
+    {
+        UE_LOG(LogWindowBenchmark, Error, TEXT("wt.Bench.Run: %d case(s) regressed more than %.1f%% against %s"), RegressionCount, TolerancePercent, *BaselinePath);
+    }
+
+    if (bExitWhenDone)
+    {
+        FPlatformMisc::RequestExitWithStatus(false, RegressionCount > 0 ? 1 : 0);
+    }
+}
+
+static FAutoConsoleCommandWithWorldAndArgs BenchmarkSuiteCommand(
+    TEXT("wt.Bench.Run"),
+    TEXT("Runs the WindowTransparency benchmark suite, writes JSON results and compares them against a baseline. Usage: wt.Bench.Run [Iterations] [-filter=Name] [-baseline=Path] [-tolerance=Percent] [-writebaseline] [-exit]"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RunBenchmarkSuite));
+
+#endif // !UE_BUILD_SHIPPING
@@ -0,0 +1,49 @@
+﻿// WindowTransparencyBenchmarks.h
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if !UE_BUILD_SHIPPING
+
+class UWorld;
+
+struct FWindowBenchmarkResult
+{
+    FString Name;
+    int32 Size = 0;
+    int32 Iterations = 0;
+    double MillisecondsPerIteration = 0.0;
+    double ItemsPerSecond = 0.0;
+
+    FString GetKey() const { return FString::Printf(TEXT("%s/%d"), *Name, Size); }
+};
+
+// wt.Bench.Run と自動テスト（WindowTransparency.Perf.*）が共有するベンチマークスイート
+struct FWindowTransparencyBenchmarks
+{
+    static constexpr int32 DefaultIterations = 20;
+    static constexpr float DefaultTolerancePercent = 10.0f;
+
+    static TArray<FString> GetCaseNames();
+
+    /** True if the case spawns a component and needs a game world that has begun play. */
+    static bool NeedsWorld(const FString& CaseName);
+
+    /**
+     * Runs the case at each of its sizes after one warm-up run and appends a result per size. Larger sizes run fewer
+     * iterations so every size takes about as long. False if the case is unknown, or needs a world and World cannot be used.
+     */
+    static bool RunCase(const FString& CaseName, int32 Iterations, UWorld* World, TArray<FWindowBenchmarkResult>& OutResults, double& InOutChecksum);
+
+    /** Saved/Profiling/WindowTransparency. Results are written here and the baseline is read from here by default. */
+    static FString GetDefaultDirectory();
+    static FString GetDefaultBaselinePath();
+
+    static bool SaveResults(const TArray<FWindowBenchmarkResult>& Results, const FString& FilePath);
+    static bool LoadBaseline(const FString& FilePath, TMap<FString, double>& OutMillisecondsByKey);
+
+    /** Percent by which Result is slower than its baseline entry (negative if faster). False if the baseline has no entry for it. */
+    static bool GetBaselineDelta(const FWindowBenchmarkResult& Result, const TMap<FString, double>& Baseline, double& OutDeltaPercent);
+};
+
+#endif // !UE_BUILD_SHIPPING
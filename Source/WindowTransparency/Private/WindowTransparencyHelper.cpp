@@ -5,6 +5,7 @@
 #include "Engine/GameViewportClient.h"
 #include "Framework/Application/SlateApplication.h"
 #include "Widgets/SWindow.h"
+#include "Widgets/SViewport.h"
 #include "Engine/World.h"
 #include "GameFramework/PlayerController.h"
 #include "Components/PrimitiveComponent.h"
@@ -12,14 +13,528 @@
 #include "Engine/LocalPlayer.h"
 #include "Layout/WidgetPath.h"
 #include "GameFramework/Actor.h"
+#include "SceneView.h"
+#include "EngineUtils.h"
+#include "WindowTransparencyStats.h"
+#include "WindowTransparencyTrace.h"
+#include "WindowTransparency.h"
+#include "HAL/IConsoleManager.h"
+#include "WindowTransparencyOSBackend.h"
+#include "WindowTransparencyOSTypes.h"
+#include "WindowHitTestStrategy.h"
+#include "Algo/StableSort.h"
+#include "WindowClickThroughThread.h"
+#include "WindowStencilPickExtension.h"
+#include "WindowPixelAlphaProbeExtension.h"
+#include "WindowAutoFitExtension.h"
+#include "WindowRawInputThread.h"
+#include "WindowTransparencyKernels.h"
+#include "UnrealClient.h"
+#include "Misc/App.h"
+#include "Misc/ScopeExit.h"
+#include "Async/Async.h"
+#include "Tasks/Task.h"
+#if PLATFORM_WINDOWS
+#include "Windows/WindowsApplication.h"
+#endif
 
+using namespace WindowTransparencyOS;
 
 DEFINE_LOG_CATEGORY_STATIC(LogWindowHelper, Log, All);
 
+// ---------------------------------------------------------------------------
+// コンソール変数（実行中に変更するとすぐに反映される）
+// ---------------------------------------------------------------------------
+
+static int32 GWindowHitTestEnabled = -1;
+static FAutoConsoleVariableRef CVarWindowHitTestEnabled(
+    TEXT("wt.HitTest.Enabled"),
+    GWindowHitTestEnabled,
+    TEXT("Enables (1) or disables (0) automatic hit testing. -1 leaves the value set from Blueprint unchanged."),
+    FConsoleVariableDelegate::CreateLambda([](IConsoleVariable* Var)
+    {
+        UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+        if (Helper && GWindowHitTestEnabled >= 0)
+        {
+            Helper->SetHitTestEnabled(GWindowHitTestEnabled != 0);
+        }
+    }),
+    ECVF_Default);
+
+static int32 GWindowHitTestMode = -1;
+static FAutoConsoleVariableRef CVarWindowHitTestMode(
+    TEXT("wt.HitTest.Mode"),
+    GWindowHitTestMode,
+    TEXT("Hit test type: 0 = None, 1 = GameRaycast, 2 = RegisteredTargets, 3 = CustomPipeline, 4 = StencilPick. -1 leaves the value set from Blueprint unchanged."),
+    FConsoleVariableDelegate::CreateLambda([](IConsoleVariable* Var)
+    {
+        UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+        const UEnum* HitTestEnum = StaticEnum<EWindowHitTestType>();
+        if (Helper && GWindowHitTestMode >= 0 && HitTestEnum && HitTestEnum->IsValidEnumValue(GWindowHitTestMode))
+        {
+            Helper->SetHitTestType(static_cast<EWindowHitTestType>(GWindowHitTestMode));
+        }
+    }),
+    ECVF_Default);
+
+static int32 GWindowHitTestTraceChannel = -1;
+static FAutoConsoleVariableRef CVarWindowHitTestTraceChannel(
+    TEXT("wt.HitTest.TraceChannel"),
+    GWindowHitTestTraceChannel,
+    TEXT("ECollisionChannel used by GameRaycast hit testing (e.g. 0 = WorldStatic, 1 = WorldDynamic, 2 = Pawn, 3 = Visibility). -1 leaves the value set from Blueprint unchanged."),
+    FConsoleVariableDelegate::CreateLambda([](IConsoleVariable* Var)
+    {
+        UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+        if (Helper && GWindowHitTestTraceChannel >= 0 && GWindowHitTestTraceChannel < ECC_MAX)
+        {
+            Helper->SetGameRaycastTraceChannel(static_cast<ECollisionChannel>(GWindowHitTestTraceChannel));
+        }
+    }),
+    ECVF_Default);
+
+static bool GWindowHitTestTraceComplex = true;
+static FAutoConsoleVariableRef CVarWindowHitTestTraceComplex(
+    TEXT("wt.HitTest.TraceComplex"),
+    GWindowHitTestTraceComplex,
+    TEXT("If true, GameRaycast traces against complex (per-triangle) collision; if false, against simple collision, which is cheaper."),
+    ECVF_Default);
+
+static bool GWindowHitTestBroadPhase = true;
+static FAutoConsoleVariableRef CVarWindowHitTestBroadPhase(
+    TEXT("wt.HitTest.BroadPhase"),
+    GWindowHitTestBroadPhase,
+    TEXT("If true, GameRaycast first tests the cursor against the screen-space bounds of blocking actors and hit-testable widgets, and only traces when it falls inside one."),
+    ECVF_Default);
+
+static bool GWindowHitTestWidgetCache = true;
+static FAutoConsoleVariableRef CVarWindowHitTestWidgetCache(
+    TEXT("wt.HitTest.WidgetCache"),
+    GWindowHitTestWidgetCache,
+    TEXT("If true, the UI hit test uses a cached flat list of widget rects instead of calling LocateWindowUnderMouse every tick."),
+    ECVF_Default);
+
+static float GWindowHitTestWidgetCacheMaxAge = 0.0f;
+static FAutoConsoleVariableRef CVarWindowHitTestWidgetCacheMaxAge(
+    TEXT("wt.HitTest.WidgetCacheMaxAge"),
+    GWindowHitTestWidgetCacheMaxAge,
+    TEXT("Seconds after which the widget rect cache is rebuilt even without an invalidation. Off (0) by default: a rebuild walks the whole Slate tree of the game window, ")
+    TEXT("and the cache is already rebuilt when a widget it walked is added, removed, shown, hidden, moved or resized, on a Slate invalidate-all, on a viewport move or resize, ")
+    TEXT("and when Invalidate Widget Hit Cache is called."),
+    ECVF_Default);
+
+static int32 GWindowStencilPickOpaqueMask = 0;
+static FAutoConsoleVariableRef CVarWindowStencilPickOpaqueMask(
+    TEXT("wt.StencilPick.OpaqueMask"),
+    GWindowStencilPickOpaqueMask,
+    TEXT("CustomStencil bits that make a pixel opaque for Stencil Pick even when no actor is registered with that value. ")
+    TEXT("0 (default) only treats values registered with Register Stencil Actor as opaque, so stencil values written for other effects (outlines, masks) do not block clicks. ")
+    TEXT("255 treats any non-zero value as opaque."),
+    ECVF_Default);
+
+static float GWindowHitTestRate = 0.0f;
+static FAutoConsoleVariableRef CVarWindowHitTestRate(
+    TEXT("wt.HitTest.Rate"),
+    GWindowHitTestRate,
+    TEXT("Maximum hit tests per second. 0 runs a hit test every tick."),
+    ECVF_Default);
+
+static float GWindowHitTestHysteresisMs = 0.0f;
+static FAutoConsoleVariableRef CVarWindowHitTestHysteresis(
+    TEXT("wt.HitTest.Hysteresis"),
+    GWindowHitTestHysteresisMs,
+    TEXT("Milliseconds a new hit test result must persist before the opaque/transparent state switches. 0 switches immediately."),
+    ECVF_Default);
+
+static int32 GWindowHitTestPredict = -1;
+static float GWindowHitTestPredictHorizonMs = 50.0f;
+static FAutoConsoleVariableRef CVarWindowHitTestPredict(
+    TEXT("wt.HitTest.Predict"),
+    GWindowHitTestPredict,
+    TEXT("1 extrapolates the cursor up to wt.HitTest.PredictHorizonMs ahead and switches to opaque when the predicted path enters content. -1 leaves the value set from Blueprint unchanged."),
+    FConsoleVariableDelegate::CreateLambda([](IConsoleVariable* Var)
+    {
+        UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+        if (Helper && GWindowHitTestPredict >= 0)
+        {
+            Helper->SetCursorPrediction(GWindowHitTestPredict != 0, GWindowHitTestPredictHorizonMs);
+        }
+    }),
+    ECVF_Default);
+
+static FAutoConsoleVariableRef CVarWindowHitTestPredictHorizonMs(
+    TEXT("wt.HitTest.PredictHorizonMs"),
+    GWindowHitTestPredictHorizonMs,
+    TEXT("Maximum time in milliseconds the cursor is extrapolated ahead. The actual horizon is the last cursor sample interval, capped by this."),
+    FConsoleVariableDelegate::CreateLambda([](IConsoleVariable* Var)
+    {
+        UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+        if (Helper && Helper->IsCursorPredictionEnabled())
+        {
+            Helper->SetCursorPrediction(true, GWindowHitTestPredictHorizonMs);
+        }
+    }),
+    ECVF_Default);
+
+static float GWindowInputThreadRate = 240.0f;
+static int32 GWindowInputThread = -1;
+static FAutoConsoleVariableRef CVarWindowInputThread(
+    TEXT("wt.InputThread"),
+    GWindowInputThread,
+    TEXT("1 applies click-through from a dedicated input thread at wt.InputThread.Rate, 0 applies it from the game thread tick. -1 leaves the value set from Blueprint unchanged."),
+    FConsoleVariableDelegate::CreateLambda([](IConsoleVariable* Var)
+    {
+        UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+        if (Helper && GWindowInputThread >= 0)
+        {
+            Helper->SetInputThreadEnabled(GWindowInputThread != 0, GWindowInputThreadRate);
+        }
+    }),
+    ECVF_Default);
+
+static FAutoConsoleVariableRef CVarWindowInputThreadRate(
+    TEXT("wt.InputThread.Rate"),
+    GWindowInputThreadRate,
+    TEXT("Click-through decisions per second made by the input thread."),
+    FConsoleVariableDelegate::CreateLambda([](IConsoleVariable* Var)
+    {
+        UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+        if (Helper && Helper->IsInputThreadRunning())
+        {
+            Helper->SetInputThreadEnabled(true, GWindowInputThreadRate);
+        }
+    }),
+    ECVF_Default);
+
+static int32 GWindowAutoFit = -1;
+static float GWindowAutoFitMargin = 32.0f;
+static FAutoConsoleVariableRef CVarWindowAutoFit(
+    TEXT("wt.AutoFit"),
+    GWindowAutoFit,
+    TEXT("1 fits the game window to the screen bounds of the 3D content while DWM transparency is active, 0 keeps the full window. -1 leaves the value set from Blueprint unchanged."),
+    FConsoleVariableDelegate::CreateLambda([](IConsoleVariable* Var)
+    {
+        UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+        if (Helper && GWindowAutoFit >= 0)
+        {
+            Helper->SetAutoFitToContent(GWindowAutoFit != 0, GWindowAutoFitMargin);
+        }
+    }),
+    ECVF_Default);
+
+static FAutoConsoleVariableRef CVarWindowAutoFitMargin(
+    TEXT("wt.AutoFit.Margin"),
+    GWindowAutoFitMargin,
+    TEXT("Pixels kept around the content when the window is fitted to it."),
+    FConsoleVariableDelegate::CreateLambda([](IConsoleVariable* Var)
+    {
+        UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+        if (Helper && Helper->IsAutoFitToContentEnabled())
+        {
+            Helper->SetAutoFitToContent(true, GWindowAutoFitMargin);
+        }
+    }),
+    ECVF_Default);
+
+static int32 GWindowIdleThrottle = -1;
+static float GWindowIdleFPS = 5.0f;
+static int32 GWindowIdleSuspendRendering = 0;
+static FAutoConsoleVariableRef CVarWindowIdleThrottle(
+    TEXT("wt.Idle"),
+    GWindowIdleThrottle,
+    TEXT("1 drops to wt.Idle.FPS while no opaque content is on screen, 0 always renders at the normal rate. -1 leaves the value set from Blueprint unchanged."),
+    FConsoleVariableDelegate::CreateLambda([](IConsoleVariable* Var)
+    {
+        UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+        if (Helper && GWindowIdleThrottle >= 0)
+        {
+            Helper->SetIdleThrottle(GWindowIdleThrottle != 0, GWindowIdleFPS, GWindowIdleSuspendRendering != 0);
+        }
+    }),
+    ECVF_Default);
+
+static FAutoConsoleVariableRef CVarWindowIdleFPS(
+    TEXT("wt.Idle.FPS"),
+    GWindowIdleFPS,
+    TEXT("Frame rate cap while idle. 0 leaves the frame rate unchanged."),
+    FConsoleVariableDelegate::CreateLambda([](IConsoleVariable* Var)
+    {
+        UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+        if (Helper && Helper->IsIdleThrottleEnabled())
+        {
+            Helper->SetIdleThrottle(true, GWindowIdleFPS, GWindowIdleSuspendRendering != 0);
+        }
+    }),
+    ECVF_Default);
+
+static FAutoConsoleVariableRef CVarWindowIdleSuspendRendering(
+    TEXT("wt.Idle.SuspendRendering"),
+    GWindowIdleSuspendRendering,
+    TEXT("1 also stops drawing the game viewport while idle, keeping its last transparent frame."),
+    FConsoleVariableDelegate::CreateLambda([](IConsoleVariable* Var)
+    {
+        UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+        if (Helper && Helper->IsIdleThrottleEnabled())
+        {
+            Helper->SetIdleThrottle(true, GWindowIdleFPS, GWindowIdleSuspendRendering != 0);
+        }
+    }),
+    ECVF_Default);
+
+static int32 GWindowWallpaperGovernor = -1;
+static float GWindowWallpaperFPS = 30.0f;
+static float GWindowWallpaperOccludedFPS = 2.0f;
+static int32 GWindowWallpaperPauseWhenOccluded = 0;
+
+static void ApplyWallpaperGovernorCVarsTo(UWindowTransparencyHelper* Helper)
+{
+    if (Helper && (GWindowWallpaperGovernor > 0 || (GWindowWallpaperGovernor < 0 && Helper->IsWallpaperGovernorEnabled())))
+    {
+        Helper->SetWallpaperGovernor(true, GWindowWallpaperFPS, GWindowWallpaperOccludedFPS, GWindowWallpaperPauseWhenOccluded != 0);
+    }
+    else if (Helper && GWindowWallpaperGovernor == 0)
+    {
+        Helper->SetWallpaperGovernor(false);
+    }
+}
+
+static void ApplyWallpaperGovernorCVars(IConsoleVariable* Var)
+{
+    ApplyWallpaperGovernorCVarsTo(FWindowTransparencyModule::GetHelper());
+}
+
+static FAutoConsoleVariableRef CVarWindowWallpaperGovernor(
+    TEXT("wt.Wallpaper.Governor"),
+    GWindowWallpaperGovernor,
+    TEXT("1 caps the frame rate in desktop background mode and lowers it while other windows cover the desktop, 0 disables it. -1 leaves the value set from Blueprint unchanged."),
+    FConsoleVariableDelegate::CreateStatic(&ApplyWallpaperGovernorCVars),
+    ECVF_Default);
+
+static FAutoConsoleVariableRef CVarWindowWallpaperFPS(
+    TEXT("wt.Wallpaper.FPS"),
+    GWindowWallpaperFPS,
+    TEXT("Frame rate cap in desktop background mode while the desktop is visible. 0 leaves the engine cap unchanged."),
+    FConsoleVariableDelegate::CreateStatic(&ApplyWallpaperGovernorCVars),
+    ECVF_Default);
+
+static FAutoConsoleVariableRef CVarWindowWallpaperOccludedFPS(
+    TEXT("wt.Wallpaper.OccludedFPS"),
+    GWindowWallpaperOccludedFPS,
+    TEXT("Frame rate cap in desktop background mode while other windows cover the whole desktop."),
+    FConsoleVariableDelegate::CreateStatic(&ApplyWallpaperGovernorCVars),
+    ECVF_Default);
+
+static FAutoConsoleVariableRef CVarWindowWallpaperPauseWhenOccluded(
+    TEXT("wt.Wallpaper.PauseWhenOccluded"),
+    GWindowWallpaperPauseWhenOccluded,
+    TEXT("1 also stops drawing the viewport while the desktop is covered."),
+    FConsoleVariableDelegate::CreateStatic(&ApplyWallpaperGovernorCVars),
+    ECVF_Default);
+
+static int32 GWindowWallpaperMouseInput = -1;
+static FAutoConsoleVariableRef CVarWindowWallpaperMouseInput(
+    TEXT("wt.Wallpaper.MouseInput"),
+    GWindowWallpaperMouseInput,
+    TEXT("1 delivers mouse input over the desktop to wallpaper mouse event subscribers through a raw input thread, 0 disables it. -1 leaves the value set from Blueprint unchanged."),
+    FConsoleVariableDelegate::CreateLambda([](IConsoleVariable* Var)
+    {
+        UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+        if (Helper && GWindowWallpaperMouseInput >= 0)
+        {
+            Helper->SetWallpaperMouseInputEnabled(GWindowWallpaperMouseInput != 0);
+        }
+    }),
+    ECVF_Default);
+
+static float GWindowExternalWindowsSnapshotInterval = -1.0f;
+static FAutoConsoleVariableRef CVarWindowExternalWindowsSnapshotInterval(
+    TEXT("wt.ExternalWindows.SnapshotInterval"),
+    GWindowExternalWindowsSnapshotInterval,
+    TEXT("Seconds between external window enumerations while a component is bound to them. Negative uses the shortest interval the bound components request."),
+    FConsoleVariableDelegate::CreateLambda([](IConsoleVariable* Var)
+    {
+        if (UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper())
+        {
+            Helper->SetExternalWindowsSnapshotIntervalOverride(GWindowExternalWindowsSnapshotInterval);
+        }
+    }),
+    ECVF_Default);
+
+// コマンドラインや ini で設定されたコンソール変数はヘルパーの生成前に評価されるため、上のコールバックでは反映されない。
+// 初回の初期化時に、Blueprint の値を上書きする指定（-1 以外）をまとめて反映する
+#if PLATFORM_WINDOWS
+static void ApplyConsoleVariablesToHelper(UWindowTransparencyHelper* Helper)
+{
+    if (GWindowHitTestEnabled >= 0)
+    {
+        Helper->SetHitTestEnabled(GWindowHitTestEnabled != 0);
+    }
+    const UEnum* HitTestEnum = StaticEnum<EWindowHitTestType>();
+    if (GWindowHitTestMode >= 0 && HitTestEnum && HitTestEnum->IsValidEnumValue(GWindowHitTestMode))
+    {
+        Helper->SetHitTestType(static_cast<EWindowHitTestType>(GWindowHitTestMode));
+    }
+    if (GWindowHitTestTraceChannel >= 0 && GWindowHitTestTraceChannel < ECC_MAX)
+    {
+        Helper->SetGameRaycastTraceChannel(static_cast<ECollisionChannel>(GWindowHitTestTraceChannel));
+    }
+    if (GWindowHitTestPredict >= 0)
+    {
+        Helper->SetCursorPrediction(GWindowHitTestPredict != 0, GWindowHitTestPredictHorizonMs);
+    }
+    if (GWindowInputThread >= 0)
+    {
+        Helper->SetInputThreadEnabled(GWindowInputThread != 0, GWindowInputThreadRate);
+    }
+    if (GWindowAutoFit >= 0)
+    {
+        Helper->SetAutoFitToContent(GWindowAutoFit != 0, GWindowAutoFitMargin);
+    }
+    if (GWindowIdleThrottle >= 0)
+    {
+        Helper->SetIdleThrottle(GWindowIdleThrottle != 0, GWindowIdleFPS, GWindowIdleSuspendRendering != 0);
+    }
+    if (GWindowWallpaperGovernor >= 0)
+    {
+        ApplyWallpaperGovernorCVarsTo(Helper);
+    }
+    if (GWindowWallpaperMouseInput >= 0)
+    {
+        Helper->SetWallpaperMouseInputEnabled(GWindowWallpaperMouseInput != 0);
+    }
+    if (GWindowExternalWindowsSnapshotInterval >= 0.0f)
+    {
+        Helper->SetExternalWindowsSnapshotIntervalOverride(GWindowExternalWindowsSnapshotInterval);
+    }
+}
+#endif
+
 #if PLATFORM_WINDOWS
 #pragma comment(lib, "Dwmapi.lib") 
+
+// Explorer の再起動はトップレベルウィンドウへの TaskbarCreated のブロードキャストで分かる
+class FWindowTaskbarCreatedHandler : public IWindowsMessageHandler
+{
+public:
+    explicit FWindowTaskbarCreatedHandler(UWindowTransparencyHelper* InOwner)
+        : Owner(InOwner)
+        , TaskbarCreatedMessage(RegisterWindowMessageW(L"TaskbarCreated"))
+    {
+    }
+
+    virtual bool ProcessMessage(HWND Hwnd, uint32 Message, WPARAM WParam, LPARAM LParam, int32& OutResult) override
+    {
+        if (TaskbarCreatedMessage != 0 && Message == TaskbarCreatedMessage)
+        {
+            if (UWindowTransparencyHelper* Helper = Owner.Get())
+            {
+                Helper->HandleTaskbarCreated();
+            }
+        }
+        return false;
+    }
+
+private:
+    TWeakObjectPtr<UWindowTransparencyHelper> Owner;
+    UINT TaskbarCreatedMessage;
+};
+
+static FWindowsApplication* GetWindowsApplication()
+{
+    if (!FSlateApplication::IsInitialized())
+    {
+        return nullptr;
+    }
+    return static_cast<FWindowsApplication*>(FSlateApplication::Get().GetPlatformApplication().Get());
+}
+#endif
+
+// バウンドの8頂点を画面に投影した矩形。カメラの後ろに回り込む頂点があるときは、箱の辺を近平面で切った点を代わりに投影し、矩形はビューの範囲に収める。
+// 全体がカメラの後ろにあれば false
+static bool ProjectBoundsToScreen(const FBox& Bounds, const FIntRect& ViewRect, const FMatrix& ViewProjectionMatrix, FBox2D& OutScreenRect)
+{
+    constexpr double MinClipW = UE_KINDA_SMALL_NUMBER;
+    FVector4 ClipCorners[8];
+    for (int32 Corner = 0; Corner < 8; ++Corner)
+    {
+        const FVector CornerPosition(
+            (Corner & 1) ? Bounds.Max.X : Bounds.Min.X,
+            (Corner & 2) ? Bounds.Max.Y : Bounds.Min.Y,
+            (Corner & 4) ? Bounds.Max.Z : Bounds.Min.Z);
+        ClipCorners[Corner] = ViewProjectionMatrix.TransformFVector4(FVector4(CornerPosition, 1.0));
+    }
+
+    // FSceneView::ProjectWorldToScreen と同じ変換
+    OutScreenRect = FBox2D(ForceInit);
+    auto AddClipPoint = [&](const FVector4& Clip)
+    {
+        const double InvW = 1.0 / Clip.W;
+        OutScreenRect += FVector2D(
+            ViewRect.Min.X + (0.5 + Clip.X * InvW * 0.5) * ViewRect.Width(),
+            ViewRect.Min.Y + (0.5 - Clip.Y * InvW * 0.5) * ViewRect.Height());
+    };
+
+    bool bClipped = false;
+    for (int32 Corner = 0; Corner < 8; ++Corner)
+    {
+        const FVector4& Clip = ClipCorners[Corner];
+        if (Clip.W > MinClipW)
+        {
+            AddClipPoint(Clip);
+        }
+        // 近平面をまたぐ辺（1ビットだけ違う頂点の組）を切る
+        for (int32 Axis = 1; Axis < 8; Axis <<= 1)
+        {
+            if (Corner & Axis)
+            {
+                continue;
+            }
+            const FVector4& Other = ClipCorners[Corner | Axis];
+            if ((Clip.W > MinClipW) != (Other.W > MinClipW))
+            {
+                const double Alpha = (MinClipW - Clip.W) / (Other.W - Clip.W);
+                AddClipPoint(Clip + (Other - Clip) * Alpha);
+                bClipped = true;
+            }
+        }
+    }
+    if (!OutScreenRect.bIsValid)
+    {
+        return false;
+    }
+    if (bClipped)
+    {
+        OutScreenRect.Min = FVector2D::Max(OutScreenRect.Min, FVector2D(ViewRect.Min));
+        OutScreenRect.Max = FVector2D::Min(OutScreenRect.Max, FVector2D(ViewRect.Max));
+        OutScreenRect.bIsValid = OutScreenRect.Max.X >= OutScreenRect.Min.X && OutScreenRect.Max.Y >= OutScreenRect.Min.Y;
+    }
+    return OutScreenRect.bIsValid;
+}
+
+#if PLATFORM_WINDOWS
+static BOOL CALLBACK CollectMonitorWorkAreasProc(HMONITOR Monitor, HDC, LPRECT, LPARAM lParam)
+{
+    TArray<FIntRect>* WorkAreas = reinterpret_cast<TArray<FIntRect>*>(lParam);
+    MONITORINFO MonitorInfo;
+    MonitorInfo.cbSize = sizeof(MonitorInfo);
+    if (GetMonitorInfo(Monitor, &MonitorInfo))
+    {
+        WorkAreas->Emplace(MonitorInfo.rcWork.left, MonitorInfo.rcWork.top, MonitorInfo.rcWork.right, MonitorInfo.rcWork.bottom);
+    }
+    return TRUE;
+}
 #endif
 
+bool UWindowTransparencyHelper::GetPlayerProjectionData(APlayerController* PC, FSceneViewProjectionData& OutProjectionData) const
+{
+    ULocalPlayer* LocalPlayer = PC ? PC->GetLocalPlayer() : nullptr;
+    if (!LocalPlayer || !LocalPlayer->ViewportClient || !LocalPlayer->ViewportClient->Viewport)
+    {
+        return false;
+    }
+    // 自動フィット中の切り出しは、GetProjectionData がビュー拡張を通して描画と同じように適用する
+    return LocalPlayer->GetProjectionData(LocalPlayer->ViewportClient->Viewport, OutProjectionData);
+}
+
 static APlayerController* GetFirstLocalPlayerController(const UObject* WorldContextObject)
 {
     if (GEngine && GEngine->GameViewport)
@@ -44,7 +559,6 @@ UWindowTransparencyHelper::UWindowTransparencyHelper()
     , bIsClickThroughStateOS(false)
     , bIsTopmostActive(false)
     , bIsDWMTransparentActive(false)
-#if PLATFORM_WINDOWS
     , GameHWnd(nullptr)
     , OriginalWindowStyle(0)
     , OriginalExWindowStyle(0)
@@ -56,22 +570,215 @@ UWindowTransparencyHelper::UWindowTransparencyHelper()
     , TrueOriginalExWindowStyle(0)
     , bTrueOriginalStateStored(false)
     , CurrentWorkerW(nullptr)
+#if PLATFORM_WINDOWS
+    , OSBackend(MakeShared<FWindowTransparencyWin32Backend>())
 #endif
+    , CachedWorkerW(nullptr)
+    , bWorkerWDiscoveryInFlight(false)
+    , WorkerWDiscoveryGeneration(0)
+    , bDesktopBackgroundPending(false)
+    , TimeSinceWorkerWCheck(0.0f)
     , bHitTestingGloballyEnabled(false)
     , CurrentHitTestTypeLogic(EWindowHitTestType::None)
     , GameRaycastTraceChannelLogic(ECollisionChannel::ECC_Visibility)
     , bIsMouseOverOpaqueAreaLogic(true)
     , bCanHelperTick(false)
+    , bConsoleVariablesApplied(false)
+    , ExternalWindowsSnapshotInterval(0.1f)
+    , ExternalWindowsSnapshotIntervalOverride(-1.0f)
+    , TimeSinceExternalWindowsSnapshot(0.0f)
+    , LastCursorSampleTime(0.0)
+    , PreviousCursorSampleTime(0.0)
+    , PendingClickThroughChangeTime(-1.0)
+    , LastClickThroughFlipTime(-1.0)
+    , bLastDesiredClickThrough(false)
+    , ClickThroughFlipCount(0)
+    , ClickThroughRapidFlipCount(0)
+    , FlickerWindowMs(100.0f)
+    , TimeSinceHitTest(0.0f)
+    , PendingHitTestStateSince(-1.0)
+    , bPendingHitTestState(false)
+    , HitTestKernel(EWindowHitTestKernel::SinglePoint)
+    , HitTestCombineRule(EWindowHitTestCombineRule::Any)
+    , HitTestKernelRadius(2.0f)
+    , HitTestWeightedThreshold(0.5f)
+    , LastHitTestKernelSamplesTraced(0)
+    , bHitTestBroadPhaseCoversAll(false)
+    , HitTestBroadPhaseFrame(0)
+    , HitTestBroadPhaseTests(0)
+    , HitTestBroadPhaseRejects(0)
+    , bBroadPhasePrimitivesDirty(true)
+    , BroadPhasePrimitiveRebuildCount(0)
+    , BroadPhaseViewProjectionMatrix(FMatrix::Identity)
+    , BroadPhaseViewRect(0, 0, 0, 0)
+    , WidgetHitCacheViewportRect(ForceInit)
+    , WidgetHitCacheBuildTime(0.0)
+    , LastWidgetHitIndex(INDEX_NONE)
+    , WidgetHitCacheRebuildCount(0)
+    , bWidgetHitCacheDirty(true)
+    , WidgetHitCacheSignature(0)
+    , WidgetHitCacheCheckFrame(0)
+    , HitTestPipelineType(EWindowHitTestType::None)
+    , bHitTestPipelineUsesPhysics(false)
+    , bHitTestPipelineUsesTargets(false)
+    , bAutoOrderHitTestStrategies(false)
+    , HitTestMinConfidence(0.5f)
+    , HitTestPipelineRunsSinceSort(0)
+    , bHitTestPipelineUsesWidgets(false)
+    , bHitTestPipelineBoundedByRects(true)
+    , LastHitTestMousePos(FVector2D::ZeroVector)
+    , ClickThroughAppliedSerial(0)
+    , bCursorPredictionEnabled(false)
+    , CursorPredictionMaxHorizonMs(50.0f)
+    , CursorSampleCount(0)
+    , PendingPredictedPos(FVector2D::ZeroVector)
+    , PendingPredictionTime(-1.0)
+    , PredictedSwitchDeadline(-1.0)
+    , PredictedOpaqueUntil(-1.0)
+    , bEvaluatingPredictedCursor(false)
+    , CursorPredictionCount(0)
+    , CursorPredictionAccurateCount(0)
+    , CursorPredictionErrorSum(0.0)
+    , CursorPredictionErrorMax(0.0f)
+    , PredictedSwitchCount(0)
+    , CorrectPredictedSwitchCount(0)
+    , FalsePredictedSwitchCount(0)
+    , bHitTestPipelineUsesStencil(false)
+    , bLastStencilPickValid(false)
+    , bLastStencilPickOpaque(false)
+    , LastStencilPickValue(0)
+    , LastStencilPickPosition(FVector2D::ZeroVector)
+    , LastStencilPickTime(0.0)
+    , bHitTestPipelineUsesPixelAlpha(false)
+    , bLastPixelAlphaValid(false)
+    , LastPixelAlpha(0)
+    , LastPixelAlphaTime(0.0)
+    , bAutoFitEnabled(false)
+    , AutoFitMarginPixels(32.0f)
+    , AutoFitShrinkDelaySeconds(0.5f)
+    , AutoFitShrinkPendingSince(-1.0)
+    , TimeSinceAutoFit(0.0f)
+    , AutoFitResizeCount(0)
+    , bIdleThrottleEnabled(false)
+    , IdleFPS(5.0f)
+    , bIdleSuspendRendering(false)
+    , IdleDelaySeconds(0.5f)
+    , bIsIdle(false)
+    , bIdleMaxFPSApplied(false)
+    , bIdleRenderingSuspended(false)
+    , IdleSavedMaxFPS(0.0f)
+    , IdleNoContentSince(-1.0)
+    , IdleLastInteractionTime(0.0)
+    , IdleAccumulatedSeconds(0.0)
+    , ActiveAccumulatedSeconds(0.0)
+    , IdleEntryCount(0)
+    , TimeSinceIdleCheck(0.0f)
+    , bWallpaperGovernorEnabled(false)
+    , WallpaperFPS(30.0f)
+    , WallpaperOccludedFPS(2.0f)
+    , bWallpaperPauseWhenOccluded(false)
+    , bWallpaperGovernorActive(false)
+    , bWallpaperOccluded(false)
+    , bWallpaperRenderingPaused(false)
+    , WallpaperSavedMaxFPS(0.0f)
+    , WallpaperAppliedMaxFPS(0.0f)
+    , WallpaperVisibleFraction(1.0f)
+    , WallpaperVisibleSeconds(0.0)
+    , WallpaperOccludedSeconds(0.0)
+    , WallpaperOcclusionCount(0)
+    , bWallpaperMouseInputEnabled(true)
+    , WallpaperMouseBatchCount(0)
+    , WallpaperMouseEventCount(0)
 {
+    RebuildHitTestKernel();
 }
 
 UWindowTransparencyHelper::~UWindowTransparencyHelper()
 {
+#if PLATFORM_WINDOWS
+    FWindowsApplication* WindowsApplication = GetWindowsApplication();
+    if (TaskbarCreatedHandler.IsValid() && WindowsApplication)
+    {
+        WindowsApplication->RemoveMessageHandler(*TaskbarCreatedHandler);
+    }
+#endif
+}
+
+void UWindowTransparencyHelper::BeginDestroy()
+{
+    if (InvalidateAllWidgetsHandle.IsValid() && FSlateApplication::IsInitialized())
+    {
+        FSlateApplication::Get().OnInvalidateAllWidgets().Remove(InvalidateAllWidgetsHandle);
+    }
+    InvalidateAllWidgetsHandle.Reset();
+    UActorComponent::GlobalCreatePhysicsStateDelegate.Remove(CreatePhysicsStateHandle);
+    UActorComponent::GlobalDestroyPhysicsStateDelegate.Remove(DestroyPhysicsStateHandle);
+    CreatePhysicsStateHandle.Reset();
+    DestroyPhysicsStateHandle.Reset();
+    Super::BeginDestroy();
+}
+
+bool UWindowTransparencyHelper::HasOSBackend(const TCHAR* Caller) const
+{
+    if (!OSBackend.IsValid())
+    {
+        UE_LOG(LogWindowHelper, Log, TEXT("%s: Not supported on this platform."), Caller);
+        return false;
+    }
+    return true;
 }
 
+void UWindowTransparencyHelper::SetOSBackend(TSharedPtr<IWindowTransparencyOSBackend> InBackend)
+{
+    // 以前のバックエンドで取得したハンドルと状態はすべて破棄する
+    StopAutoFit(true);
+    ExitIdle(TEXT("backend changed"));
+    // 入力スレッドは以前のバックエンドを握っているので、新しいバックエンドで動かし直す
+    const float InputThreadRate = ClickThroughThread.IsValid() ? ClickThroughThread->GetRate() : 0.0f;
+    ClickThroughThread.Reset();
 #if PLATFORM_WINDOWS
+    OSBackend = InBackend.IsValid() ? InBackend : MakeShared<FWindowTransparencyWin32Backend>();
+    RawInputThread.Reset();
+#else
+    OSBackend = InBackend;
+#endif
+
+    GameHWnd = nullptr;
+    GameSWindowPtr.Reset();
+    CurrentWorkerW = nullptr;
+    CachedWorkerW = nullptr;
+    ++WorkerWDiscoveryGeneration;
+    bDesktopBackgroundPending = false;
+    DefaultParentHwnd = nullptr;
+    TrueOriginalParentHwnd = nullptr;
+    bOriginalStylesStored = false;
+    bTrueOriginalStateStored = false;
+    bIsDesktopBackgroundActive = false;
+    bIsInitialized = false;
+    bCanHelperTick = false;
+    bIsBorderlessActive = false;
+    bIsClickThroughStateOS = false;
+    bIsTopmostActive = false;
+    bIsDWMTransparentActive = false;
+    CompleteDesktopBackgroundRequests();
+    if (InputThreadRate > 0.0f)
+    {
+        SetInputThreadEnabled(true, InputThreadRate);
+    }
+}
+
 HWND UWindowTransparencyHelper::GetGameHWnd() const
 {
+    if (!OSBackend.IsValid())
+    {
+        return nullptr;
+    }
+    if (HWND OverrideHWnd = OSBackend->GetGameWindowOverride())
+    {
+        return OverrideHWnd;
+    }
+
+#if PLATFORM_WINDOWS
     if (GameSWindowPtr.IsValid()) {
         TSharedPtr<SWindow> StrongSWindow = GameSWindowPtr.Pin();
         if (StrongSWindow.IsValid() && StrongSWindow->GetNativeWindow().IsValid()) {
@@ -102,10 +809,12 @@ HWND UWindowTransparencyHelper::GetGameHWnd() const
             return static_cast<HWND>(Handle);
         }
     }
+#endif
     UE_LOG(LogWindowHelper, Warning, TEXT("GetGameHWnd: Could not retrieve HWND."));
     return nullptr;
 }
 
+#if PLATFORM_WINDOWS
 BOOL CALLBACK UWindowTransparencyHelper::EnumWindowsProc(HWND hwnd, LPARAM lParam)
 {
     EnumWindowsCallbackData* Data = reinterpret_cast<EnumWindowsCallbackData*>(lParam);
@@ -175,6 +884,27 @@ BOOL CALLBACK UWindowTransparencyHelper::EnumWindowsProc(HWND hwnd, LPARAM lPara
         {
             return true;
         }
+
+        // GetWindowRect は見えないリサイズ枠を含むので、見た目の枠は DWM から取る
+        RECT FrameRect;
+        if (SUCCEEDED(::DwmGetWindowAttribute(hwnd, DWMWA_EXTENDED_FRAME_BOUNDS, &FrameRect, sizeof(FrameRect))))
+        {
+            Info.FrameBounds = FIntRect(FrameRect.left, FrameRect.top, FrameRect.right, FrameRect.bottom);
+        }
+        else
+        {
+            Info.FrameBounds = FIntRect(Rect.left, Rect.top, Rect.right, Rect.bottom);
+        }
+
+        // クリックスルーや完全に透明なレイヤードウィンドウは後ろを隠さない
+        const LONG_PTR ExStyle = ::GetWindowLongPtr(hwnd, GWL_EXSTYLE);
+        Info.bSeeThrough = (ExStyle & WS_EX_TRANSPARENT) != 0;
+        if (!Info.bSeeThrough && (ExStyle & WS_EX_LAYERED))
+        {
+            BYTE Alpha = 255;
+            DWORD Flags = 0;
+            Info.bSeeThrough = ::GetLayeredWindowAttributes(hwnd, nullptr, &Alpha, &Flags) && (Flags & LWA_ALPHA) && Alpha == 0;
+        }
         Data->WindowsList->Add(Info);
     }
     return true;
@@ -182,6 +912,9 @@ BOOL CALLBACK UWindowTransparencyHelper::EnumWindowsProc(HWND hwnd, LPARAM lPara
 
 TArray<FOtherWindowInfo> UWindowTransparencyHelper::GetOtherWindowsInformation(bool& bSuccess)
 {
+    SCOPE_CYCLE_COUNTER(STAT_WindowTransparency_EnumerateWindows);
+    CSV_SCOPED_TIMING_STAT(WindowTransparency, EnumerateWindows);
+
     bSuccess = false;
     TArray<FOtherWindowInfo> WindowsList;
 
@@ -199,6 +932,8 @@ TArray<FOtherWindowInfo> UWindowTransparencyHelper::GetOtherWindowsInformation(b
     if (::EnumWindows(UWindowTransparencyHelper::EnumWindowsProc, reinterpret_cast<LPARAM>(&CallbackData)))
     {
         bSuccess = true;
+        INC_DWORD_STAT_BY(STAT_WindowTransparency_WindowsEnumerated, WindowsList.Num());
+        CSV_CUSTOM_STAT(WindowTransparency, WindowsEnumerated, WindowsList.Num(), ECsvCustomStatOp::Accumulate);
     }
     else
     {
@@ -208,12 +943,17 @@ TArray<FOtherWindowInfo> UWindowTransparencyHelper::GetOtherWindowsInformation(b
 
     return WindowsList;
 }
+#endif
 
 FOtherWindowInfo UWindowTransparencyHelper::GetCurrentWindowInfo(bool& bSuccess)
 {
     bSuccess = false;
     FOtherWindowInfo CurrentInfo;
 
+    if (!HasOSBackend(TEXT("GetCurrentWindowInfo")))
+    {
+        return CurrentInfo;
+    }
     ReInitializeIfNeeded();
     if (!IsInitialized() || !GameHWnd)
     {
@@ -222,7 +962,7 @@ FOtherWindowInfo UWindowTransparencyHelper::GetCurrentWindowInfo(bool& bSuccess)
     }
 
     RECT WindowRect;
-    if (::GetWindowRect(GameHWnd, &WindowRect))
+    if (OSBackend->GetWindowScreenRect(GameHWnd, WindowRect))
     {
         CurrentInfo.PosX = WindowRect.left;
         CurrentInfo.PosY = WindowRect.top;
@@ -233,22 +973,42 @@ FOtherWindowInfo UWindowTransparencyHelper::GetCurrentWindowInfo(bool& bSuccess)
     }
     else
     {
-        DWORD ErrorCode = GetLastError();
+        DWORD ErrorCode = OSBackend->GetLastErrorCode();
         UE_LOG(LogWindowHelper, Error, TEXT("GetCurrentWindowInfo: GetWindowRect failed for HWND %p. Error code: %u"), GameHWnd, ErrorCode);
     }
 
     return CurrentInfo;
 }
 
-#endif
+bool UWindowTransparencyHelper::GetClientScreenRect(FIntRect& OutRect)
+{
+    if (!OSBackend.IsValid())
+    {
+        return false;
+    }
+    ReInitializeIfNeeded();
+    if (!IsInitialized() || !GameHWnd)
+    {
+        return false;
+    }
+
+    POINT ClientOrigin;
+    RECT ClientRect;
+    if (!OSBackend->GetClientScreenOrigin(GameHWnd, ClientOrigin) || !OSBackend->GetClientAreaRect(GameHWnd, ClientRect))
+    {
+        UE_LOG(LogWindowHelper, Error, TEXT("GetClientScreenRect: Could not query the client area of HWND %p."), GameHWnd);
+        return false;
+    }
+    OutRect = FIntRect(ClientOrigin.x, ClientOrigin.y, ClientOrigin.x + (ClientRect.right - ClientRect.left), ClientOrigin.y + (ClientRect.bottom - ClientRect.top));
+    return true;
+}
 
 void UWindowTransparencyHelper::StoreOriginalWindowStyles()
 {
-#if PLATFORM_WINDOWS
-    if (GameHWnd && !bOriginalStylesStored)
+    if (GameHWnd && OSBackend.IsValid() && !bOriginalStylesStored)
     {
-        OriginalWindowStyle = GetWindowLongPtr(GameHWnd, GWL_STYLE);
-        OriginalExWindowStyle = GetWindowLongPtr(GameHWnd, GWL_EXSTYLE);
+        OriginalWindowStyle = OSBackend->GetWindowStyle(GameHWnd, GWL_STYLE);
+        OriginalExWindowStyle = OSBackend->GetWindowStyle(GameHWnd, GWL_EXSTYLE);
         bOriginalStylesStored = true;
         UE_LOG(LogWindowHelper, Log, TEXT("Stored current window styles. Style: 0x%p, ExStyle: 0x%p"), (void*)OriginalWindowStyle, (void*)OriginalExWindowStyle);
 
@@ -260,15 +1020,17 @@ void UWindowTransparencyHelper::StoreOriginalWindowStyles()
             UE_LOG(LogWindowHelper, Log, TEXT("Stored TRUE original window styles from current. Style: 0x%p, ExStyle: 0x%p"), (void*)TrueOriginalWindowStyle, (void*)TrueOriginalExWindowStyle);
         }
     }
-#endif
 }
 
 void UWindowTransparencyHelper::ReInitializeIfNeeded()
 {
-#if PLATFORM_WINDOWS
+    if (!OSBackend.IsValid())
+    {
+        return;
+    }
     if (bIsDesktopBackgroundActive)
     {
-        if (!GameHWnd || !IsWindow(GameHWnd))
+        if (!GameHWnd || !OSBackend->IsValidWindow(GameHWnd))
         {
             UE_LOG(LogWindowHelper, Error, TEXT("ReInitializeIfNeeded: GameHWnd (%p) became invalid during Desktop Background mode! Forcing mode disable and full re-init."), GameHWnd);
 
@@ -285,11 +1047,14 @@ void UWindowTransparencyHelper::ReInitializeIfNeeded()
     }
 
     bool bNeedsReinit = false;
-    if (!GameHWnd || (GameHWnd && !IsWindow(GameHWnd))) {
+    if (!GameHWnd || (GameHWnd && !OSBackend->IsValidWindow(GameHWnd))) {
         UE_LOG(LogWindowHelper, Log, TEXT("ReInitializeIfNeeded: GameHWnd %p is invalid or null."), GameHWnd);
         bNeedsReinit = true;
     }
-    if (!GameSWindowPtr.IsValid()) {
+    if (OSBackend->GetGameWindowOverride()) {
+        // バックエンドが指定したウィンドウを使うため、Slate側の確認は不要
+    }
+    else if (!GameSWindowPtr.IsValid()) {
         UE_LOG(LogWindowHelper, Log, TEXT("ReInitializeIfNeeded: GameSWindowPtr is invalid."));
         bNeedsReinit = true;
     }
@@ -311,13 +1076,17 @@ void UWindowTransparencyHelper::ReInitializeIfNeeded()
         bCanHelperTick = false;
         Initialize();
     }
-#endif
 }
 
 bool UWindowTransparencyHelper::Initialize()
 {
-#if PLATFORM_WINDOWS
-    if (bIsInitialized && GameHWnd && IsWindow(GameHWnd) && !bIsDesktopBackgroundActive)
+    if (!HasOSBackend(TEXT("Initialize")))
+    {
+        bIsInitialized = false;
+        bCanHelperTick = false;
+        return false;
+    }
+    if (bIsInitialized && OSBackend->IsValidWindow(GameHWnd) && !bIsDesktopBackgroundActive)
     {
         return true;
     }
@@ -334,9 +1103,9 @@ bool UWindowTransparencyHelper::Initialize()
 
         if (!bTrueOriginalStateStored)
         {
-            TrueOriginalWindowStyle = GetWindowLongPtr(GameHWnd, GWL_STYLE);
-            TrueOriginalExWindowStyle = GetWindowLongPtr(GameHWnd, GWL_EXSTYLE);
-            TrueOriginalParentHwnd = ::GetParent(GameHWnd);
+            TrueOriginalWindowStyle = OSBackend->GetWindowStyle(GameHWnd, GWL_STYLE);
+            TrueOriginalExWindowStyle = OSBackend->GetWindowStyle(GameHWnd, GWL_EXSTYLE);
+            TrueOriginalParentHwnd = OSBackend->GetParentWindow(GameHWnd);
             bTrueOriginalStateStored = true;
             UE_LOG(LogWindowHelper, Log, TEXT("Stored TRUE original state. Parent: %p, Style: 0x%p, ExStyle: 0x%p"),
                 TrueOriginalParentHwnd, (void*)TrueOriginalWindowStyle, (void*)TrueOriginalExWindowStyle);
@@ -348,17 +1117,31 @@ bool UWindowTransparencyHelper::Initialize()
         }
         else if (!bOriginalStylesStored && !bIsDesktopBackgroundActive)
         {
-            OriginalWindowStyle = GetWindowLongPtr(GameHWnd, GWL_STYLE);
-            OriginalExWindowStyle = GetWindowLongPtr(GameHWnd, GWL_EXSTYLE);
-            DefaultParentHwnd = ::GetParent(GameHWnd);
+            OriginalWindowStyle = OSBackend->GetWindowStyle(GameHWnd, GWL_STYLE);
+            OriginalExWindowStyle = OSBackend->GetWindowStyle(GameHWnd, GWL_EXSTYLE);
+            DefaultParentHwnd = OSBackend->GetParentWindow(GameHWnd);
             bOriginalStylesStored = true;
         }
 
-        LONG_PTR CurrentExStyle = GetWindowLongPtr(GameHWnd, GWL_EXSTYLE);
+        LONG_PTR CurrentExStyle = OSBackend->GetWindowStyle(GameHWnd, GWL_EXSTYLE);
         bIsClickThroughStateOS = (CurrentExStyle & WS_EX_TRANSPARENT) != 0;
         bCanHelperTick = true;
+
+#if PLATFORM_WINDOWS
+        FWindowsApplication* WindowsApplication = GetWindowsApplication();
+        if (!TaskbarCreatedHandler.IsValid() && WindowsApplication)
+        {
+            TaskbarCreatedHandler = MakeShared<FWindowTaskbarCreatedHandler>(this);
+            WindowsApplication->AddMessageHandler(*TaskbarCreatedHandler);
+        }
+        if (!bConsoleVariablesApplied)
+        {
+            bConsoleVariablesApplied = true;
+            ApplyConsoleVariablesToHelper(this);
+        }
+#endif
         UE_LOG(LogWindowHelper, Log, TEXT("WindowTransparencyHelper Initialized. GameHWnd: %p, GameSWindow valid: %s, Current Parent: %p."),
-            GameHWnd, GameSWindowPtr.IsValid() ? TEXT("true") : TEXT("false"), ::GetParent(GameHWnd));
+            GameHWnd, GameSWindowPtr.IsValid() ? TEXT("true") : TEXT("false"), OSBackend->GetParentWindow(GameHWnd));
         return true;
     }
     else
@@ -368,17 +1151,14 @@ bool UWindowTransparencyHelper::Initialize()
         UE_LOG(LogWindowHelper, Warning, TEXT("WindowTransparencyHelper: Could not get game HWND during Initialize."));
         return false;
     }
-#else
-    bIsInitialized = false;
-    bCanHelperTick = false;
-    UE_LOG(LogWindowHelper, Log, TEXT("WindowTransparencyHelper: Platform is not Windows. Initialize is a no-op."));
-    return false;
-#endif
 }
 
 void UWindowTransparencyHelper::SetDWMTransparency(bool bEnable)
 {
-#if PLATFORM_WINDOWS
+    if (!HasOSBackend(TEXT("SetDWMTransparency")))
+    {
+        return;
+    }
     ReInitializeIfNeeded();
     if (!IsInitialized() || !GameHWnd)
     {
@@ -389,55 +1169,55 @@ void UWindowTransparencyHelper::SetDWMTransparency(bool bEnable)
 
     ApplyDWMAlphaTransparency(bEnable);
     bIsDWMTransparentActive = bEnable;
-    InvalidateRect(GameHWnd, NULL, true);
-    UpdateWindow(GameHWnd);
+    OSBackend->RepaintWindow(GameHWnd);
     UE_LOG(LogWindowHelper, Log, TEXT("DWM Transparency set to: %s"), bEnable ? TEXT("true") : TEXT("false"));
-#else
-    UE_LOG(LogWindowHelper, Log, TEXT("SetDWMTransparency: Not supported on this platform."));
-#endif
 }
 
 void UWindowTransparencyHelper::ApplyDWMAlphaTransparency(bool bEnable)
 {
-#if PLATFORM_WINDOWS
-    if (!GameHWnd) return;
+    if (!GameHWnd || !OSBackend.IsValid()) return;
     MARGINS margins = bEnable ? MARGINS{ -1 } : MARGINS{ 0, 0, 0, 0 };
-    HRESULT hr = DwmExtendFrameIntoClientArea(GameHWnd, &margins);
+    HRESULT hr = OSBackend->ExtendFrameIntoClientArea(GameHWnd, margins);
     if (!SUCCEEDED(hr))
     {
         UE_LOG(LogWindowHelper, Error, TEXT("DwmExtendFrameIntoClientArea %s failed with HRESULT: 0x%08lX"), bEnable ? TEXT("enable") : TEXT("disable"), hr);
     }
-#endif
 }
 
 void UWindowTransparencyHelper::EnableBorderless(bool bEnable)
 {
-#if PLATFORM_WINDOWS
+    if (!HasOSBackend(TEXT("EnableBorderless")))
+    {
+        return;
+    }
     ReInitializeIfNeeded();
     if (!IsInitialized() || !GameHWnd || !bOriginalStylesStored)
     {
         UE_LOG(LogWindowHelper, Warning, TEXT("EnableBorderless: Not initialized, HWND is null, or original styles not stored."));
         return;
     }
-    LONG_PTR CurrentStyle = GetWindowLongPtr(GameHWnd, GWL_STYLE);
+    LONG_PTR CurrentStyle = OSBackend->GetWindowStyle(GameHWnd, GWL_STYLE);
     bool bIsCurrentlyBorderless = !(CurrentStyle & WS_CAPTION) && !(CurrentStyle & WS_THICKFRAME);
     if (bEnable == bIsBorderlessActive && bEnable == bIsCurrentlyBorderless) return;
 
     LONG_PTR NewStyle = bEnable ? ((OriginalWindowStyle & ~WS_OVERLAPPEDWINDOW) | WS_POPUP) : OriginalWindowStyle;
-    SetWindowLongPtr(GameHWnd, GWL_STYLE, NewStyle);
+    OSBackend->SetWindowStyle(GameHWnd, GWL_STYLE, NewStyle);
     bIsBorderlessActive = bEnable;
-    SetWindowPos(GameHWnd, NULL, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_FRAMECHANGED | SWP_NOACTIVATE);
-    InvalidateRect(GameHWnd, NULL, true);
-    UpdateWindow(GameHWnd);
+    OSBackend->SetWindowPosition(GameHWnd, NULL, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_FRAMECHANGED | SWP_NOACTIVATE);
+    OSBackend->RepaintWindow(GameHWnd);
     UE_LOG(LogWindowHelper, Log, TEXT("Borderless mode set to: %s"), bEnable ? TEXT("true") : TEXT("false"));
-#else
-    UE_LOG(LogWindowHelper, Log, TEXT("EnableBorderless: Not supported on this platform."));
-#endif
 }
 
 void UWindowTransparencyHelper::EnableClickThrough(bool bEnable)
 {
-#if PLATFORM_WINDOWS
+    WT_TRACE_SCOPE("WindowTransparency::EnableClickThrough");
+    if (!HasOSBackend(TEXT("EnableClickThrough")))
+    {
+        bIsClickThroughStateOS = false;
+        return;
+    }
+    // 直接の指定は入力スレッドの判定より優先する。次の Tick でまた判定材料が渡される
+    PublishClickThroughCoverage(false);
     ReInitializeIfNeeded();
     if (!IsInitialized() || !GameHWnd)
     {
@@ -446,7 +1226,7 @@ void UWindowTransparencyHelper::EnableClickThrough(bool bEnable)
         return;
     }
 
-    LONG_PTR CurrentExStyle = GetWindowLongPtr(GameHWnd, GWL_EXSTYLE);
+    LONG_PTR CurrentExStyle = OSBackend->GetWindowStyle(GameHWnd, GWL_EXSTYLE);
     bool bIsCurrentlyClickThroughOSLevel = (CurrentExStyle & WS_EX_TRANSPARENT) != 0;
 
     if (bIsClickThroughStateOS != bIsCurrentlyClickThroughOSLevel && bEnable != bIsCurrentlyClickThroughOSLevel) {
@@ -466,6 +1246,10 @@ void UWindowTransparencyHelper::EnableClickThrough(bool bEnable)
                 bEnable ? TEXT("true") : TEXT("false"));
         }
         bIsClickThroughStateOS = bEnable;
+        if (ClickThroughThread.IsValid())
+        {
+            ClickThroughThread->SyncClickThroughState(bEnable);
+        }
         return;
     }
 
@@ -496,9 +1280,10 @@ void UWindowTransparencyHelper::EnableClickThrough(bool bEnable)
 
     if (NewExStyle != CurrentExStyle)
     {
-        SetWindowLongPtr(GameHWnd, GWL_EXSTYLE, NewExStyle);
-        LONG_PTR StyleAfterSet = GetWindowLongPtr(GameHWnd, GWL_EXSTYLE);
+        OSBackend->SetWindowStyle(GameHWnd, GWL_EXSTYLE, NewExStyle);
+        LONG_PTR StyleAfterSet = OSBackend->GetWindowStyle(GameHWnd, GWL_EXSTYLE);
         bool bSetSuccessfully = (bEnable && (StyleAfterSet & WS_EX_TRANSPARENT)) || (!bEnable && !(StyleAfterSet & WS_EX_TRANSPARENT));
+        WT_TRACE_EVENT(OSStyleApplied, bEnable, static_cast<uint64>(CurrentExStyle), static_cast<uint64>(StyleAfterSet), bSetSuccessfully);
 
         UE_LOG(LogWindowHelper, Log, TEXT("EnableClickThrough: OS Click-Through set to %s. OldExStyle: 0x%p, Attempted NewExStyle: 0x%p, Actual StyleAfterSet: 0x%p. Success: %s"),
             bEnable ? TEXT("true") : TEXT("false"),
@@ -508,7 +1293,8 @@ void UWindowTransparencyHelper::EnableClickThrough(bool bEnable)
             bSetSuccessfully ? TEXT("Yes") : TEXT("No"));
 
         if (bSetSuccessfully) {
-            SetWindowPos(GameHWnd, NULL, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_FRAMECHANGED | SWP_NOACTIVATE);
+            RecordClickThroughFlip();
+            OSBackend->SetWindowPosition(GameHWnd, NULL, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_FRAMECHANGED | SWP_NOACTIVATE);
         }
         else {
             UE_LOG(LogWindowHelper, Error, TEXT("EnableClickThrough: Failed to apply desired ExStyle change!"));
@@ -520,54 +1306,58 @@ void UWindowTransparencyHelper::EnableClickThrough(bool bEnable)
             (void*)NewExStyle, (void*)CurrentExStyle, bEnable ? TEXT("true") : TEXT("false"), bIsCurrentlyClickThroughOSLevel ? TEXT("true") : TEXT("false"));
     }
     bIsClickThroughStateOS = bEnable;
-#else
-    bIsClickThroughStateOS = false;
-#endif
+    if (ClickThroughThread.IsValid())
+    {
+        ClickThroughThread->SyncClickThroughState(bEnable);
+    }
 }
 
 void UWindowTransparencyHelper::SetWindowTopmost(bool bTopmost)
 {
-#if PLATFORM_WINDOWS
+    if (!HasOSBackend(TEXT("SetWindowTopmost")))
+    {
+        return;
+    }
     ReInitializeIfNeeded();
     if (!IsInitialized() || !GameHWnd)
     {
         UE_LOG(LogWindowHelper, Warning, TEXT("SetWindowTopmost: Not initialized or HWND is null."));
         return;
     }
-    LONG_PTR CurrentExStyle = GetWindowLongPtr(GameHWnd, GWL_EXSTYLE);
+    LONG_PTR CurrentExStyle = OSBackend->GetWindowStyle(GameHWnd, GWL_EXSTYLE);
     bool bIsCurrentlyTopmostOS = (CurrentExStyle & WS_EX_TOPMOST) != 0;
     if (bTopmost == bIsTopmostActive && bTopmost == bIsCurrentlyTopmostOS) return;
 
     HWND HwndInsertAfter = bTopmost ? HWND_TOPMOST : HWND_NOTOPMOST;
-    SetWindowPos(GameHWnd, HwndInsertAfter, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
+    OSBackend->SetWindowPosition(GameHWnd, HwndInsertAfter, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
     bIsTopmostActive = bTopmost;
     UE_LOG(LogWindowHelper, Log, TEXT("Window topmost set to: %s"), bTopmost ? TEXT("true") : TEXT("false"));
-#else
-    UE_LOG(LogWindowHelper, Log, TEXT("SetWindowTopmost: Not supported on this platform."));
-#endif
 }
 
 FVector2D UWindowTransparencyHelper::GetMousePositionInWindow(bool& bSuccess)
 {
     bSuccess = false;
-#if PLATFORM_WINDOWS
+    if (!OSBackend.IsValid())
+    {
+        return FVector2D::ZeroVector;
+    }
     if (!GameHWnd && bIsInitialized) {
         GameHWnd = GetGameHWnd();
     }
     if (!GameHWnd) return FVector2D::ZeroVector;
 
     POINT CursorPosScreen;
-    if (::GetCursorPos(&CursorPosScreen))
+    if (OSBackend->GetCursorScreenPosition(CursorPosScreen))
     {
         RECT WindowRect;
-        if (::GetWindowRect(GameHWnd, &WindowRect))
+        if (OSBackend->GetWindowScreenRect(GameHWnd, WindowRect))
         {
             bSuccess = true;
             return FVector2D(static_cast<float>(CursorPosScreen.x - WindowRect.left), static_cast<float>(CursorPosScreen.y - WindowRect.top));
         }
         else
         {
-            DWORD ErrorCode = GetLastError();
+            DWORD ErrorCode = OSBackend->GetLastErrorCode();
             UE_LOG(LogWindowHelper, Error, TEXT("GetMousePositionInWindow: GetWindowRect failed for HWND %p. Error code: %u"), GameHWnd, ErrorCode);
             if (ErrorCode == ERROR_INVALID_WINDOW_HANDLE)
             {
@@ -578,15 +1368,20 @@ FVector2D UWindowTransparencyHelper::GetMousePositionInWindow(bool& bSuccess)
             }
         }
     }
-#endif
     return FVector2D::ZeroVector;
 }
 
 void UWindowTransparencyHelper::RestoreDefaultWindowSettings()
 {
-#if PLATFORM_WINDOWS
+    if (!HasOSBackend(TEXT("RestoreDefaultWindowSettings")))
+    {
+        return;
+    }
+    PublishClickThroughCoverage(false);
+    StopAutoFit(true);
+    ExitIdle(TEXT("window settings restored"));
     UE_LOG(LogWindowHelper, Log, TEXT("Attempting to restore default window settings..."));
-    if (!GameHWnd || !IsWindow(GameHWnd))
+    if (!GameHWnd || !OSBackend->IsValidWindow(GameHWnd))
     {
         UE_LOG(LogWindowHelper, Warning, TEXT("Cannot restore default settings: HWND is null or invalid."));
         bIsBorderlessActive = false;
@@ -602,9 +1397,9 @@ void UWindowTransparencyHelper::RestoreDefaultWindowSettings()
 
     if (bOriginalStylesStored)
     {
-        if (GetWindowLongPtr(GameHWnd, GWL_EXSTYLE) != OriginalExWindowStyle)
+        if (OSBackend->GetWindowStyle(GameHWnd, GWL_EXSTYLE) != OriginalExWindowStyle)
         {
-            SetWindowLongPtr(GameHWnd, GWL_EXSTYLE, OriginalExWindowStyle);
+            OSBackend->SetWindowStyle(GameHWnd, GWL_EXSTYLE, OriginalExWindowStyle);
             UE_LOG(LogWindowHelper, Log, TEXT("Restored OriginalExWindowStyle."));
             bRestoredSomething = true;
         }
@@ -613,17 +1408,17 @@ void UWindowTransparencyHelper::RestoreDefaultWindowSettings()
     {
         if (bIsClickThroughStateOS)
         {
-            LONG_PTR CurrentExStyle = GetWindowLongPtr(GameHWnd, GWL_EXSTYLE);
+            LONG_PTR CurrentExStyle = OSBackend->GetWindowStyle(GameHWnd, GWL_EXSTYLE);
             LONG_PTR NewExStyle = CurrentExStyle & ~(WS_EX_TRANSPARENT | WS_EX_LAYERED);
             if (NewExStyle != CurrentExStyle)
             {
-                SetWindowLongPtr(GameHWnd, GWL_EXSTYLE, NewExStyle);
+                OSBackend->SetWindowStyle(GameHWnd, GWL_EXSTYLE, NewExStyle);
                 UE_LOG(LogWindowHelper, Log, TEXT("Removed WS_EX_TRANSPARENT and WS_EX_LAYERED (no original style)."));
                 bRestoredSomething = true;
             }
         }
     }
-    bIsClickThroughStateOS = (GetWindowLongPtr(GameHWnd, GWL_EXSTYLE) & WS_EX_TRANSPARENT) != 0;
+    bIsClickThroughStateOS = (OSBackend->GetWindowStyle(GameHWnd, GWL_EXSTYLE) & WS_EX_TRANSPARENT) != 0;
 
 
     if (bIsDWMTransparentActive)
@@ -638,20 +1433,20 @@ void UWindowTransparencyHelper::RestoreDefaultWindowSettings()
     {
         if (bOriginalStylesStored)
         {
-            if (GetWindowLongPtr(GameHWnd, GWL_STYLE) != OriginalWindowStyle)
+            if (OSBackend->GetWindowStyle(GameHWnd, GWL_STYLE) != OriginalWindowStyle)
             {
-                SetWindowLongPtr(GameHWnd, GWL_STYLE, OriginalWindowStyle);
+                OSBackend->SetWindowStyle(GameHWnd, GWL_STYLE, OriginalWindowStyle);
                 UE_LOG(LogWindowHelper, Log, TEXT("Restored OriginalWindowStyle."));
                 bRestoredSomething = true;
             }
         }
         else
         {
-            LONG_PTR CurrentStyle = GetWindowLongPtr(GameHWnd, GWL_STYLE);
+            LONG_PTR CurrentStyle = OSBackend->GetWindowStyle(GameHWnd, GWL_STYLE);
             LONG_PTR NewStyle = CurrentStyle | WS_OVERLAPPEDWINDOW;
             if (NewStyle != CurrentStyle)
             {
-                SetWindowLongPtr(GameHWnd, GWL_STYLE, NewStyle);
+                OSBackend->SetWindowStyle(GameHWnd, GWL_STYLE, NewStyle);
                 UE_LOG(LogWindowHelper, Log, TEXT("Applied WS_OVERLAPPEDWINDOW (no original style)."));
                 bRestoredSomething = true;
             }
@@ -661,7 +1456,7 @@ void UWindowTransparencyHelper::RestoreDefaultWindowSettings()
 
     if (bIsTopmostActive)
     {
-        SetWindowPos(GameHWnd, HWND_NOTOPMOST, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
+        OSBackend->SetWindowPosition(GameHWnd, HWND_NOTOPMOST, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
         bIsTopmostActive = false;
         bRestoredSomething = true;
         UE_LOG(LogWindowHelper, Log, TEXT("Set window to HWND_NOTOPMOST."));
@@ -669,18 +1464,14 @@ void UWindowTransparencyHelper::RestoreDefaultWindowSettings()
 
     if (bRestoredSomething)
     {
-        SetWindowPos(GameHWnd, NULL, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_FRAMECHANGED | SWP_NOACTIVATE);
-        InvalidateRect(GameHWnd, NULL, true);
-        UpdateWindow(GameHWnd);
+        OSBackend->SetWindowPosition(GameHWnd, NULL, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_FRAMECHANGED | SWP_NOACTIVATE);
+        OSBackend->RepaintWindow(GameHWnd);
         UE_LOG(LogWindowHelper, Log, TEXT("Window settings restoration commands issued."));
     }
     else
     {
         UE_LOG(LogWindowHelper, Log, TEXT("No specific modifications by this helper were flagged for restoration, or original styles were already in place."));
     }
-#else
-    UE_LOG(LogWindowHelper, Log, TEXT("RestoreDefaultWindowSettings: Not supported on this platform."));
-#endif
 }
 
 TStatId UWindowTransparencyHelper::GetStatId() const
@@ -690,374 +1481,2833 @@ TStatId UWindowTransparencyHelper::GetStatId() const
 
 void UWindowTransparencyHelper::Tick(float DeltaTime)
 {
-#if PLATFORM_WINDOWS
+    SCOPE_CYCLE_COUNTER(STAT_WindowTransparency_HelperTick);
+    CSV_SCOPED_TIMING_STAT(WindowTransparency, HelperTick);
+    WT_TRACE_SCOPE("WindowTransparency::Tick");
+
+    // ウィンドウの状態もカーソルも OS バックエンド越しに扱うので、判定の流れはプラットフォームによらず同じ
+    if (!OSBackend.IsValid())
+    {
+        return;
+    }
+    UpdateWallpaperGovernor();
+    UpdateWallpaperMouseInput();
     if (bIsDesktopBackgroundActive) {
+        PublishClickThroughCoverage(false);
+        RevalidateDesktopBackgroundParent(DeltaTime);
+        UpdateExternalWindowsSnapshot(DeltaTime);
         return;
     }
-    if (!bCanHelperTick || !bIsInitialized || !GameHWnd || !IsWindow(GameHWnd))
+    if (!bCanHelperTick || !bIsInitialized || !GameHWnd || !OSBackend->IsValidWindow(GameHWnd))
     {
         ReInitializeIfNeeded();
-        if (!bCanHelperTick || !bIsInitialized || !GameHWnd || !IsWindow(GameHWnd))
+        if (!bCanHelperTick || !bIsInitialized || !GameHWnd || !OSBackend->IsValidWindow(GameHWnd))
         {
             return;
         }
     }
+    UpdateExternalWindowsSnapshot(DeltaTime);
+    UpdateAutoFit(DeltaTime);
+    UpdateIdleThrottle();
 
-#else
-    if (!bCanHelperTick || !bIsInitialized)
-    {
-        return;
-    }
-#endif
     if (!bHitTestingGloballyEnabled || CurrentHitTestTypeLogic == EWindowHitTestType::None)
     {
+        PublishClickThroughCoverage(false);
         if (!bIsMouseOverOpaqueAreaLogic)
         {
-#if PLATFORM_WINDOWS
             UE_LOG(LogWindowHelper, Verbose, TEXT("Tick: Hit testing disabled/None. Setting bIsMouseOverOpaqueAreaLogic to true. OS click-through state (%s) is not changed by Tick."), bIsClickThroughStateOS ? TEXT("true") : TEXT("false"));
-#else
-            UE_LOG(LogWindowHelper, Verbose, TEXT("Tick: Hit testing disabled/None. Setting bIsMouseOverOpaqueAreaLogic to true."));
-#endif
         }
         bIsMouseOverOpaqueAreaLogic = true;
         return;
     }
 
-    UpdateHitDetectionLogic(DeltaTime);
-#if PLATFORM_WINDOWS
+    // wt.HitTest.Rate が指定されていれば、間隔が空くまで前回の判定結果を使う
+    TimeSinceHitTest += DeltaTime;
+    if (GWindowHitTestRate <= 0.0f || TimeSinceHitTest >= 1.0f / GWindowHitTestRate)
+    {
+        TimeSinceHitTest = 0.0f;
+        UpdateHitDetectionLogic(DeltaTime);
+    }
     bool bShouldBeClickThroughLogically = bIsDWMTransparentActive && !bIsMouseOverOpaqueAreaLogic;
 
-    if (bIsClickThroughStateOS != bShouldBeClickThroughLogically)
+    // カーソルが境界を越えたのは前回のサンプル以降なので、前回のサンプル時刻からOS状態が追いつくまでを計測する。
+    // 今回のサンプル時刻を起点にすると同じTick内の処理時間しか測れない
+    if (bShouldBeClickThroughLogically != bLastDesiredClickThrough)
+    {
+        bLastDesiredClickThrough = bShouldBeClickThroughLogically;
+        PendingClickThroughChangeTime = PreviousCursorSampleTime > 0.0 ? PreviousCursorSampleTime : LastCursorSampleTime;
+    }
+
+    if (IsInputThreadRunning())
+    {
+        // 切り替えは入力スレッドが判断してスタイルも書き換える。ここでは書き換えられた状態を読み直し、判定材料を渡すだけ
+        SyncClickThroughStateFromInputThread();
+        PublishClickThroughCoverage(true);
+    }
+    else if (bIsClickThroughStateOS != bShouldBeClickThroughLogically)
     {
         UE_LOG(LogWindowHelper, Verbose, TEXT("Tick: Logic dictates click-through: %s. OS state is: %s. Updating OS state."),
             bShouldBeClickThroughLogically ? TEXT("true") : TEXT("false"),
             bIsClickThroughStateOS ? TEXT("true") : TEXT("false"));
+        WT_TRACE_EVENT(ClickThroughRequest, bShouldBeClickThroughLogically, bIsClickThroughStateOS, bIsDWMTransparentActive, bIsMouseOverOpaqueAreaLogic);
         EnableClickThrough(bShouldBeClickThroughLogically);
     }
-#endif
-}
 
+    if (PendingClickThroughChangeTime >= 0.0 && bIsClickThroughStateOS == bShouldBeClickThroughLogically)
+    {
+        ClickThroughLatencyHistogram.AddSample((FPlatformTime::Seconds() - PendingClickThroughChangeTime) * 1000.0);
+        PendingClickThroughChangeTime = -1.0;
+    }
+}
 
-void UWindowTransparencyHelper::SetHitTestEnabled(bool bEnable)
+void UWindowTransparencyHelper::RecordClickThroughFlip()
 {
-    bHitTestingGloballyEnabled = bEnable;
-    if (!bEnable)
+    const double Now = FPlatformTime::Seconds();
+    if (LastClickThroughFlipTime >= 0.0)
     {
-#if PLATFORM_WINDOWS
-        if (bIsClickThroughStateOS)
+        const double IntervalMs = (Now - LastClickThroughFlipTime) * 1000.0;
+        ClickThroughFlipIntervalHistogram.AddSample(IntervalMs);
+        if (IntervalMs < FlickerWindowMs)
         {
-            UE_LOG(LogWindowHelper, Log, TEXT("Hit Test Disabled. Window was click-through, setting to interactive."));
-            EnableClickThrough(false);
+            ++ClickThroughRapidFlipCount;
         }
-#endif
-        bIsMouseOverOpaqueAreaLogic = true;
     }
-    else { UE_LOG(LogWindowHelper, Log, TEXT("Hit Test Enabled: %s"), bEnable ? TEXT("true") : TEXT("false")); }
+    LastClickThroughFlipTime = Now;
+    ++ClickThroughFlipCount;
 }
 
-void UWindowTransparencyHelper::SetHitTestType(EWindowHitTestType NewType)
+void UWindowTransparencyHelper::ResetClickThroughStats()
 {
-    if (CurrentHitTestTypeLogic != NewType)
+    ClickThroughLatencyHistogram.Reset();
+    ClickThroughFlipIntervalHistogram.Reset();
+    PendingClickThroughChangeTime = -1.0;
+    LastClickThroughFlipTime = -1.0;
+    ClickThroughFlipCount = 0;
+    ClickThroughRapidFlipCount = 0;
+    HitTestBroadPhaseTests = 0;
+    HitTestBroadPhaseRejects = 0;
+    PendingPredictionTime = -1.0;
+    PredictedSwitchDeadline = -1.0;
+    CursorPredictionCount = 0;
+    CursorPredictionAccurateCount = 0;
+    CursorPredictionErrorSum = 0.0;
+    CursorPredictionErrorMax = 0.0f;
+    PredictedSwitchCount = 0;
+    CorrectPredictedSwitchCount = 0;
+    FalsePredictedSwitchCount = 0;
+    for (UWindowHitTestStrategy* Strategy : HitTestStrategies)
     {
-        CurrentHitTestTypeLogic = NewType;
-        UE_LOG(LogWindowHelper, Log, TEXT("Hit Test Type set to: %s"), *UEnum::GetValueAsString(NewType));
+        if (Strategy)
+        {
+            Strategy->ResetStats();
+        }
     }
+    IdleAccumulatedSeconds = 0.0;
+    ActiveAccumulatedSeconds = 0.0;
+    IdleEntryCount = bIsIdle ? 1 : 0;
+    WallpaperVisibleSeconds = 0.0;
+    WallpaperOccludedSeconds = 0.0;
+    WallpaperOcclusionCount = bWallpaperOccluded ? 1 : 0;
 }
 
-void UWindowTransparencyHelper::SetGameRaycastTraceChannel(ECollisionChannel NewChannel)
+void UWindowTransparencyHelper::DumpClickThroughStats() const
 {
-    if (GameRaycastTraceChannelLogic != NewChannel)
+    UE_LOG(LogWindowHelper, Display, TEXT("%s"), *ClickThroughLatencyHistogram.ToString(TEXT("Click-through latency")));
+    UE_LOG(LogWindowHelper, Display, TEXT("%s"), *ClickThroughFlipIntervalHistogram.ToString(TEXT("Click-through flip interval")));
+    UE_LOG(LogWindowHelper, Display, TEXT("Click-through flips: %d total, %d within %.0f ms of the previous flip (%.1f%%)"),
+        ClickThroughFlipCount, ClickThroughRapidFlipCount, FlickerWindowMs,
+        ClickThroughFlipCount > 0 ? 100.0f * ClickThroughRapidFlipCount / ClickThroughFlipCount : 0.0f);
+    UE_LOG(LogWindowHelper, Display, TEXT("Hit test broad phase: %llu of %llu tests rejected without a trace (%.1f%%), %d candidate rects"),
+        HitTestBroadPhaseRejects, HitTestBroadPhaseTests, 100.0f * GetHitTestBroadPhaseRejectRate(), HitTestBroadPhaseRects.Num());
+    UE_LOG(LogWindowHelper, Display, TEXT("Widget hit cache: %d rects, rebuilt %d times"), WidgetHitCache.Num(), WidgetHitCacheRebuildCount);
+    for (const FWindowHitTestStrategyStats& Stats : GetHitTestStrategyStats())
     {
-        GameRaycastTraceChannelLogic = NewChannel;
-        const UEnum* EnumPtr = StaticEnum<ECollisionChannel>();
-        FString ChannelName = EnumPtr ? EnumPtr->GetNameStringByValue(static_cast<int64>(NewChannel)) : FString::FromInt(static_cast<int32>(NewChannel));
-        UE_LOG(LogWindowHelper, Log, TEXT("Game Raycast Trace Channel set to: %s"), *ChannelName);
+        UE_LOG(LogWindowHelper, Display, TEXT("Hit test strategy %s: %d evaluations, %d decisive (%d opaque), mean %.3f ms"),
+            *Stats.StrategyName, Stats.Evaluations, Stats.DecisiveCount, Stats.OpaqueCount, Stats.MeanMs);
     }
-}
-
-void UWindowTransparencyHelper::UpdateHitDetectionLogic(float DeltaTime)
-{
-#if PLATFORM_WINDOWS
-    bool bMousePosSuccess;
-    FVector2D MousePosInWindow = GetMousePositionInWindow(bMousePosSuccess);
-
-    if (!bMousePosSuccess)
+    if (bCursorPredictionEnabled)
     {
-        bIsMouseOverOpaqueAreaLogic = false;
-        UE_LOG(LogWindowHelper, Verbose, TEXT("UpdateHitDetectionLogic: Mouse position not retrieved. Assuming transparent area."));
-        return;
+        const FWindowCursorPredictionStats PredictionStats = GetCursorPredictionStats();
+        UE_LOG(LogWindowHelper, Display, TEXT("Cursor prediction: %d predictions, mean error %.1f px, max %.1f px, %.1f%% within %.0f px; %d early switches, %d false (%.1f%%)"),
+            PredictionStats.Predictions, PredictionStats.MeanErrorPixels, PredictionStats.MaxErrorPixels, 100.0f * PredictionStats.Accuracy, PredictionStats.AccuratePixels,
+            PredictionStats.PredictedSwitches, PredictionStats.FalseSwitches, 100.0f * PredictionStats.FalseSwitchRate);
     }
-
-    switch (CurrentHitTestTypeLogic)
+    if (ClickThroughThread.IsValid())
     {
-    case EWindowHitTestType::GameRaycast:
+        UE_LOG(LogWindowHelper, Display, TEXT("Input thread: %.0f Hz, %u iterations, %u click-through style writes"),
+            ClickThroughThread->GetRate(), ClickThroughThread->GetIterationCount(), ClickThroughThread->GetApplyCount());
+    }
+    if (bAutoFitEnabled)
     {
-        bIsMouseOverOpaqueAreaLogic = PerformGameRaycastUnderMouse(MousePosInWindow);
-        const UEnum* EnumPtr = StaticEnum<ECollisionChannel>();
-        FString ChannelName = EnumPtr ? EnumPtr->GetNameStringByValue(static_cast<int64>(GameRaycastTraceChannelLogic)) : FString::FromInt(static_cast<int32>(GameRaycastTraceChannelLogic));
-        UE_LOG(LogWindowHelper, Log, TEXT("GameRaycastTest Result: bIsMouseOverOpaqueAreaLogic = %s at Pos: %s (Channel: %s)"),
-            bIsMouseOverOpaqueAreaLogic ? TEXT("true (Opaque)") : TEXT("false (Transparent)"), *MousePosInWindow.ToString(), *ChannelName);
-        break;
+        UE_LOG(LogWindowHelper, Display, TEXT("Auto-fit: window %dx%d of %dx%d (%.1f%% of the area), %d resizes"),
+            AutoFitWindowRect.Width(), AutoFitWindowRect.Height(), AutoFitHomeRect.Width(), AutoFitHomeRect.Height(),
+            100.0f * GetAutoFitAreaRatio(), AutoFitResizeCount);
     }
-    case EWindowHitTestType::None:
-    default:
-        bIsMouseOverOpaqueAreaLogic = true;
-        break;
+    if (bIdleThrottleEnabled)
+    {
+        const FWindowIdleStats IdleStats = GetIdleStats();
+        UE_LOG(LogWindowHelper, Display, TEXT("Idle: %s, %.1f s idle / %.1f s active (%.1f%% idle), %d idle periods"),
+            IdleStats.bIdle ? TEXT("idle") : TEXT("active"), IdleStats.IdleSeconds, IdleStats.ActiveSeconds, 100.0f * IdleStats.IdleFraction, IdleStats.IdleEntries);
     }
-#endif
-}
-
-bool UWindowTransparencyHelper::PerformGameRaycastUnderMouse(FVector2D MousePosInWindow)
-{
-    APlayerController* PC = GetFirstLocalPlayerController(this);
-    if (!PC)
+    if (bWallpaperGovernorEnabled)
     {
-        UE_LOG(LogWindowHelper, Warning, TEXT("GameRaycastTest: PlayerController not found. Assuming no hit (transparent)."));
-        return false;
+        const FWindowWallpaperGovernorStats WallpaperStats = GetWallpaperGovernorStats();
+        UE_LOG(LogWindowHelper, Display, TEXT("Wallpaper governor: %s, %.1f%% of the desktop visible, %.1f s visible / %.1f s occluded, %d occlusions"),
+            !WallpaperStats.bActive ? TEXT("inactive") : WallpaperStats.bOccluded ? TEXT("occluded") : TEXT("visible"),
+            100.0f * WallpaperStats.VisibleDesktopFraction, WallpaperStats.VisibleSeconds, WallpaperStats.OccludedSeconds, WallpaperStats.Occlusions);
     }
-
-    FHitResult HitResult3D;
-    FCollisionQueryParams CollisionParams3D(SCENE_QUERY_STAT(WindowTransparencyRaycast3D), true);
-
-    bool bHit3D = PC->GetHitResultAtScreenPosition(
-        MousePosInWindow,
-        this->GameRaycastTraceChannelLogic,
-        CollisionParams3D,
-        HitResult3D
-    );
-
-    if (bHit3D && HitResult3D.GetActor())
+#if PLATFORM_WINDOWS
+    if (RawInputThread.IsValid())
     {
-        AActor* HitActor = HitResult3D.GetActor();
-        const UEnum* EnumPtr = StaticEnum<ECollisionChannel>();
-        FString ChannelName = EnumPtr ? EnumPtr->GetNameStringByValue(static_cast<int64>(this->GameRaycastTraceChannelLogic)) : FString::FromInt(static_cast<int32>(this->GameRaycastTraceChannelLogic));
-        UE_LOG(LogWindowHelper, Verbose, TEXT("GameRaycastTest: Hit 3D Actor: %s (Component: %s) using Channel %s"),
-            *HitActor->GetName(),
-            HitResult3D.GetComponent() ? *HitResult3D.GetComponent()->GetName() : TEXT("None"),
-            *ChannelName);
-        return true;
+        UE_LOG(LogWindowHelper, Display, TEXT("Wallpaper mouse input: %u raw inputs, %u queued, %d events delivered in %d batches"),
+            RawInputThread->GetReceivedCount(), RawInputThread->GetQueuedCount(), WallpaperMouseEventCount, WallpaperMouseBatchCount);
     }
+#endif
+}
 
-    if (FSlateApplication::IsInitialized() && GEngine && GEngine->GameViewport)
+static FAutoConsoleCommand DumpClickThroughStatsCommand(
+    TEXT("wt.Stats.Dump"),
+    TEXT("Logs the click-through latency and flicker histograms."),
+    FConsoleCommandDelegate::CreateLambda([]()
     {
-        TSharedPtr<SWindow> GameSWindow = GEngine->GameViewport->GetWindow();
-        if (GameSWindow.IsValid())
+        if (UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper())
         {
-            TArray<TSharedRef<SWindow>> WindowsToSearch;
-            WindowsToSearch.Add(GameSWindow.ToSharedRef());
+            Helper->DumpClickThroughStats();
+        }
+    }));
 
-            FVector2D MousePosScreen = MousePosInWindow + GEngine->GameViewport->GetGameViewportWidget()->GetCachedGeometry().GetAbsolutePosition();
-            FWidgetPath WidgetPath = FSlateApplication::Get().LocateWindowUnderMouse(
-                MousePosScreen,
-                WindowsToSearch,
-                false, /*bAllowDisabledWidgets*/
-                PC->GetLocalPlayer() ? PC->GetLocalPlayer()->GetControllerId() : 0
-            );
+static FAutoConsoleCommand ResetClickThroughStatsCommand(
+    TEXT("wt.Stats.Reset"),
+    TEXT("Clears the click-through latency and flicker histograms."),
+    FConsoleCommandDelegate::CreateLambda([]()
+    {
+        if (UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper())
+        {
+            Helper->ResetClickThroughStats();
+        }
+    }));
 
-            if (WidgetPath.IsValid() && WidgetPath.Widgets.Num() > 0)
-            {
-                const FArrangedWidget& LastWidgetArranged = WidgetPath.Widgets.Last();
-                TSharedRef<SWidget> HitWidget = LastWidgetArranged.Widget;
-                FString WidgetType = HitWidget->GetTypeAsString();
-                FString WidgetDesc = HitWidget->ToString();
+void UWindowTransparencyHelper::SetInputThreadEnabled(bool bEnable, float RateHz)
+{
+    if (!bEnable)
+    {
+        if (ClickThroughThread.IsValid())
+        {
+            ClickThroughThread.Reset();
+            UE_LOG(LogWindowHelper, Log, TEXT("SetInputThreadEnabled: Input thread stopped."));
+        }
+        return;
+    }
 
-                UE_LOG(LogWindowHelper, Verbose, TEXT("GameRaycastTest: UI Hit Candidate: Type: %s, Desc: %s, Visible: %d, Enabled: %d, PathLen: %d"),
-                    *WidgetType, *WidgetDesc, HitWidget->GetVisibility().IsVisible(), HitWidget->IsEnabled(), WidgetPath.Widgets.Num());
+    if (ClickThroughThread.IsValid())
+    {
+        ClickThroughThread->SetRate(RateHz);
+        return;
+    }
+    if (!FPlatformProcess::SupportsMultithreading())
+    {
+        UE_LOG(LogWindowHelper, Warning, TEXT("SetInputThreadEnabled: Multithreading is not supported. Click-through stays on the game thread."));
+        return;
+    }
+    if (!HasOSBackend(TEXT("SetInputThreadEnabled")))
+    {
+        return;
+    }
 
-                if (HitWidget->GetVisibility().IsVisible() && HitWidget->IsEnabled())
-                {
-                    if (WidgetType == TEXT("SWindow") ||
-                        WidgetType == TEXT("SGameLayerManager") ||
-                        WidgetType == TEXT("SViewport") ||
-                        (WidgetType == TEXT("SBorder") && WidgetPath.Widgets.Num() <= 2) ||
-                        (WidgetType == TEXT("SOverlay") && WidgetPath.Widgets.Num() <= 2) ||
-                        (WidgetType == TEXT("SScaleBox") && WidgetPath.Widgets.Num() <= 2) ||
-                        (WidgetType == TEXT("SCanvasPanel") && WidgetPath.Widgets.Num() <= 2) ||
-                        (WidgetType == TEXT("SObjectWidget") && WidgetPath.Widgets.Num() <= 1)
-                        )
-                    {
-                        UE_LOG(LogWindowHelper, Verbose, TEXT("GameRaycastTest: UI Hit on %s (%s), but considering it non-blocking/transparent due to type/context."), *WidgetType, *WidgetDesc);
-                    }
-                    else
-                    {
-                        UE_LOG(LogWindowHelper, Verbose, TEXT("GameRaycastTest: Hit blocking UI Widget: %s (%s)"), *WidgetType, *WidgetDesc);
-                        return true;
-                    }
-                }
-            }
-        }
+    ClickThroughThread = MakeShared<FWindowClickThroughThread>(OSBackend, RateHz, bIsClickThroughStateOS);
+    if (!ClickThroughThread->IsRunning())
+    {
+        ClickThroughThread.Reset();
+        return;
     }
-    const UEnum* EnumPtr = StaticEnum<ECollisionChannel>();
-    FString ChannelName = EnumPtr ? EnumPtr->GetNameStringByValue(static_cast<int64>(this->GameRaycastTraceChannelLogic)) : FString::FromInt(static_cast<int32>(this->GameRaycastTraceChannelLogic));
-    UE_LOG(LogWindowHelper, Verbose, TEXT("GameRaycastTest: No blocking hit found on 3D (using Channel %s) or UI. Assuming transparent."), *ChannelName);
-    return false;
+    ClickThroughAppliedSerial = 0;
+    UE_LOG(LogWindowHelper, Log, TEXT("SetInputThreadEnabled: Input thread started at %.0f Hz."), ClickThroughThread->GetRate());
 }
 
-#if PLATFORM_WINDOWS
-// Helper struct for EnumWindowsProcWorkerW
-struct WorkerWEnumData {
-    HWND WorkerW_Handle = nullptr;
-    HWND Progman_Handle = nullptr;
-    int MonitorCount = 0; // マルチモニター対応のためのヒント
-};
+bool UWindowTransparencyHelper::IsInputThreadRunning() const
+{
+    return ClickThroughThread.IsValid();
+}
 
-// Callback for EnumWindows to find the correct WorkerW
-static BOOL CALLBACK EnumWindowsProcFindWorkerW(HWND hwnd, LPARAM lParam)
+void UWindowTransparencyHelper::SyncClickThroughStateFromInputThread()
 {
-    WorkerWEnumData* pData = reinterpret_cast<WorkerWEnumData*>(lParam);
-    WCHAR className[256];
-    WCHAR windowTitle[256];
+    if (!ClickThroughThread.IsValid() || !ClickThroughThread->ConsumeAppliedSerial(ClickThroughAppliedSerial) || !GameHWnd)
+    {
+        return;
+    }
+    // 入力スレッドが書き換えた後なので、スタイルを読み直して実際の状態に合わせる
+    const bool bClickThroughOS = (OSBackend->GetWindowStyle(GameHWnd, GWL_EXSTYLE) & WS_EX_TRANSPARENT) != 0;
+    if (bClickThroughOS != bIsClickThroughStateOS)
+    {
+        WT_TRACE_EVENT(ClickThroughRequest, bClickThroughOS, bIsClickThroughStateOS, bIsDWMTransparentActive, !bClickThroughOS);
+        RecordClickThroughFlip();
+        bIsClickThroughStateOS = bClickThroughOS;
+    }
+}
 
-    if (GetClassNameW(hwnd, className, sizeof(className) / sizeof(WCHAR)) && wcscmp(className, L"WorkerW") == 0)
+void UWindowTransparencyHelper::PublishClickThroughCoverage(bool bActive)
+{
+    if (!ClickThroughThread.IsValid())
     {
-        GetWindowText(hwnd, windowTitle, sizeof(windowTitle) / sizeof(WCHAR));
-        bool bIsVisible = IsWindowVisible(hwnd);
-        HWND parentHwnd = GetParent(hwnd);
-        RECT rcClient;
-        GetClientRect(hwnd, &rcClient);
+        return;
+    }
 
-        HWND defView = FindWindowEx(hwnd, NULL, L"SHELLDLL_DefView", NULL);
-        if (defView == NULL)
-        {
-            UE_LOG(LogWindowHelper, Log, TEXT("  - WorkerW %p does NOT have SHELLDLL_DefView child. Candidate."), hwnd);
+    TSharedPtr<FWindowClickThroughCoverage> Coverage = MakeShared<FWindowClickThroughCoverage>();
+    Coverage->GameHWnd = GameHWnd;
+    Coverage->bActive = bActive && bIsDWMTransparentActive && GameHWnd != nullptr;
+    Coverage->bGameVerdictOpaque = bIsMouseOverOpaqueAreaLogic;
+    Coverage->GameVerdictPos = LastHitTestMousePos;
+    Coverage->PredictedOpaqueUntil = PredictedOpaqueUntil;
 
-            if (bIsVisible && (rcClient.right - rcClient.left > 0) && (rcClient.bottom - rcClient.top > 0))
-            {
+    APlayerController* PC = Coverage->bActive && bHitTestPipelineBoundedByRects ? GetFirstLocalPlayerController(this) : nullptr;
+    if (PC)
+    {
+        // パイプラインの判定範囲をブロードフェーズの矩形で表す（フレーム内でキャッシュ済みならそれを使う）
+        UpdateHitTestBroadPhase(PC);
+        Coverage->bCoversAll = bHitTestBroadPhaseCoversAll;
+        const double Margin = GetHitTestKernelMargin();
+        Coverage->CandidateRects.Reserve(HitTestBroadPhaseRects.Num());
+        for (const FBox2D& Rect : HitTestBroadPhaseRects)
+        {
+            Coverage->CandidateRects.Add(Rect.ExpandBy(Margin));
+        }
 
-                pData->WorkerW_Handle = hwnd;
-                UE_LOG(LogWindowHelper, Log, TEXT("  - WorkerW %p SELECTED as target (Visible, Valid Size, No DefView)."), hwnd);
-                return false;
-            }
-            else
+        if (bHitTestPipelineUsesWidgets)
+        {
+            RefreshWidgetHitCache();
+            Coverage->WidgetRects.Reserve(WidgetHitCache.Num());
+            for (const FWidgetHitEntry& Entry : WidgetHitCache)
             {
-                FString skipReason;
-                if (!bIsVisible) skipReason += TEXT("NotVisible; ");
-                if (rcClient.right - rcClient.left <= 0) skipReason += TEXT("ZeroWidth; ");
-                if (rcClient.bottom - rcClient.top <= 0) skipReason += TEXT("ZeroHeight; ");
-                UE_LOG(LogWindowHelper, Log, TEXT("  - WorkerW %p (No DefView) SKIPPED. Reason: %s"), hwnd, *skipReason);
+                Coverage->WidgetRects.Emplace(Entry.Rect, Entry.bBlocking);
             }
         }
-        else
-        {
-            UE_LOG(LogWindowHelper, Log, TEXT("  - WorkerW %p HAS SHELLDLL_DefView child (%p). Skipping."), hwnd, defView);
-        }
     }
-    return true;
+    Coverage->bGameVerdictInCandidates = Coverage->IsInCandidateRects(LastHitTestMousePos);
+
+    ClickThroughThread->PublishCoverage(Coverage);
 }
 
-HWND UWindowTransparencyHelper::FindTargetWorkerW()
+void UWindowTransparencyHelper::SetAutoFitToContent(bool bEnable, float MarginPixels, float ShrinkDelaySeconds)
 {
-    HWND progman = FindWindowW(L"Progman", NULL);
-    if (!progman)
+#if PLATFORM_WINDOWS
+    AutoFitMarginPixels = FMath::Max(0.0f, MarginPixels);
+    AutoFitShrinkDelaySeconds = FMath::Max(0.0f, ShrinkDelaySeconds);
+    if (bEnable == bAutoFitEnabled)
     {
-        UE_LOG(LogWindowHelper, Warning, TEXT("FindTargetWorkerW: Progman window not found."));
-        return nullptr;
+        return;
     }
-    UE_LOG(LogWindowHelper, Log, TEXT("FindTargetWorkerW: Found Progman: %p"), progman);
-
-    ULONG_PTR result;
-    UE_LOG(LogWindowHelper, Log, TEXT("FindTargetWorkerW: Sending 0x052C message to Progman %p."), progman);
-    SendMessageTimeout(progman, 0x052C, 0x0000000D, 0, SMTO_NORMAL, 1000, &result);
-    SendMessageTimeout(progman, 0x052C, 0, 0, SMTO_NORMAL, 1000, &result);
-
-    WorkerWEnumData data;
-    data.WorkerW_Handle = nullptr;
-    data.Progman_Handle = progman;
-    data.MonitorCount = GetSystemMetrics(SM_CMONITORS);
-
-    UE_LOG(LogWindowHelper, Log, TEXT("FindTargetWorkerW: Strategy 1 - EnumWindows for top-level WorkerW. Monitor count: %d"), data.MonitorCount);
-    EnumWindows(EnumWindowsProcFindWorkerW, reinterpret_cast<LPARAM>(&data));
-
-    if (data.WorkerW_Handle)
+    bAutoFitEnabled = bEnable;
+    if (bEnable)
     {
-        UE_LOG(LogWindowHelper, Log, TEXT("FindTargetWorkerW: Strategy 1 - Found target WorkerW: %p"), data.WorkerW_Handle);
-        return data.WorkerW_Handle;
+        // フィット前の投影を記録させるため、最初のリサイズより前に作っておく
+        if (!AutoFitExtension.IsValid())
+        {
+            AutoFitExtension = FSceneViewExtensions::NewExtension<FWindowAutoFitExtension>();
+        }
+        TimeSinceAutoFit = 0.0f;
+        UE_LOG(LogWindowHelper, Log, TEXT("SetAutoFitToContent: Enabled with a %.0f px margin."), AutoFitMarginPixels);
     }
-
-    UE_LOG(LogWindowHelper, Warning, TEXT("FindTargetWorkerW: Strategy 1 failed. Strategy 2 - EnumChildWindows on Progman (%p)."), progman);
-    data.WorkerW_Handle = nullptr;
-    EnumChildWindows(progman, EnumWindowsProcFindWorkerW, reinterpret_cast<LPARAM>(&data));
-
-    if (data.WorkerW_Handle)
+    else
     {
-        UE_LOG(LogWindowHelper, Log, TEXT("FindTargetWorkerW: Strategy 2 - Found target WorkerW (%p) as child of Progman."), data.WorkerW_Handle);
-        return data.WorkerW_Handle;
+        StopAutoFit(true);
+        UE_LOG(LogWindowHelper, Log, TEXT("SetAutoFitToContent: Disabled."));
     }
-
-    UE_LOG(LogWindowHelper, Error, TEXT("FindTargetWorkerW: All strategies failed. No suitable WorkerW found."));
-    return nullptr;
+#else
+    UE_LOG(LogWindowHelper, Log, TEXT("SetAutoFitToContent: Not supported on this platform."));
+#endif
 }
-#endif // PLATFORM_WINDOWS
 
+float UWindowTransparencyHelper::GetAutoFitAreaRatio() const
+{
+    const double HomeArea = static_cast<double>(AutoFitHomeRect.Width()) * AutoFitHomeRect.Height();
+    if (HomeArea <= 0.0)
+    {
+        return 1.0f;
+    }
+    return static_cast<float>(static_cast<double>(AutoFitWindowRect.Width()) * AutoFitWindowRect.Height() / HomeArea);
+}
 
-//TODO:２回実行しないと適応されないのを修正する
-void UWindowTransparencyHelper::SetAsDesktopBackground(bool bEnable)
+void UWindowTransparencyHelper::UpdateAutoFit(float DeltaTime)
 {
 #if PLATFORM_WINDOWS
-    if (bEnable)
+    if (!bAutoFitEnabled)
     {
+        return;
+    }
+    if (!bIsDWMTransparentActive)
+    {
+        // 透過していなければウィンドウ全体が見えているので元の矩形に戻す
+        StopAutoFit(true);
+        return;
+    }
 
-        if (!bIsInitialized || !GameHWnd || !IsWindow(GameHWnd)) {
-            UE_LOG(LogWindowHelper, Log, TEXT("SetAsDesktopBackground(Enable): Helper not initialized or GameHWnd invalid. Calling Initialize()."));
-            if (!Initialize()) {
-                UE_LOG(LogWindowHelper, Error, TEXT("SetAsDesktopBackground(Enable): Initialize() failed. Cannot proceed."));
-                return;
+    // 内容の矩形は全アクターを走査して求めることがあるので、毎フレームは更新しない
+    constexpr float AutoFitUpdateInterval = 0.1f;
+    TimeSinceAutoFit += DeltaTime;
+    if (TimeSinceAutoFit < AutoFitUpdateInterval)
+    {
+        return;
+    }
+    TimeSinceAutoFit = 0.0f;
+
+    RECT CurrentRect;
+    if (!OSBackend->GetWindowScreenRect(GameHWnd, CurrentRect))
+    {
+        return;
+    }
+    const FIntRect WindowRect(CurrentRect.left, CurrentRect.top, CurrentRect.right, CurrentRect.bottom);
+    if (AutoFitHomeRect.Area() <= 0)
+    {
+        AutoFitHomeRect = WindowRect;
+        AutoFitWindowRect = WindowRect;
+    }
+    else if (WindowRect != AutoFitWindowRect)
+    {
+        if (WindowRect.Size() == AutoFitWindowRect.Size())
+        {
+            // ウィンドウごと動かされたら、フィット前の矩形も同じだけ動かす
+            AutoFitHomeRect += WindowRect.Min - AutoFitWindowRect.Min;
+        }
+        else
+        {
+            // ユーザーや OS にサイズを変えられたら、その矩形をフィット前の矩形とし直す
+            UE_LOG(LogWindowHelper, Log, TEXT("UpdateAutoFit: The window was resized externally to %dx%d. Using it as the unfitted rect."), WindowRect.Width(), WindowRect.Height());
+            AutoFitHomeRect = WindowRect;
+            if (AutoFitExtension.IsValid())
+            {
+                AutoFitExtension->ClearCrop();
             }
         }
+        AutoFitWindowRect = WindowRect;
+    }
 
-        CurrentWorkerW = FindTargetWorkerW();
-        if (!CurrentWorkerW)
+    APlayerController* PC = GetFirstLocalPlayerController(this);
+    FBox2D ContentBounds(ForceInit);
+    FIntRect TargetRect = AutoFitHomeRect;
+    bool bGrow = true;
+    if (PC && ComputeContentScreenBounds(PC, ContentBounds))
+    {
+        if (!ContentBounds.bIsValid)
         {
-            UE_LOG(LogWindowHelper, Error, TEXT("SetAsDesktopBackground: Failed to find WorkerW."));
+            // 何も映っていなければ今の矩形のままにする
+            AutoFitShrinkPendingSince = -1.0;
             return;
         }
+        const FBox2D ScreenBounds = ContentBounds.ShiftBy(FVector2D(WindowRect.Min));
+        TargetRect = FIntRect(
+            FMath::FloorToInt(ScreenBounds.Min.X - AutoFitMarginPixels), FMath::FloorToInt(ScreenBounds.Min.Y - AutoFitMarginPixels),
+            FMath::CeilToInt(ScreenBounds.Max.X + AutoFitMarginPixels), FMath::CeilToInt(ScreenBounds.Max.Y + AutoFitMarginPixels));
+        TargetRect.Clip(AutoFitHomeRect);
 
-        LONG_PTR DesktopBackgroundStyle = (GetWindowLongPtr(GameHWnd, GWL_STYLE) & ~(WS_CAPTION | WS_THICKFRAME | WS_SYSMENU)) | WS_POPUP;
+        // 極端に小さいスワップチェーンは作り直しが不安定になるので、最小サイズを保つ
+        constexpr int32 AutoFitMinSize = 64;
+        const FIntPoint MinSize(FMath::Min(AutoFitMinSize, AutoFitHomeRect.Width()), FMath::Min(AutoFitMinSize, AutoFitHomeRect.Height()));
+        if (TargetRect.Width() < MinSize.X || TargetRect.Height() < MinSize.Y)
+        {
+            const FIntPoint Center = TargetRect.Area() > 0 ? TargetRect.Min + TargetRect.Size() / 2 : FIntPoint(FMath::RoundToInt(ScreenBounds.GetCenter().X), FMath::RoundToInt(ScreenBounds.GetCenter().Y));
+            const FIntPoint Size(FMath::Max(TargetRect.Width(), MinSize.X), FMath::Max(TargetRect.Height(), MinSize.Y));
+            FIntPoint Min(
+                FMath::Clamp(Center.X - Size.X / 2, AutoFitHomeRect.Min.X, AutoFitHomeRect.Max.X - Size.X),
+                FMath::Clamp(Center.Y - Size.Y / 2, AutoFitHomeRect.Min.Y, AutoFitHomeRect.Max.Y - Size.Y));
+            TargetRect = FIntRect(Min, Min + Size);
+        }
+
+        // 内容が余白の半分より端に近づいたらすぐに広げる。縮めるのは小さい矩形がしばらく続いてから
+        const double GrowMargin = AutoFitMarginPixels * 0.5;
+        const FIntRect GrowTrigger = FIntRect(
+            FMath::FloorToInt(ScreenBounds.Min.X - GrowMargin), FMath::FloorToInt(ScreenBounds.Min.Y - GrowMargin),
+            FMath::CeilToInt(ScreenBounds.Max.X + GrowMargin), FMath::CeilToInt(ScreenBounds.Max.Y + GrowMargin));
+        FIntRect ClippedTrigger = GrowTrigger;
+        ClippedTrigger.Clip(AutoFitHomeRect);
+        bGrow = !AutoFitWindowRect.Contains(ClippedTrigger.Min) || !AutoFitWindowRect.Contains(ClippedTrigger.Max - FIntPoint(1, 1));
+    }
+
+    if (TargetRect == AutoFitWindowRect)
+    {
+        AutoFitShrinkPendingSince = -1.0;
+        return;
+    }
+    if (bGrow)
+    {
+        ApplyAutoFitRect(TargetRect);
+        return;
+    }
+
+    const int32 Slack = FMath::Max(
+        FMath::Max(TargetRect.Min.X - AutoFitWindowRect.Min.X, TargetRect.Min.Y - AutoFitWindowRect.Min.Y),
+        FMath::Max(AutoFitWindowRect.Max.X - TargetRect.Max.X, AutoFitWindowRect.Max.Y - TargetRect.Max.Y));
+    if (Slack <= AutoFitMarginPixels)
+    {
+        AutoFitShrinkPendingSince = -1.0;
+        return;
+    }
+    const double Now = FPlatformTime::Seconds();
+    if (AutoFitShrinkPendingSince < 0.0)
+    {
+        AutoFitShrinkPendingSince = Now;
+    }
+    if (Now - AutoFitShrinkPendingSince >= AutoFitShrinkDelaySeconds)
+    {
+        ApplyAutoFitRect(TargetRect);
+    }
+#endif
+}
+
+bool UWindowTransparencyHelper::ComputeContentScreenBounds(APlayerController* PC, FBox2D& OutBounds, bool bIncludeWorldPrimitives)
+{
+    OutBounds = FBox2D(ForceInit);
+    UWorld* World = PC->GetWorld();
+    FSceneViewProjectionData ProjectionData;
+    if (!World || !GetPlayerProjectionData(PC, ProjectionData))
+    {
+        return false;
+    }
+    const FMatrix ViewProjectionMatrix = ProjectionData.ComputeViewProjectionMatrix();
+    const FIntRect ViewRect = ProjectionData.GetConstrainedViewRect();
+
+    // カメラをまたぐバウンドは近平面で切られ、全体が後ろにあるものだけが除かれる
+    auto AddProjectedBounds = [&](const FBox& Bounds)
+    {
+        FBox2D ScreenRect;
+        if (Bounds.IsValid && ProjectBoundsToScreen(Bounds, ViewRect, ViewProjectionMatrix, ScreenRect))
+        {
+            OutBounds += ScreenRect;
+        }
+    };
+
+    // ヒットテストの対象を内容とみなす
+    HitTestTargets.ForEachProxyBounds(AddProjectedBounds);
+    for (const TPair<int32, TArray<TWeakObjectPtr<AActor>>>& Pair : StencilActors)
+    {
+        for (const TWeakObjectPtr<AActor>& Registered : Pair.Value)
+        {
+            const AActor* Actor = Registered.Get();
+            if (Actor && !Actor->IsHidden())
+            {
+                AddProjectedBounds(Actor->GetComponentsBoundingBox());
+            }
+        }
+    }
+    if (bIncludeWorldPrimitives && (bHitTestPipelineUsesPhysics || (HitTestTargets.GetProxyCount() == 0 && StencilActors.Num() == 0)))
+    {
+        // ワールドは走査せず、ブロードフェーズと共有する投影済みの矩形を使う。見えない壁は内容に含めない
+        ProjectBroadPhasePrimitives(World, ViewProjectionMatrix, ViewRect, [&OutBounds](const UPrimitiveComponent& Primitive, const FBox2D& ScreenRect)
+        {
+            const AActor* Owner = Primitive.GetOwner();
+            if (Primitive.IsVisible() && (!Owner || !Owner->IsHidden()))
+            {
+                OutBounds += ScreenRect;
+            }
+        });
+    }
+
+    // UI: ブロックするウィジェット。フィット後は縮んだウィンドウに配置し直されるが、はみ出せば次の更新ですぐに広がる
+    RefreshWidgetHitCache();
+    for (const FWidgetHitEntry& Entry : WidgetHitCache)
+    {
+        if (Entry.bBlocking)
+        {
+            OutBounds += Entry.Rect;
+        }
+    }
+    return true;
+}
+
+void UWindowTransparencyHelper::ApplyAutoFitRect(const FIntRect& NewRect)
+{
+#if PLATFORM_WINDOWS
+    AutoFitShrinkPendingSince = -1.0;
+    OSBackend->SetWindowPosition(GameHWnd, NULL, NewRect.Min.X, NewRect.Min.Y, NewRect.Width(), NewRect.Height(), SWP_NOZORDER | SWP_NOACTIVATE);
+    RECT AppliedRect;
+    AutoFitWindowRect = OSBackend->GetWindowScreenRect(GameHWnd, AppliedRect) ? FIntRect(AppliedRect.left, AppliedRect.top, AppliedRect.right, AppliedRect.bottom) : NewRect;
+    ++AutoFitResizeCount;
+
+    if (!AutoFitExtension.IsValid())
+    {
+        AutoFitExtension = FSceneViewExtensions::NewExtension<FWindowAutoFitExtension>();
+    }
+    FViewport* Viewport = GEngine && GEngine->GameViewport ? GEngine->GameViewport->Viewport : nullptr;
+    AutoFitExtension->SetCrop(Viewport, AutoFitHomeRect, AutoFitWindowRect);
+
+    // ウィンドウ座標が変わったので、ブロードフェーズとウィジェット矩形は次の判定で作り直す
+    HitTestBroadPhaseFrame = 0;
+    bWidgetHitCacheDirty = true;
+    UE_LOG(LogWindowHelper, Verbose, TEXT("ApplyAutoFitRect: Window fitted to (%d, %d) %dx%d, %.1f%% of the unfitted area."),
+        AutoFitWindowRect.Min.X, AutoFitWindowRect.Min.Y, AutoFitWindowRect.Width(), AutoFitWindowRect.Height(), 100.0f * GetAutoFitAreaRatio());
+#endif
+}
+
+void UWindowTransparencyHelper::StopAutoFit(bool bRestoreWindow)
+{
+#if PLATFORM_WINDOWS
+    if (AutoFitExtension.IsValid())
+    {
+        AutoFitExtension->ClearCrop();
+    }
+    if (bRestoreWindow && AutoFitHomeRect.Area() > 0 && AutoFitWindowRect != AutoFitHomeRect && GameHWnd && OSBackend->IsValidWindow(GameHWnd))
+    {
+        OSBackend->SetWindowPosition(GameHWnd, NULL, AutoFitHomeRect.Min.X, AutoFitHomeRect.Min.Y, AutoFitHomeRect.Width(), AutoFitHomeRect.Height(), SWP_NOZORDER | SWP_NOACTIVATE);
+        HitTestBroadPhaseFrame = 0;
+        bWidgetHitCacheDirty = true;
+    }
+    AutoFitHomeRect = FIntRect();
+    AutoFitWindowRect = FIntRect();
+    AutoFitShrinkPendingSince = -1.0;
+    TimeSinceAutoFit = 0.0f;
+#endif
+}
+
+void UWindowTransparencyHelper::SetIdleThrottle(bool bEnable, float InIdleFPS, bool bSuspendRendering, float InIdleDelaySeconds)
+{
+#if PLATFORM_WINDOWS
+    IdleDelaySeconds = FMath::Max(0.0f, InIdleDelaySeconds);
+    if (!bEnable)
+    {
+        ExitIdle(TEXT("idle throttle disabled"));
+        bIdleThrottleEnabled = false;
+        return;
+    }
+
+    // 待機中に設定が変わったら、いったん戻してから新しい設定で入り直す
+    const bool bWasIdle = bIsIdle;
+    ExitIdle(TEXT("idle settings changed"));
+    IdleFPS = FMath::Max(0.0f, InIdleFPS);
+    bIdleSuspendRendering = bSuspendRendering;
+    if (!bIdleThrottleEnabled)
+    {
+        bIdleThrottleEnabled = true;
+        IdleNoContentSince = -1.0;
+        IdleLastInteractionTime = FSlateApplication::IsInitialized() ? FSlateApplication::Get().GetLastUserInteractionTime() : 0.0;
+        IdleAccumulatedSeconds = 0.0;
+        ActiveAccumulatedSeconds = 0.0;
+        IdleEntryCount = 0;
+        UE_LOG(LogWindowHelper, Log, TEXT("SetIdleThrottle: Enabled at %.0f FPS%s."), IdleFPS, bIdleSuspendRendering ? TEXT(" with rendering suspended") : TEXT(""));
+    }
+    else if (bWasIdle)
+    {
+        EnterIdle();
+    }
+#else
+    UE_LOG(LogWindowHelper, Log, TEXT("SetIdleThrottle: Not supported on this platform."));
+#endif
+}
+
+FWindowIdleStats UWindowTransparencyHelper::GetIdleStats() const
+{
+    FWindowIdleStats Stats;
+    Stats.bIdle = bIsIdle;
+    Stats.IdleSeconds = static_cast<float>(IdleAccumulatedSeconds);
+    Stats.ActiveSeconds = static_cast<float>(ActiveAccumulatedSeconds);
+    const double TotalSeconds = IdleAccumulatedSeconds + ActiveAccumulatedSeconds;
+    Stats.IdleFraction = TotalSeconds > 0.0 ? static_cast<float>(IdleAccumulatedSeconds / TotalSeconds) : 0.0f;
+    Stats.IdleEntries = IdleEntryCount;
+    return Stats;
+}
+
+void UWindowTransparencyHelper::UpdateIdleThrottle()
+{
+#if PLATFORM_WINDOWS
+    if (!bIdleThrottleEnabled)
+    {
+        return;
+    }
+
+    // ワールドの DeltaTime は時間の遅れの影響を受けるので、実時間で集計する
+    const double AppDeltaTime = FApp::GetDeltaTime();
+    (bIsIdle ? IdleAccumulatedSeconds : ActiveAccumulatedSeconds) += AppDeltaTime;
+
+    if (!bIsDWMTransparentActive)
+    {
+        // 透過していなければ空のフレームも背景として見えているので待機しない
+        IdleNoContentSince = -1.0;
+        ExitIdle(TEXT("DWM transparency is off"));
+        return;
+    }
+
+    // 入力があればすぐに戻す
+    const double LastInteractionTime = FSlateApplication::IsInitialized() ? FSlateApplication::Get().GetLastUserInteractionTime() : 0.0;
+    if (LastInteractionTime > IdleLastInteractionTime)
+    {
+        IdleLastInteractionTime = LastInteractionTime;
+        IdleNoContentSince = -1.0;
+        ExitIdle(TEXT("user input"));
+        return;
+    }
+
+    // 通常時は一定間隔で、待機中は（すでに低いFPSなので）毎回調べる
+    constexpr float IdleCheckInterval = 0.1f;
+    TimeSinceIdleCheck += static_cast<float>(AppDeltaTime);
+    if (!bIsIdle && TimeSinceIdleCheck < IdleCheckInterval)
+    {
+        return;
+    }
+    TimeSinceIdleCheck = 0.0f;
+
+    APlayerController* PC = GetFirstLocalPlayerController(this);
+    if (!PC || HasVisibleContent(PC))
+    {
+        IdleNoContentSince = -1.0;
+        ExitIdle(TEXT("content on screen"));
+        return;
+    }
+
+    const double Now = FPlatformTime::Seconds();
+    if (IdleNoContentSince < 0.0)
+    {
+        IdleNoContentSince = Now;
+    }
+    if (!bIsIdle && Now - IdleNoContentSince >= IdleDelaySeconds)
+    {
+        EnterIdle();
+    }
+#endif
+}
+
+bool UWindowTransparencyHelper::HasVisibleContent(APlayerController* PC)
+{
+    // UI: ブロックするウィジェットが表示されていれば内容あり
+    RefreshWidgetHitCache();
+    for (const FWidgetHitEntry& Entry : WidgetHitCache)
+    {
+        if (Entry.bBlocking)
+        {
+            return true;
+        }
+    }
+
+    // 3D: 登録されたヒットテストの対象（とステンシルのアクター）のうち、ビューポートに映っているものがあるか。
+    // 床や壁のようなワールドの衝突は、映っていても内容とはみなさない
+    FBox2D ContentBounds;
+    if (!ComputeContentScreenBounds(PC, ContentBounds, false))
+    {
+        // ビューを投影できないときは、映っているものとみなす
+        return true;
+    }
+    if (!ContentBounds.bIsValid)
+    {
+        return false;
+    }
+    FViewport* Viewport = GEngine && GEngine->GameViewport ? GEngine->GameViewport->Viewport : nullptr;
+    if (!Viewport)
+    {
+        return true;
+    }
+    const FBox2D ViewportRect(FVector2D::ZeroVector, FVector2D(Viewport->GetSizeXY()));
+    return ContentBounds.Intersect(ViewportRect);
+}
+
+void UWindowTransparencyHelper::EnterIdle()
+{
+    if (bIsIdle)
+    {
+        return;
+    }
+    bIsIdle = true;
+    ++IdleEntryCount;
+
+    if (GEngine && IdleFPS > 0.0f)
+    {
+        IdleSavedMaxFPS = GEngine->GetMaxFPS();
+        if (IdleSavedMaxFPS <= 0.0f || IdleSavedMaxFPS > IdleFPS)
+        {
+            GEngine->SetMaxFPS(IdleFPS);
+            bIdleMaxFPSApplied = true;
+        }
+    }
+    FViewport* Viewport = GEngine && GEngine->GameViewport ? GEngine->GameViewport->Viewport : nullptr;
+    if (bIdleSuspendRendering && Viewport)
+    {
+        // 最後に描画した（透明な）フレームがそのまま表示され続ける
+        Viewport->SetGameRenderingEnabled(false);
+        bIdleRenderingSuspended = true;
+    }
+    UE_LOG(LogWindowHelper, Log, TEXT("EnterIdle: No opaque content for %.2f s. %s%s"), IdleDelaySeconds,
+        bIdleMaxFPSApplied ? *FString::Printf(TEXT("Capping at %.0f FPS."), IdleFPS) : TEXT("Frame rate unchanged."),
+        bIdleRenderingSuspended ? TEXT(" Viewport rendering suspended.") : TEXT(""));
+}
+
+void UWindowTransparencyHelper::ExitIdle(const TCHAR* Reason)
+{
+    if (!bIsIdle)
+    {
+        return;
+    }
+    bIsIdle = false;
+    TimeSinceIdleCheck = 0.0f;
+
+    // 待機中にゲーム側が上限を変えていたら、その値を優先して戻さない
+    if (bIdleMaxFPSApplied && GEngine)
+    {
+        if (FMath::IsNearlyEqual(GEngine->GetMaxFPS(), IdleFPS))
+        {
+            GEngine->SetMaxFPS(IdleSavedMaxFPS);
+        }
+        else
+        {
+            UE_LOG(LogWindowHelper, Log, TEXT("ExitIdle: Max FPS was changed to %.0f while idle. Keeping it instead of restoring %.0f."), GEngine->GetMaxFPS(), IdleSavedMaxFPS);
+        }
+    }
+    bIdleMaxFPSApplied = false;
+    FViewport* Viewport = GEngine && GEngine->GameViewport ? GEngine->GameViewport->Viewport : nullptr;
+    if (bIdleRenderingSuspended && Viewport)
+    {
+        Viewport->SetGameRenderingEnabled(true);
+    }
+    bIdleRenderingSuspended = false;
+    UE_LOG(LogWindowHelper, Log, TEXT("ExitIdle: Resuming normal rendering (%s)."), Reason);
+}
+
+void UWindowTransparencyHelper::SetWallpaperGovernor(bool bEnable, float InWallpaperFPS, float InOccludedFPS, bool bPauseWhenOccluded)
+{
+#if PLATFORM_WINDOWS
+    WallpaperFPS = FMath::Max(0.0f, InWallpaperFPS);
+    WallpaperOccludedFPS = FMath::Max(0.0f, InOccludedFPS);
+    bWallpaperPauseWhenOccluded = bPauseWhenOccluded;
+    if (bEnable != bWallpaperGovernorEnabled)
+    {
+        bWallpaperGovernorEnabled = bEnable;
+        if (bEnable)
+        {
+            WallpaperVisibleSeconds = 0.0;
+            WallpaperOccludedSeconds = 0.0;
+            WallpaperOcclusionCount = 0;
+        }
+        UE_LOG(LogWindowHelper, Log, TEXT("SetWallpaperGovernor: %s (%.0f FPS visible, %.0f FPS occluded%s)."), bEnable ? TEXT("Enabled") : TEXT("Disabled"),
+            WallpaperFPS, WallpaperOccludedFPS, bWallpaperPauseWhenOccluded ? TEXT(", paused when occluded") : TEXT(""));
+    }
+    UpdateWallpaperGovernor();
+    if (bWallpaperGovernorActive)
+    {
+        ApplyWallpaperFrameRate();
+    }
+#else
+    UE_LOG(LogWindowHelper, Log, TEXT("SetWallpaperGovernor: Not supported on this platform."));
+#endif
+}
+
+FWindowWallpaperGovernorStats UWindowTransparencyHelper::GetWallpaperGovernorStats() const
+{
+    FWindowWallpaperGovernorStats Stats;
+    Stats.bActive = bWallpaperGovernorActive;
+    Stats.bOccluded = bWallpaperOccluded;
+    Stats.VisibleDesktopFraction = WallpaperVisibleFraction;
+    Stats.VisibleSeconds = static_cast<float>(WallpaperVisibleSeconds);
+    Stats.OccludedSeconds = static_cast<float>(WallpaperOccludedSeconds);
+    Stats.Occlusions = WallpaperOcclusionCount;
+    return Stats;
+}
+
+void UWindowTransparencyHelper::UpdateWallpaperGovernor()
+{
+#if PLATFORM_WINDOWS
+    const bool bShouldBeActive = bWallpaperGovernorEnabled && bIsDesktopBackgroundActive;
+    if (bShouldBeActive && !bWallpaperGovernorActive)
+    {
+        ActivateWallpaperGovernor();
+    }
+    else if (!bShouldBeActive && bWallpaperGovernorActive)
+    {
+        DeactivateWallpaperGovernor();
+    }
+    if (bWallpaperGovernorActive)
+    {
+        (bWallpaperOccluded ? WallpaperOccludedSeconds : WallpaperVisibleSeconds) += FApp::GetDeltaTime();
+    }
+#endif
+}
+
+void UWindowTransparencyHelper::ActivateWallpaperGovernor()
+{
+    if (bWallpaperGovernorActive)
+    {
+        return;
+    }
+    bWallpaperGovernorActive = true;
+    bWallpaperOccluded = false;
+    WallpaperVisibleFraction = 1.0f;
+    WallpaperSavedMaxFPS = GEngine ? GEngine->GetMaxFPS() : 0.0f;
+
+    // 外部ウィンドウのスナップショットを購読して、覆われ具合を判定する（購読中だけ列挙が行われる）
+    WallpaperSnapshotHandle = ExternalWindowsSnapshotUpdated.AddUObject(this, &UWindowTransparencyHelper::OnWallpaperSnapshotUpdated);
+    ApplyWallpaperFrameRate();
+    UE_LOG(LogWindowHelper, Log, TEXT("ActivateWallpaperGovernor: Governing the desktop background frame rate."));
+}
+
+void UWindowTransparencyHelper::DeactivateWallpaperGovernor()
+{
+    if (!bWallpaperGovernorActive)
+    {
+        return;
+    }
+    bWallpaperGovernorActive = false;
+    bWallpaperOccluded = false;
+    ExternalWindowsSnapshotUpdated.Remove(WallpaperSnapshotHandle);
+    WallpaperSnapshotHandle.Reset();
+
+    // ExitIdle と同じく、壁紙モード中にゲーム側が上限を変えていたら、その値を優先して戻さない
+    if (GEngine)
+    {
+        if (FMath::IsNearlyEqual(GEngine->GetMaxFPS(), WallpaperAppliedMaxFPS))
+        {
+            GEngine->SetMaxFPS(WallpaperSavedMaxFPS);
+            UE_LOG(LogWindowHelper, Log, TEXT("DeactivateWallpaperGovernor: Restored the frame rate cap to %.0f."), WallpaperSavedMaxFPS);
+        }
+        else
+        {
+            UE_LOG(LogWindowHelper, Log, TEXT("DeactivateWallpaperGovernor: Max FPS was changed to %.0f in wallpaper mode. Keeping it instead of restoring %.0f."), GEngine->GetMaxFPS(), WallpaperSavedMaxFPS);
+        }
+    }
+    FViewport* Viewport = GEngine && GEngine->GameViewport ? GEngine->GameViewport->Viewport : nullptr;
+    if (bWallpaperRenderingPaused && Viewport)
+    {
+        Viewport->SetGameRenderingEnabled(true);
+    }
+    bWallpaperRenderingPaused = false;
+}
+
+void UWindowTransparencyHelper::ApplyWallpaperFrameRate()
+{
+    if (GEngine)
+    {
+        const float Cap = bWallpaperOccluded ? WallpaperOccludedFPS : WallpaperFPS;
+        WallpaperAppliedMaxFPS = Cap > 0.0f ? Cap : WallpaperSavedMaxFPS;
+        GEngine->SetMaxFPS(WallpaperAppliedMaxFPS);
+    }
+
+    const bool bShouldPause = bWallpaperOccluded && bWallpaperPauseWhenOccluded;
+    FViewport* Viewport = GEngine && GEngine->GameViewport ? GEngine->GameViewport->Viewport : nullptr;
+    if (Viewport && bShouldPause != bWallpaperRenderingPaused)
+    {
+        Viewport->SetGameRenderingEnabled(!bShouldPause);
+        bWallpaperRenderingPaused = bShouldPause;
+    }
+}
+
+void UWindowTransparencyHelper::OnWallpaperSnapshotUpdated(const TArray<FOtherWindowInfo>& Snapshot)
+{
+#if PLATFORM_WINDOWS
+    RECT WindowRect;
+    if (!bWallpaperGovernorActive || !GameHWnd || !OSBackend->GetWindowScreenRect(GameHWnd, WindowRect))
+    {
+        return;
+    }
+
+    // 見えうるのは壁紙のうち作業領域（タスクバーを除く）に入っている部分だけ
+    const FIntRect DesktopRect(WindowRect.left, WindowRect.top, WindowRect.right, WindowRect.bottom);
+    TArray<FIntRect> WorkAreas;
+    EnumDisplayMonitors(nullptr, nullptr, &CollectMonitorWorkAreasProc, reinterpret_cast<LPARAM>(&WorkAreas));
+    TArray<FIntRect> DesktopRegions;
+    for (FIntRect WorkArea : WorkAreas)
+    {
+        WorkArea.Clip(DesktopRect);
+        if (WorkArea.Area() > 0)
+        {
+            DesktopRegions.Add(WorkArea);
+        }
+    }
+    if (DesktopRegions.Num() == 0)
+    {
+        DesktopRegions.Add(DesktopRect);
+    }
+
+    TArray<FIntRect> Occluders;
+    Occluders.Reserve(Snapshot.Num());
+    for (const FOtherWindowInfo& Info : Snapshot)
+    {
+        if (Info.bSeeThrough)
+        {
+            continue;
+        }
+        Occluders.Add(Info.FrameBounds.Area() > 0 ? Info.FrameBounds : FIntRect(Info.PosX, Info.PosY, Info.PosX + Info.Width, Info.PosY + Info.Height));
+    }
+
+    const int64 DesktopArea = FWindowTransparencyKernels::ComputeUncoveredArea(DesktopRegions, TArray<FIntRect>());
+    const int64 VisibleArea = FWindowTransparencyKernels::ComputeUncoveredArea(DesktopRegions, Occluders);
+    WallpaperVisibleFraction = DesktopArea > 0 ? static_cast<float>(static_cast<double>(VisibleArea) / DesktopArea) : 0.0f;
+
+    // 境界のずれで残る細い隙間は覆われているとみなす
+    constexpr float OccludedVisibleFraction = 0.005f;
+    const bool bOccluded = WallpaperVisibleFraction <= OccludedVisibleFraction;
+    if (bOccluded != bWallpaperOccluded)
+    {
+        bWallpaperOccluded = bOccluded;
+        if (bOccluded)
+        {
+            ++WallpaperOcclusionCount;
+        }
+        ApplyWallpaperFrameRate();
+        UE_LOG(LogWindowHelper, Log, TEXT("OnWallpaperSnapshotUpdated: Desktop %s (%.1f%% visible)."),
+            bOccluded ? TEXT("fully covered, throttling") : TEXT("visible again, restoring the wallpaper frame rate"), 100.0f * WallpaperVisibleFraction);
+    }
+#endif
+}
+
+void UWindowTransparencyHelper::SetWallpaperMouseInputEnabled(bool bEnable)
+{
+    if (bEnable != bWallpaperMouseInputEnabled)
+    {
+        bWallpaperMouseInputEnabled = bEnable;
+        UE_LOG(LogWindowHelper, Log, TEXT("SetWallpaperMouseInputEnabled: %s."), bEnable ? TEXT("Enabled") : TEXT("Disabled"));
+    }
+    UpdateWallpaperMouseInput();
+}
+
+bool UWindowTransparencyHelper::IsWallpaperMouseInputActive() const
+{
+#if PLATFORM_WINDOWS
+    return RawInputThread.IsValid() && RawInputThread->IsRunning();
+#else
+    return false;
+#endif
+}
+
+void UWindowTransparencyHelper::UpdateWallpaperMouseInput()
+{
+#if PLATFORM_WINDOWS
+    // 登録はプロセス全体に効くので、使われている間だけ行う
+    const bool bShouldRun = bWallpaperMouseInputEnabled && bIsDesktopBackgroundActive && WallpaperMouseEvents.IsBound() && !OSBackend->GetGameWindowOverride();
+    if (!bShouldRun)
+    {
+        if (RawInputThread.IsValid())
+        {
+            RawInputThread.Reset();
+            UE_LOG(LogWindowHelper, Log, TEXT("UpdateWallpaperMouseInput: Raw input thread stopped."));
+        }
+        return;
+    }
+    if (RawInputThread.IsValid())
+    {
+        // 入力スレッドの初期化は非同期なので、失敗はここで拾う
+        if (!RawInputThread->IsRunning())
+        {
+            RawInputThread.Reset();
+            bWallpaperMouseInputEnabled = false;
+            UE_LOG(LogWindowHelper, Warning, TEXT("UpdateWallpaperMouseInput: The raw input thread failed to start. Wallpaper mouse input is disabled."));
+        }
+        return;
+    }
+    if (!FPlatformProcess::SupportsMultithreading())
+    {
+        return;
+    }
+
+    // 入力スレッドからはバッチの最初の1件でだけ呼ばれ、ゲームスレッドでまとめて取り出す
+    TWeakObjectPtr<UWindowTransparencyHelper> WeakThis(this);
+    RawInputThread = MakeShared<FWindowRawInputThread>([WeakThis]()
+    {
+        AsyncTask(ENamedThreads::GameThread, [WeakThis]()
+        {
+            if (UWindowTransparencyHelper* Helper = WeakThis.Get())
+            {
+                Helper->DispatchWallpaperMouseEvents();
+            }
+        });
+    });
+    if (!RawInputThread->IsRunning())
+    {
+        RawInputThread.Reset();
+        // 作れなかったときは毎 Tick 再試行しない
+        bWallpaperMouseInputEnabled = false;
+        UE_LOG(LogWindowHelper, Warning, TEXT("UpdateWallpaperMouseInput: Could not start the raw input thread. Wallpaper mouse input is disabled."));
+        return;
+    }
+    WallpaperMouseBatchCount = 0;
+    WallpaperMouseEventCount = 0;
+    UE_LOG(LogWindowHelper, Log, TEXT("UpdateWallpaperMouseInput: Raw input thread started."));
+#endif
+}
+
+void UWindowTransparencyHelper::DispatchWallpaperMouseEvents()
+{
+#if PLATFORM_WINDOWS
+    if (!RawInputThread.IsValid())
+    {
+        return;
+    }
+    TArray<FWindowRawMouseEvent> RawEvents;
+    RawInputThread->DrainEvents(RawEvents);
+
+    RECT WindowRect;
+    if (RawEvents.Num() == 0 || !bIsDesktopBackgroundActive || !GameHWnd || !OSBackend->GetWindowScreenRect(GameHWnd, WindowRect))
+    {
+        return;
+    }
+
+    // 壁紙モードでは Tick のヒットテストが動かないので、ここで同じパイプラインを使う
+    APlayerController* PC = GetFirstLocalPlayerController(this);
+    const bool bUsePipeline = PC && bHitTestingGloballyEnabled && CurrentHitTestTypeLogic != EWindowHitTestType::None;
+    if (bUsePipeline)
+    {
+        EnsureHitTestPipeline();
+        if (bHitTestPipelineUsesTargets)
+        {
+            HitTestTargets.Refresh();
+        }
+    }
+
+    TArray<FWindowWallpaperMouseEvent> Events;
+    Events.Reserve(RawEvents.Num());
+    // 統計は Tick のヒットテストのものなので、ここでは記録しない
+    auto HitTestEvent = [this, PC, bUsePipeline](FWindowWallpaperMouseEvent& Event)
+    {
+        FHitResult Hit;
+        const bool bHit3D = TraceHitTestKernel(PC, Event.Position, bUsePipeline && bHitTestPipelineUsesTargets, Hit);
+        Event.HitActor = bHit3D ? Hit.GetActor() : nullptr;
+        Event.bOverContent = bUsePipeline ? RunHitTestPipeline(PC, Event.Position, false) : bHit3D;
+    };
+    int32 LastMoveIndex = INDEX_NONE;
+    for (const FWindowRawMouseEvent& RawEvent : RawEvents)
+    {
+        FWindowWallpaperMouseEvent& Event = Events.AddDefaulted_GetRef();
+        Event.Position = FVector2D(RawEvent.ScreenPosition.x - WindowRect.left, RawEvent.ScreenPosition.y - WindowRect.top);
+        Event.WheelDelta = RawEvent.WheelDelta;
+        Event.Timestamp = RawEvent.Time;
+        switch (RawEvent.Type)
+        {
+        case FWindowRawMouseEvent::EType::ButtonDown:
+            Event.Type = EWindowWallpaperMouseEventType::ButtonDown;
+            break;
+        case FWindowRawMouseEvent::EType::ButtonUp:
+            Event.Type = EWindowWallpaperMouseEventType::ButtonUp;
+            break;
+        case FWindowRawMouseEvent::EType::Wheel:
+            Event.Type = EWindowWallpaperMouseEventType::Wheel;
+            break;
+        case FWindowRawMouseEvent::EType::Move:
+        default:
+            Event.Type = EWindowWallpaperMouseEventType::Move;
+            break;
+        }
+        if (Event.Type == EWindowWallpaperMouseEventType::ButtonDown || Event.Type == EWindowWallpaperMouseEventType::ButtonUp)
+        {
+            static const FKey Buttons[] = { EKeys::LeftMouseButton, EKeys::RightMouseButton, EKeys::MiddleMouseButton, EKeys::ThumbMouseButton, EKeys::ThumbMouseButton2 };
+            Event.Button = Buttons[FMath::Clamp(RawEvent.Button, 0, static_cast<int32>(UE_ARRAY_COUNT(Buttons)) - 1)];
+        }
+
+        if (!PC)
+        {
+            continue;
+        }
+        // 移動はバッチの最後の位置でまとめて判定する
+        if (Event.Type == EWindowWallpaperMouseEventType::Move)
+        {
+            LastMoveIndex = Events.Num() - 1;
+            continue;
+        }
+        HitTestEvent(Event);
+    }
+    if (LastMoveIndex != INDEX_NONE)
+    {
+        HitTestEvent(Events[LastMoveIndex]);
+        for (FWindowWallpaperMouseEvent& Event : Events)
+        {
+            if (Event.Type == EWindowWallpaperMouseEventType::Move)
+            {
+                Event.bOverContent = Events[LastMoveIndex].bOverContent;
+                Event.HitActor = Events[LastMoveIndex].HitActor;
+            }
+        }
+    }
+
+    ++WallpaperMouseBatchCount;
+    WallpaperMouseEventCount += Events.Num();
+    WallpaperMouseEvents.Broadcast(Events);
+#endif
+}
+
+void UWindowTransparencyHelper::SetExternalWindowsSnapshotInterval(FDelegateHandle Subscriber, float IntervalSeconds)
+{
+    ExternalWindowsSnapshotIntervalRequests.Add(Subscriber, FMath::Max(0.0f, IntervalSeconds));
+    UpdateExternalWindowsSnapshotInterval();
+}
+
+void UWindowTransparencyHelper::ClearExternalWindowsSnapshotInterval(FDelegateHandle Subscriber)
+{
+    ExternalWindowsSnapshotIntervalRequests.Remove(Subscriber);
+    UpdateExternalWindowsSnapshotInterval();
+}
+
+void UWindowTransparencyHelper::SetExternalWindowsSnapshotIntervalOverride(float IntervalSeconds)
+{
+    ExternalWindowsSnapshotIntervalOverride = IntervalSeconds;
+    UpdateExternalWindowsSnapshotInterval();
+}
+
+void UWindowTransparencyHelper::UpdateExternalWindowsSnapshotInterval()
+{
+    if (ExternalWindowsSnapshotIntervalOverride >= 0.0f)
+    {
+        ExternalWindowsSnapshotInterval = ExternalWindowsSnapshotIntervalOverride;
+        return;
+    }
+
+    // 購読者ごとの要求のうち最も短い間隔に合わせる。後から登録した購読者が他の購読者の更新を遅らせないようにする
+    float Interval = TNumericLimits<float>::Max();
+    for (const TPair<FDelegateHandle, float>& Request : ExternalWindowsSnapshotIntervalRequests)
+    {
+        Interval = FMath::Min(Interval, Request.Value);
+    }
+    ExternalWindowsSnapshotInterval = ExternalWindowsSnapshotIntervalRequests.Num() > 0 ? Interval : 0.1f;
+}
+
+void UWindowTransparencyHelper::UpdateExternalWindowsSnapshot(float DeltaTime)
+{
+#if PLATFORM_WINDOWS
+    if (!ExternalWindowsSnapshotUpdated.IsBound())
+    {
+        // 購読者がいない間は列挙しない。購読開始直後に即座に取得できるようにしておく
+        TimeSinceExternalWindowsSnapshot = ExternalWindowsSnapshotInterval;
+        return;
+    }
+
+    TimeSinceExternalWindowsSnapshot += DeltaTime;
+    if (TimeSinceExternalWindowsSnapshot < ExternalWindowsSnapshotInterval)
+    {
+        return;
+    }
+    TimeSinceExternalWindowsSnapshot = 0.0f;
+
+    bool bSuccess = false;
+    TArray<FOtherWindowInfo> NewSnapshot = GetOtherWindowsInformation(bSuccess);
+    if (!bSuccess)
+    {
+        return;
+    }
+    ExternalWindowsSnapshot = MoveTemp(NewSnapshot);
+    ExternalWindowsSnapshotUpdated.Broadcast(ExternalWindowsSnapshot);
+#endif
+}
+
+void UWindowTransparencyHelper::SetHitTestEnabled(bool bEnable)
+{
+    bHitTestingGloballyEnabled = bEnable;
+    if (!bEnable)
+    {
+        if (bIsClickThroughStateOS)
+        {
+            UE_LOG(LogWindowHelper, Log, TEXT("Hit Test Disabled. Window was click-through, setting to interactive."));
+            EnableClickThrough(false);
+        }
+        bIsMouseOverOpaqueAreaLogic = true;
+    }
+    else { UE_LOG(LogWindowHelper, Log, TEXT("Hit Test Enabled: %s"), bEnable ? TEXT("true") : TEXT("false")); }
+}
+
+void UWindowTransparencyHelper::SetHitTestType(EWindowHitTestType NewType)
+{
+    if (CurrentHitTestTypeLogic != NewType)
+    {
+        CurrentHitTestTypeLogic = NewType;
+        UE_LOG(LogWindowHelper, Log, TEXT("Hit Test Type set to: %s"), *UEnum::GetValueAsString(NewType));
+    }
+}
+
+void UWindowTransparencyHelper::SetGameRaycastTraceChannel(ECollisionChannel NewChannel)
+{
+    if (GameRaycastTraceChannelLogic != NewChannel)
+    {
+        GameRaycastTraceChannelLogic = NewChannel;
+        const UEnum* EnumPtr = StaticEnum<ECollisionChannel>();
+        FString ChannelName = EnumPtr ? EnumPtr->GetNameStringByValue(static_cast<int64>(NewChannel)) : FString::FromInt(static_cast<int32>(NewChannel));
+        UE_LOG(LogWindowHelper, Log, TEXT("Game Raycast Trace Channel set to: %s"), *ChannelName);
+    }
+}
+
+void UWindowTransparencyHelper::SetHitTestKernel(EWindowHitTestKernel NewKernel, float RadiusPixels)
+{
+    HitTestKernel = NewKernel;
+    HitTestKernelRadius = FMath::Max(0.0f, RadiusPixels);
+    RebuildHitTestKernel();
+    UE_LOG(LogWindowHelper, Log, TEXT("Hit Test Kernel set to: %s (Radius %.1f px, %d samples)"), *UEnum::GetValueAsString(NewKernel), HitTestKernelRadius, HitTestKernelSamples.Num());
+}
+
+void UWindowTransparencyHelper::SetHitTestCombineRule(EWindowHitTestCombineRule NewRule, float WeightedThreshold)
+{
+    HitTestCombineRule = NewRule;
+    HitTestWeightedThreshold = FMath::Clamp(WeightedThreshold, 0.0f, 1.0f);
+    UE_LOG(LogWindowHelper, Log, TEXT("Hit Test Combine Rule set to: %s (Weighted threshold %.2f)"), *UEnum::GetValueAsString(NewRule), HitTestWeightedThreshold);
+}
+
+void UWindowTransparencyHelper::RebuildHitTestKernel()
+{
+    HitTestKernelSamples.Reset();
+
+    // 中心を先頭に、内側から外側の順に並べる（早期打ち切りが効きやすい）
+    TArray<FVector2f> Offsets;
+    Offsets.Add(FVector2f::ZeroVector);
+    const float R = HitTestKernelRadius;
+    if (R > 0.0f)
+    {
+        switch (HitTestKernel)
+        {
+        case EWindowHitTestKernel::Cross:
+            Offsets.Append({ FVector2f(R, 0.0f), FVector2f(-R, 0.0f), FVector2f(0.0f, R), FVector2f(0.0f, -R) });
+            break;
+        case EWindowHitTestKernel::Grid3x3:
+            Offsets.Append({ FVector2f(R, 0.0f), FVector2f(-R, 0.0f), FVector2f(0.0f, R), FVector2f(0.0f, -R) });
+            Offsets.Append({ FVector2f(R, R), FVector2f(-R, R), FVector2f(R, -R), FVector2f(-R, -R) });
+            break;
+        case EWindowHitTestKernel::Disc:
+            for (int32 Index = 0; Index < 6; ++Index)
+            {
+                const float Angle = UE_TWO_PI * Index / 6.0f;
+                Offsets.Add(FVector2f(FMath::Cos(Angle), FMath::Sin(Angle)) * (R * 0.5f));
+            }
+            for (int32 Index = 0; Index < 12; ++Index)
+            {
+                const float Angle = UE_TWO_PI * (Index + 0.5f) / 12.0f;
+                Offsets.Add(FVector2f(FMath::Cos(Angle), FMath::Sin(Angle)) * R);
+            }
+            break;
+        case EWindowHitTestKernel::SinglePoint:
+        default:
+            break;
+        }
+    }
+
+    // 重みは中心1.0、半径上で0.5になるように線形に減らし、合計が1になるよう正規化する
+    float TotalWeight = 0.0f;
+    for (const FVector2f& Offset : Offsets)
+    {
+        const float Weight = R > 0.0f ? 1.0f - 0.5f * FMath::Min(Offset.Size() / R, 1.0f) : 1.0f;
+        HitTestKernelSamples.Add(FVector3f(Offset.X, Offset.Y, Weight));
+        TotalWeight += Weight;
+    }
+    for (FVector3f& Sample : HitTestKernelSamples)
+    {
+        Sample.Z /= TotalWeight;
+    }
+}
+
+bool UWindowTransparencyHelper::TraceHitTestKernel(APlayerController* PC, const FVector2D& MousePosInWindow, bool bUseRegisteredTargets, FHitResult& OutHit)
+{
+    LastHitTestKernelSamplesTraced = 0;
+
+    // 逆ビュー射影行列はサンプル数に関係なく1回だけ計算する
+    UWorld* World = PC->GetWorld();
+    FSceneViewProjectionData ProjectionData;
+    if (!World || !GetPlayerProjectionData(PC, ProjectionData))
+    {
+        return false;
+    }
+    const FMatrix InvViewProjectionMatrix = ProjectionData.ComputeViewProjectionMatrix().InverseFast();
+    const FIntRect ViewRect = ProjectionData.GetConstrainedViewRect();
+
+    FCollisionQueryParams CollisionParams(SCENE_QUERY_STAT(WindowTransparencyRaycastKernel), GWindowHitTestTraceComplex);
+    const double TraceDistance = PC->HitResultTraceDistance;
+
+    const int32 NumSamples = HitTestKernelSamples.Num();
+    TArray<FVector, TInlineAllocator<19>> SampleOrigins;
+    TArray<FVector, TInlineAllocator<19>> SampleDirections;
+    SampleOrigins.SetNum(NumSamples);
+    SampleDirections.SetNum(NumSamples);
+    for (int32 SampleIndex = 0; SampleIndex < NumSamples; ++SampleIndex)
+    {
+        const FVector3f& Sample = HitTestKernelSamples[SampleIndex];
+        FSceneView::DeprojectScreenToWorld(MousePosInWindow + FVector2D(Sample.X, Sample.Y), ViewRect, InvViewProjectionMatrix, SampleOrigins[SampleIndex], SampleDirections[SampleIndex]);
+    }
+
+    // ワールドへのトレースはサンプルごとにシーンクエリになる。画面上のブロードフェーズ矩形（1フレームに1回だけ更新）の
+    // 外にあるサンプルは何にも当たらないので、トレースせずに外れとして数える。
+    // 全サンプルを包む球のスイープは遠くで半径がメートル単位になり、ライントレースより高くつくので使わない
+    const bool bSkipOutsideBroadPhase = !bUseRegisteredTargets && NumSamples > 1 && GWindowHitTestBroadPhase;
+    if (bSkipOutsideBroadPhase)
+    {
+        UpdateHitTestBroadPhase(PC);
+    }
+
+    int32 HitCount = 0;
+    float HitWeight = 0.0f;
+    float RemainingWeight = 1.0f;
+    bool bResult = false;
+
+    for (int32 SampleIndex = 0; SampleIndex < NumSamples; ++SampleIndex)
+    {
+        const FVector3f& Sample = HitTestKernelSamples[SampleIndex];
+        FHitResult SampleHit;
+        const bool bTraceSample = !bSkipOutsideBroadPhase || IsInHitTestBroadPhase(MousePosInWindow + FVector2D(Sample.X, Sample.Y), 0.0);
+        if (bTraceSample)
+        {
+            ++LastHitTestKernelSamplesTraced;
+        }
+        if (bTraceSample && TraceHitTestSample(World, SampleOrigins[SampleIndex], SampleDirections[SampleIndex], TraceDistance, CollisionParams, bUseRegisteredTargets, SampleHit))
+        {
+            if (HitCount == 0)
+            {
+                OutHit = SampleHit;
+            }
+            ++HitCount;
+            HitWeight += Sample.Z;
+        }
+        RemainingWeight -= Sample.Z;
+
+        // 残りのサンプルで結果が変わらなくなった時点で打ち切る
+        const int32 RemainingSamples = NumSamples - SampleIndex - 1;
+        bool bDecided = false;
+        switch (HitTestCombineRule)
+        {
+        case EWindowHitTestCombineRule::Majority:
+            bDecided = HitCount * 2 > NumSamples || (HitCount + RemainingSamples) * 2 <= NumSamples;
+            bResult = HitCount * 2 > NumSamples;
+            break;
+        case EWindowHitTestCombineRule::Weighted:
+            bDecided = HitWeight >= HitTestWeightedThreshold || HitWeight + RemainingWeight < HitTestWeightedThreshold;
+            bResult = HitWeight >= HitTestWeightedThreshold;
+            break;
+        case EWindowHitTestCombineRule::Any:
+        default:
+            bDecided = HitCount > 0;
+            bResult = HitCount > 0;
+            break;
+        }
+        if (bDecided)
+        {
+            break;
+        }
+    }
+
+    INC_DWORD_STAT_BY(STAT_WindowTransparency_HitTestKernelTraces, LastHitTestKernelSamplesTraced);
+    CSV_CUSTOM_STAT(WindowTransparency, HitTestKernelTraces, LastHitTestKernelSamplesTraced, ECsvCustomStatOp::Accumulate);
+    return bResult;
+}
+
+bool UWindowTransparencyHelper::TraceHitTestSample(UWorld* World, const FVector& WorldOrigin, const FVector& WorldDirection, double TraceDistance, const FCollisionQueryParams& CollisionParams, bool bUseRegisteredTargets, FHitResult& OutHit) const
+{
+    if (!bUseRegisteredTargets)
+    {
+        return World->LineTraceSingleByChannel(OutHit, WorldOrigin, WorldOrigin + WorldDirection * TraceDistance, GameRaycastTraceChannelLogic, CollisionParams) && OutHit.GetActor();
+    }
+
+    FWindowHitTestBVHHit TargetHit;
+    if (!HitTestTargets.RayCast(WorldOrigin, WorldDirection, TraceDistance, TargetHit))
+    {
+        return false;
+    }
+    USceneComponent* TargetComponent = TargetHit.Owner.Get();
+    AActor* TargetActor = TargetComponent ? TargetComponent->GetOwner() : nullptr;
+    if (!TargetActor)
+    {
+        return false;
+    }
+    OutHit = FHitResult(TargetActor, nullptr, WorldOrigin + WorldDirection * TargetHit.Distance, -WorldDirection);
+    OutHit.Distance = TargetHit.Distance;
+    OutHit.TraceStart = WorldOrigin;
+    OutHit.TraceEnd = WorldOrigin + WorldDirection * TraceDistance;
+    return true;
+}
+
+void UWindowTransparencyHelper::UpdateHitTestBroadPhase(APlayerController* PC)
+{
+    if (HitTestBroadPhaseFrame == GFrameCounter)
+    {
+        return;
+    }
+    HitTestBroadPhaseFrame = GFrameCounter;
+    HitTestBroadPhaseRects.Reset();
+    bHitTestBroadPhaseCoversAll = false;
+
+    SCOPE_CYCLE_COUNTER(STAT_WindowTransparency_HitTestBroadPhase);
+    WT_TRACE_SCOPE("WindowTransparency::HitTestBroadPhase");
+
+    // 3D: トレースチャンネルをブロックするコンポーネントのバウンドを画面に投影する
+    UWorld* World = PC->GetWorld();
+    FSceneViewProjectionData ProjectionData;
+    if (!World || !GetPlayerProjectionData(PC, ProjectionData))
+    {
+        bHitTestBroadPhaseCoversAll = true;
+        return;
+    }
+    const FMatrix ViewProjectionMatrix = ProjectionData.ComputeViewProjectionMatrix();
+    const FIntRect ViewRect = ProjectionData.GetConstrainedViewRect();
+
+    auto AddProjectedBounds = [&](const FBox& Bounds)
+    {
+        FBox2D ScreenRect;
+        if (ProjectBoundsToScreen(Bounds, ViewRect, ViewProjectionMatrix, ScreenRect))
+        {
+            HitTestBroadPhaseRects.Add(ScreenRect);
+        }
+    };
+
+    // パイプラインに含まれる3D判定の対象だけを集める
+    if (bHitTestPipelineUsesTargets)
+    {
+        HitTestTargets.ForEachProxyBounds(AddProjectedBounds);
+    }
+    if (bHitTestPipelineUsesPhysics)
+    {
+        ProjectBroadPhasePrimitives(World, ViewProjectionMatrix, ViewRect, [this](const UPrimitiveComponent& Primitive, const FBox2D& ScreenRect)
+        {
+            HitTestBroadPhaseRects.Add(ScreenRect);
+        });
+    }
+
+    // UI: キャッシュ済みのウィジェット矩形のうち、ブロックするものを候補にする
+    RefreshWidgetHitCache();
+    for (const FWidgetHitEntry& Entry : WidgetHitCache)
+    {
+        if (Entry.bBlocking)
+        {
+            HitTestBroadPhaseRects.Add(Entry.Rect);
+        }
+    }
+}
+
+void UWindowTransparencyHelper::ProjectBroadPhasePrimitives(UWorld* World, const FMatrix& ViewProjectionMatrix, const FIntRect& ViewRect, TFunctionRef<void(const UPrimitiveComponent&, const FBox2D&)> OnScreenRect)
+{
+    UpdateBroadPhasePrimitives(World);
+    const bool bViewChanged = !ViewProjectionMatrix.Equals(BroadPhaseViewProjectionMatrix, 0.0) || ViewRect != BroadPhaseViewRect;
+    BroadPhaseViewProjectionMatrix = ViewProjectionMatrix;
+    BroadPhaseViewRect = ViewRect;
+    for (auto It = BroadPhasePrimitives.CreateIterator(); It; ++It)
+    {
+        FBroadPhasePrimitive& Entry = It->Value;
+        const UPrimitiveComponent* Primitive = Entry.Primitive.Get();
+        if (!Primitive)
+        {
+            It.RemoveCurrent();
+            continue;
+        }
+        // 衝突設定は物理状態を作り直さずに変わるので、ここで毎回確認する
+        if (!Primitive->IsRegistered() || !Primitive->IsQueryCollisionEnabled() ||
+            Primitive->GetCollisionResponseToChannel(GameRaycastTraceChannelLogic) != ECR_Block)
+        {
+            continue;
+        }
+        if (bViewChanged || Entry.ProjectedOrigin != Primitive->Bounds.Origin || Entry.ProjectedExtent != Primitive->Bounds.BoxExtent)
+        {
+            Entry.ProjectedOrigin = Primitive->Bounds.Origin;
+            Entry.ProjectedExtent = Primitive->Bounds.BoxExtent;
+            Entry.bOnScreen = ProjectBoundsToScreen(Primitive->Bounds.GetBox(), ViewRect, ViewProjectionMatrix, Entry.ScreenRect);
+        }
+        if (Entry.bOnScreen)
+        {
+            OnScreenRect(*Primitive, Entry.ScreenRect);
+        }
+    }
+}
+
+void UWindowTransparencyHelper::UpdateBroadPhasePrimitives(UWorld* World)
+{
+    if (!CreatePhysicsStateHandle.IsValid())
+    {
+        CreatePhysicsStateHandle = UActorComponent::GlobalCreatePhysicsStateDelegate.AddUObject(this, &UWindowTransparencyHelper::OnPrimitivePhysicsStateCreated);
+        DestroyPhysicsStateHandle = UActorComponent::GlobalDestroyPhysicsStateDelegate.AddUObject(this, &UWindowTransparencyHelper::OnPrimitivePhysicsStateDestroyed);
+    }
+    if (!bBroadPhasePrimitivesDirty && BroadPhasePrimitivesWorld.Get() == World)
+    {
+        return;
+    }
+
+    WT_TRACE_SCOPE("WindowTransparency::RebuildBroadPhasePrimitives");
+    BroadPhasePrimitives.Reset();
+    BroadPhasePrimitivesWorld = World;
+    bBroadPhasePrimitivesDirty = false;
+    ++BroadPhasePrimitiveRebuildCount;
+    for (TActorIterator<AActor> It(World); It; ++It)
+    {
+        It->ForEachComponent<UPrimitiveComponent>(false, [this](UPrimitiveComponent* Primitive)
+        {
+            BroadPhasePrimitives.Add(Primitive).Primitive = Primitive;
+        });
+    }
+}
+
+void UWindowTransparencyHelper::OnPrimitivePhysicsStateCreated(UActorComponent* Component)
+{
+    if (!IsInGameThread())
+    {
+        // 物理状態を非同期に作る経路もあるので、そのときは次の更新でまとめて作り直す
+        TWeakObjectPtr<UWindowTransparencyHelper> WeakThis(this);
+        AsyncTask(ENamedThreads::GameThread, [WeakThis]()
+        {
+            if (UWindowTransparencyHelper* This = WeakThis.Get())
+            {
+                This->bBroadPhasePrimitivesDirty = true;
+            }
+        });
+        return;
+    }
+    UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(Component);
+    if (Primitive && !bBroadPhasePrimitivesDirty && Primitive->GetWorld() == BroadPhasePrimitivesWorld.Get())
+    {
+        BroadPhasePrimitives.Add(Primitive).Primitive = Primitive;
+    }
+}
+
+void UWindowTransparencyHelper::OnPrimitivePhysicsStateDestroyed(UActorComponent* Component)
+{
+    if (!IsInGameThread())
+    {
+        TWeakObjectPtr<UWindowTransparencyHelper> WeakThis(this);
+        AsyncTask(ENamedThreads::GameThread, [WeakThis]()
+        {
+            if (UWindowTransparencyHelper* This = WeakThis.Get())
+            {
+                This->bBroadPhasePrimitivesDirty = true;
+            }
+        });
+        return;
+    }
+    if (UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(Component))
+    {
+        BroadPhasePrimitives.Remove(Primitive);
+    }
+}
+
+void UWindowTransparencyHelper::OnSlateInvalidateAllWidgets(bool bClearResourcesImmediately)
+{
+    bWidgetHitCacheDirty = true;
+}
+
+void UWindowTransparencyHelper::InvalidateWidgetHitCache()
+{
+    bWidgetHitCacheDirty = true;
+}
+
+// ウィジェットキャッシュの署名に加える、1つのウィジェットの配置と状態。子の数で追加・削除を、ポインタで差し替えを見分ける
+static uint32 HashWidgetHitLayout(uint32 Hash, SWidget& Widget)
+{
+    const EVisibility Visibility = Widget.GetVisibility();
+    const FGeometry& Geometry = Widget.GetTickSpaceGeometry();
+    const FChildren* Children = Widget.GetChildren();
+    const uint32 Flags = (Visibility.IsVisible() ? 1u : 0u) | (Visibility.IsHitTestVisible() ? 2u : 0u) | (Visibility.AreChildrenHitTestVisible() ? 4u : 0u) | (Widget.IsEnabled() ? 8u : 0u);
+    Hash = HashCombineFast(Hash, PointerHash(&Widget));
+    Hash = HashCombineFast(Hash, GetTypeHash(FVector2D(Geometry.GetAbsolutePosition())));
+    Hash = HashCombineFast(Hash, GetTypeHash(FVector2D(Geometry.GetAbsoluteSize())));
+    return HashCombineFast(Hash, HashCombineFast(Flags, GetTypeHash(Children ? Children->Num() : 0)));
+}
+
+uint32 UWindowTransparencyHelper::ComputeWidgetHitCacheSignature() const
+{
+    uint32 Signature = 0;
+    for (const TWeakPtr<SWidget>& WeakWidget : WidgetHitCacheLayout)
+    {
+        const TSharedPtr<SWidget> Widget = WeakWidget.Pin();
+        if (!Widget.IsValid())
+        {
+            // 辿ったウィジェットが破棄されていれば必ず作り直す
+            return ~WidgetHitCacheSignature;
+        }
+        Signature = HashWidgetHitLayout(Signature, *Widget);
+    }
+    return Signature;
+}
+
+void UWindowTransparencyHelper::RefreshWidgetHitCache()
+{
+    TSharedPtr<SWindow> GameSWindow;
+    TSharedPtr<SViewport> ViewportWidget;
+    if (FSlateApplication::IsInitialized() && GEngine && GEngine->GameViewport)
+    {
+        GameSWindow = GEngine->GameViewport->GetWindow();
+        ViewportWidget = GEngine->GameViewport->GetGameViewportWidget();
+    }
+    if (!GameSWindow.IsValid() || !ViewportWidget.IsValid())
+    {
+        WidgetHitCache.Reset();
+        LastWidgetHitIndex = INDEX_NONE;
+        bWidgetHitCacheDirty = true;
+        return;
+    }
+
+    if (!InvalidateAllWidgetsHandle.IsValid())
+    {
+        InvalidateAllWidgetsHandle = FSlateApplication::Get().OnInvalidateAllWidgets().AddUObject(this, &UWindowTransparencyHelper::OnSlateInvalidateAllWidgets);
+    }
+
+    // レイアウトは Slate のフレーム内では変わらないので、確認は1フレームに1回だけ
+    if (!bWidgetHitCacheDirty && WidgetHitCacheCheckFrame == GFrameCounter)
+    {
+        return;
+    }
+    WidgetHitCacheCheckFrame = GFrameCounter;
+
+    // 辿ったウィジェットの配置・表示・子の数の署名が変わったとき、Slate の全体無効化、明示的な無効化、ビューポートの移動・リサイズで作り直す
+    // （最大保持時間は既定では無効）。署名の確認は辿ったウィジェットを並べ直すだけで、木を辿り直すよりずっと軽い
+    const FGeometry& ViewportGeometry = ViewportWidget->GetCachedGeometry();
+    const FBox2D ViewportRect(ViewportGeometry.GetAbsolutePosition(), ViewportGeometry.GetAbsolutePosition() + ViewportGeometry.GetAbsoluteSize());
+    const double Now = FPlatformTime::Seconds();
+    const bool bExpired = GWindowHitTestWidgetCacheMaxAge > 0.0f && Now - WidgetHitCacheBuildTime >= GWindowHitTestWidgetCacheMaxAge;
+    if (!bWidgetHitCacheDirty && !bExpired && ViewportRect == WidgetHitCacheViewportRect && ComputeWidgetHitCacheSignature() == WidgetHitCacheSignature)
+    {
+        return;
+    }
+
+    WidgetHitCache.Reset();
+    WidgetHitCacheLayout.Reset();
+    LastWidgetHitIndex = INDEX_NONE;
+    WidgetHitCacheViewportRect = ViewportRect;
+    WidgetHitCacheBuildTime = Now;
+    bWidgetHitCacheDirty = false;
+    ++WidgetHitCacheRebuildCount;
+    uint32 LayoutSignature = 0;
+
+    struct FPendingWidget
+    {
+        TSharedRef<SWidget> Widget;
+        int32 PathLength;
+        FBox2D ClipRect;
+    };
+
+    // 前順で辿るので、配列の後ろにあるものほど手前に描画される
+    TArray<FPendingWidget, TInlineAllocator<64>> WidgetStack;
+    WidgetStack.Add({ GameSWindow.ToSharedRef(), 1, FBox2D(FVector2D(-BIG_NUMBER), FVector2D(BIG_NUMBER)) });
+    while (WidgetStack.Num() > 0)
+    {
+        const FPendingWidget Pending = WidgetStack.Pop();
+        WidgetHitCacheLayout.Add(Pending.Widget);
+        LayoutSignature = HashWidgetHitLayout(LayoutSignature, *Pending.Widget);
+        const EVisibility Visibility = Pending.Widget->GetVisibility();
+        if (!Visibility.IsVisible())
+        {
+            continue;
+        }
+
+        const FGeometry& Geometry = Pending.Widget->GetTickSpaceGeometry();
+        const FVector2D TopLeft = Geometry.GetAbsolutePosition() - ViewportRect.Min;
+        FBox2D Rect(TopLeft, TopLeft + Geometry.GetAbsoluteSize());
+        Rect.Min = FVector2D::Max(Rect.Min, Pending.ClipRect.Min);
+        Rect.Max = FVector2D::Min(Rect.Max, Pending.ClipRect.Max);
+        const bool bHasArea = Rect.Max.X > Rect.Min.X && Rect.Max.Y > Rect.Min.Y;
+
+        if (bHasArea && Visibility.IsHitTestVisible() && Pending.Widget->IsEnabled())
+        {
+            FWidgetHitEntry& Entry = WidgetHitCache.AddDefaulted_GetRef();
+            Entry.Rect = Rect;
+            Entry.Widget = Pending.Widget;
+            Entry.PathLength = Pending.PathLength;
+            Entry.bBlocking = FWindowTransparencyKernels::IsBlockingHitTestWidget(Pending.Widget->GetType(), Pending.PathLength);
+        }
+
+        if (Visibility.AreChildrenHitTestVisible())
+        {
+            const FBox2D ChildClipRect = Pending.Widget->GetClipping() != EWidgetClipping::Inherit ? Rect : Pending.ClipRect;
+            FChildren* Children = Pending.Widget->GetChildren();
+            for (int32 ChildIndex = Children ? Children->Num() - 1 : INDEX_NONE; ChildIndex >= 0; --ChildIndex)
+            {
+                WidgetStack.Add({ Children->GetChildAt(ChildIndex), Pending.PathLength + 1, ChildClipRect });
+            }
+        }
+    }
+    WidgetHitCacheSignature = LayoutSignature;
+}
+
+bool UWindowTransparencyHelper::HitTestWidgetCache(const FVector2D& MousePosInWindow)
+{
+    RefreshWidgetHitCache();
+
+    // 前回ヒットした矩形にまだカーソルが乗っていれば、それより手前の矩形だけ調べればよい
+    int32 FirstCandidate = 0;
+    if (WidgetHitCache.IsValidIndex(LastWidgetHitIndex) && WidgetHitCache[LastWidgetHitIndex].Rect.IsInside(MousePosInWindow))
+    {
+        FirstCandidate = LastWidgetHitIndex;
+    }
+
+    LastWidgetHitIndex = INDEX_NONE;
+    for (int32 Index = WidgetHitCache.Num() - 1; Index >= FirstCandidate; --Index)
+    {
+        if (WidgetHitCache[Index].Rect.IsInside(MousePosInWindow))
+        {
+            LastWidgetHitIndex = Index;
+            break;
+        }
+    }
+    if (LastWidgetHitIndex == INDEX_NONE)
+    {
+        return false;
+    }
+
+    const FWidgetHitEntry& Entry = WidgetHitCache[LastWidgetHitIndex];
+    if (UE_LOG_ACTIVE(LogWindowHelper, Verbose))
+    {
+        const TSharedPtr<SWidget> HitWidget = Entry.Widget.Pin();
+        UE_LOG(LogWindowHelper, Verbose, TEXT("GameRaycastTest: Cached UI hit on %s (PathLen: %d, Blocking: %d)"),
+            HitWidget.IsValid() ? *HitWidget->ToString() : TEXT("(destroyed)"), Entry.PathLength, Entry.bBlocking);
+    }
+    return Entry.bBlocking;
+}
+
+bool UWindowTransparencyHelper::IsInHitTestBroadPhase(const FVector2D& MousePosInWindow, double Margin) const
+{
+    if (bHitTestBroadPhaseCoversAll)
+    {
+        return true;
+    }
+
+    for (const FBox2D& Rect : HitTestBroadPhaseRects)
+    {
+        if (MousePosInWindow.X >= Rect.Min.X - Margin && MousePosInWindow.X <= Rect.Max.X + Margin &&
+            MousePosInWindow.Y >= Rect.Min.Y - Margin && MousePosInWindow.Y <= Rect.Max.Y + Margin)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void UWindowTransparencyHelper::UpdateHitDetectionLogic(float DeltaTime)
+{
+    WT_TRACE_SCOPE("WindowTransparency::UpdateHitDetection");
+    bool bMousePosSuccess;
+    FVector2D MousePosInWindow = GetMousePositionInWindow(bMousePosSuccess);
+    PreviousCursorSampleTime = LastCursorSampleTime;
+    LastCursorSampleTime = FPlatformTime::Seconds();
+    LastHitTestMousePos = MousePosInWindow;
+    WT_TRACE_EVENT(CursorSample, MousePosInWindow, bMousePosSuccess);
+    const bool bWasMouseOverOpaque = bIsMouseOverOpaqueAreaLogic;
+
+    if (!bMousePosSuccess)
+    {
+        bIsMouseOverOpaqueAreaLogic = false;
+        UE_LOG(LogWindowHelper, Verbose, TEXT("UpdateHitDetectionLogic: Mouse position not retrieved. Assuming transparent area."));
+        return;
+    }
+
+    switch (CurrentHitTestTypeLogic)
+    {
+    case EWindowHitTestType::GameRaycast:
+    case EWindowHitTestType::RegisteredTargets:
+    case EWindowHitTestType::CustomPipeline:
+    case EWindowHitTestType::StencilPick:
+    {
+        bool bRawIsOpaque = PerformGameRaycastUnderMouse(MousePosInWindow);
+        bool bPredicted = false;
+        if (bCursorPredictionEnabled)
+        {
+            bRawIsOpaque = ApplyCursorPrediction(MousePosInWindow, bRawIsOpaque, bPredicted);
+        }
+        // 予測による切り替えは先回りが目的なので、ヒステリシスで遅らせない
+        if (bPredicted)
+        {
+            PendingHitTestStateSince = -1.0;
+            bIsMouseOverOpaqueAreaLogic = true;
+        }
+        else
+        {
+            bIsMouseOverOpaqueAreaLogic = ApplyHitTestHysteresis(bRawIsOpaque);
+        }
+        const UEnum* EnumPtr = StaticEnum<ECollisionChannel>();
+        FString ChannelName = EnumPtr ? EnumPtr->GetNameStringByValue(static_cast<int64>(GameRaycastTraceChannelLogic)) : FString::FromInt(static_cast<int32>(GameRaycastTraceChannelLogic));
+        UE_LOG(LogWindowHelper, Log, TEXT("GameRaycastTest Result: bIsMouseOverOpaqueAreaLogic = %s at Pos: %s (Channel: %s)"),
+            bIsMouseOverOpaqueAreaLogic ? TEXT("true (Opaque)") : TEXT("false (Transparent)"), *MousePosInWindow.ToString(), *ChannelName);
+        break;
+    }
+    case EWindowHitTestType::None:
+    default:
+        bIsMouseOverOpaqueAreaLogic = true;
+        break;
+    }
+    WT_TRACE_EVENT(HitTestDecision, MousePosInWindow, static_cast<uint8>(CurrentHitTestTypeLogic), static_cast<uint8>(GameRaycastTraceChannelLogic), bWasMouseOverOpaque, bIsMouseOverOpaqueAreaLogic);
+}
+
+// 予測位置と実際の位置の差がこれ以下なら当たりとみなす
+static constexpr float CursorPredictionAccuratePixels = 8.0f;
+
+void UWindowTransparencyHelper::SetCursorPrediction(bool bEnable, float MaxHorizonMs)
+{
+    bCursorPredictionEnabled = bEnable;
+    CursorPredictionMaxHorizonMs = FMath::Clamp(MaxHorizonMs, 0.0f, 200.0f);
+    CursorSampleCount = 0;
+    PendingPredictionTime = -1.0;
+    PredictedSwitchDeadline = -1.0;
+    PredictedOpaqueUntil = -1.0;
+    UE_LOG(LogWindowHelper, Log, TEXT("Cursor prediction %s (max horizon %.0f ms)."), bEnable ? TEXT("enabled") : TEXT("disabled"), CursorPredictionMaxHorizonMs);
+}
+
+FWindowCursorPredictionStats UWindowTransparencyHelper::GetCursorPredictionStats() const
+{
+    FWindowCursorPredictionStats Stats;
+    Stats.Predictions = CursorPredictionCount;
+    Stats.MeanErrorPixels = CursorPredictionCount > 0 ? static_cast<float>(CursorPredictionErrorSum / CursorPredictionCount) : 0.0f;
+    Stats.MaxErrorPixels = CursorPredictionErrorMax;
+    Stats.Accuracy = CursorPredictionCount > 0 ? static_cast<float>(CursorPredictionAccurateCount) / CursorPredictionCount : 0.0f;
+    Stats.AccuratePixels = CursorPredictionAccuratePixels;
+    Stats.PredictedSwitches = PredictedSwitchCount;
+    Stats.CorrectSwitches = CorrectPredictedSwitchCount;
+    Stats.FalseSwitches = FalsePredictedSwitchCount;
+    const int32 ResolvedSwitches = CorrectPredictedSwitchCount + FalsePredictedSwitchCount;
+    Stats.FalseSwitchRate = ResolvedSwitches > 0 ? static_cast<float>(FalsePredictedSwitchCount) / ResolvedSwitches : 0.0f;
+    return Stats;
+}
+
+void UWindowTransparencyHelper::RecordCursorSample(const FVector2D& MousePosInWindow, double SampleTime)
+{
+    // 答え合わせ: 予測した時刻をまたいだら、前後のサンプルを補間した位置と比べる
+    if (PendingPredictionTime >= 0.0 && CursorSampleCount > 0 && SampleTime >= PendingPredictionTime)
+    {
+        const double Interval = SampleTime - CursorSampleTimes[0];
+        const double Alpha = Interval > UE_DOUBLE_SMALL_NUMBER ? FMath::Clamp((PendingPredictionTime - CursorSampleTimes[0]) / Interval, 0.0, 1.0) : 1.0;
+        const FVector2D ActualPos = FMath::Lerp(CursorSamplePositions[0], MousePosInWindow, Alpha);
+        const float Error = static_cast<float>(FVector2D::Distance(ActualPos, PendingPredictedPos));
+        ++CursorPredictionCount;
+        CursorPredictionErrorSum += Error;
+        CursorPredictionErrorMax = FMath::Max(CursorPredictionErrorMax, Error);
+        if (Error <= CursorPredictionAccuratePixels)
+        {
+            ++CursorPredictionAccurateCount;
+        }
+        PendingPredictionTime = -1.0;
+    }
+
+    for (int32 Index = NumCursorSamples - 1; Index > 0; --Index)
+    {
+        CursorSamplePositions[Index] = CursorSamplePositions[Index - 1];
+        CursorSampleTimes[Index] = CursorSampleTimes[Index - 1];
+    }
+    CursorSamplePositions[0] = MousePosInWindow;
+    CursorSampleTimes[0] = SampleTime;
+    CursorSampleCount = FMath::Min(CursorSampleCount + 1, NumCursorSamples);
+}
+
+bool UWindowTransparencyHelper::ApplyCursorPrediction(const FVector2D& MousePosInWindow, bool bRawIsOpaque, bool& bOutPredicted)
+{
+    bOutPredicted = false;
+    PredictedOpaqueUntil = -1.0;
+    const double Now = LastCursorSampleTime;
+    RecordCursorSample(MousePosInWindow, Now);
+
+    // 先行して不透明にした結果、カーソルが期限内に実際にコンテンツへ入ったかを数える
+    if (PredictedSwitchDeadline >= 0.0)
+    {
+        if (bRawIsOpaque)
+        {
+            ++CorrectPredictedSwitchCount;
+            PredictedSwitchDeadline = -1.0;
+        }
+        else if (Now > PredictedSwitchDeadline)
+        {
+            ++FalsePredictedSwitchCount;
+            PredictedSwitchDeadline = -1.0;
+        }
+    }
+
+    if (bRawIsOpaque || CursorSampleCount < 2)
+    {
+        return bRawIsOpaque;
+    }
+
+    const double Interval0 = CursorSampleTimes[0] - CursorSampleTimes[1];
+    if (Interval0 <= UE_DOUBLE_SMALL_NUMBER)
+    {
+        return false;
+    }
+    const FVector2D Velocity = (CursorSamplePositions[0] - CursorSamplePositions[1]) / Interval0;
+    FVector2D Acceleration = FVector2D::ZeroVector;
+    if (CursorSampleCount >= 3)
+    {
+        const double Interval1 = CursorSampleTimes[1] - CursorSampleTimes[2];
+        if (Interval1 > UE_DOUBLE_SMALL_NUMBER)
+        {
+            const FVector2D PreviousVelocity = (CursorSamplePositions[1] - CursorSamplePositions[2]) / Interval1;
+            Acceleration = (Velocity - PreviousVelocity) / (0.5 * (Interval0 + Interval1));
+        }
+    }
+
+    // 次のサンプルまでを予測する。上限で打ち切り、加速度の寄与は速度の寄与を超えないようにする
+    const double Horizon = FMath::Min(Interval0, CursorPredictionMaxHorizonMs / 1000.0);
+    if (Horizon <= 0.0 || Velocity.SizeSquared() * Horizon * Horizon < 1.0)
+    {
+        return false;
+    }
+    auto PredictAt = [&](double Time)
+    {
+        FVector2D AccelerationOffset = 0.5 * Acceleration * Time * Time;
+        const double MaxAccelerationOffset = Velocity.Size() * Time;
+        if (AccelerationOffset.SizeSquared() > MaxAccelerationOffset * MaxAccelerationOffset)
+        {
+            AccelerationOffset = AccelerationOffset.GetSafeNormal() * MaxAccelerationOffset;
+        }
+        return MousePosInWindow + Velocity * Time + AccelerationOffset;
+    };
+
+    if (PendingPredictionTime < 0.0)
+    {
+        PendingPredictionTime = Now + Horizon;
+        PendingPredictedPos = PredictAt(Horizon);
+    }
+
+    APlayerController* PC = GetFirstLocalPlayerController(this);
+    if (!PC)
+    {
+        return false;
+    }
+    if (bHitTestPipelineBoundedByRects)
+    {
+        UpdateHitTestBroadPhase(PC);
+    }
+
+    // 予測経路上の数点を手前から調べ、最初にコンテンツに入った点で打ち切る。
+    // 予測点の評価は戦略の統計と並べ替えに含めない（実際のカーソル位置の評価ではないため）
+    constexpr int32 NumPathSteps = 3;
+    for (int32 Step = 1; Step <= NumPathSteps; ++Step)
+    {
+        const FVector2D PredictedPos = PredictAt(Horizon * Step / NumPathSteps);
+        if (bHitTestPipelineBoundedByRects && !IsInHitTestBroadPhase(PredictedPos, GetHitTestKernelMargin()))
+        {
+            continue;
+        }
+        TGuardValue<bool> EvaluatingPredictedCursorGuard(bEvaluatingPredictedCursor, true);
+        if (RunHitTestPipeline(PC, PredictedPos, false))
+        {
+            if (PredictedSwitchDeadline < 0.0)
+            {
+                ++PredictedSwitchCount;
+                // 次のサンプルが少し遅れても外れ扱いにならないよう、予測範囲の2倍まで待つ
+                PredictedSwitchDeadline = Now + 2.0 * Horizon;
+            }
+            bOutPredicted = true;
+            PredictedOpaqueUntil = Now + 2.0 * Horizon;
+            UE_LOG(LogWindowHelper, Verbose, TEXT("CursorPrediction: Predicted cursor %s enters content. Switching to opaque early."), *PredictedPos.ToString());
+            return true;
+        }
+    }
+    return false;
+}
+
+bool UWindowTransparencyHelper::ApplyHitTestHysteresis(bool bRawIsOpaque)
+{
+    if (bRawIsOpaque == bIsMouseOverOpaqueAreaLogic)
+    {
+        PendingHitTestStateSince = -1.0;
+        return bRawIsOpaque;
+    }
+    if (GWindowHitTestHysteresisMs <= 0.0f)
+    {
+        return bRawIsOpaque;
+    }
+
+    // 新しい判定結果が一定時間続いたときだけ切り替える
+    const double Now = FPlatformTime::Seconds();
+    if (PendingHitTestStateSince < 0.0 || bPendingHitTestState != bRawIsOpaque)
+    {
+        PendingHitTestStateSince = Now;
+        bPendingHitTestState = bRawIsOpaque;
+        return bIsMouseOverOpaqueAreaLogic;
+    }
+    if ((Now - PendingHitTestStateSince) * 1000.0 >= GWindowHitTestHysteresisMs)
+    {
+        PendingHitTestStateSince = -1.0;
+        return bRawIsOpaque;
+    }
+    return bIsMouseOverOpaqueAreaLogic;
+}
+
+bool UWindowTransparencyHelper::PerformGameRaycastUnderMouse(FVector2D MousePosInWindow)
+{
+    APlayerController* PC = GetFirstLocalPlayerController(this);
+    if (!PC)
+    {
+        UE_LOG(LogWindowHelper, Warning, TEXT("GameRaycastTest: PlayerController not found. Assuming no hit (transparent)."));
+        return false;
+    }
+
+    EnsureHitTestPipeline();
+    return RunHitTestPipeline(PC, MousePosInWindow);
+}
+
+void UWindowTransparencyHelper::SetHitTestStrategies(const TArray<UWindowHitTestStrategy*>& Strategies)
+{
+    HitTestStrategies.Reset();
+    for (UWindowHitTestStrategy* Strategy : Strategies)
+    {
+        if (Strategy)
+        {
+            HitTestStrategies.Add(Strategy);
+        }
+    }
+    HitTestPipelineType = EWindowHitTestType::CustomPipeline;
+    SetHitTestType(EWindowHitTestType::CustomPipeline);
+    OnHitTestStrategiesChanged();
+}
+
+UWindowHitTestStrategy* UWindowTransparencyHelper::AddHitTestStrategy(TSubclassOf<UWindowHitTestStrategy> StrategyClass)
+{
+    if (!StrategyClass || StrategyClass->HasAnyClassFlags(CLASS_Abstract))
+    {
+        UE_LOG(LogWindowHelper, Warning, TEXT("AddHitTestStrategy: Strategy class is null or abstract."));
+        return nullptr;
+    }
+
+    // プリセットが有効なら、それを土台にして追加する
+    EnsureHitTestPipeline();
+    UWindowHitTestStrategy* Strategy = NewObject<UWindowHitTestStrategy>(this, StrategyClass);
+    HitTestStrategies.Add(Strategy);
+    HitTestPipelineType = EWindowHitTestType::CustomPipeline;
+    SetHitTestType(EWindowHitTestType::CustomPipeline);
+    OnHitTestStrategiesChanged();
+    return Strategy;
+}
+
+void UWindowTransparencyHelper::ClearHitTestStrategies()
+{
+    SetHitTestStrategies(TArray<UWindowHitTestStrategy*>());
+}
+
+TArray<FWindowHitTestStrategyStats> UWindowTransparencyHelper::GetHitTestStrategyStats() const
+{
+    TArray<FWindowHitTestStrategyStats> Result;
+    for (const UWindowHitTestStrategy* Strategy : HitTestStrategies)
+    {
+        if (Strategy)
+        {
+            Result.Add(Strategy->GetStats());
+        }
+    }
+    return Result;
+}
+
+void UWindowTransparencyHelper::SetHitTestStrategyOrdering(bool bAutoOrder, float MinConfidence)
+{
+    bAutoOrderHitTestStrategies = bAutoOrder;
+    HitTestMinConfidence = FMath::Clamp(MinConfidence, 0.0f, 1.0f);
+    SortHitTestStrategies();
+}
+
+void UWindowTransparencyHelper::EnsureHitTestPipeline()
+{
+    if (CurrentHitTestTypeLogic == EWindowHitTestType::CustomPipeline || CurrentHitTestTypeLogic == HitTestPipelineType)
+    {
+        return;
+    }
+
+    HitTestPipelineType = CurrentHitTestTypeLogic;
+    HitTestStrategies.Reset();
+    if (CurrentHitTestTypeLogic == EWindowHitTestType::StencilPick)
+    {
+        HitTestStrategies.Add(NewObject<UWindowHitTestStrategy_WidgetRects>(this));
+        HitTestStrategies.Add(NewObject<UWindowHitTestStrategy_StencilPick>(this));
+    }
+    else if (CurrentHitTestTypeLogic == EWindowHitTestType::GameRaycast || CurrentHitTestTypeLogic == EWindowHitTestType::RegisteredTargets)
+    {
+        HitTestStrategies.Add(NewObject<UWindowHitTestStrategy_BroadPhase>(this));
+        HitTestStrategies.Add(NewObject<UWindowHitTestStrategy_WidgetRects>(this));
+        if (CurrentHitTestTypeLogic == EWindowHitTestType::RegisteredTargets)
+        {
+            HitTestStrategies.Add(NewObject<UWindowHitTestStrategy_RegisteredTargets>(this));
+        }
+        else
+        {
+            HitTestStrategies.Add(NewObject<UWindowHitTestStrategy_PhysicsTrace>(this));
+        }
+    }
+    OnHitTestStrategiesChanged();
+}
+
+void UWindowTransparencyHelper::OnHitTestStrategiesChanged()
+{
+    bHitTestPipelineUsesPhysics = false;
+    bHitTestPipelineUsesTargets = false;
+    bHitTestPipelineUsesWidgets = false;
+    bHitTestPipelineUsesStencil = false;
+    bHitTestPipelineUsesPixelAlpha = false;
+    bHitTestPipelineBoundedByRects = true;
+    for (const UWindowHitTestStrategy* Strategy : HitTestStrategies)
+    {
+        if (!Strategy)
+        {
+            continue;
+        }
+        bHitTestPipelineUsesPhysics |= Strategy->IsA<UWindowHitTestStrategy_PhysicsTrace>();
+        bHitTestPipelineUsesTargets |= Strategy->IsA<UWindowHitTestStrategy_RegisteredTargets>();
+        bHitTestPipelineUsesWidgets |= Strategy->IsA<UWindowHitTestStrategy_WidgetRects>();
+        bHitTestPipelineUsesStencil |= Strategy->IsA<UWindowHitTestStrategy_StencilPick>();
+        bHitTestPipelineUsesPixelAlpha |= Strategy->IsA<UWindowHitTestStrategy_PixelAlpha>();
+        // 組み込み以外の戦略の判定範囲はブロードフェーズの矩形で表せない
+        bHitTestPipelineBoundedByRects &= Strategy->IsA<UWindowHitTestStrategy_BroadPhase>() || Strategy->IsA<UWindowHitTestStrategy_WidgetRects>() ||
+            Strategy->IsA<UWindowHitTestStrategy_PhysicsTrace>() || Strategy->IsA<UWindowHitTestStrategy_RegisteredTargets>();
+    }
+    // ブロードフェーズの収集対象が変わるので次回作り直す
+    HitTestBroadPhaseFrame = 0;
+    // ステンシルを使わなくなったら読み出しパスを止める
+    if (StencilPickExtension.IsValid() && !bHitTestPipelineUsesStencil)
+    {
+        StencilPickExtension->SetEnabled(false);
+        bLastStencilPickValid = false;
+    }
+    if (PixelAlphaProbeExtension.IsValid() && !bHitTestPipelineUsesPixelAlpha)
+    {
+        PixelAlphaProbeExtension->SetEnabled(false);
+        bLastPixelAlphaValid = false;
+    }
+    SortHitTestStrategies();
+}
+
+void UWindowTransparencyHelper::SortHitTestStrategies()
+{
+    HitTestStrategies.RemoveAll([](const TObjectPtr<UWindowHitTestStrategy>& Strategy) { return Strategy == nullptr; });
+    Algo::StableSort(HitTestStrategies, [this](const TObjectPtr<UWindowHitTestStrategy>& A, const TObjectPtr<UWindowHitTestStrategy>& B)
+    {
+        return A->GetOrderingCost(bAutoOrderHitTestStrategies) < B->GetOrderingCost(bAutoOrderHitTestStrategies);
+    });
+    HitTestPipelineRunsSinceSort = 0;
+}
+
+bool UWindowTransparencyHelper::RunHitTestPipeline(APlayerController* PC, const FVector2D& MousePosInWindow, bool bRecordStats)
+{
+    // 実測値による並べ替えは一定回数ごとに行う
+    constexpr int32 RunsBetweenSorts = 64;
+    if (bRecordStats && bAutoOrderHitTestStrategies && ++HitTestPipelineRunsSinceSort >= RunsBetweenSorts)
+    {
+        SortHitTestStrategies();
+    }
+
+    // Blueprint の戦略がパイプラインを変更しても安全なようにコピーして回す
+    const TArray<TObjectPtr<UWindowHitTestStrategy>> Strategies = HitTestStrategies;
+    EWindowHitTestVerdict FallbackVerdict = EWindowHitTestVerdict::Undecided;
+    for (UWindowHitTestStrategy* Strategy : Strategies)
+    {
+        if (!Strategy)
+        {
+            continue;
+        }
+
+        const double StartTime = FPlatformTime::Seconds();
+        const EWindowHitTestVerdict Verdict = Strategy->Evaluate(PC, FVector2D(MousePosInWindow));
+        if (bRecordStats)
+        {
+            Strategy->RecordEvaluation((FPlatformTime::Seconds() - StartTime) * 1000.0, Verdict);
+        }
+
+        if (Verdict == EWindowHitTestVerdict::Undecided)
+        {
+            continue;
+        }
+        if (Strategy->Confidence >= HitTestMinConfidence)
+        {
+            UE_LOG(LogWindowHelper, Verbose, TEXT("GameRaycastTest: %s decided %s."), *Strategy->GetClass()->GetName(), *UEnum::GetValueAsString(Verdict));
+            return Verdict == EWindowHitTestVerdict::Opaque;
+        }
+        if (FallbackVerdict == EWindowHitTestVerdict::Undecided)
+        {
+            FallbackVerdict = Verdict;
+        }
+    }
+
+    if (FallbackVerdict != EWindowHitTestVerdict::Undecided)
+    {
+        UE_LOG(LogWindowHelper, Verbose, TEXT("GameRaycastTest: No confident verdict. Using low-confidence verdict %s."), *UEnum::GetValueAsString(FallbackVerdict));
+        return FallbackVerdict == EWindowHitTestVerdict::Opaque;
+    }
+
+    const UEnum* EnumPtr = StaticEnum<ECollisionChannel>();
+    FString ChannelName = EnumPtr ? EnumPtr->GetNameStringByValue(static_cast<int64>(this->GameRaycastTraceChannelLogic)) : FString::FromInt(static_cast<int32>(this->GameRaycastTraceChannelLogic));
+    UE_LOG(LogWindowHelper, Verbose, TEXT("GameRaycastTest: No blocking hit found on 3D (using Channel %s) or UI. Assuming transparent."), *ChannelName);
+    return false;
+}
+
+void UWindowTransparencyHelper::RegisterStencilActor(AActor* Actor, int32 StencilValue)
+{
+    if (!IsValid(Actor) || StencilValue < 1 || StencilValue > 255)
+    {
+        UE_LOG(LogWindowHelper, Warning, TEXT("RegisterStencilActor: Actor is invalid or StencilValue %d is outside 1-255."), StencilValue);
+        return;
+    }
+
+    UnregisterStencilActor(Actor, false);
+    StencilActors.FindOrAdd(StencilValue).Add(Actor);
+    Actor->ForEachComponent<UPrimitiveComponent>(false, [StencilValue](UPrimitiveComponent* Primitive)
+    {
+        Primitive->SetRenderCustomDepth(true);
+        Primitive->SetCustomDepthStencilValue(StencilValue);
+    });
+}
+
+void UWindowTransparencyHelper::UnregisterStencilActor(AActor* Actor, bool bClearCustomDepth)
+{
+    for (auto It = StencilActors.CreateIterator(); It; ++It)
+    {
+        It.Value().RemoveAll([Actor](const TWeakObjectPtr<AActor>& Registered) { return !Registered.IsValid() || Registered.Get() == Actor; });
+        if (It.Value().IsEmpty())
+        {
+            It.RemoveCurrent();
+        }
+    }
+
+    if (bClearCustomDepth && IsValid(Actor))
+    {
+        Actor->ForEachComponent<UPrimitiveComponent>(false, [](UPrimitiveComponent* Primitive)
+        {
+            Primitive->SetRenderCustomDepth(false);
+            Primitive->SetCustomDepthStencilValue(0);
+        });
+    }
+}
+
+bool UWindowTransparencyHelper::PickStencilUnderCursor(APlayerController* PC, const FVector2D& MousePosInWindow, FWindowStencilPickResult& OutResult)
+{
+    OutResult = FWindowStencilPickResult();
+    // 読み出しは数フレーム遅れるので予測位置には答えられない。読み出し位置も実際のカーソルから動かさない
+    if (bEvaluatingPredictedCursor)
+    {
+        return false;
+    }
+    ULocalPlayer* LocalPlayer = PC ? PC->GetLocalPlayer() : nullptr;
+    FViewport* Viewport = LocalPlayer && LocalPlayer->ViewportClient ? LocalPlayer->ViewportClient->Viewport : nullptr;
+    if (!Viewport)
+    {
+        bLastStencilPickValid = false;
+        return false;
+    }
+
+    if (!StencilPickExtension.IsValid())
+    {
+        StencilPickExtension = FSceneViewExtensions::NewExtension<FWindowStencilPickExtension>();
+        static const TConsoleVariableData<int32>* CVarCustomDepth = IConsoleManager::Get().FindTConsoleVariableDataInt(TEXT("r.CustomDepth"));
+        if (CVarCustomDepth && CVarCustomDepth->GetValueOnGameThread() < 3)
+        {
+            UE_LOG(LogWindowHelper, Warning, TEXT("PickStencilUnderCursor: r.CustomDepth is %d. Set Custom Depth-Stencil Pass to 'Enabled with Stencil' (3) or every pixel reads as transparent."),
+                CVarCustomDepth->GetValueOnGameThread());
+        }
+    }
+    const FIntPoint Pixel(FMath::FloorToInt(MousePosInWindow.X), FMath::FloorToInt(MousePosInWindow.Y));
+    StencilPickExtension->SetEnabled(true);
+    StencilPickExtension->SetPickTarget(Viewport, Pixel);
+
+    // 読み出しは数フレーム遅れて届く。古すぎる結果（ヒッチや無効化の後）や、カーソルが動いた後の結果は使わない
+    constexpr double MaxSampleAgeSeconds = 0.25;
+    const double Now = FPlatformTime::Seconds();
+    const FWindowStencilPickSample Sample = StencilPickExtension->GetLatestSample();
+    if (!Sample.bValid || Now - Sample.Time > MaxSampleAgeSeconds ||
+        FMath::Abs(Sample.Position.X - Pixel.X) > 1 || FMath::Abs(Sample.Position.Y - Pixel.Y) > 1)
+    {
+        // 新しい位置の結果が届くまでは直前の判定を保つ。未判定を返すと透明扱いになり、カーソルを動かすたびにちらつく
+        if (bLastStencilPickValid && Now - LastStencilPickTime <= MaxSampleAgeSeconds)
+        {
+            OutResult = GetLastStencilPickResult();
+            return true;
+        }
+        bLastStencilPickValid = false;
+        return false;
+    }
+
+    // 登録された値（とマスクで指定したビット）だけをコンテンツとみなす。他の用途で書かれたステンシルは無視する
+    const int32 StencilValue = static_cast<int32>(Sample.StencilValue);
+    bLastStencilPickValid = true;
+    bLastStencilPickOpaque = StencilValue != 0 && (StencilActors.Contains(StencilValue) || (StencilValue & GWindowStencilPickOpaqueMask) != 0);
+    LastStencilPickValue = static_cast<int32>(Sample.StencilValue);
+    LastStencilPickPosition = FVector2D(Sample.Position);
+    LastStencilPickTime = Sample.Time;
+    LastStencilPickActor = bLastStencilPickOpaque ? ResolveStencilActor(PC, LastStencilPickValue, LastStencilPickPosition) : nullptr;
+    OutResult = GetLastStencilPickResult();
+    return true;
+}
+
+bool UWindowTransparencyHelper::ProbePixelAlphaUnderCursor(APlayerController* PC, const FVector2D& MousePosInWindow, uint8& OutAlpha)
+{
+    OutAlpha = 0;
+    if (bEvaluatingPredictedCursor)
+    {
+        return false;
+    }
+    ULocalPlayer* LocalPlayer = PC ? PC->GetLocalPlayer() : nullptr;
+    FViewport* Viewport = LocalPlayer && LocalPlayer->ViewportClient ? LocalPlayer->ViewportClient->Viewport : nullptr;
+    if (!Viewport)
+    {
+        bLastPixelAlphaValid = false;
+        return false;
+    }
+
+    if (!PixelAlphaProbeExtension.IsValid())
+    {
+        PixelAlphaProbeExtension = FSceneViewExtensions::NewExtension<FWindowPixelAlphaProbeExtension>();
+    }
+    const FIntPoint Pixel(FMath::FloorToInt(MousePosInWindow.X), FMath::FloorToInt(MousePosInWindow.Y));
+    PixelAlphaProbeExtension->SetEnabled(true);
+    PixelAlphaProbeExtension->SetProbeTarget(Viewport, Pixel);
+
+    // 読み出しは数フレーム遅れて届く。カーソルが動いた後や古すぎる結果は使わない
+    constexpr double MaxSampleAgeSeconds = 0.25;
+    const double Now = FPlatformTime::Seconds();
+    const FWindowPixelAlphaSample Sample = PixelAlphaProbeExtension->GetLatestSample();
+    if (!Sample.bValid || Now - Sample.Time > MaxSampleAgeSeconds ||
+        FMath::Abs(Sample.Position.X - Pixel.X) > 1 || FMath::Abs(Sample.Position.Y - Pixel.Y) > 1)
+    {
+        // ステンシルピックと同じく、新しい位置の結果が届くまでは直前のアルファを使う
+        if (bLastPixelAlphaValid && Now - LastPixelAlphaTime <= MaxSampleAgeSeconds)
+        {
+            OutAlpha = LastPixelAlpha;
+            return true;
+        }
+        bLastPixelAlphaValid = false;
+        return false;
+    }
+    bLastPixelAlphaValid = true;
+    LastPixelAlpha = Sample.Alpha;
+    LastPixelAlphaTime = Sample.Time;
+    OutAlpha = Sample.Alpha;
+    return true;
+}
+
+AActor* UWindowTransparencyHelper::ResolveStencilActor(APlayerController* PC, int32 StencilValue, const FVector2D& MousePosInWindow)
+{
+    TArray<TWeakObjectPtr<AActor>>* Actors = StencilActors.Find(StencilValue);
+    if (!Actors)
+    {
+        return nullptr;
+    }
+    Actors->RemoveAll([](const TWeakObjectPtr<AActor>& Registered) { return !Registered.IsValid(); });
+    if (Actors->Num() <= 1)
+    {
+        return Actors->Num() == 1 ? (*Actors)[0].Get() : nullptr;
+    }
+
+    // 同じ値を共有するアクターは、画面上のバウンドにカーソルが入っているもののうち最も手前を選ぶ
+    FSceneViewProjectionData ProjectionData;
+    if (!GetPlayerProjectionData(PC, ProjectionData))
+    {
+        return (*Actors)[0].Get();
+    }
+    const FMatrix ViewProjectionMatrix = ProjectionData.ComputeViewProjectionMatrix();
+    const FIntRect ViewRect = ProjectionData.GetConstrainedViewRect();
+
+    AActor* NearestActor = nullptr;
+    double NearestDistanceSquared = TNumericLimits<double>::Max();
+    for (const TWeakObjectPtr<AActor>& Registered : *Actors)
+    {
+        AActor* Actor = Registered.Get();
+        const FBox Bounds = Actor->GetComponentsBoundingBox();
+        FBox2D ScreenRect;
+        if (ProjectBoundsToScreen(Bounds, ViewRect, ViewProjectionMatrix, ScreenRect) && !ScreenRect.IsInside(MousePosInWindow))
+        {
+            continue;
+        }
+        const double DistanceSquared = FVector::DistSquared(ProjectionData.ViewOrigin, Bounds.GetCenter());
+        if (DistanceSquared < NearestDistanceSquared)
+        {
+            NearestDistanceSquared = DistanceSquared;
+            NearestActor = Actor;
+        }
+    }
+    return NearestActor ? NearestActor : (*Actors)[0].Get();
+}
+
+FWindowStencilPickResult UWindowTransparencyHelper::GetLastStencilPickResult() const
+{
+    FWindowStencilPickResult Result;
+    Result.bValid = bLastStencilPickValid;
+    if (bLastStencilPickValid)
+    {
+        Result.bOpaque = bLastStencilPickOpaque;
+        Result.StencilValue = LastStencilPickValue;
+        Result.Actor = LastStencilPickActor.Get();
+        Result.Position = LastStencilPickPosition;
+        Result.AgeMs = static_cast<float>((FPlatformTime::Seconds() - LastStencilPickTime) * 1000.0);
+    }
+    return Result;
+}
+
+bool UWindowTransparencyHelper::IsCursorInHitTestBroadPhase(APlayerController* PC, const FVector2D& MousePosInWindow)
+{
+    if (!GWindowHitTestBroadPhase)
+    {
+        return true;
+    }
+
+    if (bHitTestPipelineUsesTargets)
+    {
+        HitTestTargets.Refresh();
+    }
+    UpdateHitTestBroadPhase(PC);
+    ++HitTestBroadPhaseTests;
+    // カーネルの半径ぶん広げて判定する
+    if (!IsInHitTestBroadPhase(MousePosInWindow, GetHitTestKernelMargin()))
+    {
+        ++HitTestBroadPhaseRejects;
+        INC_DWORD_STAT(STAT_WindowTransparency_HitTestBroadPhaseRejects);
+        UE_LOG(LogWindowHelper, Verbose, TEXT("GameRaycastTest: Cursor outside all %d broad phase rects. Assuming transparent."), HitTestBroadPhaseRects.Num());
+        return false;
+    }
+    return true;
+}
+
+bool UWindowTransparencyHelper::TraceUnderCursor(APlayerController* PC, const FVector2D& MousePosInWindow, bool bUseRegisteredTargets)
+{
+    if (bUseRegisteredTargets)
+    {
+        HitTestTargets.Refresh();
+    }
+
+    FHitResult HitResult3D;
+    bool bHit3D = false;
+    {
+        SCOPE_CYCLE_COUNTER(STAT_WindowTransparency_HitTest3D);
+        CSV_SCOPED_TIMING_STAT(WindowTransparency, HitTest3D);
+        WT_TRACE_SCOPE("WindowTransparency::HitTest3D");
+
+        // 登録ターゲットはどのサンプル数でも自前のBVHに対してレイを飛ばす
+        if (HitTestKernelSamples.Num() > 1 || bUseRegisteredTargets)
+        {
+            bHit3D = TraceHitTestKernel(PC, MousePosInWindow, bUseRegisteredTargets, HitResult3D);
+        }
+        else
+        {
+            FCollisionQueryParams CollisionParams3D(SCENE_QUERY_STAT(WindowTransparencyRaycast3D), GWindowHitTestTraceComplex);
+            bHit3D = PC->GetHitResultAtScreenPosition(
+                MousePosInWindow,
+                this->GameRaycastTraceChannelLogic,
+                CollisionParams3D,
+                HitResult3D
+            );
+        }
+    }
+
+    if (bHit3D && HitResult3D.GetActor())
+    {
+        AActor* HitActor = HitResult3D.GetActor();
+        const UEnum* EnumPtr = StaticEnum<ECollisionChannel>();
+        FString ChannelName = EnumPtr ? EnumPtr->GetNameStringByValue(static_cast<int64>(this->GameRaycastTraceChannelLogic)) : FString::FromInt(static_cast<int32>(this->GameRaycastTraceChannelLogic));
+        UE_LOG(LogWindowHelper, Verbose, TEXT("GameRaycastTest: Hit 3D Actor: %s (Component: %s) using Channel %s"),
+            *HitActor->GetName(),
+            HitResult3D.GetComponent() ? *HitResult3D.GetComponent()->GetName() : TEXT("None"),
+            *ChannelName);
+        return true;
+    }
+    return false;
+}
+
+bool UWindowTransparencyHelper::HitTestWidgetsUnderCursor(APlayerController* PC, const FVector2D& MousePosInWindow)
+{
+    if (FSlateApplication::IsInitialized() && GEngine && GEngine->GameViewport)
+    {
+        SCOPE_CYCLE_COUNTER(STAT_WindowTransparency_HitTestWidget);
+        CSV_SCOPED_TIMING_STAT(WindowTransparency, HitTestWidget);
+        WT_TRACE_SCOPE("WindowTransparency::HitTestWidget");
+
+        if (GWindowHitTestWidgetCache)
+        {
+            if (HitTestWidgetCache(MousePosInWindow))
+            {
+                return true;
+            }
+        }
+        else
+        {
+            TSharedPtr<SWindow> GameSWindow = GEngine->GameViewport->GetWindow();
+            if (GameSWindow.IsValid())
+            {
+                TArray<TSharedRef<SWindow>> WindowsToSearch;
+                WindowsToSearch.Add(GameSWindow.ToSharedRef());
+
+                FVector2D MousePosScreen = MousePosInWindow + GEngine->GameViewport->GetGameViewportWidget()->GetCachedGeometry().GetAbsolutePosition();
+                FWidgetPath WidgetPath = FSlateApplication::Get().LocateWindowUnderMouse(
+                    MousePosScreen,
+                    WindowsToSearch,
+                    false, /*bAllowDisabledWidgets*/
+                    PC->GetLocalPlayer() ? PC->GetLocalPlayer()->GetControllerId() : 0
+                );
+
+                if (WidgetPath.IsValid() && WidgetPath.Widgets.Num() > 0)
+                {
+                    const FArrangedWidget& LastWidgetArranged = WidgetPath.Widgets.Last();
+                    TSharedRef<SWidget> HitWidget = LastWidgetArranged.Widget;
+                    FString WidgetType = HitWidget->GetTypeAsString();
+                    FString WidgetDesc = HitWidget->ToString();
+
+                    UE_LOG(LogWindowHelper, Verbose, TEXT("GameRaycastTest: UI Hit Candidate: Type: %s, Desc: %s, Visible: %d, Enabled: %d, PathLen: %d"),
+                        *WidgetType, *WidgetDesc, HitWidget->GetVisibility().IsVisible(), HitWidget->IsEnabled(), WidgetPath.Widgets.Num());
+
+                    if (HitWidget->GetVisibility().IsVisible() && HitWidget->IsEnabled())
+                    {
+                        if (!FWindowTransparencyKernels::IsBlockingHitTestWidget(HitWidget->GetType(), WidgetPath.Widgets.Num()))
+                        {
+                            UE_LOG(LogWindowHelper, Verbose, TEXT("GameRaycastTest: UI Hit on %s (%s), but considering it non-blocking/transparent due to type/context."), *WidgetType, *WidgetDesc);
+                        }
+                        else
+                        {
+                            UE_LOG(LogWindowHelper, Verbose, TEXT("GameRaycastTest: Hit blocking UI Widget: %s (%s)"), *WidgetType, *WidgetDesc);
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+void UWindowTransparencyHelper::DiscoverWorkerWAsync(TFunction<void(HWND)> OnComplete)
+{
+    if (!HasOSBackend(TEXT("DiscoverWorkerWAsync")))
+    {
+        if (OnComplete)
+        {
+            OnComplete(nullptr);
+        }
+        return;
+    }
+    if (HWND WorkerW = GetValidCachedWorkerW())
+    {
+        if (OnComplete)
+        {
+            OnComplete(WorkerW);
+        }
+        return;
+    }
+    if (OnComplete)
+    {
+        PendingWorkerWCallbacks.Add(MoveTemp(OnComplete));
+    }
+    if (bWorkerWDiscoveryInFlight)
+    {
+        return;
+    }
+    bWorkerWDiscoveryInFlight = true;
+
+    // バックエンドは探索中に差し替えられても生きているよう、参照を持って渡す
+    TSharedPtr<IWindowTransparencyOSBackend> Backend = OSBackend;
+    const uint32 Generation = WorkerWDiscoveryGeneration;
+    TWeakObjectPtr<UWindowTransparencyHelper> WeakThis(this);
+    UE::Tasks::Launch(UE_SOURCE_LOCATION, [WeakThis, Backend, Generation]()
+    {
+        HWND FoundWorkerW = nullptr;
+        {
+            WT_TRACE_SCOPE("WindowTransparency::FindTargetWorkerW");
+            FoundWorkerW = Backend->FindDesktopWorkerW();
+        }
+        AsyncTask(ENamedThreads::GameThread, [WeakThis, FoundWorkerW, Generation]()
+        {
+            if (UWindowTransparencyHelper* This = WeakThis.Get())
+            {
+                This->OnWorkerWDiscovered(FoundWorkerW, Generation);
+            }
+        });
+    });
+}
+
+void UWindowTransparencyHelper::OnWorkerWDiscovered(HWND FoundWorkerW, uint32 Generation)
+{
+    bWorkerWDiscoveryInFlight = false;
+    if (Generation != WorkerWDiscoveryGeneration)
+    {
+        // 探索中にバックエンドが差し替えられたか Explorer が再起動したので、結果を捨てて探し直す
+        if (PendingWorkerWCallbacks.Num() > 0)
+        {
+            DiscoverWorkerWAsync(nullptr);
+        }
+        return;
+    }
+
+    CachedWorkerW = FoundWorkerW;
+    TArray<TFunction<void(HWND)>> Callbacks = MoveTemp(PendingWorkerWCallbacks);
+    PendingWorkerWCallbacks.Reset();
+    for (TFunction<void(HWND)>& Callback : Callbacks)
+    {
+        Callback(FoundWorkerW);
+    }
+}
+
+HWND UWindowTransparencyHelper::GetValidCachedWorkerW()
+{
+    // IsWindow だけの安い確認。壁紙の変更や Explorer の再起動で WorkerW は作り直される
+    if (CachedWorkerW && (!OSBackend.IsValid() || !OSBackend->IsValidWindow(CachedWorkerW)))
+    {
+        UE_LOG(LogWindowHelper, Log, TEXT("GetValidCachedWorkerW: Cached WorkerW %p is no longer a window."), CachedWorkerW);
+        CachedWorkerW = nullptr;
+    }
+    return CachedWorkerW;
+}
+
+void UWindowTransparencyHelper::HandleTaskbarCreated()
+{
+    UE_LOG(LogWindowHelper, Log, TEXT("HandleTaskbarCreated: Explorer restarted. Rediscovering the desktop WorkerW."));
+    const bool bHadWorkerW = CachedWorkerW != nullptr;
+    CachedWorkerW = nullptr;
+    ++WorkerWDiscoveryGeneration;
+    if (bIsDesktopBackgroundActive)
+    {
+        RediscoverDesktopBackgroundParent();
+    }
+    else if (bHadWorkerW)
+    {
+        // 壁紙モードを使っているなら、次に有効にしたとき待たずに済むよう先に探しておく
+        DiscoverWorkerWAsync(nullptr);
+    }
+}
+
+void UWindowTransparencyHelper::RevalidateDesktopBackgroundParent(float DeltaTime)
+{
+    // 子ウィンドウになっている間は TaskbarCreated が届かないので、親の WorkerW が消えていないか定期的に確認する
+    constexpr float WorkerWCheckInterval = 1.0f;
+    TimeSinceWorkerWCheck += DeltaTime;
+    if (TimeSinceWorkerWCheck < WorkerWCheckInterval)
+    {
+        return;
+    }
+    TimeSinceWorkerWCheck = 0.0f;
+    if (!CurrentWorkerW || bWorkerWDiscoveryInFlight || OSBackend->IsValidWindow(CurrentWorkerW))
+    {
+        return;
+    }
+    UE_LOG(LogWindowHelper, Warning, TEXT("RevalidateDesktopBackgroundParent: WorkerW %p was destroyed. Rediscovering it."), CurrentWorkerW);
+    CachedWorkerW = nullptr;
+    ++WorkerWDiscoveryGeneration;
+    RediscoverDesktopBackgroundParent();
+}
+
+void UWindowTransparencyHelper::RediscoverDesktopBackgroundParent()
+{
+    DiscoverWorkerWAsync([this](HWND NewWorkerW)
+    {
+        ReattachToWorkerW(NewWorkerW);
+    });
+}
+
+void UWindowTransparencyHelper::ReattachToWorkerW(HWND NewWorkerW)
+{
+    if (!bIsDesktopBackgroundActive || NewWorkerW == CurrentWorkerW)
+    {
+        return;
+    }
+    if (!NewWorkerW || !GameHWnd || !OSBackend->IsValidWindow(GameHWnd))
+    {
+        UE_LOG(LogWindowHelper, Error, TEXT("ReattachToWorkerW: No WorkerW found or the game window is gone. Desktop background mode cannot be restored."));
+        return;
+    }
+    if (OSBackend->SetParentWindow(GameHWnd, NewWorkerW) == NULL && OSBackend->GetParentWindow(GameHWnd) != NewWorkerW)
+    {
+        UE_LOG(LogWindowHelper, Error, TEXT("ReattachToWorkerW: SetParent of GameHWnd %p to WorkerW %p failed. Error: %d."), GameHWnd, NewWorkerW, OSBackend->GetLastErrorCode());
+        return;
+    }
+
+    CurrentWorkerW = NewWorkerW;
+    RECT rcWorker;
+    if (OSBackend->GetClientAreaRect(CurrentWorkerW, rcWorker) && rcWorker.right - rcWorker.left > 0 && rcWorker.bottom - rcWorker.top > 0)
+    {
+        OSBackend->SetWindowPosition(GameHWnd, NULL, rcWorker.left, rcWorker.top, rcWorker.right - rcWorker.left, rcWorker.bottom - rcWorker.top, SWP_NOZORDER | SWP_NOACTIVATE | SWP_FRAMECHANGED);
+    }
+    OSBackend->SetWindowPosition(GameHWnd, HWND_BOTTOM, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
+    UE_LOG(LogWindowHelper, Log, TEXT("ReattachToWorkerW: Reparented GameHWnd %p to the new WorkerW %p."), GameHWnd, CurrentWorkerW);
+    WT_TRACE_EVENT(DesktopBackgroundTransition, true, true, reinterpret_cast<uint64>(CurrentWorkerW));
+}
+
+void UWindowTransparencyHelper::CompleteDesktopBackgroundRequests()
+{
+    // コールバックから再び呼ばれても安全なように、取り出してから呼ぶ
+    TArray<TFunction<void(bool)>> Callbacks = MoveTemp(DesktopBackgroundCallbacks);
+    DesktopBackgroundCallbacks.Reset();
+    for (TFunction<void(bool)>& Callback : Callbacks)
+    {
+        Callback(bIsDesktopBackgroundActive);
+    }
+}
+
+//TODO:２回実行しないと適応されないのを修正する
+void UWindowTransparencyHelper::SetAsDesktopBackground(bool bEnable, TFunction<void(bool)> OnComplete)
+{
+    WT_TRACE_SCOPE("WindowTransparency::SetAsDesktopBackground");
+    if (OnComplete)
+    {
+        DesktopBackgroundCallbacks.Add(MoveTemp(OnComplete));
+    }
+    // WorkerW の探索待ちでなければ、この呼び出しで結果が決まっている
+    ON_SCOPE_EXIT
+    {
+        if (!bDesktopBackgroundPending)
+        {
+            CompleteDesktopBackgroundRequests();
+        }
+    };
+    if (!HasOSBackend(TEXT("SetAsDesktopBackground")))
+    {
+        return;
+    }
+    PublishClickThroughCoverage(false);
+    if (bEnable)
+    {
+        StopAutoFit(true);
+        ExitIdle(TEXT("desktop background"));
+
+        if (!bIsInitialized || !GameHWnd || !OSBackend->IsValidWindow(GameHWnd)) {
+            UE_LOG(LogWindowHelper, Log, TEXT("SetAsDesktopBackground(Enable): Helper not initialized or GameHWnd invalid. Calling Initialize()."));
+            if (!Initialize()) {
+                UE_LOG(LogWindowHelper, Error, TEXT("SetAsDesktopBackground(Enable): Initialize() failed. Cannot proceed."));
+                return;
+            }
+        }
+
+        CurrentWorkerW = GetValidCachedWorkerW();
+        if (!CurrentWorkerW)
+        {
+            // 探索は Progman への送信で数秒止まることがあるのでワーカーで行い、見つかったらここからやり直す
+            if (!bDesktopBackgroundPending)
+            {
+                bDesktopBackgroundPending = true;
+                DiscoverWorkerWAsync([this](HWND FoundWorkerW)
+                {
+                    if (!bDesktopBackgroundPending)
+                    {
+                        return;
+                    }
+                    bDesktopBackgroundPending = false;
+                    if (!FoundWorkerW)
+                    {
+                        UE_LOG(LogWindowHelper, Error, TEXT("SetAsDesktopBackground: Failed to find WorkerW."));
+                        WT_TRACE_EVENT(DesktopBackgroundTransition, true, false, 0);
+                        CompleteDesktopBackgroundRequests();
+                        return;
+                    }
+                    SetAsDesktopBackground(true);
+                });
+            }
+            UE_LOG(LogWindowHelper, Log, TEXT("SetAsDesktopBackground: Waiting for WorkerW discovery to finish."));
+            return;
+        }
+        bDesktopBackgroundPending = false;
+
+        LONG_PTR DesktopBackgroundStyle = (OSBackend->GetWindowStyle(GameHWnd, GWL_STYLE) & ~(WS_CAPTION | WS_THICKFRAME | WS_SYSMENU)) | WS_POPUP;
         if (!bIsBorderlessActive) {
-            SetWindowLongPtr(GameHWnd, GWL_STYLE, DesktopBackgroundStyle);
+            OSBackend->SetWindowStyle(GameHWnd, GWL_STYLE, DesktopBackgroundStyle);
         }
 
 
-        LONG_PTR CurrentExStyle = GetWindowLongPtr(GameHWnd, GWL_EXSTYLE);
-        SetWindowLongPtr(GameHWnd, GWL_EXSTYLE, CurrentExStyle | WS_EX_LAYERED | WS_EX_TRANSPARENT);
-        SetWindowPos(GameHWnd, NULL, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_FRAMECHANGED | SWP_NOACTIVATE);
+        LONG_PTR CurrentExStyle = OSBackend->GetWindowStyle(GameHWnd, GWL_EXSTYLE);
+        OSBackend->SetWindowStyle(GameHWnd, GWL_EXSTYLE, CurrentExStyle | WS_EX_LAYERED | WS_EX_TRANSPARENT);
+        OSBackend->SetWindowPosition(GameHWnd, NULL, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_FRAMECHANGED | SWP_NOACTIVATE);
 
         UE_LOG(LogWindowHelper, Log, TEXT("SetAsDesktopBackground: About to call SetParent. GameHWnd: %p, WorkerW: %p"), GameHWnd, CurrentWorkerW);
-        if (::SetParent(GameHWnd, CurrentWorkerW) == NULL) {
-            DWORD lastError = GetLastError();
+        if (OSBackend->SetParentWindow(GameHWnd, CurrentWorkerW) == NULL) {
+            DWORD lastError = OSBackend->GetLastErrorCode();
             UE_LOG(LogWindowHelper, Error, TEXT("SetAsDesktopBackground: SetParent of GameHWnd %p to WorkerW %p failed. Error: %d."), GameHWnd, CurrentWorkerW, lastError);
 
             if (!bIsBorderlessActive) {
-                SetWindowLongPtr(GameHWnd, GWL_STYLE, GetWindowLongPtr(GameHWnd, GWL_STYLE) & ~WS_POPUP | (TrueOriginalWindowStyle & (WS_CAPTION | WS_THICKFRAME | WS_SYSMENU))); // 大まかな復元
+                OSBackend->SetWindowStyle(GameHWnd, GWL_STYLE, OSBackend->GetWindowStyle(GameHWnd, GWL_STYLE) & ~WS_POPUP | (TrueOriginalWindowStyle & (WS_CAPTION | WS_THICKFRAME | WS_SYSMENU))); // 大まかな復元
             }
-            SetWindowLongPtr(GameHWnd, GWL_EXSTYLE, CurrentExStyle);
-            SetWindowPos(GameHWnd, NULL, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_FRAMECHANGED | SWP_NOACTIVATE);
+            OSBackend->SetWindowStyle(GameHWnd, GWL_EXSTYLE, CurrentExStyle);
+            OSBackend->SetWindowPosition(GameHWnd, NULL, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_FRAMECHANGED | SWP_NOACTIVATE);
+            WT_TRACE_EVENT(DesktopBackgroundTransition, true, false, reinterpret_cast<uint64>(CurrentWorkerW));
             CurrentWorkerW = nullptr;
             return;
         }
         UE_LOG(LogWindowHelper, Log, TEXT("SetAsDesktopBackground: Successfully set parent of GameHWnd %p to WorkerW %p."), GameHWnd, CurrentWorkerW);
 
         RECT rcWorker;
-        if (GetClientRect(CurrentWorkerW, &rcWorker))
+        if (OSBackend->GetClientAreaRect(CurrentWorkerW, rcWorker))
         {
             if (rcWorker.right - rcWorker.left > 0 && rcWorker.bottom - rcWorker.top > 0) {
-                SetWindowPos(GameHWnd, NULL, rcWorker.left, rcWorker.top, rcWorker.right - rcWorker.left, rcWorker.bottom - rcWorker.top, SWP_NOZORDER | SWP_NOACTIVATE | SWP_FRAMECHANGED);
+                OSBackend->SetWindowPosition(GameHWnd, NULL, rcWorker.left, rcWorker.top, rcWorker.right - rcWorker.left, rcWorker.bottom - rcWorker.top, SWP_NOZORDER | SWP_NOACTIVATE | SWP_FRAMECHANGED);
             }
             else { /* ... */ }
         }
-        SetWindowPos(GameHWnd, HWND_BOTTOM, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
+        OSBackend->SetWindowPosition(GameHWnd, HWND_BOTTOM, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
 
         bIsDesktopBackgroundActive = true;
         GameSWindowPtr.Reset();
         bIsClickThroughStateOS = true;
 
         UE_LOG(LogWindowHelper, Log, TEXT("Window set as desktop background. GameHWnd: %p"), GameHWnd);
+        WT_TRACE_EVENT(DesktopBackgroundTransition, true, true, reinterpret_cast<uint64>(CurrentWorkerW));
     }
     else
     {
+        bDesktopBackgroundPending = false;
         if (!bIsDesktopBackgroundActive) return;
+        DeactivateWallpaperGovernor();
+#if PLATFORM_WINDOWS
+        RawInputThread.Reset();
+#endif
 
-        if (!GameHWnd || !IsWindow(GameHWnd)) {
+        if (!GameHWnd || !OSBackend->IsValidWindow(GameHWnd)) {
             UE_LOG(LogWindowHelper, Error, TEXT("SetAsDesktopBackground(Disable): GameHWnd is invalid. Cannot restore properly. Resetting flags."));
             bIsDesktopBackgroundActive = false;
             CurrentWorkerW = nullptr;
@@ -1069,9 +4319,9 @@ void UWindowTransparencyHelper::SetAsDesktopBackground(bool bEnable)
         UE_LOG(LogWindowHelper, Log, TEXT("SetAsDesktopBackground: Disabling desktop background mode. GameHWnd for restore: %p"), GameHWnd);
 
         HWND TargetParent = bTrueOriginalStateStored ? TrueOriginalParentHwnd : NULL;
-        if (::SetParent(GameHWnd, TargetParent) == NULL && TargetParent != NULL) {
-            if (::SetParent(GameHWnd, NULL) == NULL) {
-                UE_LOG(LogWindowHelper, Error, TEXT("SetAsDesktopBackground(Disable): SetParent to TrueOriginalParentHwnd/NULL failed. Error: %d"), GetLastError());
+        if (OSBackend->SetParentWindow(GameHWnd, TargetParent) == NULL && TargetParent != NULL) {
+            if (OSBackend->SetParentWindow(GameHWnd, NULL) == NULL) {
+                UE_LOG(LogWindowHelper, Error, TEXT("SetAsDesktopBackground(Disable): SetParent to TrueOriginalParentHwnd/NULL failed. Error: %d"), OSBackend->GetLastErrorCode());
             }
             else {
                 UE_LOG(LogWindowHelper, Log, TEXT("SetAsDesktopBackground(Disable): Restored parent to NULL (top-level)."));
@@ -1083,35 +4333,32 @@ void UWindowTransparencyHelper::SetAsDesktopBackground(bool bEnable)
 
         if (bTrueOriginalStateStored)
         {
-            SetWindowLongPtr(GameHWnd, GWL_STYLE, TrueOriginalWindowStyle);
-            SetWindowLongPtr(GameHWnd, GWL_EXSTYLE, TrueOriginalExWindowStyle);
+            OSBackend->SetWindowStyle(GameHWnd, GWL_STYLE, TrueOriginalWindowStyle);
+            OSBackend->SetWindowStyle(GameHWnd, GWL_EXSTYLE, TrueOriginalExWindowStyle);
             UE_LOG(LogWindowHelper, Log, TEXT("SetAsDesktopBackground(Disable): Restored TRUE original styles. Style: 0x%p, ExStyle: 0x%p"), (void*)TrueOriginalWindowStyle, (void*)TrueOriginalExWindowStyle);
         }
         else {
             UE_LOG(LogWindowHelper, Warning, TEXT("SetAsDesktopBackground(Disable): True original styles not stored. Attempting restore with potentially current Original styles (if any)."));
             if (bOriginalStylesStored) {
-                SetWindowLongPtr(GameHWnd, GWL_STYLE, OriginalWindowStyle);
-                SetWindowLongPtr(GameHWnd, GWL_EXSTYLE, OriginalExWindowStyle);
+                OSBackend->SetWindowStyle(GameHWnd, GWL_STYLE, OriginalWindowStyle);
+                OSBackend->SetWindowStyle(GameHWnd, GWL_EXSTYLE, OriginalExWindowStyle);
             }
         }
-        bIsClickThroughStateOS = (GetWindowLongPtr(GameHWnd, GWL_EXSTYLE) & WS_EX_TRANSPARENT) != 0;
+        bIsClickThroughStateOS = (OSBackend->GetWindowStyle(GameHWnd, GWL_EXSTYLE) & WS_EX_TRANSPARENT) != 0;
 
 
-        SetWindowPos(GameHWnd, NULL, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_FRAMECHANGED | SWP_SHOWWINDOW);
-        InvalidateRect(GameHWnd, NULL, true);
-        UpdateWindow(GameHWnd);
+        OSBackend->SetWindowPosition(GameHWnd, NULL, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER | SWP_FRAMECHANGED | SWP_SHOWWINDOW);
+        OSBackend->RepaintWindow(GameHWnd);
 
         bIsDesktopBackgroundActive = false;
+        WT_TRACE_EVENT(DesktopBackgroundTransition, false, true, reinterpret_cast<uint64>(CurrentWorkerW));
         CurrentWorkerW = nullptr;
-        bIsBorderlessActive = (GetWindowLongPtr(GameHWnd, GWL_STYLE) & WS_POPUP) != 0 && !((GetWindowLongPtr(GameHWnd, GWL_STYLE) & (WS_CAPTION | WS_THICKFRAME)));
-        bIsTopmostActive = (GetWindowLongPtr(GameHWnd, GWL_EXSTYLE) & WS_EX_TOPMOST) != 0;
+        bIsBorderlessActive = (OSBackend->GetWindowStyle(GameHWnd, GWL_STYLE) & WS_POPUP) != 0 && !((OSBackend->GetWindowStyle(GameHWnd, GWL_STYLE) & (WS_CAPTION | WS_THICKFRAME)));
+        bIsTopmostActive = (OSBackend->GetWindowStyle(GameHWnd, GWL_EXSTYLE) & WS_EX_TOPMOST) != 0;
 
         bIsInitialized = false;
         bOriginalStylesStored = false;
         GameSWindowPtr.Reset();
         UE_LOG(LogWindowHelper, Log, TEXT("Window removed from desktop background. Triggering re-initialization. Final GameHWnd: %p"), GameHWnd);
     }
-#else
-    UE_LOG(LogWindowHelper, Log, TEXT("SetAsDesktopBackground: Not supported on this platform."));
-#endif
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+﻿// WindowTransparencyHistogram.cpp
+#include "WindowTransparencyHistogram.h"
+
+// 最後のバケットはそれ以上すべて
+const double FWindowTransparencyRollingHistogram::BucketUpperBoundsMs[NumBuckets] = { 1.0, 2.0, 4.0, 8.0, 16.7, 33.3, 50.0, 100.0, 250.0, 500.0, 1000.0, DBL_MAX };
+
+FWindowTransparencyRollingHistogram::FWindowTransparencyRollingHistogram(int32 InCapacity)
+    : Capacity(FMath::Max(1, InCapacity))
+    , NextSampleIndex(0)
+    , TotalSampleCount(0)
+{
+    Samples.Reserve(Capacity);
+    FMemory::Memzero(BucketCounts);
+}
+
+void FWindowTransparencyRollingHistogram::AddSample(double Milliseconds)
+{
+    Milliseconds = FMath::Max(0.0, Milliseconds);
+    if (Samples.Num() < Capacity)
+    {
+        Samples.Add(Milliseconds);
+    }
+    else
+    {
+        Samples[NextSampleIndex] = Milliseconds;
+    }
+    NextSampleIndex = (NextSampleIndex + 1) % Capacity;
+    ++TotalSampleCount;
+
+    for (int32 BucketIndex = 0; BucketIndex < NumBuckets; ++BucketIndex)
+    {
+        if (Milliseconds <= BucketUpperBoundsMs[BucketIndex])
+        {
+            ++BucketCounts[BucketIndex];
+            break;
+        }
+    }
+}
+
+void FWindowTransparencyRollingHistogram::Reset()
+{
+    Samples.Reset();
+    NextSampleIndex = 0;
+    TotalSampleCount = 0;
+    FMemory::Memzero(BucketCounts);
+}
+
+FWindowTransparencyHistogramSummary FWindowTransparencyRollingHistogram::GetSummary() const
+{
+    FWindowTransparencyHistogramSummary Summary;
+    Summary.SampleCount = Samples.Num();
+    Summary.TotalSampleCount = TotalSampleCount;
+    if (Samples.Num() == 0)
+    {
+        return Summary;
+    }
+
+    TArray<double> Sorted = Samples;
+    Sorted.Sort();
+
+    double Sum = 0.0;
+    for (const double Sample : Sorted)
+    {
+        Sum += Sample;
+    }
+    auto Percentile = [&Sorted](double Fraction)
+    {
+        const int32 Index = FMath::Clamp(FMath::CeilToInt32(Fraction * Sorted.Num()) - 1, 0, Sorted.Num() - 1);
+        return static_cast<float>(Sorted[Index]);
+    };
+
+    Summary.MeanMs = static_cast<float>(Sum / Sorted.Num());
+    Summary.P50Ms = Percentile(0.50);
+    Summary.P95Ms = Percentile(0.95);
+    Summary.P99Ms = Percentile(0.99);
+    Summary.MaxMs = static_cast<float>(Sorted.Last());
+    return Summary;
+}
+
+FString FWindowTransparencyRollingHistogram::ToString(const TCHAR* Name) const
+{
+    const FWindowTransparencyHistogramSummary Summary = GetSummary();
+    FString Result = FString::Printf(TEXT("%s: %d samples (%d total), mean %.2f ms, p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, max %.2f ms"),
+        Name, Summary.SampleCount, Summary.TotalSampleCount, Summary.MeanMs, Summary.P50Ms, Summary.P95Ms, Summary.P99Ms, Summary.MaxMs);
+
+    double LowerBound = 0.0;
+    for (int32 BucketIndex = 0; BucketIndex < NumBuckets; ++BucketIndex)
+    {
+        if (BucketCounts[BucketIndex] > 0)
+        {
+            if (BucketIndex == NumBuckets - 1)
+            {
+                Result += FString::Printf(TEXT("\n  >  %6.1f ms : %lld"), LowerBound, BucketCounts[BucketIndex]);
+            }
+            else
+            {
+                Result += FString::Printf(TEXT("\n  <= %6.1f ms : %lld"), BucketUpperBoundsMs[BucketIndex], BucketCounts[BucketIndex]);
+            }
+        }
+        LowerBound = BucketUpperBoundsMs[BucketIndex];
+    }
+    return Result;
+}
@@ -0,0 +1,79 @@
+﻿// WindowTransparencyKernels.cpp
+#include "WindowTransparencyKernels.h"
+
+// ゲーム画面そのものや、浅い階層の全画面コンテナは背景として扱う
+bool FWindowTransparencyKernels::IsBlockingHitTestWidget(const FName& WidgetType, int32 PathLength)
+{
+    static const FName SWindowType(TEXT("SWindow"));
+    static const FName SGameLayerManagerType(TEXT("SGameLayerManager"));
+    static const FName SViewportType(TEXT("SViewport"));
+    static const FName SBorderType(TEXT("SBorder"));
+    static const FName SOverlayType(TEXT("SOverlay"));
+    static const FName SScaleBoxType(TEXT("SScaleBox"));
+    static const FName SCanvasPanelType(TEXT("SCanvasPanel"));
+    static const FName SObjectWidgetType(TEXT("SObjectWidget"));
+
+    if (WidgetType == SWindowType || WidgetType == SGameLayerManagerType || WidgetType == SViewportType)
+    {
+        return false;
+    }
+    if ((WidgetType == SBorderType || WidgetType == SOverlayType || WidgetType == SScaleBoxType || WidgetType == SCanvasPanelType) && PathLength <= 2)
+    {
+        return false;
+    }
+    if (WidgetType == SObjectWidgetType && PathLength <= 1)
+    {
+        return false;
+    }
+    return true;
+}
+
+// Regions から Occluders に覆われていない部分の面積を求める（矩形の引き算を繰り返す）
+int64 FWindowTransparencyKernels::ComputeUncoveredArea(const TArray<FIntRect>& Regions, const TArray<FIntRect>& Occluders)
+{
+    TArray<FIntRect> Uncovered = Regions;
+    TArray<FIntRect> Remaining;
+    for (const FIntRect& Occluder : Occluders)
+    {
+        Remaining.Reset();
+        for (const FIntRect& Piece : Uncovered)
+        {
+            FIntRect Overlap = Piece;
+            Overlap.Clip(Occluder);
+            if (Overlap.Area() <= 0)
+            {
+                Remaining.Add(Piece);
+                continue;
+            }
+            // 重なった部分の上下左右に残る矩形
+            if (Piece.Min.Y < Overlap.Min.Y)
+            {
+                Remaining.Emplace(Piece.Min.X, Piece.Min.Y, Piece.Max.X, Overlap.Min.Y);
+            }
+            if (Overlap.Max.Y < Piece.Max.Y)
+            {
+                Remaining.Emplace(Piece.Min.X, Overlap.Max.Y, Piece.Max.X, Piece.Max.Y);
+            }
+            if (Piece.Min.X < Overlap.Min.X)
+            {
+                Remaining.Emplace(Piece.Min.X, Overlap.Min.Y, Overlap.Min.X, Overlap.Max.Y);
+            }
+            if (Overlap.Max.X < Piece.Max.X)
+            {
+                Remaining.Emplace(Overlap.Max.X, Overlap.Min.Y, Piece.Max.X, Overlap.Max.Y);
+            }
+        }
+        Swap(Uncovered, Remaining);
+        if (Uncovered.Num() == 0)
+        {
+            break;
+        }
+    }
+
+    int64 Area = 0;
+    for (const FIntRect& Piece : Uncovered)
+    {
+        Area += static_cast<int64>(Piece.Width()) * Piece.Height();
+    }
+    return Area;
+}
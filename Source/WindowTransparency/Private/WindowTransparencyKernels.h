@@ -0,0 +1,17 @@
+﻿// WindowTransparencyKernels.h
+#pragma once
+
+#include "CoreMinimal.h"
+
+// ヘルパーが毎フレーム使う純粋な計算。ベンチマークが同じコードを計測できるよう、ヘルパーの外に置く
+struct FWindowTransparencyKernels
+{
+    /**
+     * True if a hit-test-visible widget of WidgetType at PathLength (1 for the window) blocks clicks. The game viewport and
+     * shallow full-screen containers count as background, so only widgets the user placed hold the window opaque.
+     */
+    static bool IsBlockingHitTestWidget(const FName& WidgetType, int32 PathLength);
+
+    /** Area of Regions not covered by any of Occluders. Regions must not overlap each other. */
+    static int64 ComputeUncoveredArea(const TArray<FIntRect>& Regions, const TArray<FIntRect>& Occluders);
+};
@@ -0,0 +1,443 @@
+﻿// WindowTransparencyOSBackend.cpp
+#include "WindowTransparencyOSBackend.h"
+#include "WindowTransparencyOSTypes.h"
+#include "Misc/ScopeLock.h"
+
+using namespace WindowTransparencyOS;
+
+FWindowTransparencyOSCallCounts IWindowTransparencyOSBackend::GetCallCounts() const
+{
+    auto Load = [this](ECall Call) { return CallCounters[static_cast<int32>(Call)].load(std::memory_order_relaxed); };
+    FWindowTransparencyOSCallCounts Counts;
+    Counts.GetStyle = Load(ECall::GetStyle);
+    Counts.SetStyle = Load(ECall::SetStyle);
+    Counts.SetPosition = Load(ECall::SetPosition);
+    Counts.GetParent = Load(ECall::GetParent);
+    Counts.SetParent = Load(ECall::SetParent);
+    Counts.Repaint = Load(ECall::Repaint);
+    Counts.ExtendFrame = Load(ECall::ExtendFrame);
+    Counts.QueryGeometry = Load(ECall::QueryGeometry);
+    Counts.FindWorkerW = Load(ECall::FindWorkerW);
+    return Counts;
+}
+
+void IWindowTransparencyOSBackend::ResetCallCounts()
+{
+    for (std::atomic<int32>& Counter : CallCounters)
+    {
+        Counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+#if PLATFORM_WINDOWS
+
+#include "WindowTransparencyStats.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogWindowOSBackend, Log, All);
+
+// ---------------------------------------------------------------------------
+// Win32
+// ---------------------------------------------------------------------------
+
+LONG_PTR FWindowTransparencyWin32Backend::GetWindowStyle(HWND Hwnd, int Index)
+{
+    CountCall(ECall::GetStyle);
+    return ::GetWindowLongPtr(Hwnd, Index);
+}
+
+LONG_PTR FWindowTransparencyWin32Backend::SetWindowStyle(HWND Hwnd, int Index, LONG_PTR NewStyle)
+{
+    CountCall(ECall::SetStyle);
+    INC_DWORD_STAT(STAT_WindowTransparency_StyleChanges);
+    CSV_CUSTOM_STAT(WindowTransparency, StyleChanges, 1, ECsvCustomStatOp::Accumulate);
+    return ::SetWindowLongPtr(Hwnd, Index, NewStyle);
+}
+
+bool FWindowTransparencyWin32Backend::SetWindowPosition(HWND Hwnd, HWND InsertAfter, int X, int Y, int Width, int Height, UINT Flags)
+{
+    CountCall(ECall::SetPosition);
+    INC_DWORD_STAT(STAT_WindowTransparency_SetWindowPosCalls);
+    CSV_CUSTOM_STAT(WindowTransparency, SetWindowPosCalls, 1, ECsvCustomStatOp::Accumulate);
+    return ::SetWindowPos(Hwnd, InsertAfter, X, Y, Width, Height, Flags) != 0;
+}
+
+HWND FWindowTransparencyWin32Backend::GetParentWindow(HWND Hwnd)
+{
+    CountCall(ECall::GetParent);
+    return ::GetParent(Hwnd);
+}
+
+HWND FWindowTransparencyWin32Backend::SetParentWindow(HWND Hwnd, HWND NewParent)
+{
+    CountCall(ECall::SetParent);
+    return ::SetParent(Hwnd, NewParent);
+}
+
+bool FWindowTransparencyWin32Backend::IsValidWindow(HWND Hwnd)
+{
+    return Hwnd && ::IsWindow(Hwnd);
+}
+
+void FWindowTransparencyWin32Backend::RepaintWindow(HWND Hwnd)
+{
+    CountCall(ECall::Repaint);
+    ::InvalidateRect(Hwnd, NULL, true);
+    ::UpdateWindow(Hwnd);
+}
+
+HRESULT FWindowTransparencyWin32Backend::ExtendFrameIntoClientArea(HWND Hwnd, const MARGINS& Margins)
+{
+    CountCall(ECall::ExtendFrame);
+    return ::DwmExtendFrameIntoClientArea(Hwnd, &Margins);
+}
+
+bool FWindowTransparencyWin32Backend::GetCursorScreenPosition(POINT& OutPoint)
+{
+    CountCall(ECall::QueryGeometry);
+    return ::GetCursorPos(&OutPoint) != 0;
+}
+
+bool FWindowTransparencyWin32Backend::GetWindowScreenRect(HWND Hwnd, RECT& OutRect)
+{
+    CountCall(ECall::QueryGeometry);
+    return ::GetWindowRect(Hwnd, &OutRect) != 0;
+}
+
+bool FWindowTransparencyWin32Backend::GetClientAreaRect(HWND Hwnd, RECT& OutRect)
+{
+    CountCall(ECall::QueryGeometry);
+    return ::GetClientRect(Hwnd, &OutRect) != 0;
+}
+
+bool FWindowTransparencyWin32Backend::GetClientScreenOrigin(HWND Hwnd, POINT& OutPoint)
+{
+    CountCall(ECall::QueryGeometry);
+    OutPoint = { 0, 0 };
+    return ::ClientToScreen(Hwnd, &OutPoint) != 0;
+}
+
+// Helper struct for EnumWindowsProcWorkerW
+struct WorkerWEnumData {
+    HWND WorkerW_Handle = nullptr;
+    HWND Progman_Handle = nullptr;
+    int MonitorCount = 0; // マルチモニター対応のためのヒント
+};
+
+// Callback for EnumWindows to find the correct WorkerW
+static BOOL CALLBACK EnumWindowsProcFindWorkerW(HWND hwnd, LPARAM lParam)
+{
+    WorkerWEnumData* pData = reinterpret_cast<WorkerWEnumData*>(lParam);
+    WCHAR className[256];
+    WCHAR windowTitle[256];
+
+    if (GetClassNameW(hwnd, className, sizeof(className) / sizeof(WCHAR)) && wcscmp(className, L"WorkerW") == 0)
+    {
+        GetWindowText(hwnd, windowTitle, sizeof(windowTitle) / sizeof(WCHAR));
+        bool bIsVisible = IsWindowVisible(hwnd);
+        HWND parentHwnd = GetParent(hwnd);
+        RECT rcClient;
+        GetClientRect(hwnd, &rcClient);
+
+        HWND defView = FindWindowEx(hwnd, NULL, L"SHELLDLL_DefView", NULL);
+        if (defView == NULL)
+        {
+            UE_LOG(LogWindowOSBackend, Log, TEXT("  - WorkerW %p does NOT have SHELLDLL_DefView child. Candidate."), hwnd);
+
+            if (bIsVisible && (rcClient.right - rcClient.left > 0) && (rcClient.bottom - rcClient.top > 0))
+            {
+
+                pData->WorkerW_Handle = hwnd;
+                UE_LOG(LogWindowOSBackend, Log, TEXT("  - WorkerW %p SELECTED as target (Visible, Valid Size, No DefView)."), hwnd);
+                return false;
+            }
+            else
+            {
+                FString skipReason;
+                if (!bIsVisible) skipReason += TEXT("NotVisible; ");
+                if (rcClient.right - rcClient.left <= 0) skipReason += TEXT("ZeroWidth; ");
+                if (rcClient.bottom - rcClient.top <= 0) skipReason += TEXT("ZeroHeight; ");
+                UE_LOG(LogWindowOSBackend, Log, TEXT("  - WorkerW %p (No DefView) SKIPPED. Reason: %s"), hwnd, *skipReason);
+            }
+        }
+        else
+        {
+            UE_LOG(LogWindowOSBackend, Log, TEXT("  - WorkerW %p HAS SHELLDLL_DefView child (%p). Skipping."), hwnd, defView);
+        }
+    }
+    return true;
+}
+
+HWND FWindowTransparencyWin32Backend::FindDesktopWorkerW()
+{
+    CountCall(ECall::FindWorkerW);
+    HWND progman = FindWindowW(L"Progman", NULL);
+    if (!progman)
+    {
+        UE_LOG(LogWindowOSBackend, Warning, TEXT("FindTargetWorkerW: Progman window not found."));
+        return nullptr;
+    }
+    UE_LOG(LogWindowOSBackend, Log, TEXT("FindTargetWorkerW: Found Progman: %p"), progman);
+
+    ULONG_PTR result;
+    UE_LOG(LogWindowOSBackend, Log, TEXT("FindTargetWorkerW: Sending 0x052C message to Progman %p."), progman);
+    SendMessageTimeout(progman, 0x052C, 0x0000000D, 0, SMTO_NORMAL, 1000, &result);
+    SendMessageTimeout(progman, 0x052C, 0, 0, SMTO_NORMAL, 1000, &result);
+
+    WorkerWEnumData data;
+    data.WorkerW_Handle = nullptr;
+    data.Progman_Handle = progman;
+    data.MonitorCount = GetSystemMetrics(SM_CMONITORS);
+
+    UE_LOG(LogWindowOSBackend, Log, TEXT("FindTargetWorkerW: Strategy 1 - EnumWindows for top-level WorkerW. Monitor count: %d"), data.MonitorCount);
+    EnumWindows(EnumWindowsProcFindWorkerW, reinterpret_cast<LPARAM>(&data));
+
+    if (data.WorkerW_Handle)
+    {
+        UE_LOG(LogWindowOSBackend, Log, TEXT("FindTargetWorkerW: Strategy 1 - Found target WorkerW: %p"), data.WorkerW_Handle);
+        return data.WorkerW_Handle;
+    }
+
+    UE_LOG(LogWindowOSBackend, Warning, TEXT("FindTargetWorkerW: Strategy 1 failed. Strategy 2 - EnumChildWindows on Progman (%p)."), progman);
+    data.WorkerW_Handle = nullptr;
+    EnumChildWindows(progman, EnumWindowsProcFindWorkerW, reinterpret_cast<LPARAM>(&data));
+
+    if (data.WorkerW_Handle)
+    {
+        UE_LOG(LogWindowOSBackend, Log, TEXT("FindTargetWorkerW: Strategy 2 - Found target WorkerW (%p) as child of Progman."), data.WorkerW_Handle);
+        return data.WorkerW_Handle;
+    }
+
+    UE_LOG(LogWindowOSBackend, Error, TEXT("FindTargetWorkerW: All strategies failed. No suitable WorkerW found."));
+    return nullptr;
+}
+
+DWORD FWindowTransparencyWin32Backend::GetLastErrorCode() const
+{
+    return ::GetLastError();
+}
+
+#endif // PLATFORM_WINDOWS
+
+// ---------------------------------------------------------------------------
+// Simulated
+// ---------------------------------------------------------------------------
+
+FWindowTransparencySimulatedBackend::FWindowTransparencySimulatedBackend()
+    : GameWindow(nullptr)
+    , DesktopWorkerW(nullptr)
+    , CursorPosition({ 0, 0 })
+    , NextHandleValue(0x1000)
+    , bFailSetParent(false)
+    , LastErrorCode(0)
+{
+    GameWindow = CreateSimulatedWindow(WS_OVERLAPPEDWINDOW | WS_VISIBLE, WS_EX_APPWINDOW, { 100, 100, 1380, 820 });
+    DesktopWorkerW = CreateSimulatedWindow(WS_POPUP | WS_VISIBLE, 0, { 0, 0, 1920, 1080 });
+}
+
+void FWindowTransparencySimulatedBackend::SetSimulatedWorkerW(HWND Hwnd)
+{
+    FScopeLock Lock(&WindowsLock);
+    DesktopWorkerW = Hwnd;
+}
+
+void FWindowTransparencySimulatedBackend::SetCursorScreenPosition(int32 X, int32 Y)
+{
+    FScopeLock Lock(&WindowsLock);
+    CursorPosition = { X, Y };
+}
+
+HWND FWindowTransparencySimulatedBackend::CreateSimulatedWindow(LONG_PTR Style, LONG_PTR ExStyle, const RECT& Rect)
+{
+    FScopeLock Lock(&WindowsLock);
+    const HWND Hwnd = reinterpret_cast<HWND>(NextHandleValue);
+    NextHandleValue += 0x10;
+
+    FSimulatedWindow& Window = Windows.Add(Hwnd);
+    Window.Style = Style;
+    Window.ExStyle = ExStyle;
+    Window.Rect = Rect;
+    return Hwnd;
+}
+
+void FWindowTransparencySimulatedBackend::DestroySimulatedWindow(HWND Hwnd)
+{
+    FScopeLock Lock(&WindowsLock);
+    Windows.Remove(Hwnd);
+}
+
+const FWindowTransparencySimulatedBackend::FSimulatedWindow* FWindowTransparencySimulatedBackend::FindSimulatedWindow(HWND Hwnd) const
+{
+    FScopeLock Lock(&WindowsLock);
+    return Windows.Find(Hwnd);
+}
+
+LONG_PTR FWindowTransparencySimulatedBackend::GetWindowStyle(HWND Hwnd, int Index)
+{
+    FScopeLock Lock(&WindowsLock);
+    CountCall(ECall::GetStyle);
+    const FSimulatedWindow* Window = Windows.Find(Hwnd);
+    if (!Window)
+    {
+        return 0;
+    }
+    // WS_EX_TOPMOST はZオーダーから決まる
+    return Index == GWL_STYLE ? Window->Style : ((Window->ExStyle & ~WS_EX_TOPMOST) | (Window->bTopmost ? WS_EX_TOPMOST : 0));
+}
+
+LONG_PTR FWindowTransparencySimulatedBackend::SetWindowStyle(HWND Hwnd, int Index, LONG_PTR NewStyle)
+{
+    FScopeLock Lock(&WindowsLock);
+    CountCall(ECall::SetStyle);
+    FSimulatedWindow* Window = Windows.Find(Hwnd);
+    if (!Window)
+    {
+        return 0;
+    }
+    LONG_PTR& Target = Index == GWL_STYLE ? Window->Style : Window->ExStyle;
+    const LONG_PTR PreviousStyle = Target;
+    Target = NewStyle;
+    return PreviousStyle;
+}
+
+bool FWindowTransparencySimulatedBackend::SetWindowPosition(HWND Hwnd, HWND InsertAfter, int X, int Y, int Width, int Height, UINT Flags)
+{
+    FScopeLock Lock(&WindowsLock);
+    CountCall(ECall::SetPosition);
+    FSimulatedWindow* Window = Windows.Find(Hwnd);
+    if (!Window)
+    {
+        return false;
+    }
+    Window->LastPositionFlags = Flags;
+    if (!(Flags & SWP_NOMOVE))
+    {
+        const LONG CurrentWidth = Window->Rect.right - Window->Rect.left;
+        const LONG CurrentHeight = Window->Rect.bottom - Window->Rect.top;
+        Window->Rect = { X, Y, X + CurrentWidth, Y + CurrentHeight };
+    }
+    if (!(Flags & SWP_NOSIZE))
+    {
+        Window->Rect.right = Window->Rect.left + Width;
+        Window->Rect.bottom = Window->Rect.top + Height;
+    }
+    if (!(Flags & SWP_NOZORDER))
+    {
+        if (InsertAfter == HWND_TOPMOST)
+        {
+            Window->bTopmost = true;
+        }
+        else if (InsertAfter == HWND_NOTOPMOST || InsertAfter == HWND_BOTTOM)
+        {
+            Window->bTopmost = false;
+        }
+    }
+    return true;
+}
+
+HWND FWindowTransparencySimulatedBackend::GetParentWindow(HWND Hwnd)
+{
+    FScopeLock Lock(&WindowsLock);
+    CountCall(ECall::GetParent);
+    const FSimulatedWindow* Window = Windows.Find(Hwnd);
+    return Window ? Window->Parent : nullptr;
+}
+
+HWND FWindowTransparencySimulatedBackend::SetParentWindow(HWND Hwnd, HWND NewParent)
+{
+    FScopeLock Lock(&WindowsLock);
+    CountCall(ECall::SetParent);
+    FSimulatedWindow* Window = Windows.Find(Hwnd);
+    if (!Window || (NewParent && !Windows.Contains(NewParent)))
+    {
+        LastErrorCode = ERROR_INVALID_WINDOW_HANDLE;
+        return nullptr;
+    }
+    if (bFailSetParent)
+    {
+        LastErrorCode = ERROR_ACCESS_DENIED;
+        return nullptr;
+    }
+    // Win32 と同様に、以前の親を返す（トップレベルだった場合はデスクトップを表す非nullの値）
+    const HWND PreviousParent = Window->Parent ? Window->Parent : reinterpret_cast<HWND>(static_cast<UPTRINT>(0x10));
+    Window->Parent = NewParent;
+    return PreviousParent;
+}
+
+bool FWindowTransparencySimulatedBackend::IsValidWindow(HWND Hwnd)
+{
+    FScopeLock Lock(&WindowsLock);
+    return Hwnd && Windows.Contains(Hwnd);
+}
+
+void FWindowTransparencySimulatedBackend::RepaintWindow(HWND Hwnd)
+{
+    CountCall(ECall::Repaint);
+}
+
+HRESULT FWindowTransparencySimulatedBackend::ExtendFrameIntoClientArea(HWND Hwnd, const MARGINS& Margins)
+{
+    FScopeLock Lock(&WindowsLock);
+    CountCall(ECall::ExtendFrame);
+    FSimulatedWindow* Window = Windows.Find(Hwnd);
+    if (!Window)
+    {
+        return E_HANDLE;
+    }
+    Window->Frame = Margins;
+    return S_OK;
+}
+
+bool FWindowTransparencySimulatedBackend::GetCursorScreenPosition(POINT& OutPoint)
+{
+    FScopeLock Lock(&WindowsLock);
+    CountCall(ECall::QueryGeometry);
+    OutPoint = CursorPosition;
+    return true;
+}
+
+bool FWindowTransparencySimulatedBackend::GetWindowScreenRect(HWND Hwnd, RECT& OutRect)
+{
+    FScopeLock Lock(&WindowsLock);
+    CountCall(ECall::QueryGeometry);
+    const FSimulatedWindow* Window = Windows.Find(Hwnd);
+    if (!Window)
+    {
+        return false;
+    }
+    OutRect = Window->Rect;
+    return true;
+}
+
+bool FWindowTransparencySimulatedBackend::GetClientAreaRect(HWND Hwnd, RECT& OutRect)
+{
+    FScopeLock Lock(&WindowsLock);
+    CountCall(ECall::QueryGeometry);
+    const FSimulatedWindow* Window = Windows.Find(Hwnd);
+    if (!Window)
+    {
+        return false;
+    }
+    OutRect = { 0, 0, Window->Rect.right - Window->Rect.left, Window->Rect.bottom - Window->Rect.top };
+    return true;
+}
+
+bool FWindowTransparencySimulatedBackend::GetClientScreenOrigin(HWND Hwnd, POINT& OutPoint)
+{
+    FScopeLock Lock(&WindowsLock);
+    CountCall(ECall::QueryGeometry);
+    const FSimulatedWindow* Window = Windows.Find(Hwnd);
+    if (!Window)
+    {
+        return false;
+    }
+    // 模擬ウィンドウは枠を持たないので、クライアント領域はウィンドウ矩形と一致する
+    OutPoint = { Window->Rect.left, Window->Rect.top };
+    return true;
+}
+
+HWND FWindowTransparencySimulatedBackend::FindDesktopWorkerW()
+{
+    FScopeLock Lock(&WindowsLock);
+    CountCall(ECall::FindWorkerW);
+    return DesktopWorkerW;
+}
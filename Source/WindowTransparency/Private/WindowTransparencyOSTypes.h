@@ -0,0 +1,56 @@
+﻿// WindowTransparencyOSTypes.h
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WindowTransparencyOSBackend.h"
+
+#if !PLATFORM_WINDOWS
+// Windows 以外でウィンドウ状態のロジックと模擬バックエンドをビルドするための Win32 の定数。
+// マクロにはせず WindowTransparencyOS の中だけに置き、使う .cpp が using namespace WindowTransparencyOS で取り込む
+namespace WindowTransparencyOS
+{
+    constexpr int GWL_STYLE = -16;
+    constexpr int GWL_EXSTYLE = -20;
+
+    constexpr LONG_PTR WS_OVERLAPPED = 0x00000000L;
+    constexpr LONG_PTR WS_POPUP = 0x80000000L;
+    constexpr LONG_PTR WS_CHILD = 0x40000000L;
+    constexpr LONG_PTR WS_VISIBLE = 0x10000000L;
+    constexpr LONG_PTR WS_CAPTION = 0x00C00000L;
+    constexpr LONG_PTR WS_SYSMENU = 0x00080000L;
+    constexpr LONG_PTR WS_THICKFRAME = 0x00040000L;
+    constexpr LONG_PTR WS_MINIMIZEBOX = 0x00020000L;
+    constexpr LONG_PTR WS_MAXIMIZEBOX = 0x00010000L;
+    constexpr LONG_PTR WS_OVERLAPPEDWINDOW = WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU | WS_THICKFRAME | WS_MINIMIZEBOX | WS_MAXIMIZEBOX;
+
+    constexpr LONG_PTR WS_EX_TOPMOST = 0x00000008L;
+    constexpr LONG_PTR WS_EX_TRANSPARENT = 0x00000020L;
+    constexpr LONG_PTR WS_EX_TOOLWINDOW = 0x00000080L;
+    constexpr LONG_PTR WS_EX_APPWINDOW = 0x00040000L;
+    constexpr LONG_PTR WS_EX_LAYERED = 0x00080000L;
+    constexpr LONG_PTR WS_EX_NOACTIVATE = 0x08000000L;
+
+    constexpr UINT SWP_NOSIZE = 0x0001;
+    constexpr UINT SWP_NOMOVE = 0x0002;
+    constexpr UINT SWP_NOZORDER = 0x0004;
+    constexpr UINT SWP_NOACTIVATE = 0x0010;
+    constexpr UINT SWP_FRAMECHANGED = 0x0020;
+    constexpr UINT SWP_SHOWWINDOW = 0x0040;
+    constexpr UINT SWP_NOOWNERZORDER = 0x0200;
+    constexpr UINT SWP_NOSENDCHANGING = 0x0400;
+    constexpr UINT SWP_ASYNCWINDOWPOS = 0x4000;
+
+    inline const HWND HWND_TOP = reinterpret_cast<HWND>(static_cast<intptr_t>(0));
+    inline const HWND HWND_BOTTOM = reinterpret_cast<HWND>(static_cast<intptr_t>(1));
+    inline const HWND HWND_TOPMOST = reinterpret_cast<HWND>(static_cast<intptr_t>(-1));
+    inline const HWND HWND_NOTOPMOST = reinterpret_cast<HWND>(static_cast<intptr_t>(-2));
+
+    constexpr HRESULT S_OK = 0;
+    constexpr HRESULT E_HANDLE = static_cast<HRESULT>(0x80070006);
+    constexpr bool SUCCEEDED(HRESULT Hr) { return Hr >= 0; }
+    constexpr bool FAILED(HRESULT Hr) { return Hr < 0; }
+
+    constexpr DWORD ERROR_ACCESS_DENIED = 5;
+    constexpr DWORD ERROR_INVALID_WINDOW_HANDLE = 1400;
+}
+#endif
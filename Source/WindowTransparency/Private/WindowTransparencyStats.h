@@ -0,0 +1,30 @@
+﻿// WindowTransparencyStats.h
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+
+// stat WindowTransparency で表示される統計グループ
+DECLARE_STATS_GROUP(TEXT("WindowTransparency"), STATGROUP_WindowTransparency, STATCAT_Advanced);
+
+// 処理時間
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Helper Tick"), STAT_WindowTransparency_HelperTick, STATGROUP_WindowTransparency, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("HitTest 3D Trace"), STAT_WindowTransparency_HitTest3D, STATGROUP_WindowTransparency, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("HitTest Widget Path"), STAT_WindowTransparency_HitTestWidget, STATGROUP_WindowTransparency, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("HitTest Broad Phase"), STAT_WindowTransparency_HitTestBroadPhase, STATGROUP_WindowTransparency, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Enumerate Windows"), STAT_WindowTransparency_EnumerateWindows, STATGROUP_WindowTransparency, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Regenerate Mesh"), STAT_WindowTransparency_RegenerateMesh, STATGROUP_WindowTransparency, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Build Window Meshes"), STAT_WindowTransparency_BuildMeshes, STATGROUP_WindowTransparency, );
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Apply Window Meshes"), STAT_WindowTransparency_ApplyMeshes, STATGROUP_WindowTransparency, );
+
+// フレームごとの回数（毎フレーム0にリセットされる）
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Style Changes"), STAT_WindowTransparency_StyleChanges, STATGROUP_WindowTransparency, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("SetWindowPos Calls"), STAT_WindowTransparency_SetWindowPosCalls, STATGROUP_WindowTransparency, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Windows Enumerated"), STAT_WindowTransparency_WindowsEnumerated, STATGROUP_WindowTransparency, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Sections Rebuilt"), STAT_WindowTransparency_SectionsRebuilt, STATGROUP_WindowTransparency, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("HitTest Kernel Traces"), STAT_WindowTransparency_HitTestKernelTraces, STATGROUP_WindowTransparency, );
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("HitTest Broad Phase Rejects"), STAT_WindowTransparency_HitTestBroadPhaseRejects, STATGROUP_WindowTransparency, );
+
+// -csvprofile 用のカテゴリ
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(WINDOWTRANSPARENCY_API, WindowTransparency);
@@ -0,0 +1,118 @@
+﻿// WindowTransparencyTrace.cpp
+#include "WindowTransparencyTrace.h"
+
+#if WINDOWTRANSPARENCY_TRACE_ENABLED
+
+#include "HAL/PlatformTime.h"
+
+UE_TRACE_CHANNEL_DEFINE(WindowTransparencyChannel)
+
+UE_TRACE_EVENT_BEGIN(WindowTransparency, CursorSample)
+    UE_TRACE_EVENT_FIELD(uint64, Cycle)
+    UE_TRACE_EVENT_FIELD(uint32, SequenceId)
+    UE_TRACE_EVENT_FIELD(float, X)
+    UE_TRACE_EVENT_FIELD(float, Y)
+    UE_TRACE_EVENT_FIELD(bool, bValid)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(WindowTransparency, HitTestDecision)
+    UE_TRACE_EVENT_FIELD(uint64, Cycle)
+    UE_TRACE_EVENT_FIELD(uint32, SequenceId)
+    UE_TRACE_EVENT_FIELD(float, X)
+    UE_TRACE_EVENT_FIELD(float, Y)
+    UE_TRACE_EVENT_FIELD(uint8, HitTestType)
+    UE_TRACE_EVENT_FIELD(uint8, TraceChannel)
+    UE_TRACE_EVENT_FIELD(bool, bWasOpaque)
+    UE_TRACE_EVENT_FIELD(bool, bIsOpaque)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(WindowTransparency, ClickThroughRequest)
+    UE_TRACE_EVENT_FIELD(uint64, Cycle)
+    UE_TRACE_EVENT_FIELD(uint32, SequenceId)
+    UE_TRACE_EVENT_FIELD(bool, bEnable)
+    UE_TRACE_EVENT_FIELD(bool, bOSStateBefore)
+    UE_TRACE_EVENT_FIELD(bool, bDWMTransparentActive)
+    UE_TRACE_EVENT_FIELD(bool, bMouseOverOpaque)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(WindowTransparency, OSStyleApplied)
+    UE_TRACE_EVENT_FIELD(uint64, Cycle)
+    UE_TRACE_EVENT_FIELD(uint32, SequenceId)
+    UE_TRACE_EVENT_FIELD(bool, bEnable)
+    UE_TRACE_EVENT_FIELD(uint64, OldExStyle)
+    UE_TRACE_EVENT_FIELD(uint64, NewExStyle)
+    UE_TRACE_EVENT_FIELD(bool, bSuccess)
+    UE_TRACE_EVENT_FIELD(uint64, CursorToStyleCycles)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(WindowTransparency, DesktopBackgroundTransition)
+    UE_TRACE_EVENT_FIELD(uint64, Cycle)
+    UE_TRACE_EVENT_FIELD(bool, bEnable)
+    UE_TRACE_EVENT_FIELD(bool, bSuccess)
+    UE_TRACE_EVENT_FIELD(uint64, WorkerW)
+UE_TRACE_EVENT_END()
+
+// ゲームスレッドからのみ呼ばれる
+static uint32 GTraceSequenceId = 0;
+static uint64 GLastCursorSampleCycle = 0;
+
+void FWindowTransparencyTrace::CursorSample(const FVector2D& MousePosInWindow, bool bValid)
+{
+    GLastCursorSampleCycle = FPlatformTime::Cycles64();
+    ++GTraceSequenceId;
+
+    UE_TRACE_LOG(WindowTransparency, CursorSample, WindowTransparencyChannel)
+        << CursorSample.Cycle(GLastCursorSampleCycle)
+        << CursorSample.SequenceId(GTraceSequenceId)
+        << CursorSample.X(static_cast<float>(MousePosInWindow.X))
+        << CursorSample.Y(static_cast<float>(MousePosInWindow.Y))
+        << CursorSample.bValid(bValid);
+}
+
+void FWindowTransparencyTrace::HitTestDecision(const FVector2D& MousePosInWindow, uint8 HitTestType, uint8 TraceChannel, bool bWasOpaque, bool bIsOpaque)
+{
+    UE_TRACE_LOG(WindowTransparency, HitTestDecision, WindowTransparencyChannel)
+        << HitTestDecision.Cycle(FPlatformTime::Cycles64())
+        << HitTestDecision.SequenceId(GTraceSequenceId)
+        << HitTestDecision.X(static_cast<float>(MousePosInWindow.X))
+        << HitTestDecision.Y(static_cast<float>(MousePosInWindow.Y))
+        << HitTestDecision.HitTestType(HitTestType)
+        << HitTestDecision.TraceChannel(TraceChannel)
+        << HitTestDecision.bWasOpaque(bWasOpaque)
+        << HitTestDecision.bIsOpaque(bIsOpaque);
+}
+
+void FWindowTransparencyTrace::ClickThroughRequest(bool bEnable, bool bOSStateBefore, bool bDWMTransparentActive, bool bMouseOverOpaque)
+{
+    UE_TRACE_LOG(WindowTransparency, ClickThroughRequest, WindowTransparencyChannel)
+        << ClickThroughRequest.Cycle(FPlatformTime::Cycles64())
+        << ClickThroughRequest.SequenceId(GTraceSequenceId)
+        << ClickThroughRequest.bEnable(bEnable)
+        << ClickThroughRequest.bOSStateBefore(bOSStateBefore)
+        << ClickThroughRequest.bDWMTransparentActive(bDWMTransparentActive)
+        << ClickThroughRequest.bMouseOverOpaque(bMouseOverOpaque);
+}
+
+void FWindowTransparencyTrace::OSStyleApplied(bool bEnable, uint64 OldExStyle, uint64 NewExStyle, bool bSuccess)
+{
+    const uint64 Cycle = FPlatformTime::Cycles64();
+    UE_TRACE_LOG(WindowTransparency, OSStyleApplied, WindowTransparencyChannel)
+        << OSStyleApplied.Cycle(Cycle)
+        << OSStyleApplied.SequenceId(GTraceSequenceId)
+        << OSStyleApplied.bEnable(bEnable)
+        << OSStyleApplied.OldExStyle(OldExStyle)
+        << OSStyleApplied.NewExStyle(NewExStyle)
+        << OSStyleApplied.bSuccess(bSuccess)
+        << OSStyleApplied.CursorToStyleCycles(GLastCursorSampleCycle != 0 ? Cycle - GLastCursorSampleCycle : 0);
+}
+
+void FWindowTransparencyTrace::DesktopBackgroundTransition(bool bEnable, bool bSuccess, uint64 WorkerWHandle)
+{
+    UE_TRACE_LOG(WindowTransparency, DesktopBackgroundTransition, WindowTransparencyChannel)
+        << DesktopBackgroundTransition.Cycle(FPlatformTime::Cycles64())
+        << DesktopBackgroundTransition.bEnable(bEnable)
+        << DesktopBackgroundTransition.bSuccess(bSuccess)
+        << DesktopBackgroundTransition.WorkerW(WorkerWHandle);
+}
+
+#endif // WINDOWTRANSPARENCY_TRACE_ENABLED
@@ -0,0 +1,42 @@
+﻿// WindowTransparencyTrace.h
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+// Unreal Insights 用のトレース。-trace=default,WindowTransparency で有効化する
+#if UE_TRACE_ENABLED && !UE_BUILD_SHIPPING
+#define WINDOWTRANSPARENCY_TRACE_ENABLED 1
+#else
+#define WINDOWTRANSPARENCY_TRACE_ENABLED 0
+#endif
+
+#if WINDOWTRANSPARENCY_TRACE_ENABLED
+
+UE_TRACE_CHANNEL_EXTERN(WindowTransparencyChannel);
+
+/**
+ * Markers for each stage of a click-through decision. Every cursor sample starts a new sequence id, and the later markers of that
+ * decision carry the same id, so cursor-to-style latency can be read per event. OSStyleApplied also records the latency directly.
+ */
+struct FWindowTransparencyTrace
+{
+    static void CursorSample(const FVector2D& MousePosInWindow, bool bValid);
+    static void HitTestDecision(const FVector2D& MousePosInWindow, uint8 HitTestType, uint8 TraceChannel, bool bWasOpaque, bool bIsOpaque);
+    static void ClickThroughRequest(bool bEnable, bool bOSStateBefore, bool bDWMTransparentActive, bool bMouseOverOpaque);
+    static void OSStyleApplied(bool bEnable, uint64 OldExStyle, uint64 NewExStyle, bool bSuccess);
+    static void DesktopBackgroundTransition(bool bEnable, bool bSuccess, uint64 WorkerWHandle);
+};
+
+// チャンネルが無効な間は引数の評価も行わない
+#define WT_TRACE_SCOPE(Name) TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL_STR(Name, WindowTransparencyChannel)
+#define WT_TRACE_EVENT(Stage, ...) \
+    do { if (UE_TRACE_CHANNELEXPR_IS_ENABLED(WindowTransparencyChannel)) { FWindowTransparencyTrace::Stage(__VA_ARGS__); } } while (0)
+
+#else
+
+#define WT_TRACE_SCOPE(Name)
+#define WT_TRACE_EVENT(Stage, ...) do { } while (0)
+
+#endif // WINDOWTRANSPARENCY_TRACE_ENABLED
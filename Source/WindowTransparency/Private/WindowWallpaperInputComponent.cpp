@@ -0,0 +1,51 @@
+﻿// WindowWallpaperInputComponent.cpp
+#include "WindowWallpaperInputComponent.h"
+#include "WindowTransparency.h"
+
+UWindowWallpaperInputComponent::UWindowWallpaperInputComponent()
+    : bReceiveMoveEvents(true)
+{
+    // 入力は通知で届くので Tick は不要
+    PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UWindowWallpaperInputComponent::BeginPlay()
+{
+    Super::BeginPlay();
+
+    // 購読している間だけヘルパーが入力スレッドを動かす
+    if (UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper())
+    {
+        WallpaperMouseEventsHandle = Helper->OnWallpaperMouseEvents().AddUObject(this, &UWindowWallpaperInputComponent::HandleWallpaperMouseEvents);
+        BoundHelper = Helper;
+    }
+}
+
+void UWindowWallpaperInputComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    if (UWindowTransparencyHelper* Helper = BoundHelper.Get())
+    {
+        Helper->OnWallpaperMouseEvents().Remove(WallpaperMouseEventsHandle);
+    }
+    WallpaperMouseEventsHandle.Reset();
+    BoundHelper.Reset();
+    Super::EndPlay(EndPlayReason);
+}
+
+void UWindowWallpaperInputComponent::HandleWallpaperMouseEvents(const TArray<FWindowWallpaperMouseEvent>& Events)
+{
+    if (bReceiveMoveEvents)
+    {
+        OnWallpaperMouseEvents.Broadcast(Events);
+        return;
+    }
+
+    TArray<FWindowWallpaperMouseEvent> FilteredEvents = Events.FilterByPredicate([](const FWindowWallpaperMouseEvent& Event)
+    {
+        return Event.Type != EWindowWallpaperMouseEventType::Move;
+    });
+    if (FilteredEvents.Num() > 0)
+    {
+        OnWallpaperMouseEvents.Broadcast(FilteredEvents);
+    }
+}
@@ -1,15 +1,174 @@
 ﻿// WindowsRepresentationComponent.cpp
 #include "WindowsRepresentationComponent.h"
+#include "WindowCuboidGenerator.h"
+#include "WindowTransparencyStats.h"
 #include "PhysicsEngine/BodySetup.h"
+#include "Components/BoxComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "UObject/ConstructorHelpers.h"
+#include "WindowTransparency.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/GameViewportClient.h"
+#include "GameFramework/PlayerController.h"
+#include "Kismet/GameplayStatics.h"
+#include "SceneView.h"
+#include "Tasks/Task.h"
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+
+static int32 GWindowMeshCoalesceUpdates = -1;
+static FAutoConsoleVariableRef CVarWindowMeshCoalesceUpdates(
+    TEXT("wt.Mesh.CoalesceUpdates"),
+    GWindowMeshCoalesceUpdates,
+    TEXT("Overrides bCoalesceUpdates on every WindowsRepresentationComponent: 0 = rebuild on each UpdateWindows call, 1 = once per frame, -1 = use the component setting."),
+    ECVF_Default);
+
+// 長方形のウィンドウであれば、直方体を表すボックスのトランスフォームと大きさ（半分）を求める
+static bool ComputeWindowBox(const FWindowPoints& Points, float CuboidThickness, FTransform& OutTransform, FVector& OutExtent)
+{
+    const FVector EdgeX = Points.Point2_TR - Points.Point1_TL;
+    const FVector EdgeY = Points.Point4_BL - Points.Point1_TL;
+    const float Width = EdgeX.Size();
+    const float Height = EdgeY.Size();
+    if (Width <= KINDA_SMALL_NUMBER || Height <= KINDA_SMALL_NUMBER)
+    {
+        return false;
+    }
+
+    const FVector AxisX = EdgeX / Width;
+    const FVector AxisY = EdgeY / Height;
+    const float Tolerance = 1.e-3f * FMath::Max(Width, Height);
+    if (FMath::Abs(FVector::DotProduct(AxisX, AxisY)) > 1.e-3f ||
+        !Points.Point3_BR.Equals(Points.Point1_TL + EdgeX + EdgeY, Tolerance))
+    {
+        return false;
+    }
+
+    const FVector SurfaceNormal = FVector::CrossProduct(EdgeX, EdgeY).GetSafeNormal();
+    const FVector Center = (Points.Point1_TL + Points.Point3_BR) * 0.5f - SurfaceNormal * (CuboidThickness * 0.5f);
+
+    OutTransform = FTransform(FRotationMatrix::MakeFromXZ(AxisX, SurfaceNormal).ToQuat(), Center);
+    OutExtent = FVector(Width * 0.5f, Height * 0.5f, CuboidThickness * 0.5f);
+    return true;
+}
+
+// メッシュ生成の入力。ゲームスレッドで作成した不変のコピーで、ワーカースレッドからも安全に読める
+struct FWindowMeshBuildRequest
+{
+    uint32 Generation = 0;
+    float Thickness = 0.0f;
+    bool bWithVertexColors = false;
+    bool bCreateCollision = false;
+    bool bUseBoxCollision = false;
+    bool bUseInstancing = false;
+    bool bForceCollisionRebuild = false;
+    TSet<FName> ActiveWindowNames;
+    TArray<FWindowPoints> DirtyWindows;
+    TArray<FWindowSectionSource> DirtySources;
+};
+
+struct FWindowMeshBuildEntry
+{
+    FName WindowName;
+    FWindowSectionSource Source;
+    FWindowCuboidBuffers Cuboid;
+    bool bIsRectangle = false;
+    FTransform BoxTransform;
+    FVector BoxExtent = FVector::ZeroVector;
+};
+
+// メッシュ生成の結果。ゲームスレッドで一度に適用する
+struct FWindowMeshBuildResult
+{
+    uint32 Generation = 0;
+    bool bCreateCollision = false;
+    bool bUseBoxCollision = false;
+    bool bUseInstancing = false;
+    bool bForceCollisionRebuild = false;
+    TSet<FName> ActiveWindowNames;
+    TArray<FWindowMeshBuildEntry> Entries;
+};
+
+static void BuildWindowMeshes(const FWindowMeshBuildRequest& Request, FWindowMeshBuildResult& OutResult)
+{
+    SCOPE_CYCLE_COUNTER(STAT_WindowTransparency_BuildMeshes);
+
+    OutResult.Generation = Request.Generation;
+    OutResult.bCreateCollision = Request.bCreateCollision;
+    OutResult.bUseBoxCollision = Request.bUseBoxCollision;
+    OutResult.bUseInstancing = Request.bUseInstancing;
+    OutResult.bForceCollisionRebuild = Request.bForceCollisionRebuild;
+    OutResult.ActiveWindowNames = Request.ActiveWindowNames;
+
+    // 既存のエントリは縮めずに残し、バッファを再利用する
+    OutResult.Entries.SetNum(Request.DirtyWindows.Num(), EAllowShrinking::No);
+    for (int32 Index = 0; Index < Request.DirtyWindows.Num(); ++Index)
+    {
+        const FWindowPoints& Points = Request.DirtyWindows[Index];
+        FWindowMeshBuildEntry& Entry = OutResult.Entries[Index];
+        Entry.WindowName = Points.WindowName;
+        Entry.Source = Request.DirtySources[Index];
+        Entry.bIsRectangle = (Request.bUseBoxCollision || Request.bUseInstancing) && ComputeWindowBox(Points, Request.Thickness, Entry.BoxTransform, Entry.BoxExtent);
+
+        // インスタンス描画される長方形は頂点を生成しない
+        if (!(Request.bUseInstancing && Entry.bIsRectangle))
+        {
+            FWindowCuboidGenerator::Build(Points, Request.Thickness, Request.bWithVertexColors, Entry.Cuboid);
+        }
+    }
+}
 
 UWindowsRepresentationComponent::UWindowsRepresentationComponent()
 {
-    PrimaryComponentTick.bCanEverTick = false;
+    // 更新要求があったフレームの最後にだけTickする
+    PrimaryComponentTick.bCanEverTick = true;
+    PrimaryComponentTick.bStartWithTickEnabled = false;
+    PrimaryComponentTick.bTickEvenWhenPaused = true;
+    PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
 
     ProceduralMeshComponent = CreateDefaultSubobject<UProceduralMeshComponent>(TEXT("GeneratedWindowsMesh"));
+    InstancedMeshComponent = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("GeneratedWindowsInstances"));
+
+    static ConstructorHelpers::FObjectFinder<UStaticMesh> CubeMeshFinder(TEXT("/Engine/BasicShapes/Cube.Cube"));
+    if (CubeMeshFinder.Succeeded())
+    {
+        InstanceCubeMesh = CubeMeshFinder.Object;
+    }
+    RenderMode = EWindowRenderMode::ProceduralMesh;
+    AppliedRenderMode = EWindowRenderMode::ProceduralMesh;
+    LastInstanceUpdateSeconds = 0.0;
     Thickness = 10.0f;
     bCreateCollision = true;
+    bGenerateVertexColors = false;
+    bCoalesceUpdates = true;
     NextAvailableSectionIndex = 0;
+    bCollisionBuilt = false;
+    CollisionMode = EWindowCollisionMode::ConvexMesh;
+    AppliedCollisionMode = EWindowCollisionMode::ConvexMesh;
+    bRegeneratePending = false;
+    LastRebuiltWindowCount = 0;
+    bAsyncMeshGeneration = false;
+    MeshBuildGeneration = 0;
+    bMeshBuildInFlight = false;
+    bMeshBuildQueued = false;
+    bAsyncCookingOverridden = false;
+    bSavedUseAsyncCooking = false;
+    bConvexCollisionApplied = false;
+
+    bBindToExternalWindows = false;
+    ExternalWindowUpdateInterval = 0.1f;
+    ProjectionPlayerIndex = 0;
+    ProjectionDistance = 1000.0f;
+    bUseCustomProjectionPlane = false;
+    ProjectionPlaneOrigin = FVector::ZeroVector;
+    ProjectionPlaneNormal = FVector::ForwardVector;
+    bInterpolateExternalWindows = false;
+    ExternalWindowInterpSpeed = 15.0f;
+    bExternalWindowsBound = false;
+    bExternalSnapshotPending = false;
+    LastViewProjectionMatrix = FMatrix::Identity;
+    LastGameWindowRect = FIntRect();
 }
 
 void UWindowsRepresentationComponent::BeginPlay()
@@ -24,25 +183,56 @@ void UWindowsRepresentationComponent::BeginPlay()
         {
             ProceduralMeshComponent->RegisterComponent();
         }
+
+        InstancedMeshComponent->AttachToComponent(ProceduralMeshComponent, FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+        InstancedMeshComponent->NumCustomDataFloats = 3; // Width, Height, Thickness
+        if (!InstancedMeshComponent->IsRegistered())
+        {
+            InstancedMeshComponent->RegisterComponent();
+        }
     }
     else
     {
         UE_LOG(LogTemp, Warning, TEXT("UWindowsRepresentationComponent needs an Owner with a RootComponent to attach its ProceduralMeshComponent."));
     }
 
-    WindowSectionMap.Empty();
-    NextAvailableSectionIndex = 0;
+    ResetSectionCache();
     RegenerateMesh();
+
+    if (bBindToExternalWindows)
+    {
+        BindExternalWindows();
+    }
+}
+
+void UWindowsRepresentationComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    UnbindExternalWindows();
+    Super::EndPlay(EndPlayReason);
 }
 
 void UWindowsRepresentationComponent::OnComponentDestroyed(bool bDestroyingHierarchy)
 {
+    UnbindExternalWindows();
     if (ProceduralMeshComponent && !ProceduralMeshComponent->IsBeingDestroyed())
     {
         ProceduralMeshComponent->ClearAllMeshSections();
         ProceduralMeshComponent->ClearCollisionConvexMeshes();
     }
-    WindowSectionMap.Empty();
+    if (InstancedMeshComponent && !InstancedMeshComponent->IsBeingDestroyed())
+    {
+        InstancedMeshComponent->ClearInstances();
+    }
+    ReleaseAllWindowBoxes();
+    for (UBoxComponent* Box : FreeWindowBoxes)
+    {
+        if (Box && !Box->IsBeingDestroyed())
+        {
+            Box->DestroyComponent();
+        }
+    }
+    FreeWindowBoxes.Empty();
+    ResetSectionCache();
     Super::OnComponentDestroyed(bDestroyingHierarchy);
 }
 
@@ -58,6 +248,10 @@ void UWindowsRepresentationComponent::PostEditChangeProperty(FPropertyChangedEve
         PropertyName == GET_MEMBER_NAME_CHECKED(UWindowsRepresentationComponent, Thickness) ||
         PropertyName == GET_MEMBER_NAME_CHECKED(UWindowsRepresentationComponent, WindowMaterial) ||
         PropertyName == GET_MEMBER_NAME_CHECKED(UWindowsRepresentationComponent, bCreateCollision) ||
+        PropertyName == GET_MEMBER_NAME_CHECKED(UWindowsRepresentationComponent, CollisionMode) ||
+        PropertyName == GET_MEMBER_NAME_CHECKED(UWindowsRepresentationComponent, bGenerateVertexColors) ||
+        PropertyName == GET_MEMBER_NAME_CHECKED(UWindowsRepresentationComponent, RenderMode) ||
+        PropertyName == GET_MEMBER_NAME_CHECKED(UWindowsRepresentationComponent, InstanceCubeMesh) ||
         MemberPropertyName == GET_MEMBER_NAME_CHECKED(UWindowsRepresentationComponent, WindowPointSets) ||
         (PropertyChangedEvent.Property && PropertyChangedEvent.Property->GetOwnerStruct() == FWindowPoints::StaticStruct())
         )
@@ -71,11 +265,466 @@ void UWindowsRepresentationComponent::UpdateWindows(const TArray<FWindowPoints>&
 {
     WindowPointSets = NewPointSets;
     Thickness = NewThickness;
+
+    UWorld* World = GetWorld();
+    const bool bShouldCoalesce = GWindowMeshCoalesceUpdates >= 0 ? GWindowMeshCoalesceUpdates != 0 : bCoalesceUpdates;
+    if (bShouldCoalesce && World && World->IsGameWorld() && IsRegistered())
+    {
+        if (!bRegeneratePending)
+        {
+            bRegeneratePending = true;
+            SetComponentTickEnabled(true);
+        }
+        return;
+    }
     RegenerateMesh();
 }
 
+void UWindowsRepresentationComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+    Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+    if (bExternalWindowsBound)
+    {
+        if (bExternalSnapshotPending)
+        {
+            ApplyExternalWindowsSnapshot();
+        }
+        if (bInterpolateExternalWindows)
+        {
+            InterpolateExternalWindows(DeltaTime);
+        }
+    }
+
+    if (bRegeneratePending)
+    {
+        RegenerateMesh();
+    }
+
+    // バインド中は毎フレームTickし、それ以外は次の更新要求まで停止する
+    if (!bExternalWindowsBound)
+    {
+        SetComponentTickEnabled(false);
+    }
+}
+
+void UWindowsRepresentationComponent::SetBindToExternalWindows(bool bEnable)
+{
+    bBindToExternalWindows = bEnable;
+    if (!HasBegunPlay())
+    {
+        return;
+    }
+
+    if (bEnable)
+    {
+        BindExternalWindows();
+    }
+    else
+    {
+        UnbindExternalWindows();
+    }
+}
+
+void UWindowsRepresentationComponent::BindExternalWindows()
+{
+#if PLATFORM_WINDOWS
+    if (bExternalWindowsBound)
+    {
+        return;
+    }
+
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    if (!Helper)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("UWindowsRepresentationComponent: Could not get WindowTransparencyHelper. External windows will not be bound."));
+        return;
+    }
+
+    ExternalWindowsHandle = Helper->OnExternalWindowsSnapshotUpdated().AddUObject(this, &UWindowsRepresentationComponent::OnExternalWindowsSnapshot);
+    Helper->SetExternalWindowsSnapshotInterval(ExternalWindowsHandle, ExternalWindowUpdateInterval);
+    bExternalWindowsBound = true;
+    bExternalSnapshotPending = false;
+    LastExternalWindowRects.Empty();
+    ExternalWindowTargets.Empty();
+    SetComponentTickEnabled(true);
+#else
+    UE_LOG(LogTemp, Warning, TEXT("UWindowsRepresentationComponent: External window binding is only supported on Windows."));
+#endif
+}
+
+void UWindowsRepresentationComponent::UnbindExternalWindows()
+{
+    if (!bExternalWindowsBound)
+    {
+        return;
+    }
+
+    if (UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper())
+    {
+        Helper->OnExternalWindowsSnapshotUpdated().Remove(ExternalWindowsHandle);
+        Helper->ClearExternalWindowsSnapshotInterval(ExternalWindowsHandle);
+    }
+    ExternalWindowsHandle.Reset();
+    bExternalWindowsBound = false;
+    bExternalSnapshotPending = false;
+    PendingExternalSnapshot.Empty();
+    LastExternalWindowRects.Empty();
+    ExternalWindowTargets.Empty();
+}
+
+void UWindowsRepresentationComponent::OnExternalWindowsSnapshot(const TArray<FOtherWindowInfo>& Snapshot)
+{
+    PendingExternalSnapshot = Snapshot;
+    bExternalSnapshotPending = true;
+}
+
+void UWindowsRepresentationComponent::ApplyExternalWindowsSnapshot()
+{
+#if PLATFORM_WINDOWS
+    bExternalSnapshotPending = false;
+
+    UWindowTransparencyHelper* Helper = FWindowTransparencyModule::GetHelper();
+    APlayerController* PC = UGameplayStatics::GetPlayerController(this, ProjectionPlayerIndex);
+    ULocalPlayer* LocalPlayer = PC ? PC->GetLocalPlayer() : nullptr;
+    if (!Helper || !LocalPlayer || !LocalPlayer->ViewportClient || !ProceduralMeshComponent)
+    {
+        return;
+    }
+
+    // ビューポートはクライアント領域に描画されるので、枠を含むウィンドウ矩形ではなくクライアント領域の原点を基準にする。
+    // 自動フィット中の切り出しは GetProjectionData がビュー拡張を通して適用する
+    FIntRect GameWindowRect;
+    FSceneViewProjectionData ProjectionData;
+    if (!Helper->GetClientScreenRect(GameWindowRect) || !LocalPlayer->GetProjectionData(LocalPlayer->ViewportClient->Viewport, ProjectionData))
+    {
+        return;
+    }
+
+    FPlane ProjectionPlane;
+    if (bUseCustomProjectionPlane)
+    {
+        ProjectionPlane = FPlane(ProjectionPlaneOrigin, ProjectionPlaneNormal.GetSafeNormal());
+    }
+    else
+    {
+        FVector CameraLocation;
+        FRotator CameraRotation;
+        PC->GetPlayerViewPoint(CameraLocation, CameraRotation);
+        const FVector CameraForward = CameraRotation.Vector();
+        ProjectionPlane = FPlane(CameraLocation + CameraForward * ProjectionDistance, CameraForward);
+    }
+
+    ApplyExternalWindowsSnapshotWithView(PendingExternalSnapshot, GameWindowRect, ProjectionData.GetConstrainedViewRect(), ProjectionData.ComputeViewProjectionMatrix(), ProjectionPlane);
+#endif
+}
+
+bool UWindowsRepresentationComponent::ApplyExternalWindowsSnapshotWithView(const TArray<FOtherWindowInfo>& Snapshot, const FIntRect& GameWindowRect, const FIntRect& ViewRect, const FMatrix& ViewProjectionMatrix, const FPlane& ProjectionPlane)
+{
+    if (!ProceduralMeshComponent)
+    {
+        return false;
+    }
+
+    // 逆行列は一度だけ計算し、全ウィンドウの四隅をまとめて逆投影する
+    const FMatrix InvViewProjectionMatrix = ViewProjectionMatrix.Inverse();
+
+    // カメラやゲームウィンドウが動いた場合は全ウィンドウを投影し直す
+    const bool bProjectionChanged = !ViewProjectionMatrix.Equals(LastViewProjectionMatrix) || GameWindowRect != LastGameWindowRect;
+    LastViewProjectionMatrix = ViewProjectionMatrix;
+    LastGameWindowRect = GameWindowRect;
+
+    const FTransform& MeshTransform = ProceduralMeshComponent->GetComponentTransform();
+    auto ProjectCorner = [&](int32 DesktopX, int32 DesktopY) -> FVector
+    {
+        const FVector2D ScreenPos(DesktopX - GameWindowRect.Min.X, DesktopY - GameWindowRect.Min.Y);
+        FVector RayOrigin;
+        FVector RayDirection;
+        FSceneView::DeprojectScreenToWorld(ScreenPos, ViewRect, InvViewProjectionMatrix, RayOrigin, RayDirection);
+
+        FVector WorldPoint = RayOrigin + RayDirection * ProjectionDistance;
+        if (!FMath::IsNearlyZero(FVector::DotProduct(RayDirection, FVector(ProjectionPlane))))
+        {
+            WorldPoint = FMath::RayPlaneIntersection(RayOrigin, RayDirection, ProjectionPlane);
+        }
+        return MeshTransform.InverseTransformPosition(WorldPoint);
+    };
+
+    TSet<FName> SeenWindows;
+    bool bAnyChanged = false;
+    for (const FOtherWindowInfo& Info : Snapshot)
+    {
+        const FName WindowName(*Info.WindowHandleStr);
+        SeenWindows.Add(WindowName);
+
+        const FIntRect WindowRect(Info.PosX, Info.PosY, Info.PosX + Info.Width, Info.PosY + Info.Height);
+        const FIntRect* LastRect = LastExternalWindowRects.Find(WindowName);
+        if (!bProjectionChanged && LastRect && *LastRect == WindowRect)
+        {
+            continue;
+        }
+        LastExternalWindowRects.Add(WindowName, WindowRect);
+
+        FWindowPoints Target;
+        Target.WindowName = WindowName;
+        Target.Point1_TL = ProjectCorner(WindowRect.Min.X, WindowRect.Min.Y);
+        Target.Point2_TR = ProjectCorner(WindowRect.Max.X, WindowRect.Min.Y);
+        Target.Point3_BR = ProjectCorner(WindowRect.Max.X, WindowRect.Max.Y);
+        Target.Point4_BL = ProjectCorner(WindowRect.Min.X, WindowRect.Max.Y);
+        ExternalWindowTargets.Add(WindowName, Target);
+        bAnyChanged = true;
+    }
+
+    for (auto It = ExternalWindowTargets.CreateIterator(); It; ++It)
+    {
+        if (!SeenWindows.Contains(It.Key()))
+        {
+            LastExternalWindowRects.Remove(It.Key());
+            It.RemoveCurrent();
+            bAnyChanged = true;
+        }
+    }
+
+    if (!bAnyChanged)
+    {
+        return false;
+    }
+
+    // 補間する場合、既存ウィンドウの現在位置は維持して InterpolateExternalWindows で目標に近づける
+    TMap<FName, FWindowPoints> CurrentPoints;
+    if (bInterpolateExternalWindows)
+    {
+        for (const FWindowPoints& Points : WindowPointSets)
+        {
+            CurrentPoints.Add(Points.WindowName, Points);
+        }
+    }
+
+    TArray<FWindowPoints> NewPointSets;
+    NewPointSets.Reserve(Snapshot.Num());
+    for (const FOtherWindowInfo& Info : Snapshot)
+    {
+        const FName WindowName(*Info.WindowHandleStr);
+        if (const FWindowPoints* Current = CurrentPoints.Find(WindowName))
+        {
+            NewPointSets.Add(*Current);
+        }
+        else if (const FWindowPoints* Target = ExternalWindowTargets.Find(WindowName))
+        {
+            NewPointSets.Add(*Target);
+        }
+    }
+    WindowPointSets = MoveTemp(NewPointSets);
+    bRegeneratePending = true;
+    return true;
+}
+
+void UWindowsRepresentationComponent::InterpolateExternalWindows(float DeltaTime)
+{
+    // 途中のフレームは既存セクションの頂点位置だけを書き換え、コリジョンのクックはしない。
+    // 目標に到達したウィンドウと、セクションを持たないウィンドウは通常の再生成に回す
+    FWindowCuboidBuffers InterpolatedCuboid;
+    const TArray<FVector> EmptyNormals;
+    const TArray<FVector2D> EmptyUVs;
+    const TArray<FLinearColor> EmptyColors;
+    const TArray<FProcMeshTangent> EmptyTangents;
+
+    for (FWindowPoints& Points : WindowPointSets)
+    {
+        const FWindowPoints* Target = ExternalWindowTargets.Find(Points.WindowName);
+        if (!Target)
+        {
+            continue;
+        }
+
+        bool bMoved = false;
+        bool bArrived = true;
+        auto InterpPoint = [&](FVector& Current, const FVector& Goal)
+        {
+            if (Current.Equals(Goal, 0.01f))
+            {
+                if (Current != Goal)
+                {
+                    Current = Goal;
+                    bMoved = true;
+                }
+                return;
+            }
+            Current = FMath::VInterpTo(Current, Goal, DeltaTime, ExternalWindowInterpSpeed);
+            bMoved = true;
+            bArrived = false;
+        };
+
+        InterpPoint(Points.Point1_TL, Target->Point1_TL);
+        InterpPoint(Points.Point2_TR, Target->Point2_TR);
+        InterpPoint(Points.Point3_BR, Target->Point3_BR);
+        InterpPoint(Points.Point4_BL, Target->Point4_BL);
+        if (!bMoved)
+        {
+            continue;
+        }
+
+        const int32* SectionIndex = WindowSectionMap.Find(Points.WindowName);
+        if (bArrived || !SectionIndex || !ProceduralMeshComponent)
+        {
+            bRegeneratePending = true;
+            continue;
+        }
+
+        FWindowCuboidGenerator::Build(Points, Thickness, false, InterpolatedCuboid);
+        ProceduralMeshComponent->UpdateMeshSection_LinearColor(*SectionIndex, InterpolatedCuboid.Vertices, EmptyNormals, EmptyUVs, EmptyUVs, EmptyUVs, EmptyUVs, EmptyColors, EmptyTangents);
+    }
+}
+
+void UWindowsRepresentationComponent::ResetSectionCache()
+{
+    WindowSectionMap.Empty();
+    WindowSourceMap.Empty();
+    WindowConvexMap.Empty();
+    AppliedWindowMaterial.Reset();
+    NextAvailableSectionIndex = 0;
+    bCollisionBuilt = false;
+    // 状態が不明なため、次回の適用で一度だけ凸メッシュをクリアする
+    bConvexCollisionApplied = true;
+    // 実行中の非同期生成の結果は破棄する
+    ++MeshBuildGeneration;
+    ReleaseAllWindowBoxes();
+    WindowInstanceMap.Empty();
+    InstanceWindowNames.Empty();
+    if (InstancedMeshComponent && InstancedMeshComponent->GetInstanceCount() > 0)
+    {
+        InstancedMeshComponent->ClearInstances();
+    }
+}
+
+void UWindowsRepresentationComponent::UpdateWindowInstance(FName WindowName, const FTransform& BoxTransform, const FVector& BoxExtent)
+{
+    // 立方体メッシュのバウンズからスケールを求める（BasicShapes/Cube は 100 単位）
+    const FVector MeshSize = InstanceCubeMesh ? InstanceCubeMesh->GetBounds().BoxExtent * 2.0f : FVector(100.0f);
+    const FVector SafeMeshSize(FMath::Max(MeshSize.X, KINDA_SMALL_NUMBER), FMath::Max(MeshSize.Y, KINDA_SMALL_NUMBER), FMath::Max(MeshSize.Z, KINDA_SMALL_NUMBER));
+    const FTransform InstanceTransform(BoxTransform.GetRotation(), BoxTransform.GetLocation(), (BoxExtent * 2.0f) / SafeMeshSize);
+    const float CustomData[3] = { BoxExtent.X * 2.0f, BoxExtent.Y * 2.0f, BoxExtent.Z * 2.0f };
+
+    if (const int32* ExistingIndex = WindowInstanceMap.Find(WindowName))
+    {
+        InstancedMeshComponent->UpdateInstanceTransform(*ExistingIndex, InstanceTransform, false, false, true);
+        InstancedMeshComponent->SetCustomData(*ExistingIndex, MakeArrayView(CustomData, 3), false);
+        return;
+    }
+
+    const int32 NewIndex = InstancedMeshComponent->AddInstance(InstanceTransform, false);
+    InstancedMeshComponent->SetCustomData(NewIndex, MakeArrayView(CustomData, 3), false);
+    WindowInstanceMap.Add(WindowName, NewIndex);
+    if (InstanceWindowNames.Num() <= NewIndex)
+    {
+        InstanceWindowNames.SetNum(NewIndex + 1);
+    }
+    InstanceWindowNames[NewIndex] = WindowName;
+}
+
+void UWindowsRepresentationComponent::ReleaseWindowInstance(FName WindowName)
+{
+    int32 Index = INDEX_NONE;
+    if (!WindowInstanceMap.RemoveAndCopyValue(WindowName, Index))
+    {
+        return;
+    }
+
+    // 末尾のインスタンスを空いた位置へ移動してから末尾を削除する（インデックスの詰め直しを避ける）
+    const int32 LastIndex = InstancedMeshComponent->GetInstanceCount() - 1;
+    if (Index != LastIndex && InstanceWindowNames.IsValidIndex(LastIndex))
+    {
+        FTransform LastTransform;
+        InstancedMeshComponent->GetInstanceTransform(LastIndex, LastTransform, false);
+        InstancedMeshComponent->UpdateInstanceTransform(Index, LastTransform, false, false, true);
+
+        const int32 NumCustomData = InstancedMeshComponent->NumCustomDataFloats;
+        if (NumCustomData > 0 && InstancedMeshComponent->PerInstanceSMCustomData.Num() >= (LastIndex + 1) * NumCustomData)
+        {
+            TArray<float> LastCustomData(&InstancedMeshComponent->PerInstanceSMCustomData[LastIndex * NumCustomData], NumCustomData);
+            InstancedMeshComponent->SetCustomData(Index, LastCustomData, false);
+        }
+
+        const FName MovedWindowName = InstanceWindowNames[LastIndex];
+        InstanceWindowNames[Index] = MovedWindowName;
+        WindowInstanceMap.Add(MovedWindowName, Index);
+    }
+    InstancedMeshComponent->RemoveInstance(LastIndex);
+    InstanceWindowNames.SetNum(LastIndex, EAllowShrinking::No);
+}
+
+void UWindowsRepresentationComponent::UpdateWindowBox(FName WindowName, const FTransform& BoxTransform, const FVector& BoxExtent)
+{
+    TObjectPtr<UBoxComponent>* ExistingBox = WindowBoxMap.Find(WindowName);
+    UBoxComponent* Box = ExistingBox ? ExistingBox->Get() : nullptr;
+    if (!Box)
+    {
+        if (FreeWindowBoxes.Num() > 0)
+        {
+            Box = FreeWindowBoxes.Pop();
+        }
+        else
+        {
+            Box = NewObject<UBoxComponent>(GetOwner(), NAME_None, RF_Transient);
+            Box->SetMobility(EComponentMobility::Movable);
+            Box->SetupAttachment(ProceduralMeshComponent);
+            Box->RegisterComponent();
+        }
+
+        // ProceduralMeshComponent と同じ衝突設定を引き継ぐ
+        Box->SetCollisionObjectType(ProceduralMeshComponent->GetCollisionObjectType());
+        Box->SetCollisionResponseToChannels(ProceduralMeshComponent->GetCollisionResponseToChannels());
+        Box->SetUseCCD(true);
+        Box->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+        WindowBoxMap.Add(WindowName, Box);
+    }
+
+    if (!Box->GetUnscaledBoxExtent().Equals(BoxExtent))
+    {
+        Box->SetBoxExtent(BoxExtent, false);
+    }
+    Box->SetRelativeTransform(BoxTransform, false, nullptr, ETeleportType::TeleportPhysics);
+}
+
+void UWindowsRepresentationComponent::ReleaseWindowBox(FName WindowName)
+{
+    TObjectPtr<UBoxComponent> Box;
+    if (WindowBoxMap.RemoveAndCopyValue(WindowName, Box) && Box)
+    {
+        Box->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+        FreeWindowBoxes.Add(Box);
+    }
+}
+
+void UWindowsRepresentationComponent::ReleaseAllWindowBoxes()
+{
+    TArray<FName> BoxNames;
+    WindowBoxMap.GetKeys(BoxNames);
+    for (const FName& BoxName : BoxNames)
+    {
+        ReleaseWindowBox(BoxName);
+    }
+}
+
+FWindowSectionSource UWindowsRepresentationComponent::MakeSectionSource(const FWindowPoints& Points) const
+{
+    FWindowSectionSource Source;
+    Source.Points[0] = Points.Point1_TL;
+    Source.Points[1] = Points.Point2_TR;
+    Source.Points[2] = Points.Point3_BR;
+    Source.Points[3] = Points.Point4_BL;
+    Source.Thickness = Thickness;
+    Source.bWithVertexColors = bGenerateVertexColors;
+    return Source;
+}
+
 void UWindowsRepresentationComponent::RegenerateMesh()
 {
+    SCOPE_CYCLE_COUNTER(STAT_WindowTransparency_RegenerateMesh);
+    CSV_SCOPED_TIMING_STAT(WindowTransparency, RegenerateMesh);
+
+    bRegeneratePending = false;
+
     if (!ProceduralMeshComponent)
     {
         UE_LOG(LogTemp, Error, TEXT("ProceduralMeshComponent is null in WindowsRepresentationComponent."));
@@ -87,215 +736,364 @@ void UWindowsRepresentationComponent::RegenerateMesh()
         return;
     }
 
-    TSet<FName> ActiveWindowNames;
-    for (const FWindowPoints& Points : WindowPointSets)
+    UWorld* World = GetWorld();
+    if (bAsyncMeshGeneration && World && World->IsGameWorld())
     {
-        if (Points.WindowName != NAME_None)
+        // 実行中の生成があれば要求だけ記録し、完了時にその時点の最新の状態で生成し直す
+        if (bMeshBuildInFlight)
         {
-            ActiveWindowNames.Add(Points.WindowName);
+            bMeshBuildQueued = true;
+            return;
         }
-        else
+
+        if (!bAsyncCookingOverridden)
+        {
+            bSavedUseAsyncCooking = ProceduralMeshComponent->bUseAsyncCooking;
+            bAsyncCookingOverridden = true;
+        }
+        ProceduralMeshComponent->bUseAsyncCooking = true;
+
+        TSharedRef<FWindowMeshBuildRequest> Request = MakeShared<FWindowMeshBuildRequest>();
+        CollectDirtyWindows(*Request);
+
+        // 頂点生成はワーカーで行い、結果はゲームスレッドで一度に適用する
+        bMeshBuildInFlight = true;
+        TWeakObjectPtr<UWindowsRepresentationComponent> WeakThis(this);
+        UE::Tasks::Launch(UE_SOURCE_LOCATION, [WeakThis, Request]()
+        {
+            TSharedRef<FWindowMeshBuildResult> Result = MakeShared<FWindowMeshBuildResult>();
+            BuildWindowMeshes(*Request, *Result);
+
+            AsyncTask(ENamedThreads::GameThread, [WeakThis, Result]()
+            {
+                if (UWindowsRepresentationComponent* This = WeakThis.Get())
+                {
+                    This->OnAsyncMeshBuildCompleted(*Result);
+                }
+            });
+        });
+        return;
+    }
+
+    if (bMeshBuildInFlight)
+    {
+        // 同期生成に切り替えた場合、実行中の結果は同期の結果より古いので破棄させる
+        ++MeshBuildGeneration;
+        bMeshBuildQueued = false;
+    }
+    if (bAsyncCookingOverridden)
+    {
+        ProceduralMeshComponent->bUseAsyncCooking = bSavedUseAsyncCooking;
+        bAsyncCookingOverridden = false;
+    }
+
+    TSharedRef<FWindowMeshBuildRequest> Request = MakeShared<FWindowMeshBuildRequest>();
+    CollectDirtyWindows(*Request);
+
+    if (!SyncBuildResult.IsValid())
+    {
+        SyncBuildResult = MakeShared<FWindowMeshBuildResult>();
+    }
+    BuildWindowMeshes(*Request, *SyncBuildResult);
+    ApplyMeshBuildResult(*SyncBuildResult);
+}
+
+void UWindowsRepresentationComponent::OnAsyncMeshBuildCompleted(const FWindowMeshBuildResult& Result)
+{
+    bMeshBuildInFlight = false;
+
+    // 生成中に ResetSectionCache された場合は差分の基準が変わっているので適用せず、現在の状態から作り直す
+    if (Result.Generation == MeshBuildGeneration)
+    {
+        ApplyMeshBuildResult(Result);
+    }
+    else if (!IsBeingDestroyed())
+    {
+        bMeshBuildQueued = true;
+    }
+
+    if (bMeshBuildQueued)
+    {
+        bMeshBuildQueued = false;
+        RegenerateMesh();
+    }
+}
+
+void UWindowsRepresentationComponent::CollectDirtyWindows(FWindowMeshBuildRequest& OutRequest)
+{
+    OutRequest.Generation = MeshBuildGeneration;
+    OutRequest.Thickness = Thickness;
+    OutRequest.bWithVertexColors = bGenerateVertexColors;
+    OutRequest.bCreateCollision = bCreateCollision;
+    OutRequest.bUseBoxCollision = bCreateCollision && CollisionMode == EWindowCollisionMode::BoxPrimitive;
+
+    OutRequest.bUseInstancing = RenderMode == EWindowRenderMode::InstancedCube && InstancedMeshComponent != nullptr;
+
+    if (RenderMode != AppliedRenderMode)
+    {
+        // 描画方法の切替時は全ウィンドウを作り直す
+        WindowSourceMap.Empty();
+        AppliedRenderMode = RenderMode;
+    }
+
+    if (CollisionMode != AppliedCollisionMode || bCreateCollision != bCollisionBuilt)
+    {
+        // コリジョン設定の切替時は全ウィンドウを作り直す
+        WindowSourceMap.Empty();
+        AppliedCollisionMode = CollisionMode;
+        bCollisionBuilt = bCreateCollision;
+        OutRequest.bForceCollisionRebuild = true;
+        ReleaseAllWindowBoxes();
+    }
+
+    for (const FWindowPoints& Points : WindowPointSets)
+    {
+        if (Points.WindowName == NAME_None)
         {
             UE_LOG(LogTemp, Warning, TEXT("A WindowPointSet has NAME_None for WindowName. It will be ignored. Provide a unique name."));
+            continue;
         }
+        OutRequest.ActiveWindowNames.Add(Points.WindowName);
+
+        FWindowSectionSource Source = MakeSectionSource(Points);
+        const FWindowSectionSource* PreviousSource = WindowSourceMap.Find(Points.WindowName);
+        if (PreviousSource && *PreviousSource == Source)
+        {
+            continue;
+        }
+        OutRequest.DirtyWindows.Add(Points);
+        OutRequest.DirtySources.Add(MoveTemp(Source));
+    }
+}
+
+void UWindowsRepresentationComponent::ApplyMeshBuildResult(const FWindowMeshBuildResult& Result)
+{
+    SCOPE_CYCLE_COUNTER(STAT_WindowTransparency_ApplyMeshes);
+
+    if (!ProceduralMeshComponent)
+    {
+        return;
     }
 
+    LastRebuiltWindowCount = 0;
+    bool bCollisionDirty = Result.bForceCollisionRebuild;
+
+    double InstanceUpdateSeconds = 0.0;
+    bool bInstancesChanged = false;
+
     TArray<FName> NamesToRemoveFromMap;
     for (auto It = WindowSectionMap.CreateConstIterator(); It; ++It)
     {
-        if (!ActiveWindowNames.Contains(It.Key()))
+        if (!Result.ActiveWindowNames.Contains(It.Key()))
         {
             ProceduralMeshComponent->ClearMeshSection(It.Value());
             NamesToRemoveFromMap.Add(It.Key());
             // UE_LOG(LogTemp, Log, TEXT("Cleared mesh section %d for window '%s' (removed)"), It.Value(), *It.Key().ToString());
         }
     }
+    for (auto It = WindowInstanceMap.CreateConstIterator(); It; ++It)
+    {
+        if (!Result.ActiveWindowNames.Contains(It.Key()))
+        {
+            NamesToRemoveFromMap.AddUnique(It.Key());
+        }
+    }
     for (const FName& NameToRemove : NamesToRemoveFromMap)
     {
         WindowSectionMap.Remove(NameToRemove);
+        WindowSourceMap.Remove(NameToRemove);
+        ReleaseWindowBox(NameToRemove);
+        if (WindowInstanceMap.Contains(NameToRemove))
+        {
+            const double InstanceStartTime = FPlatformTime::Seconds();
+            ReleaseWindowInstance(NameToRemove);
+            InstanceUpdateSeconds += FPlatformTime::Seconds() - InstanceStartTime;
+            bInstancesChanged = true;
+        }
+        if (WindowConvexMap.Remove(NameToRemove) > 0)
+        {
+            bCollisionDirty = true;
+        }
     }
 
-    if (bCreateCollision)
+    // マテリアルが変わった場合は全セクションに再設定する
+    const bool bMaterialChanged = AppliedWindowMaterial.Get() != WindowMaterial;
+    if (bMaterialChanged && WindowMaterial)
     {
-        ProceduralMeshComponent->ClearCollisionConvexMeshes();
+        for (auto It = WindowSectionMap.CreateConstIterator(); It; ++It)
+        {
+            ProceduralMeshComponent->SetMaterial(It.Value(), WindowMaterial);
+        }
+        if (InstancedMeshComponent)
+        {
+            InstancedMeshComponent->SetMaterial(0, WindowMaterial);
+        }
     }
-    else
+    AppliedWindowMaterial = WindowMaterial;
+
+    if (Result.bUseInstancing && InstancedMeshComponent->GetStaticMesh() != InstanceCubeMesh)
     {
-        ProceduralMeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+        InstancedMeshComponent->SetStaticMesh(InstanceCubeMesh);
+        if (WindowMaterial)
+        {
+            InstancedMeshComponent->SetMaterial(0, WindowMaterial);
+        }
     }
 
     TArray<FVector2D> EmptyUVs;
 
-    for (const FWindowPoints& Points : WindowPointSets)
+    for (const FWindowMeshBuildEntry& Entry : Result.Entries)
     {
-        if (Points.WindowName == NAME_None) continue;
+        if (Result.bUseInstancing && Entry.bIsRectangle)
+        {
+            // 長方形はインスタンスのトランスフォーム更新のみ（頂点の再構築なし）
+            if (const int32* SectionIndex = WindowSectionMap.Find(Entry.WindowName))
+            {
+                ProceduralMeshComponent->ClearMeshSection(*SectionIndex);
+                WindowSectionMap.Remove(Entry.WindowName);
+            }
 
-        TArray<FVector> SectionVertices;
-        TArray<int32> SectionTriangles;
-        TArray<FVector> SectionNormals;
-        TArray<FVector2D> SectionUVs0;
-        TArray<FLinearColor> SectionVertexColors;
-        TArray<FProcMeshTangent> SectionTangents;
-        TArray<FVector> ConvexVerticesForCollision;
+            const double InstanceStartTime = FPlatformTime::Seconds();
+            UpdateWindowInstance(Entry.WindowName, Entry.BoxTransform, Entry.BoxExtent);
+            InstanceUpdateSeconds += FPlatformTime::Seconds() - InstanceStartTime;
+            bInstancesChanged = true;
 
-        AddCuboidFromPoints(Points, Thickness, SectionVertices, SectionTriangles, SectionNormals, SectionUVs0, SectionVertexColors, SectionTangents, ConvexVerticesForCollision);
+            ReleaseWindowBox(Entry.WindowName);
+            if (WindowConvexMap.Remove(Entry.WindowName) > 0)
+            {
+                bCollisionDirty = true;
+            }
+            WindowSourceMap.Add(Entry.WindowName, Entry.Source);
+            ++LastRebuiltWindowCount;
+            continue;
+        }
 
-        if (SectionVertices.Num() == 0 || SectionTriangles.Num() == 0)
+        if (WindowInstanceMap.Contains(Entry.WindowName))
         {
-            // UE_LOG(LogTemp, Warning, TEXT("Window '%s' resulted in no mesh data."), *Points.WindowName.ToString());
-            continue;
+            ReleaseWindowInstance(Entry.WindowName);
+            bInstancesChanged = true;
         }
 
+        const FWindowCuboidBuffers& Cuboid = Entry.Cuboid;
+
         int32 CurrentSectionIndex;
-        if (WindowSectionMap.Contains(Points.WindowName))
+        if (WindowSectionMap.Contains(Entry.WindowName))
         {
-            CurrentSectionIndex = WindowSectionMap[Points.WindowName];
+            CurrentSectionIndex = WindowSectionMap[Entry.WindowName];
 
             ProceduralMeshComponent->UpdateMeshSection_LinearColor(
                 CurrentSectionIndex,
-                SectionVertices,
-                SectionNormals,
-                SectionUVs0,
+                Cuboid.Vertices,
+                Cuboid.Normals,
+                Cuboid.UVs0,
                 EmptyUVs,
                 EmptyUVs,
                 EmptyUVs,
-                SectionVertexColors,
-                SectionTangents
+                Cuboid.VertexColors,
+                Cuboid.Tangents
             );
-            // UE_LOG(LogTemp, Log, TEXT("Updated mesh section %d for window '%s'"), CurrentSectionIndex, *Points.WindowName.ToString());
+            // UE_LOG(LogTemp, Log, TEXT("Updated mesh section %d for window '%s'"), CurrentSectionIndex, *Entry.WindowName.ToString());
         }
         else
         {
             CurrentSectionIndex = NextAvailableSectionIndex++;
-            WindowSectionMap.Add(Points.WindowName, CurrentSectionIndex);
+            WindowSectionMap.Add(Entry.WindowName, CurrentSectionIndex);
 
             ProceduralMeshComponent->CreateMeshSection_LinearColor(
                 CurrentSectionIndex,
-                SectionVertices,
-                SectionTriangles,
-                SectionNormals,
-                SectionUVs0,
+                Cuboid.Vertices,
+                Cuboid.Triangles,
+                Cuboid.Normals,
+                Cuboid.UVs0,
                 EmptyUVs,           // UV1
                 EmptyUVs,           // UV2
                 EmptyUVs,           // UV3
-                SectionVertexColors,
-                SectionTangents,
+                Cuboid.VertexColors,
+                Cuboid.Tangents,
                 false
             );
-            // UE_LOG(LogTemp, Log, TEXT("Created mesh section %d for window '%s'"), CurrentSectionIndex, *Points.WindowName.ToString());
+            // UE_LOG(LogTemp, Log, TEXT("Created mesh section %d for window '%s'"), CurrentSectionIndex, *Entry.WindowName.ToString());
+
+            if (WindowMaterial)
+            {
+                ProceduralMeshComponent->SetMaterial(CurrentSectionIndex, WindowMaterial);
+            }
         }
 
-        if (WindowMaterial)
+        WindowSourceMap.Add(Entry.WindowName, Entry.Source);
+        ++LastRebuiltWindowCount;
+
+        if (Result.bUseBoxCollision && Entry.bIsRectangle)
         {
-            ProceduralMeshComponent->SetMaterial(CurrentSectionIndex, WindowMaterial);
+            // 長方形はボックスを移動するだけなのでクック不要
+            UpdateWindowBox(Entry.WindowName, Entry.BoxTransform, Entry.BoxExtent);
+            if (WindowConvexMap.Remove(Entry.WindowName) > 0)
+            {
+                bCollisionDirty = true;
+            }
         }
-
-        if (bCreateCollision && ConvexVerticesForCollision.Num() >= 4)
+        else
         {
-            ProceduralMeshComponent->AddCollisionConvexMesh(ConvexVerticesForCollision);
+            ReleaseWindowBox(Entry.WindowName);
+            WindowConvexMap.Add(Entry.WindowName, Cuboid.ConvexVertices);
+            bCollisionDirty = true;
         }
     }
 
-    if (bCreateCollision)
+    if (Result.bCreateCollision)
     {
-        if (ProceduralMeshComponent->GetBodySetup())
+        if (bCollisionDirty)
         {
-            ProceduralMeshComponent->GetBodySetup()->CreatePhysicsMeshes();
-        }
+            // 変更があった場合のみ、全ウィンドウ分の凸メッシュをまとめて一度だけクックする
+            TArray<TArray<FVector>> ConvexMeshes;
+            ConvexMeshes.Reserve(WindowConvexMap.Num());
+            for (auto It = WindowConvexMap.CreateConstIterator(); It; ++It)
+            {
+                ConvexMeshes.Add(It.Value());
+            }
+            ProceduralMeshComponent->SetCollisionConvexMeshes(ConvexMeshes);
+            bConvexCollisionApplied = ConvexMeshes.Num() > 0;
 
-        ProceduralMeshComponent->SetUseCCD(true);
-        ProceduralMeshComponent->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+            ProceduralMeshComponent->SetUseCCD(true);
+            ProceduralMeshComponent->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+        }
     }
     else
     {
+        if (bConvexCollisionApplied)
+        {
+            ProceduralMeshComponent->ClearCollisionConvexMeshes();
+            bConvexCollisionApplied = false;
+        }
         ProceduralMeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
     }
-}
-
-void UWindowsRepresentationComponent::AddCuboidFromPoints(
-    const FWindowPoints& Points,
-    float CuboidThickness,
-    TArray<FVector>& Vertices,
-    TArray<int32>& Triangles,
-    TArray<FVector>& Normals,
-    TArray<FVector2D>& UVs0,
-    TArray<FLinearColor>& VertexColors,
-    TArray<FProcMeshTangent>& Tangents,
-    TArray<FVector>& OutConvexVertices)
-{
-    Vertices.Empty();
-    Triangles.Empty();
-    Normals.Empty();
-    UVs0.Empty();
-    VertexColors.Empty();
-    Tangents.Empty();
-    OutConvexVertices.Empty();
-
-    const FVector& P1_TL = Points.Point1_TL; // Top-Left
-    const FVector& P2_TR = Points.Point2_TR; // Top-Right
-    const FVector& P3_BR = Points.Point3_BR; // Bottom-Right
-    const FVector& P4_BL = Points.Point4_BL; // Bottom-Left
-
-    FVector SurfaceNormal = FVector::CrossProduct(P2_TR - P1_TL, P4_BL - P1_TL).GetSafeNormal();
-    if (SurfaceNormal.IsNearlyZero())
-    {
-        SurfaceNormal = FVector::CrossProduct(P3_BR - P2_TR, P1_TL - P2_TR).GetSafeNormal();
-        if (SurfaceNormal.IsNearlyZero()) {
-            UE_LOG(LogTemp, Warning, TEXT("Window points for '%s' are degenerate, cannot calculate normal reliably. Using UpVector as fallback."), *Points.WindowName.ToString());
-            SurfaceNormal = FVector::UpVector;
-        }
-    }
-
-    FVector P1_TL_Back = P1_TL - SurfaceNormal * CuboidThickness;
-    FVector P2_TR_Back = P2_TR - SurfaceNormal * CuboidThickness;
-    FVector P3_BR_Back = P3_BR - SurfaceNormal * CuboidThickness;
-    FVector P4_BL_Back = P4_BL - SurfaceNormal * CuboidThickness;
-
-    FLinearColor DefaultColor = FLinearColor::White;
-
-    OutConvexVertices.Add(P1_TL);
-    OutConvexVertices.Add(P2_TR);
-    OutConvexVertices.Add(P3_BR);
-    OutConvexVertices.Add(P4_BL);
-    OutConvexVertices.Add(P1_TL_Back);
-    OutConvexVertices.Add(P2_TR_Back);
-    OutConvexVertices.Add(P3_BR_Back);
-    OutConvexVertices.Add(P4_BL_Back);
-
-    int32 V0 = Vertices.Add(P1_TL); UVs0.Add(FVector2D(0, 0)); Normals.Add(SurfaceNormal); VertexColors.Add(DefaultColor);
-    int32 V1 = Vertices.Add(P2_TR); UVs0.Add(FVector2D(1, 0)); Normals.Add(SurfaceNormal); VertexColors.Add(DefaultColor);
-    int32 V2 = Vertices.Add(P3_BR); UVs0.Add(FVector2D(1, 1)); Normals.Add(SurfaceNormal); VertexColors.Add(DefaultColor);
-    int32 V3 = Vertices.Add(P4_BL); UVs0.Add(FVector2D(0, 1)); Normals.Add(SurfaceNormal); VertexColors.Add(DefaultColor);
-    Triangles.Append({ V0, V3, V2, V0, V2, V1 });
-
-    // Surface 1: Back (-SurfaceNormal)
-    FVector BackNormal = -SurfaceNormal;
-    int32 V4 = Vertices.Add(P1_TL_Back); UVs0.Add(FVector2D(0, 0)); Normals.Add(BackNormal); VertexColors.Add(DefaultColor);
-    int32 V5 = Vertices.Add(P4_BL_Back); UVs0.Add(FVector2D(1, 0)); Normals.Add(BackNormal); VertexColors.Add(DefaultColor);
-    int32 V6 = Vertices.Add(P3_BR_Back); UVs0.Add(FVector2D(1, 1)); Normals.Add(BackNormal); VertexColors.Add(DefaultColor);
-    int32 V7 = Vertices.Add(P2_TR_Back); UVs0.Add(FVector2D(0, 1)); Normals.Add(BackNormal); VertexColors.Add(DefaultColor);
-    Triangles.Append({ V4, V7, V6, V4, V6, V5 });
-
-    // Side faces
-    auto AddSideFace = [&](const FVector& A, const FVector& B, const FVector& C, const FVector& D) {
-        FVector SideNormal = FVector::CrossProduct(B - A, D - A).GetSafeNormal();
-        int32 SV0 = Vertices.Add(A); UVs0.Add(FVector2D(0, 0)); Normals.Add(SideNormal); VertexColors.Add(DefaultColor);
-        int32 SV1 = Vertices.Add(B); UVs0.Add(FVector2D(1, 0)); Normals.Add(SideNormal); VertexColors.Add(DefaultColor);
-        int32 SV2 = Vertices.Add(C); UVs0.Add(FVector2D(1, 1)); Normals.Add(SideNormal); VertexColors.Add(DefaultColor);
-        int32 SV3 = Vertices.Add(D); UVs0.Add(FVector2D(0, 1)); Normals.Add(SideNormal); VertexColors.Add(DefaultColor);
-        Triangles.Append({ SV0, SV3, SV2, SV0, SV2, SV1 });
-        };
 
-    AddSideFace(P1_TL, P1_TL_Back, P2_TR_Back, P2_TR); // Top Edge P1-P2 (Front P1,P2 -> Back P1b,P2b)
-    AddSideFace(P2_TR, P2_TR_Back, P3_BR_Back, P3_BR); // Right Edge P2-P3
-    AddSideFace(P3_BR, P3_BR_Back, P4_BL_Back, P4_BL); // Bottom Edge P3-P4
-    AddSideFace(P4_BL, P4_BL_Back, P1_TL_Back, P1_TL); // Left Edge P4-P1
+    if (bInstancesChanged)
+    {
+        // インスタンスの描画状態は最後に一度だけ更新する
+        const double InstanceStartTime = FPlatformTime::Seconds();
+        InstancedMeshComponent->MarkRenderStateDirty();
+        InstanceUpdateSeconds += FPlatformTime::Seconds() - InstanceStartTime;
+        LastInstanceUpdateSeconds = InstanceUpdateSeconds;
+    }
 
-    for (int32 i = 0; i < Vertices.Num(); ++i)
+    if (Result.bUseInstancing && InstancedMeshComponent)
     {
-        const FVector& N = Normals[i];
-        const FVector CrossVec = (FMath::Abs(N.Z) < (1.f - KINDA_SMALL_NUMBER)) ? FVector::UpVector : FVector::RightVector;
-        FVector TangentX = FVector::CrossProduct(N, CrossVec).GetSafeNormal();
-        Tangents.Add(FProcMeshTangent(TangentX, false));
+        if (Result.bCreateCollision)
+        {
+            InstancedMeshComponent->SetCollisionObjectType(ProceduralMeshComponent->GetCollisionObjectType());
+            InstancedMeshComponent->SetCollisionResponseToChannels(ProceduralMeshComponent->GetCollisionResponseToChannels());
+            InstancedMeshComponent->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+        }
+        else
+        {
+            InstancedMeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+        }
     }
-}
\ No newline at end of file
+
+    INC_DWORD_STAT_BY(STAT_WindowTransparency_SectionsRebuilt, LastRebuiltWindowCount);
+    CSV_CUSTOM_STAT(WindowTransparency, SectionsRebuilt, LastRebuiltWindowCount, ECsvCustomStatOp::Accumulate);
+
+    UE_LOG(LogTemp, Verbose, TEXT("WindowsRepresentationComponent: Rebuilt %d of %d windows (collision %s, instance update %.3f ms)."),
+        LastRebuiltWindowCount, Result.ActiveWindowNames.Num(), bCollisionDirty ? TEXT("rebuilt") : TEXT("unchanged"), InstanceUpdateSeconds * 1000.0);
+}
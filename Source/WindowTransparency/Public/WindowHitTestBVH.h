@@ -0,0 +1,99 @@
+﻿// WindowHitTestBVH.h
+#pragma once
+
+#include "CoreMinimal.h"
+
+class USceneComponent;
+
+// BVHに登録できる単純形状
+enum class EWindowHitTestProxyShape : uint8
+{
+    Sphere,
+    Box,
+    Capsule
+};
+
+/**
+ * One shape registered for hit testing.
+ * Sphere: Start is the center. Capsule: the segment Start-End swept by Radius. Box: Transform (scale ignored) and half Extent.
+ */
+struct WINDOWTRANSPARENCY_API FWindowHitTestProxy
+{
+    EWindowHitTestProxyShape Shape = EWindowHitTestProxyShape::Sphere;
+    FVector Start = FVector::ZeroVector;
+    FVector End = FVector::ZeroVector;
+    double Radius = 0.0;
+    FTransform Transform = FTransform::Identity;
+    FVector Extent = FVector::ZeroVector;
+    TWeakObjectPtr<USceneComponent> Owner;
+
+    FBox CalcBounds() const;
+
+    /** Returns true and the distance along Direction (normalized) if the ray hits the shape within MaxDistance. */
+    bool RayCast(const FVector& Origin, const FVector& Direction, double MaxDistance, double& OutDistance) const;
+};
+
+struct FWindowHitTestBVHHit
+{
+    int32 ProxyId = INDEX_NONE;
+    double Distance = 0.0;
+    TWeakObjectPtr<USceneComponent> Owner;
+};
+
+/**
+ * Bounding volume hierarchy over the shapes of UWindowHitTestTargetComponents. Adding or removing shapes rebuilds the tree on the
+ * next Refresh; moving them only refits the node bounds, and the tree is rebuilt once refitting has grown it too much.
+ */
+class WINDOWTRANSPARENCY_API FWindowHitTestBVH
+{
+public:
+    FWindowHitTestBVH();
+
+    int32 AddProxy(const FWindowHitTestProxy& Proxy);
+    void UpdateProxy(int32 ProxyId, const FWindowHitTestProxy& Proxy);
+    void RemoveProxy(int32 ProxyId);
+
+    /** Applies pending changes. Call once before a batch of RayCast calls. */
+    void Refresh();
+
+    /** Finds the closest shape hit by the ray. Direction must be normalized. */
+    bool RayCast(const FVector& Origin, const FVector& Direction, double MaxDistance, FWindowHitTestBVHHit& OutHit) const;
+
+    int32 GetProxyCount() const { return Proxies.Num(); }
+    int32 GetRebuildCount() const { return RebuildCount; }
+    int32 GetRefitCount() const { return RefitCount; }
+
+    /** Calls Visitor with the bounds of every registered shape. */
+    void ForEachProxyBounds(TFunctionRef<void(const FBox&)> Visitor) const;
+
+private:
+    struct FNode
+    {
+        FBox Bounds = FBox(ForceInit);
+        // 内部ノード: 子ノードの番号。葉: LeafProxyIds の範囲
+        int32 Left = INDEX_NONE;
+        int32 Right = INDEX_NONE;
+        int32 FirstLeaf = 0;
+        int32 LeafCount = 0;
+    };
+
+    struct FProxyEntry
+    {
+        FWindowHitTestProxy Proxy;
+        FBox Bounds;
+    };
+
+    int32 BuildNode(int32 FirstLeaf, int32 LeafCount);
+    void Rebuild();
+    void Refit();
+    double CalcTreeSurfaceArea() const;
+
+    TSparseArray<FProxyEntry> Proxies;
+    TArray<int32> LeafProxyIds;
+    TArray<FNode> Nodes;
+    double BuiltSurfaceArea;
+    bool bNeedsRebuild;
+    bool bNeedsRefit;
+    int32 RebuildCount;
+    int32 RefitCount;
+};
@@ -0,0 +1,163 @@
+﻿// WindowHitTestStrategy.h
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "WindowHitTestStrategy.generated.h"
+
+class APlayerController;
+class UWindowTransparencyHelper;
+
+// 1つの戦略の判定結果
+UENUM(BlueprintType)
+enum class EWindowHitTestVerdict : uint8
+{
+    Undecided       UMETA(DisplayName = "Undecided"),
+    Opaque          UMETA(DisplayName = "Opaque"),
+    Transparent     UMETA(DisplayName = "Transparent")
+};
+
+USTRUCT(BlueprintType)
+struct WINDOWTRANSPARENCY_API FWindowHitTestStrategyStats
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|HitTest")
+    FString StrategyName;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|HitTest")
+    int32 Evaluations = 0;
+
+    /** Evaluations that returned Opaque or Transparent. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|HitTest")
+    int32 DecisiveCount = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|HitTest")
+    int32 OpaqueCount = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|HitTest")
+    float TotalMs = 0.0f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|HitTest")
+    float MeanMs = 0.0f;
+};
+
+/**
+ * One stage of the hit-test pipeline. Stages run cheapest-first; the first one that returns Opaque or Transparent with a
+ * Confidence of at least the helper's minimum ends the test. Subclass in C++ (override Evaluate_Implementation) or Blueprint.
+ */
+UCLASS(Abstract, Blueprintable, EditInlineNew)
+class WINDOWTRANSPARENCY_API UWindowHitTestStrategy : public UObject
+{
+    GENERATED_BODY()
+
+public:
+    UWindowHitTestStrategy();
+
+    /** Estimated milliseconds per evaluation. Used for ordering until measured timings are available. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hit Test Strategy", meta = (ClampMin = "0.0"))
+    float Cost;
+
+    /** How far a decisive verdict can be trusted (0-1). Verdicts below the helper's minimum only act as a fallback. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hit Test Strategy", meta = (ClampMin = "0.0", ClampMax = "1.0"))
+    float Confidence;
+
+    UFUNCTION(BlueprintNativeEvent, Category = "Hit Test Strategy")
+    EWindowHitTestVerdict Evaluate(APlayerController* PlayerController, FVector2D MousePosInWindow);
+
+    UFUNCTION(BlueprintPure, Category = "Hit Test Strategy")
+    FWindowHitTestStrategyStats GetStats() const;
+
+    void RecordEvaluation(double Milliseconds, EWindowHitTestVerdict Verdict);
+    void ResetStats();
+
+    /** Expected milliseconds spent per decisive verdict. Falls back to Cost until enough evaluations were measured. */
+    double GetOrderingCost(bool bUseMeasuredCost) const;
+
+protected:
+    /** The helper that owns this strategy, or the module's helper. */
+    UWindowTransparencyHelper* GetHelper() const;
+
+private:
+    FWindowHitTestStrategyStats Stats;
+};
+
+/** Transparent when the cursor is outside the screen-space bounds of every blocking actor and widget. Never reports Opaque. */
+UCLASS(meta = (DisplayName = "Screen-Space Broad Phase"))
+class WINDOWTRANSPARENCY_API UWindowHitTestStrategy_BroadPhase : public UWindowHitTestStrategy
+{
+    GENERATED_BODY()
+
+public:
+    UWindowHitTestStrategy_BroadPhase();
+    virtual EWindowHitTestVerdict Evaluate_Implementation(APlayerController* PlayerController, FVector2D MousePosInWindow) override;
+};
+
+/** Opaque when the cursor is over a blocking widget in the cached widget rects. */
+UCLASS(meta = (DisplayName = "Widget Rects"))
+class WINDOWTRANSPARENCY_API UWindowHitTestStrategy_WidgetRects : public UWindowHitTestStrategy
+{
+    GENERATED_BODY()
+
+public:
+    UWindowHitTestStrategy_WidgetRects();
+    virtual EWindowHitTestVerdict Evaluate_Implementation(APlayerController* PlayerController, FVector2D MousePosInWindow) override;
+};
+
+/** Opaque when a trace (with the helper's kernel) on the hit test channel hits an actor. */
+UCLASS(meta = (DisplayName = "Physics Trace"))
+class WINDOWTRANSPARENCY_API UWindowHitTestStrategy_PhysicsTrace : public UWindowHitTestStrategy
+{
+    GENERATED_BODY()
+
+public:
+    UWindowHitTestStrategy_PhysicsTrace();
+    virtual EWindowHitTestVerdict Evaluate_Implementation(APlayerController* PlayerController, FVector2D MousePosInWindow) override;
+};
+
+/** Opaque when a ray hits a shape registered by UWindowHitTestTargetComponent. */
+UCLASS(meta = (DisplayName = "Registered Targets"))
+class WINDOWTRANSPARENCY_API UWindowHitTestStrategy_RegisteredTargets : public UWindowHitTestStrategy
+{
+    GENERATED_BODY()
+
+public:
+    UWindowHitTestStrategy_RegisteredTargets();
+    virtual EWindowHitTestVerdict Evaluate_Implementation(APlayerController* PlayerController, FVector2D MousePosInWindow) override;
+};
+
+/**
+ * Opaque when the CustomStencil value under the cursor is registered with UWindowTransparencyHelper::RegisterStencilActor
+ * or has a bit in wt.StencilPick.OpaqueMask, transparent otherwise. The value is read back asynchronously, so the verdict
+ * lags the cursor by a few frames; Undecided until a readback taken within 1 px of the cursor completes.
+ * Also records the hovered registered actor (see UWindowTransparencyHelper::RegisterStencilActor).
+ */
+UCLASS(meta = (DisplayName = "Stencil Pick"))
+class WINDOWTRANSPARENCY_API UWindowHitTestStrategy_StencilPick : public UWindowHitTestStrategy
+{
+    GENERATED_BODY()
+
+public:
+    UWindowHitTestStrategy_StencilPick();
+    virtual EWindowHitTestVerdict Evaluate_Implementation(APlayerController* PlayerController, FVector2D MousePosInWindow) override;
+};
+
+/**
+ * Reads the alpha of the rendered pixel under the cursor. Requires the scene to output alpha (r.PostProcessing.PropagateAlpha).
+ * The pixel is read back asynchronously, so the verdict lags the cursor by a few frames; Undecided until a readback
+ * taken at the cursor position completes.
+ */
+UCLASS(meta = (DisplayName = "Pixel Alpha Probe"))
+class WINDOWTRANSPARENCY_API UWindowHitTestStrategy_PixelAlpha : public UWindowHitTestStrategy
+{
+    GENERATED_BODY()
+
+public:
+    UWindowHitTestStrategy_PixelAlpha();
+
+    /** Alpha (0-255) at or above which the pixel is considered opaque. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hit Test Strategy", meta = (ClampMin = "0", ClampMax = "255"))
+    int32 AlphaThreshold;
+
+    virtual EWindowHitTestVerdict Evaluate_Implementation(APlayerController* PlayerController, FVector2D MousePosInWindow) override;
+};
@@ -0,0 +1,86 @@
+﻿// WindowHitTestTargetComponent.h
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "WindowHitTestTargetComponent.generated.h"
+
+class USkinnedMeshComponent;
+class UWindowTransparencyHelper;
+struct FWindowHitTestProxy;
+
+// ヒットテスト対象として登録する形状
+UENUM(BlueprintType)
+enum class EWindowHitTestTargetShape : uint8
+{
+    Sphere          UMETA(DisplayName = "Sphere"),
+    Box             UMETA(DisplayName = "Box"),
+    Capsule         UMETA(DisplayName = "Capsule"),
+    SkeletalBones   UMETA(DisplayName = "Skeletal Mesh Bones")
+};
+
+/**
+ * Registers simple shapes with the WindowTransparency helper's hit-test BVH. With the hit test type set to RegisteredTargets,
+ * the cursor is ray-tested against these shapes instead of the physics scene, so no collision channel setup is needed.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class WINDOWTRANSPARENCY_API UWindowHitTestTargetComponent : public USceneComponent
+{
+    GENERATED_BODY()
+
+public:
+    UWindowHitTestTargetComponent();
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Hit Test Target")
+    EWindowHitTestTargetShape Shape;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Hit Test Target", meta = (ClampMin = "0.0", EditCondition = "Shape == EWindowHitTestTargetShape::Sphere"))
+    float SphereRadius;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Hit Test Target", meta = (EditCondition = "Shape == EWindowHitTestTargetShape::Box"))
+    FVector BoxExtent;
+
+    /** Capsule along the local Z axis. HalfHeight includes the hemispherical caps, as with UCapsuleComponent. */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Hit Test Target", meta = (ClampMin = "0.0", EditCondition = "Shape == EWindowHitTestTargetShape::Capsule"))
+    float CapsuleRadius;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Hit Test Target", meta = (ClampMin = "0.0", EditCondition = "Shape == EWindowHitTestTargetShape::Capsule"))
+    float CapsuleHalfHeight;
+
+    /**
+     * Bones used by SkeletalBones. Each bone becomes a capsule of BoneRadius from the bone to its parent. Empty uses every bone.
+     * The skeletal mesh is the attach parent, or else the first skinned mesh on the owner.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Hit Test Target", meta = (EditCondition = "Shape == EWindowHitTestTargetShape::SkeletalBones"))
+    TArray<FName> BoneNames;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Hit Test Target", meta = (ClampMin = "0.0", EditCondition = "Shape == EWindowHitTestTargetShape::SkeletalBones"))
+    float BoneRadius;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Hit Test Target")
+    bool bHitTestTargetEnabled;
+
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency|HitTest")
+    void SetHitTestTargetEnabled(bool bEnable);
+
+    /** Re-registers the shapes. Call after changing the shape properties at runtime. */
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency|HitTest")
+    void RefreshHitTestShapes();
+
+    virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+    virtual void OnRegister() override;
+    virtual void OnUnregister() override;
+    virtual void OnUpdateTransform(EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport) override;
+
+private:
+    void RegisterProxies();
+    void UnregisterProxies();
+    void UpdateProxies();
+    void BuildProxies(TArray<FWindowHitTestProxy>& OutProxies) const;
+    USkinnedMeshComponent* FindSkinnedMesh() const;
+
+    TArray<int32> ProxyIds;
+    TWeakObjectPtr<UWindowTransparencyHelper> RegisteredHelper;
+};
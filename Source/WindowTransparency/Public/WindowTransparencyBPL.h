@@ -7,6 +7,7 @@
 #include "Math/Vector2D.h"
 #include "Engine/EngineTypes.h" // For ECollisionChannel
 #include "WindowTransparencyHelper.h" // For EWindowHitTestType
+#include "WindowHitTestStrategy.h"
 #include "WindowTransparencyBPL.generated.h"
 
 UCLASS()
@@ -62,6 +63,90 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Window Transparency|HitTest", meta = (DisplayName = "Set Game Raycast Trace Channel"))
     static void SetGameRaycastTraceChannel(ECollisionChannel TraceChannel);
 
+    /**
+     * Sets the kernel of points traced around the cursor by GameRaycast hit-testing. Multiple samples catch thin geometry and
+     * keep anti-aliased edges from flickering. RadiusPixels is the distance of the outermost samples from the cursor.
+     * Samples outside the projected bounds of blocking geometry are not traced; the rest cost one line trace each until the
+     * combine rule is decided.
+     */
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency|HitTest", meta = (DisplayName = "Set Hit-Test Kernel"))
+    static void SetHitTestKernel(EWindowHitTestKernel Kernel, float RadiusPixels = 2.0f);
+
+    /** Sets how kernel samples are combined. WeightedThreshold (0-1) is only used by the Weighted rule. */
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency|HitTest", meta = (DisplayName = "Set Hit-Test Combine Rule"))
+    static void SetHitTestCombineRule(EWindowHitTestCombineRule Rule, float WeightedThreshold = 0.5f);
+
+    /**
+     * Gets the fraction (0-1) of GameRaycast hit tests answered by the screen-space broad phase without a trace,
+     * and the number of candidate rects it gathered last frame. Cleared by Reset Click-Through Stats.
+     */
+    UFUNCTION(BlueprintPure, Category = "Window Transparency|HitTest", meta = (DisplayName = "Get Hit-Test Broad Phase Reject Rate"))
+    static float GetHitTestBroadPhaseRejectRate(int32& CandidateCount);
+
+    /**
+     * Makes UI hit-testing pick up widget changes. The widget rects are cached and only rebuilt on a Slate invalidate-all or
+     * a viewport move/resize, so call this after adding, removing or moving widgets that should block click-through.
+     */
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency|HitTest", meta = (DisplayName = "Invalidate Widget Hit Cache"))
+    static void InvalidateWidgetHitCache();
+
+    /**
+     * Adds a strategy to the hit-test pipeline and switches the hit test type to Custom Pipeline. If GameRaycast or
+     * Registered Targets was active, its built-in strategies are kept. Returns the new strategy so it can be configured.
+     */
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency|HitTest", meta = (DisplayName = "Add Hit-Test Strategy", DeterminesOutputType = "StrategyClass"))
+    static UWindowHitTestStrategy* AddHitTestStrategy(TSubclassOf<UWindowHitTestStrategy> StrategyClass);
+
+    /** Removes every strategy from the hit-test pipeline. With no strategies every point is treated as transparent. */
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency|HitTest", meta = (DisplayName = "Clear Hit-Test Strategies"))
+    static void ClearHitTestStrategies();
+
+    /**
+     * Sets how pipeline strategies are ordered. If bAutoOrder is true they are re-sorted by measured cost per decisive
+     * verdict; otherwise by their Cost. A verdict below MinConfidence only counts if no later strategy is confident.
+     */
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency|HitTest", meta = (DisplayName = "Set Hit-Test Strategy Ordering"))
+    static void SetHitTestStrategyOrdering(bool bAutoOrder, float MinConfidence = 0.5f);
+
+    /** Gets per-strategy evaluation counts and timings in evaluation order. Cleared by Reset Click-Through Stats. */
+    UFUNCTION(BlueprintPure, Category = "Window Transparency|HitTest", meta = (DisplayName = "Get Hit-Test Strategy Stats"))
+    static TArray<FWindowHitTestStrategyStats> GetHitTestStrategyStats();
+
+    /**
+     * Moves click-through switching to a dedicated input thread that re-tests the cursor RateHz times per second
+     * against the hit-test coverage published by the game thread and applies a change itself, without waiting for the
+     * next hit test or message pump.
+     */
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency|HitTest", meta = (DisplayName = "Set Input Thread Enabled"))
+    static void SetInputThreadEnabled(bool bEnable, float RateHz = 240.0f);
+
+    /**
+     * Enables cursor prediction: the cursor is extrapolated up to MaxHorizonMs ahead from its recent velocity and
+     * acceleration, and the window turns opaque as soon as the predicted path enters content.
+     */
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency|HitTest", meta = (DisplayName = "Set Cursor Prediction"))
+    static void SetCursorPrediction(bool bEnable, float MaxHorizonMs = 50.0f);
+
+    /** Gets the prediction error and the early / false switch counts of cursor prediction. Cleared by Reset Click-Through Stats. */
+    UFUNCTION(BlueprintPure, Category = "Window Transparency|HitTest", meta = (DisplayName = "Get Cursor Prediction Stats"))
+    static FWindowCursorPredictionStats GetCursorPredictionStats();
+
+    /**
+     * Renders the actor's primitives into CustomDepth with StencilValue (1-255) so Stencil Pick hit testing treats them as
+     * content and reports the hovered actor. Actors sharing a value form a stencil group. Unregistered values are transparent
+     * unless they match wt.StencilPick.OpaqueMask. Requires Custom Depth-Stencil Pass = Enabled with Stencil.
+     */
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency|HitTest", meta = (DisplayName = "Register Stencil Actor"))
+    static void RegisterStencilActor(AActor* Actor, int32 StencilValue = 1);
+
+    /** Removes the actor from the stencil registry and, if bClearCustomDepth is true, stops rendering it into CustomDepth. */
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency|HitTest", meta = (DisplayName = "Unregister Stencil Actor"))
+    static void UnregisterStencilActor(AActor* Actor, bool bClearCustomDepth = true);
+
+    /** Gets the last Stencil Pick result: opacity, stencil value and hovered registered actor under the cursor. */
+    UFUNCTION(BlueprintPure, Category = "Window Transparency|HitTest", meta = (DisplayName = "Get Stencil Pick Result"))
+    static FWindowStencilPickResult GetStencilPickResult();
+
     /** Gets the last determined state of whether the mouse is over an 'opaque' area based on hit testing. */
     UFUNCTION(BlueprintPure, Category = "Window Transparency|HitTest", meta = (DisplayName = "Is Mouse Over Opaque Area (HitTest)"))
     static bool GetIsMouseOverOpaqueArea(bool& bIsOverOpaqueArea);
@@ -86,8 +171,87 @@ public:
     /**
      * Sets or unsets the game window as a desktop background.
      * When set, the window will be parented to the desktop's WorkerW, made borderless and click-through.
+     * The WorkerW is found on a worker thread, so enabling may return before the mode is active; use
+     * Set Window As Desktop Background (Wait) to continue once it is.
      * @param bEnable True to set as desktop background, false to restore.
      */
     UFUNCTION(BlueprintCallable, Category = "Window Transparency", meta = (DisplayName = "Set Window As Desktop Background"))
     static void SetWindowAsDesktopBackground(bool bEnable);
+
+    /**
+     * Latent version of Set Window As Desktop Background. Completes when the request has been applied, has failed or was
+     * superseded by another call.
+     * @param bIsActive Whether desktop background mode is active when the node completes.
+     */
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency", meta = (DisplayName = "Set Window As Desktop Background (Wait)", Latent, LatentInfo = "LatentInfo", WorldContext = "WorldContextObject"))
+    static void SetWindowAsDesktopBackgroundAndWait(UObject* WorldContextObject, bool bEnable, bool& bIsActive, FLatentActionInfo LatentInfo);
+
+    /**
+     * Fits the game window to the screen bounds of the 3D content and blocking UI plus MarginPixels while DWM transparency is active, so
+     * composition and fill cost follow the size of the content. The view is offset so the content does not move on screen.
+     * The window grows immediately when content nears its edge and shrinks after ShrinkDelaySeconds.
+     */
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency", meta = (DisplayName = "Set Auto Fit Window To Content"))
+    static void SetAutoFitToContent(bool bEnable, float MarginPixels = 32.0f, float ShrinkDelaySeconds = 0.5f);
+
+    /** Gets the area of the fitted window relative to its area before fitting (1 while not fitted). */
+    UFUNCTION(BlueprintPure, Category = "Window Transparency|Stats", meta = (DisplayName = "Get Auto Fit Area Ratio"))
+    static float GetAutoFitAreaRatio();
+
+    /**
+     * While no opaque content (registered hit-test targets, stencil actors or blocking UI) is on screen for IdleDelaySeconds,
+     * caps the frame rate at IdleFPS and optionally stops drawing the game viewport. Normal rendering resumes as soon as content comes on screen or the user interacts with the game.
+     */
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency", meta = (DisplayName = "Set Idle Throttle"))
+    static void SetIdleThrottle(bool bEnable, float IdleFPS = 5.0f, bool bSuspendRendering = false, float IdleDelaySeconds = 0.5f);
+
+    /** Gets whether the game is idle and how long it has been idle versus rendering normally. Cleared by Reset Click-Through Stats. */
+    UFUNCTION(BlueprintPure, Category = "Window Transparency|Stats", meta = (DisplayName = "Get Idle Stats"))
+    static FWindowIdleStats GetIdleStats();
+
+    /**
+     * Caps the frame rate at WallpaperFPS while the window is the desktop background, and lowers it to OccludedFPS (or pauses
+     * viewport rendering) while other windows cover the whole desktop. 0 FPS leaves the engine cap unchanged.
+     */
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency", meta = (DisplayName = "Set Wallpaper Governor"))
+    static void SetWallpaperGovernor(bool bEnable, float WallpaperFPS = 30.0f, float OccludedFPS = 2.0f, bool bPauseWhenOccluded = false);
+
+    /** Gets the wallpaper governor state and the time spent with the desktop visible versus covered. Cleared by Reset Click-Through Stats. */
+    UFUNCTION(BlueprintPure, Category = "Window Transparency|Stats", meta = (DisplayName = "Get Wallpaper Governor Stats"))
+    static FWindowWallpaperGovernorStats GetWallpaperGovernorStats();
+
+    /**
+     * Allows mouse input over the desktop to reach the wallpaper while it is the desktop background (default on). The input
+     * is delivered to Window Wallpaper Input components; it is only received while one is active.
+     */
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency", meta = (DisplayName = "Set Wallpaper Mouse Input Enabled"))
+    static void SetWallpaperMouseInputEnabled(bool bEnable);
+
+    /** True while wallpaper mouse input is being received. */
+    UFUNCTION(BlueprintPure, Category = "Window Transparency", meta = (DisplayName = "Is Wallpaper Mouse Input Active"))
+    static bool IsWallpaperMouseInputActive();
+
+    /**
+     * Gets the rolling histogram of click-through latency: the time from the last cursor sample taken before the cursor
+     * moved onto or off opaque content until the OS click-through state matched it. This is an upper bound that includes
+     * the sampling interval.
+     */
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency|Stats", meta = (DisplayName = "Get Click-Through Latency Stats"))
+    static FWindowTransparencyHistogramSummary GetClickThroughLatencyStats();
+
+    /**
+     * Gets the rolling histogram of intervals between OS click-through flips.
+     * @param RapidFlipCount Outputs how many flips happened within FlickerWindowMs of the previous flip.
+     * @param TotalFlipCount Outputs the total number of flips since the last reset.
+     */
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency|Stats", meta = (DisplayName = "Get Click-Through Flicker Stats"))
+    static FWindowTransparencyHistogramSummary GetClickThroughFlickerStats(int32& RapidFlipCount, int32& TotalFlipCount);
+
+    /** Sets the interval below which a click-through flip counts as flicker. Default is 100 ms. */
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency|Stats", meta = (DisplayName = "Set Click-Through Flicker Window"))
+    static void SetClickThroughFlickerWindow(float FlickerWindowMs);
+
+    /** Clears the click-through latency and flicker histograms. */
+    UFUNCTION(BlueprintCallable, Category = "Window Transparency|Stats", meta = (DisplayName = "Reset Click-Through Stats"))
+    static void ResetClickThroughStats();
 };
\ No newline at end of file
@@ -8,22 +8,186 @@
 #include "Tickable.h"
 #include "Engine/EngineTypes.h"
 #include "Widgets/SWindow.h" 
+#include "WindowTransparencyHistogram.h"
+#include "WindowHitTestBVH.h"
+#include "InputCoreTypes.h"
+#include "UObject/ObjectKey.h"
 
+#include "WindowTransparencyOSBackend.h"
+
+#include "WindowTransparencyHelper.generated.h"
+
+class FWindowClickThroughThread;
 #if PLATFORM_WINDOWS
-#include "Windows/AllowWindowsPlatformTypes.h"
-#include <dwmapi.h>
-#include <WinUser.h>
-#include "Windows/HideWindowsPlatformTypes.h"
+class FWindowTaskbarCreatedHandler;
+class FWindowRawInputThread;
 #endif
 
-#include "WindowTransparencyHelper.generated.h"
+class AActor;
+class APlayerController;
+class UActorComponent;
+class UPrimitiveComponent;
+class UWindowHitTestStrategy;
+class FWindowStencilPickExtension;
+class FWindowPixelAlphaProbeExtension;
+class FWindowAutoFitExtension;
+struct FCollisionQueryParams;
+struct FSceneViewProjectionData;
+struct FWindowHitTestStrategyStats;
 
 // 当たり判定の種類
 UENUM(BlueprintType)
 enum class EWindowHitTestType : uint8
 {
     None            UMETA(DisplayName = "None"),
-    GameRaycast     UMETA(DisplayName = "Game Raycast")
+    GameRaycast     UMETA(DisplayName = "Game Raycast"),
+    RegisteredTargets UMETA(DisplayName = "Registered Targets"),
+    CustomPipeline  UMETA(DisplayName = "Custom Pipeline"),
+    StencilPick     UMETA(DisplayName = "Stencil Pick")
+};
+
+// GameRaycast でカーソル周辺のどの点をトレースするか
+UENUM(BlueprintType)
+enum class EWindowHitTestKernel : uint8
+{
+    SinglePoint     UMETA(DisplayName = "Single Point"),
+    Cross           UMETA(DisplayName = "Cross (5 samples)"),
+    Grid3x3         UMETA(DisplayName = "3x3 Grid (9 samples)"),
+    Disc            UMETA(DisplayName = "Disc (19 samples)")
+};
+
+// カーネルの各サンプル結果をどうまとめるか
+UENUM(BlueprintType)
+enum class EWindowHitTestCombineRule : uint8
+{
+    Any             UMETA(DisplayName = "Any Sample"),
+    Majority        UMETA(DisplayName = "Majority of Samples"),
+    Weighted        UMETA(DisplayName = "Weighted (center-biased)")
+};
+
+// カーソル予測の精度と、予測による先行切替の当たり外れ
+USTRUCT(BlueprintType)
+struct WINDOWTRANSPARENCY_API FWindowCursorPredictionStats
+{
+    GENERATED_BODY()
+
+    /** Predictions whose target time has passed and were compared with the actual cursor. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    int32 Predictions = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    float MeanErrorPixels = 0.0f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    float MaxErrorPixels = 0.0f;
+
+    /** Fraction (0-1) of predictions within AccuratePixels of the actual cursor. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    float Accuracy = 0.0f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    float AccuratePixels = 0.0f;
+
+    /** Times the window was made opaque ahead of the cursor. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    int32 PredictedSwitches = 0;
+
+    /** Predicted switches followed by the cursor actually reaching content. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    int32 CorrectSwitches = 0;
+
+    /** Predicted switches where the cursor never reached content before the prediction expired. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    int32 FalseSwitches = 0;
+
+    /** FalseSwitches / (CorrectSwitches + FalseSwitches). */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    float FalseSwitchRate = 0.0f;
+};
+
+// ステンシルピックの結果。不透明判定とホバー中のアクターを1回の読み出しで得る
+USTRUCT(BlueprintType)
+struct WINDOWTRANSPARENCY_API FWindowStencilPickResult
+{
+    GENERATED_BODY()
+
+    /** False until the first readback has completed, or if the last one is too old to use. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|HitTest")
+    bool bValid = false;
+
+    /** True if the pixel's CustomStencil value is registered (Register Stencil Actor) or has a bit in wt.StencilPick.OpaqueMask. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|HitTest")
+    bool bOpaque = false;
+
+    /** CustomStencil value (stencil group) of the pixel. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|HitTest")
+    int32 StencilValue = 0;
+
+    /** Registered actor the pixel belongs to, or null if the value is not registered. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|HitTest")
+    TObjectPtr<AActor> Actor = nullptr;
+
+    /** Window position the value was read at. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|HitTest")
+    FVector2D Position = FVector2D::ZeroVector;
+
+    /** Milliseconds since the readback completed. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|HitTest")
+    float AgeMs = 0.0f;
+};
+
+// 内容がないときの待機（低FPS・描画停止）の状態と、待機していた時間
+USTRUCT(BlueprintType)
+struct WINDOWTRANSPARENCY_API FWindowIdleStats
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    bool bIdle = false;
+
+    /** Seconds spent idle (throttled or suspended) since the idle throttle was enabled or the stats were reset. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    float IdleSeconds = 0.0f;
+
+    /** Seconds spent rendering normally over the same period. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    float ActiveSeconds = 0.0f;
+
+    /** IdleSeconds / (IdleSeconds + ActiveSeconds). */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    float IdleFraction = 0.0f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    int32 IdleEntries = 0;
+};
+
+// 壁紙モードのFPS制御の状態と、状態ごとの時間
+USTRUCT(BlueprintType)
+struct WINDOWTRANSPARENCY_API FWindowWallpaperGovernorStats
+{
+    GENERATED_BODY()
+
+    /** True while the governor is enabled and the window is the desktop background. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    bool bActive = false;
+
+    /** True while other windows cover the whole desktop. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    bool bOccluded = false;
+
+    /** Fraction (0-1) of the desktop work area not covered by other windows in the last snapshot. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    float VisibleDesktopFraction = 1.0f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    float VisibleSeconds = 0.0f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    float OccludedSeconds = 0.0f;
+
+    /** Times the desktop went from visible to fully covered. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    int32 Occlusions = 0;
 };
 
 USTRUCT(BlueprintType)
@@ -49,9 +213,67 @@ struct WINDOWTRANSPARENCY_API FOtherWindowInfo
     UPROPERTY(BlueprintReadOnly, Category = "Window Info")
     FString WindowHandleStr;
 
-    FOtherWindowInfo() : PosX(0), PosY(0), Width(0), Height(0) {}
+    /** Visible frame in screen pixels (DWMWA_EXTENDED_FRAME_BOUNDS): the window rect without the invisible resize borders. */
+    FIntRect FrameBounds;
+
+    /** True for click-through (WS_EX_TRANSPARENT) and fully transparent layered windows, which do not hide what is behind them. */
+    bool bSeeThrough;
+
+    FOtherWindowInfo() : PosX(0), PosY(0), Width(0), Height(0), bSeeThrough(false) {}
 };
 
+// 外部ウィンドウのスナップショットが更新されたときに通知される
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnExternalWindowsSnapshotUpdated, const TArray<FOtherWindowInfo>& /*Snapshot*/);
+
+UENUM(BlueprintType)
+enum class EWindowWallpaperMouseEventType : uint8
+{
+    Move        UMETA(DisplayName = "Move"),
+    ButtonDown  UMETA(DisplayName = "Button Down"),
+    ButtonUp    UMETA(DisplayName = "Button Up"),
+    Wheel       UMETA(DisplayName = "Wheel")
+};
+
+// 壁紙モードでのマウス入力。位置は壁紙（ゲームウィンドウ）の座標
+USTRUCT(BlueprintType)
+struct WINDOWTRANSPARENCY_API FWindowWallpaperMouseEvent
+{
+    GENERATED_BODY()
+
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Wallpaper")
+    EWindowWallpaperMouseEventType Type = EWindowWallpaperMouseEventType::Move;
+
+    /** Mouse button for ButtonDown and ButtonUp. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Wallpaper")
+    FKey Button;
+
+    /** Cursor position in the wallpaper window, the same space as GetMousePositionInWindow. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Wallpaper")
+    FVector2D Position = FVector2D::ZeroVector;
+
+    /** Wheel notches for Wheel, positive away from the user. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Wallpaper")
+    float WheelDelta = 0.0f;
+
+    /**
+     * True if the hit test found opaque content (3D or UI) under the cursor. Buttons and the wheel are tested at their
+     * own position; moves in one batch share the result at the batch's last move position.
+     */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Wallpaper")
+    bool bOverContent = false;
+
+    /** Actor under the cursor, if the hit was on a 3D actor. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Wallpaper")
+    TObjectPtr<AActor> HitActor = nullptr;
+
+    /** FPlatformTime::Seconds() when the input was received. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Wallpaper")
+    double Timestamp = 0.0;
+};
+
+// 壁紙モードのマウス入力がまとめて届いたときに通知される
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnWallpaperMouseEvents, const TArray<FWindowWallpaperMouseEvent>& /*Events*/);
+
 
 UCLASS()
 class WINDOWTRANSPARENCY_API UWindowTransparencyHelper : public UObject, public FTickableGameObject
@@ -62,6 +284,8 @@ public:
     UWindowTransparencyHelper();
     ~UWindowTransparencyHelper();
 
+    virtual void BeginDestroy() override;
+
     bool Initialize();
     void SetDWMTransparency(bool bEnable);
     void EnableBorderless(bool bEnable);
@@ -70,22 +294,229 @@ public:
     FVector2D GetMousePositionInWindow(bool& bSuccess);
     void RestoreDefaultWindowSettings();
     bool IsInitialized() const { return bIsInitialized; }
-    void SetAsDesktopBackground(bool bEnable);
+    /**
+     * Enables or disables desktop background mode. Enabling may wait for the WorkerW discovery on a worker thread, so the
+     * mode can become active after this returns. OnComplete is called on the game thread once the request has finished
+     * (applied, failed or superseded by another call) with whether the mode is active.
+     */
+    void SetAsDesktopBackground(bool bEnable, TFunction<void(bool)> OnComplete = nullptr);
+    bool IsDesktopBackgroundActive() const { return bIsDesktopBackgroundActive; }
+
+    WindowTransparencyOS::HWND GetGameHWnd() const;
+
+    /**
+     * Replaces the backend every OS window call goes through. Handles and stored styles from the previous backend are
+     * discarded, so the helper re-initializes against the new one. Passing nullptr restores the Win32 backend (no backend
+     * on other platforms, where the window-state logic only runs against a backend set here).
+     */
+    void SetOSBackend(TSharedPtr<IWindowTransparencyOSBackend> InBackend);
+    TSharedPtr<IWindowTransparencyOSBackend> GetOSBackend() const { return OSBackend; }
+
+    /**
+     * Finds the desktop WorkerW on a worker thread, since the messages sent to Progman can block for seconds, and calls
+     * OnComplete on the game thread with the handle (null if none was found). A cached handle that is still a valid window
+     * is passed to OnComplete immediately without searching again.
+     */
+    void DiscoverWorkerWAsync(TFunction<void(WindowTransparencyOS::HWND)> OnComplete);
+    WindowTransparencyOS::HWND GetCachedWorkerW() const { return CachedWorkerW; }
+    bool IsWorkerWDiscoveryPending() const { return bWorkerWDiscoveryInFlight; }
+
+    /** Called when Explorer restarts (TaskbarCreated). Drops the cached WorkerW and discovers the new one. */
+    void HandleTaskbarCreated();
 
 #if PLATFORM_WINDOWS
-    HWND GetGameHWnd() const;
     TArray<FOtherWindowInfo> GetOtherWindowsInformation(bool& bSuccess);
-    FOtherWindowInfo GetCurrentWindowInfo(bool& bSuccess);
 #endif
+    FOtherWindowInfo GetCurrentWindowInfo(bool& bSuccess);
+    /** Screen rectangle of the game window's client area, which is what the viewport covers (GetCurrentWindowInfo includes the frame). */
+    bool GetClientScreenRect(FIntRect& OutRect);
+
+    // --- 外部ウィンドウのスナップショット ---
+    // 購読者がいる間だけ、指定間隔で EnumWindows を行い通知する
+    FOnExternalWindowsSnapshotUpdated& OnExternalWindowsSnapshotUpdated() { return ExternalWindowsSnapshotUpdated; }
+    /**
+     * Records the interval the subscriber bound with Subscriber needs. Snapshots are taken at the shortest interval any
+     * current subscriber requested (0.1 s when none did); call ClearExternalWindowsSnapshotInterval when unbinding.
+     */
+    void SetExternalWindowsSnapshotInterval(FDelegateHandle Subscriber, float IntervalSeconds);
+    void ClearExternalWindowsSnapshotInterval(FDelegateHandle Subscriber);
+    /** Forces one interval for every subscriber (wt.ExternalWindows.SnapshotInterval). Negative goes back to the requested intervals. */
+    void SetExternalWindowsSnapshotIntervalOverride(float IntervalSeconds);
+    float GetExternalWindowsSnapshotInterval() const { return ExternalWindowsSnapshotInterval; }
+    const TArray<FOtherWindowInfo>& GetExternalWindowsSnapshot() const { return ExternalWindowsSnapshot; }
+
+    // --- 壁紙モードのマウス入力 ---
+    /**
+     * While the window is the desktop background and this has subscribers, mouse input over the desktop is received as
+     * background raw input on a dedicated thread and delivered here in batches, with positions mapped to the wallpaper and
+     * hit tested. Clicks on other applications' windows are not reported. Nothing is registered while unsubscribed.
+     */
+    FOnWallpaperMouseEvents& OnWallpaperMouseEvents() { return WallpaperMouseEvents; }
+    /** Allows the raw input stream (default on). Disable it if something else in the process needs raw mouse input. */
+    void SetWallpaperMouseInputEnabled(bool bEnable);
+    bool IsWallpaperMouseInputEnabled() const { return bWallpaperMouseInputEnabled; }
+    bool IsWallpaperMouseInputActive() const;
 
     // --- Hit Test関連の公開メソッド ---
     void SetHitTestEnabled(bool bEnable);
     void SetHitTestType(EWindowHitTestType NewType);
     void SetGameRaycastTraceChannel(ECollisionChannel NewChannel);
 
+    /**
+     * Sets the points traced around the cursor by GameRaycast. RadiusPixels is the distance of the outermost samples from the
+     * cursor. All samples share one deprojection of the view and stop as soon as the combine rule is decided.
+     * Against the world, samples outside the screen-space broad phase rects count as misses without a query; each other
+     * sample is one line trace (up to 19 for Disc).
+     */
+    void SetHitTestKernel(EWindowHitTestKernel NewKernel, float RadiusPixels);
+    /** WeightedThreshold is the fraction (0-1) of the total sample weight that must hit for Weighted to report opaque. */
+    void SetHitTestCombineRule(EWindowHitTestCombineRule NewRule, float WeightedThreshold);
+    EWindowHitTestKernel GetHitTestKernel() const { return HitTestKernel; }
+    EWindowHitTestCombineRule GetHitTestCombineRule() const { return HitTestCombineRule; }
+    /** Number of scene queries issued by the last kernel hit test: line traces of samples inside the broad phase, up to the early-out. */
+    int32 GetLastHitTestKernelSampleCount() const { return LastHitTestKernelSamplesTraced; }
+
+    /**
+     * Fraction (0-1) of GameRaycast hit tests that the screen-space broad phase answered as transparent without a trace,
+     * because the cursor was outside the projected bounds of every blocking actor and hit-testable widget.
+     */
+    float GetHitTestBroadPhaseRejectRate() const { return HitTestBroadPhaseTests > 0 ? static_cast<float>(HitTestBroadPhaseRejects) / HitTestBroadPhaseTests : 0.0f; }
+    /** Number of screen-space rects gathered by the last broad phase update. */
+    int32 GetHitTestBroadPhaseCandidateCount() const { return HitTestBroadPhaseRects.Num(); }
+    /** Times the broad phase rebuilt its primitive set by walking every actor (world change or off-thread physics state change). */
+    int32 GetBroadPhasePrimitiveRebuildCount() const { return BroadPhasePrimitiveRebuildCount; }
+
+    /** Shapes registered by UWindowHitTestTargetComponent. Ray-tested instead of the physics scene when the type is RegisteredTargets. */
+    FWindowHitTestBVH& GetHitTestTargets() { return HitTestTargets; }
+
+    // --- ステンシルピック ---
+    // CustomStencil をカーソル位置で非同期に読み出し、不透明判定とホバー中のアクターを得る。r.CustomDepth=3 が必要
+
+    /**
+     * Renders Actor's primitives into CustomDepth with StencilValue (1-255) and maps the value back to Actor.
+     * Several actors may share a value (a stencil group); the pick then returns the nearest one under the cursor.
+     */
+    void RegisterStencilActor(AActor* Actor, int32 StencilValue);
+    void UnregisterStencilActor(AActor* Actor, bool bClearCustomDepth = true);
+
+    /**
+     * Requests a stencil pick at MousePosInWindow and returns the latest completed one. After the cursor moves, the last
+     * pick is kept for up to 0.25 s until one at the new position completes. Used by the StencilPick strategy.
+     */
+    bool PickStencilUnderCursor(APlayerController* PC, const FVector2D& MousePosInWindow, FWindowStencilPickResult& OutResult);
+
+    /** Result of the last stencil pick made by hit testing. */
+    FWindowStencilPickResult GetLastStencilPickResult() const;
+
+    /**
+     * Requests a readback of the rendered alpha at MousePosInWindow and returns the latest completed one in OutAlpha.
+     * False until a readback taken at the cursor position (within 1 px) has completed; after the cursor moves, the last alpha
+     * is kept for up to 0.25 s until one at the new position completes. Used by the PixelAlpha strategy.
+     */
+    bool ProbePixelAlphaUnderCursor(APlayerController* PC, const FVector2D& MousePosInWindow, uint8& OutAlpha);
+
+    /** Number of times the cached widget hit rects have been rebuilt. */
+    int32 GetWidgetHitCacheRebuildCount() const { return WidgetHitCacheRebuildCount; }
+    /**
+     * Rebuilds the cached widget hit rects on the next hit test. The cache already rebuilds on its own when a widget it
+     * walked is added, removed, shown, hidden, enabled, moved or resized, and on Slate invalidate-all and viewport changes,
+     * so this is only needed for changes outside that (a widget's clipping, for example).
+     */
+    void InvalidateWidgetHitCache();
+
+    /**
+     * If enabled, the cursor is extrapolated from its recent samples (velocity and acceleration) up to MaxHorizonMs
+     * ahead, and the window is made opaque as soon as the predicted path enters content instead of after the cursor has.
+     */
+    void SetCursorPrediction(bool bEnable, float MaxHorizonMs = 50.0f);
+    bool IsCursorPredictionEnabled() const { return bCursorPredictionEnabled; }
+    FWindowCursorPredictionStats GetCursorPredictionStats() const;
+
+    // --- ヒットテストのパイプライン ---
+    // GameRaycast / RegisteredTargets は組み込みの戦略で構成されたプリセット。戦略を追加・設定すると CustomPipeline になる
+
+    /** Replaces the strategies and switches the hit test type to CustomPipeline. */
+    void SetHitTestStrategies(const TArray<UWindowHitTestStrategy*>& Strategies);
+    /** Appends a strategy of the given class (to the current preset if one is active) and switches to CustomPipeline. */
+    UWindowHitTestStrategy* AddHitTestStrategy(TSubclassOf<UWindowHitTestStrategy> StrategyClass);
+    void ClearHitTestStrategies();
+    /** Strategies in their current evaluation order. */
+    const TArray<TObjectPtr<UWindowHitTestStrategy>>& GetHitTestStrategies() const { return HitTestStrategies; }
+    TArray<FWindowHitTestStrategyStats> GetHitTestStrategyStats() const;
+
+    /**
+     * If bAutoOrder is true, strategies are periodically re-sorted by measured milliseconds per decisive verdict instead of
+     * their Cost. MinConfidence is the confidence a verdict needs to end the pipeline.
+     */
+    void SetHitTestStrategyOrdering(bool bAutoOrder, float MinConfidence);
+
+    // 組み込み戦略から呼ばれる判定処理
+    bool IsCursorInHitTestBroadPhase(APlayerController* PC, const FVector2D& MousePosInWindow);
+    bool TraceUnderCursor(APlayerController* PC, const FVector2D& MousePosInWindow, bool bUseRegisteredTargets);
+    bool HitTestWidgetsUnderCursor(APlayerController* PC, const FVector2D& MousePosInWindow);
+
     UFUNCTION(BlueprintPure, Category = "Window Transparency|HitTest")
     bool IsMouseConsideredOverOpaqueArea() const { return bIsMouseOverOpaqueAreaLogic; }
 
+    // --- クリックスルーの遅延・ちらつき統計 ---
+    // 遅延: カーソルが不透明部分に出入りしたサンプルから、OSのクリックスルー状態が一致するまで
+    // ちらつき: OSのクリックスルー状態が切り替わる間隔。FlickerWindowMs 未満の切替を RapidFlip として数える
+    FWindowTransparencyHistogramSummary GetClickThroughLatencySummary() const { return ClickThroughLatencyHistogram.GetSummary(); }
+    FWindowTransparencyHistogramSummary GetClickThroughFlipIntervalSummary() const { return ClickThroughFlipIntervalHistogram.GetSummary(); }
+    int32 GetClickThroughFlipCount() const { return ClickThroughFlipCount; }
+    int32 GetClickThroughRapidFlipCount() const { return ClickThroughRapidFlipCount; }
+    void SetFlickerWindowMs(float InFlickerWindowMs) { FlickerWindowMs = FMath::Max(0.0f, InFlickerWindowMs); }
+    float GetFlickerWindowMs() const { return FlickerWindowMs; }
+    void ResetClickThroughStats();
+    void DumpClickThroughStats() const;
+
+    // --- 入力スレッド ---
+    /**
+     * Starts or stops a dedicated thread that applies click-through RateHz times per second. The game thread publishes
+     * the hit-test coverage each frame, and the thread tests the live cursor against it and writes the window style through
+     * the OS backend as soon as the verdict changes, without waiting for the game thread to tick or pump messages.
+     */
+    void SetInputThreadEnabled(bool bEnable, float RateHz = 240.0f);
+    bool IsInputThreadRunning() const;
+
+    // --- ウィンドウの自動フィット ---
+    /**
+     * While DWM transparency is active, moves and resizes the game window to the screen bounds of the hit-test content
+     * (registered 3D targets, or the cached blocking primitives, plus blocking widgets) and MarginPixels, and offsets the
+     * projection so the 3D content stays where it was on screen. The window grows as soon as content gets close to its
+     * edge and shrinks only after the smaller size has held for ShrinkDelaySeconds. UI is laid out again in the fitted
+     * window, so anchored widgets move with its edges.
+     */
+    void SetAutoFitToContent(bool bEnable, float MarginPixels = 32.0f, float ShrinkDelaySeconds = 0.5f);
+    bool IsAutoFitToContentEnabled() const { return bAutoFitEnabled; }
+    /** Area of the fitted window divided by the area it had before fitting (1 while not fitted). */
+    float GetAutoFitAreaRatio() const;
+
+    // --- 内容がないときの待機 ---
+    /**
+     * While DWM transparency is active and no opaque content is on screen (no registered hit-test target or stencil actor
+     * inside the viewport and no blocking widget) for IdleDelaySeconds, caps the frame rate at IdleFPS. World collision such
+     * as a floor does not count as content, so register the 3D content that should keep the window awake. If the game
+     * changes the max FPS while idle, that value is kept when idling ends. With bSuspendRendering the game viewport
+     * also stops drawing and keeps its last, fully transparent frame. Content coming on screen or user input restores
+     * normal rendering on the next tick.
+     */
+    void SetIdleThrottle(bool bEnable, float IdleFPS = 5.0f, bool bSuspendRendering = false, float IdleDelaySeconds = 0.5f);
+    bool IsIdleThrottleEnabled() const { return bIdleThrottleEnabled; }
+    bool IsIdle() const { return bIsIdle; }
+    FWindowIdleStats GetIdleStats() const;
+
+    // --- 壁紙モードのFPS制御 ---
+    /**
+     * Governs the frame rate while the window is the desktop background. WallpaperFPS caps rendering while any part of the
+     * desktop is visible. When the external windows snapshot shows the desktop work area fully covered, the cap drops to
+     * OccludedFPS, and with bPauseWhenOccluded the viewport also stops drawing. The wallpaper cap comes back on the first
+     * snapshot that shows the desktop again (Show Desktop, minimizing or moving windows). 0 FPS leaves the engine cap unchanged.
+     */
+    void SetWallpaperGovernor(bool bEnable, float WallpaperFPS = 30.0f, float OccludedFPS = 2.0f, bool bPauseWhenOccluded = false);
+    bool IsWallpaperGovernorEnabled() const { return bWallpaperGovernorEnabled; }
+    FWindowWallpaperGovernorStats GetWallpaperGovernorStats() const;
+
     virtual void Tick(float DeltaTime) override;
     virtual ETickableTickType GetTickableTickType() const override { return ETickableTickType::Always; }
     virtual TStatId GetStatId() const override;
@@ -103,28 +534,48 @@ private:
     bool bIsTopmostActive;
     bool bIsDWMTransparentActive;
 
-#if PLATFORM_WINDOWS
-    HWND GameHWnd;
-    LONG_PTR OriginalWindowStyle;
-    LONG_PTR OriginalExWindowStyle;
+    // バックエンドがなければ（Windows 以外の既定）ログを出して false を返す
+    bool HasOSBackend(const TCHAR* Caller) const;
+
+    WindowTransparencyOS::HWND GameHWnd;
+    WindowTransparencyOS::LONG_PTR OriginalWindowStyle;
+    WindowTransparencyOS::LONG_PTR OriginalExWindowStyle;
     bool bOriginalStylesStored;
-    HWND DefaultParentHwnd;
+    WindowTransparencyOS::HWND DefaultParentHwnd;
     bool bIsDesktopBackgroundActive;
-    HWND TrueOriginalParentHwnd;
-    LONG_PTR TrueOriginalWindowStyle;
-    LONG_PTR TrueOriginalExWindowStyle;
+    WindowTransparencyOS::HWND TrueOriginalParentHwnd;
+    WindowTransparencyOS::LONG_PTR TrueOriginalWindowStyle;
+    WindowTransparencyOS::LONG_PTR TrueOriginalExWindowStyle;
     bool bTrueOriginalStateStored;
 
-    HWND CurrentWorkerW;
+    WindowTransparencyOS::HWND CurrentWorkerW;
     TWeakPtr<SWindow> GameSWindowPtr;
+    TSharedPtr<IWindowTransparencyOSBackend> OSBackend;
+
+    // WorkerW の非同期探索とキャッシュ。世代が変わったら（バックエンド差し替え・Explorer 再起動）結果を捨てる
+    WindowTransparencyOS::HWND GetValidCachedWorkerW();
+    void OnWorkerWDiscovered(WindowTransparencyOS::HWND FoundWorkerW, uint32 Generation);
+    void RevalidateDesktopBackgroundParent(float DeltaTime);
+    void RediscoverDesktopBackgroundParent();
+    void ReattachToWorkerW(WindowTransparencyOS::HWND NewWorkerW);
+    WindowTransparencyOS::HWND CachedWorkerW;
+    bool bWorkerWDiscoveryInFlight;
+    uint32 WorkerWDiscoveryGeneration;
+    TArray<TFunction<void(WindowTransparencyOS::HWND)>> PendingWorkerWCallbacks;
+    bool bDesktopBackgroundPending;
+    TArray<TFunction<void(bool)>> DesktopBackgroundCallbacks;
+    void CompleteDesktopBackgroundRequests();
+    float TimeSinceWorkerWCheck;
 
+#if PLATFORM_WINDOWS
     struct EnumWindowsCallbackData
     {
         TArray<FOtherWindowInfo>* WindowsList;
         HWND SelfHWnd;
     };
     static BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam);
-    HWND FindTargetWorkerW();
+
+    TSharedPtr<FWindowTaskbarCreatedHandler> TaskbarCreatedHandler;
 #endif
 
     bool bHitTestingGloballyEnabled;
@@ -133,7 +584,240 @@ private:
     bool bIsMouseOverOpaqueAreaLogic;
 
     bool bCanHelperTick;
+    // 生成前に設定された wt.* コンソール変数を初回の初期化で反映したか
+    bool bConsoleVariablesApplied;
+
+    FOnExternalWindowsSnapshotUpdated ExternalWindowsSnapshotUpdated;
+    TArray<FOtherWindowInfo> ExternalWindowsSnapshot;
+    float ExternalWindowsSnapshotInterval;
+    float ExternalWindowsSnapshotIntervalOverride;
+    TMap<FDelegateHandle, float> ExternalWindowsSnapshotIntervalRequests;
+    float TimeSinceExternalWindowsSnapshot;
+    void UpdateExternalWindowsSnapshotInterval();
+    void UpdateExternalWindowsSnapshot(float DeltaTime);
 
     void UpdateHitDetectionLogic(float DeltaTime);
     bool PerformGameRaycastUnderMouse(FVector2D MousePosInWindow);
+    bool TraceHitTestKernel(APlayerController* PC, const FVector2D& MousePosInWindow, bool bUseRegisteredTargets, FHitResult& OutHit);
+    bool TraceHitTestSample(UWorld* World, const FVector& WorldOrigin, const FVector& WorldDirection, double TraceDistance, const FCollisionQueryParams& CollisionParams, bool bUseRegisteredTargets, FHitResult& OutHit) const;
+    void EnsureHitTestPipeline();
+    void OnHitTestStrategiesChanged();
+    void SortHitTestStrategies();
+    bool RunHitTestPipeline(APlayerController* PC, const FVector2D& MousePosInWindow, bool bRecordStats = true);
+    void RebuildHitTestKernel();
+    void UpdateHitTestBroadPhase(APlayerController* PC);
+    void UpdateBroadPhasePrimitives(UWorld* World);
+    void ProjectBroadPhasePrimitives(UWorld* World, const FMatrix& ViewProjectionMatrix, const FIntRect& ViewRect, TFunctionRef<void(const UPrimitiveComponent&, const FBox2D&)> OnScreenRect);
+    void OnPrimitivePhysicsStateCreated(UActorComponent* Component);
+    void OnPrimitivePhysicsStateDestroyed(UActorComponent* Component);
+    bool IsInHitTestBroadPhase(const FVector2D& MousePosInWindow, double Margin) const;
+    double GetHitTestKernelMargin() const { return HitTestKernelSamples.Num() > 1 ? HitTestKernelRadius : 0.0; }
+    void RefreshWidgetHitCache();
+    uint32 ComputeWidgetHitCacheSignature() const;
+    bool HitTestWidgetCache(const FVector2D& MousePosInWindow);
+    void OnSlateInvalidateAllWidgets(bool bClearResourcesImmediately);
+
+    void RecordClickThroughFlip();
+    bool ApplyHitTestHysteresis(bool bRawIsOpaque);
+    void PublishClickThroughCoverage(bool bActive);
+    void SyncClickThroughStateFromInputThread();
+    bool ApplyCursorPrediction(const FVector2D& MousePosInWindow, bool bRawIsOpaque, bool& bOutPredicted);
+    AActor* ResolveStencilActor(APlayerController* PC, int32 StencilValue, const FVector2D& MousePosInWindow);
+    void RecordCursorSample(const FVector2D& MousePosInWindow, double SampleTime);
+    bool GetPlayerProjectionData(APlayerController* PC, FSceneViewProjectionData& OutProjectionData) const;
+    void UpdateAutoFit(float DeltaTime);
+    bool ComputeContentScreenBounds(APlayerController* PC, FBox2D& OutBounds, bool bIncludeWorldPrimitives = true);
+    void ApplyAutoFitRect(const FIntRect& NewRect);
+    void StopAutoFit(bool bRestoreWindow);
+    void UpdateIdleThrottle();
+    bool HasVisibleContent(APlayerController* PC);
+    void EnterIdle();
+    void ExitIdle(const TCHAR* Reason);
+    void UpdateWallpaperGovernor();
+    void ActivateWallpaperGovernor();
+    void DeactivateWallpaperGovernor();
+    void ApplyWallpaperFrameRate();
+    void OnWallpaperSnapshotUpdated(const TArray<FOtherWindowInfo>& Snapshot);
+    void UpdateWallpaperMouseInput();
+    void DispatchWallpaperMouseEvents();
+
+    FWindowTransparencyRollingHistogram ClickThroughLatencyHistogram;
+    FWindowTransparencyRollingHistogram ClickThroughFlipIntervalHistogram;
+    double LastCursorSampleTime;
+    double PreviousCursorSampleTime;
+    double PendingClickThroughChangeTime;
+    double LastClickThroughFlipTime;
+    bool bLastDesiredClickThrough;
+    int32 ClickThroughFlipCount;
+    int32 ClickThroughRapidFlipCount;
+    float FlickerWindowMs;
+
+    // wt.HitTest.Rate / wt.HitTest.Hysteresis 用
+    float TimeSinceHitTest;
+    double PendingHitTestStateSince;
+    bool bPendingHitTestState;
+
+    // マルチサンプル判定: X,Y はカーソルからのオフセット（ピクセル）、Z は正規化済みの重み
+    EWindowHitTestKernel HitTestKernel;
+    EWindowHitTestCombineRule HitTestCombineRule;
+    float HitTestKernelRadius;
+    float HitTestWeightedThreshold;
+    TArray<FVector3f> HitTestKernelSamples;
+    int32 LastHitTestKernelSamplesTraced;
+
+    // ブロードフェーズ: ウィンドウ座標系での候補矩形（1フレームに1回だけ更新）
+    TArray<FBox2D> HitTestBroadPhaseRects;
+    bool bHitTestBroadPhaseCoversAll;
+    uint64 HitTestBroadPhaseFrame;
+    uint64 HitTestBroadPhaseTests;
+    uint64 HitTestBroadPhaseRejects;
+
+    // ブロードフェーズの物理側の候補: 物理状態の生成・破棄で増減させ、アクター全体を辿るのはワールドが変わったときだけ。
+    // 投影した矩形は、ビューもバウンドも変わっていなければ前フレームのものを使う
+    struct FBroadPhasePrimitive
+    {
+        TWeakObjectPtr<UPrimitiveComponent> Primitive;
+        FVector ProjectedOrigin = FVector::ZeroVector;
+        FVector ProjectedExtent = FVector(-1.0);
+        FBox2D ScreenRect = FBox2D(ForceInit);
+        bool bOnScreen = false;
+    };
+    TMap<TObjectKey<UPrimitiveComponent>, FBroadPhasePrimitive> BroadPhasePrimitives;
+    TWeakObjectPtr<UWorld> BroadPhasePrimitivesWorld;
+    bool bBroadPhasePrimitivesDirty;
+    int32 BroadPhasePrimitiveRebuildCount;
+    FMatrix BroadPhaseViewProjectionMatrix;
+    FIntRect BroadPhaseViewRect;
+    FDelegateHandle CreatePhysicsStateHandle;
+    FDelegateHandle DestroyPhysicsStateHandle;
+
+    FWindowHitTestBVH HitTestTargets;
+
+    // UIヒットテスト用: ウィンドウ座標系でのウィジェット矩形（描画順）
+    struct FWidgetHitEntry
+    {
+        FBox2D Rect = FBox2D(ForceInit);
+        TWeakPtr<SWidget> Widget;
+        int32 PathLength = 0;
+        bool bBlocking = false;
+    };
+    TArray<FWidgetHitEntry> WidgetHitCache;
+    // 作り直しのときに辿ったウィジェット（辿った順）と、その配置の署名
+    TArray<TWeakPtr<SWidget>> WidgetHitCacheLayout;
+    uint32 WidgetHitCacheSignature;
+    uint64 WidgetHitCacheCheckFrame;
+    FBox2D WidgetHitCacheViewportRect;
+    double WidgetHitCacheBuildTime;
+    int32 LastWidgetHitIndex;
+    int32 WidgetHitCacheRebuildCount;
+    bool bWidgetHitCacheDirty;
+    FDelegateHandle InvalidateAllWidgetsHandle;
+
+    UPROPERTY(Transient)
+    TArray<TObjectPtr<UWindowHitTestStrategy>> HitTestStrategies;
+    EWindowHitTestType HitTestPipelineType;
+    bool bHitTestPipelineUsesPhysics;
+    bool bHitTestPipelineUsesTargets;
+    bool bAutoOrderHitTestStrategies;
+    float HitTestMinConfidence;
+    int32 HitTestPipelineRunsSinceSort;
+
+    // 入力スレッドに渡す情報: パイプラインが矩形で表せるか、最後に判定したカーソル位置
+    bool bHitTestPipelineUsesWidgets;
+    bool bHitTestPipelineBoundedByRects;
+    FVector2D LastHitTestMousePos;
+    TSharedPtr<FWindowClickThroughThread> ClickThroughThread;
+    // ゲームスレッドが最後に読み直した、入力スレッドの書き込み番号
+    uint32 ClickThroughAppliedSerial;
+
+    // カーソル予測: 直近のサンプル（[0] が最新）と、答え合わせ待ちの予測
+    static constexpr int32 NumCursorSamples = 3;
+    bool bCursorPredictionEnabled;
+    float CursorPredictionMaxHorizonMs;
+    FVector2D CursorSamplePositions[NumCursorSamples];
+    double CursorSampleTimes[NumCursorSamples];
+    int32 CursorSampleCount;
+    FVector2D PendingPredictedPos;
+    double PendingPredictionTime;
+    double PredictedSwitchDeadline;
+    // 予測で不透明にした判定の有効期限（入力スレッドに渡す）。予測経路を評価している間は非同期の読み出しを使わない
+    double PredictedOpaqueUntil;
+    bool bEvaluatingPredictedCursor;
+    int32 CursorPredictionCount;
+    int32 CursorPredictionAccurateCount;
+    double CursorPredictionErrorSum;
+    float CursorPredictionErrorMax;
+    int32 PredictedSwitchCount;
+    int32 CorrectPredictedSwitchCount;
+    int32 FalsePredictedSwitchCount;
+
+    // ステンシルピック: 値ごとの登録アクターと、最後の結果
+    TSharedPtr<FWindowStencilPickExtension, ESPMode::ThreadSafe> StencilPickExtension;
+    TMap<int32, TArray<TWeakObjectPtr<AActor>>> StencilActors;
+    bool bHitTestPipelineUsesStencil;
+    bool bLastStencilPickValid;
+    bool bLastStencilPickOpaque;
+    int32 LastStencilPickValue;
+    TWeakObjectPtr<AActor> LastStencilPickActor;
+    FVector2D LastStencilPickPosition;
+    double LastStencilPickTime;
+
+    // ピクセルアルファ: 描画結果のアルファを非同期に読み戻す。最後の結果はカーソルが動いた直後に使う
+    TSharedPtr<FWindowPixelAlphaProbeExtension, ESPMode::ThreadSafe> PixelAlphaProbeExtension;
+    bool bHitTestPipelineUsesPixelAlpha;
+    bool bLastPixelAlphaValid;
+    uint8 LastPixelAlpha;
+    double LastPixelAlphaTime;
+
+    // ウィンドウの自動フィット: フィット前の矩形と現在の矩形（スクリーン座標）
+    TSharedPtr<FWindowAutoFitExtension, ESPMode::ThreadSafe> AutoFitExtension;
+    bool bAutoFitEnabled;
+    float AutoFitMarginPixels;
+    float AutoFitShrinkDelaySeconds;
+    FIntRect AutoFitHomeRect;
+    FIntRect AutoFitWindowRect;
+    double AutoFitShrinkPendingSince;
+    float TimeSinceAutoFit;
+    int32 AutoFitResizeCount;
+
+    // 内容がないときの待機: 待機前の最大FPSと、状態ごとの累積時間
+    bool bIdleThrottleEnabled;
+    float IdleFPS;
+    bool bIdleSuspendRendering;
+    float IdleDelaySeconds;
+    bool bIsIdle;
+    bool bIdleMaxFPSApplied;
+    bool bIdleRenderingSuspended;
+    float IdleSavedMaxFPS;
+    double IdleNoContentSince;
+    double IdleLastInteractionTime;
+    double IdleAccumulatedSeconds;
+    double ActiveAccumulatedSeconds;
+    int32 IdleEntryCount;
+    float TimeSinceIdleCheck;
+
+    // 壁紙モードのFPS制御: 有効化前の最大FPSと、状態ごとの累積時間
+    bool bWallpaperGovernorEnabled;
+    float WallpaperFPS;
+    float WallpaperOccludedFPS;
+    bool bWallpaperPauseWhenOccluded;
+    bool bWallpaperGovernorActive;
+    bool bWallpaperOccluded;
+    bool bWallpaperRenderingPaused;
+    float WallpaperSavedMaxFPS;
+    float WallpaperAppliedMaxFPS;
+    float WallpaperVisibleFraction;
+    double WallpaperVisibleSeconds;
+    double WallpaperOccludedSeconds;
+    int32 WallpaperOcclusionCount;
+    FDelegateHandle WallpaperSnapshotHandle;
+
+    // 壁紙モードのマウス入力: 購読者がいて壁紙モードの間だけ入力スレッドを動かす
+    FOnWallpaperMouseEvents WallpaperMouseEvents;
+    bool bWallpaperMouseInputEnabled;
+    int32 WallpaperMouseBatchCount;
+    int32 WallpaperMouseEventCount;
+#if PLATFORM_WINDOWS
+    TSharedPtr<FWindowRawInputThread> RawInputThread;
+#endif
 };
\ No newline at end of file
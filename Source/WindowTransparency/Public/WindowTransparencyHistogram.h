@@ -0,0 +1,62 @@
+﻿// WindowTransparencyHistogram.h
+#pragma once
+
+#include "CoreMinimal.h"
+#include "WindowTransparencyHistogram.generated.h"
+
+// ヒストグラムの集計結果（ミリ秒）
+USTRUCT(BlueprintType)
+struct WINDOWTRANSPARENCY_API FWindowTransparencyHistogramSummary
+{
+    GENERATED_BODY()
+
+    /** Number of samples in the rolling window. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    int32 SampleCount = 0;
+
+    /** Number of samples recorded since the last reset, including ones that have left the rolling window. */
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    int32 TotalSampleCount = 0;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    float MeanMs = 0.0f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    float P50Ms = 0.0f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    float P95Ms = 0.0f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    float P99Ms = 0.0f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Window Transparency|Stats")
+    float MaxMs = 0.0f;
+};
+
+/**
+ * Keeps the last Capacity samples for percentiles, plus lifetime counts in fixed millisecond buckets for the dump.
+ */
+class WINDOWTRANSPARENCY_API FWindowTransparencyRollingHistogram
+{
+public:
+    explicit FWindowTransparencyRollingHistogram(int32 InCapacity = 512);
+
+    void AddSample(double Milliseconds);
+    void Reset();
+
+    FWindowTransparencyHistogramSummary GetSummary() const;
+
+    /** Multi-line text with the summary and one line per non-empty bucket. */
+    FString ToString(const TCHAR* Name) const;
+
+private:
+    static constexpr int32 NumBuckets = 12;
+    static const double BucketUpperBoundsMs[NumBuckets];
+
+    TArray<double> Samples;
+    int32 Capacity;
+    int32 NextSampleIndex;
+    int32 TotalSampleCount;
+    int64 BucketCounts[NumBuckets];
+};
@@ -0,0 +1,198 @@
+﻿// WindowTransparencyOSBackend.h
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include <atomic>
+
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include <dwmapi.h>
+#include <WinUser.h>
+#include "Windows/HideWindowsPlatformTypes.h"
+#endif
+
+/**
+ * The OS types the backend interface passes around. On Windows these are the Win32 types themselves; elsewhere the same
+ * shapes are declared here so the window-state logic builds against the simulated backend. Nothing is added to the global
+ * namespace, and the Win32 constants the logic needs live in the module's private WindowTransparencyOSTypes.h.
+ */
+namespace WindowTransparencyOS
+{
+#if PLATFORM_WINDOWS
+    using ::HWND;
+    using ::LONG_PTR;
+    using ::LONG;
+    using ::UINT;
+    using ::DWORD;
+    using ::HRESULT;
+    using ::RECT;
+    using ::POINT;
+    using ::MARGINS;
+#else
+    struct FOSWindow;
+    typedef FOSWindow* HWND;
+    typedef intptr_t LONG_PTR;
+    typedef int32 LONG;
+    typedef uint32 UINT;
+    typedef uint32 DWORD;
+    typedef int32 HRESULT;
+
+    struct RECT { LONG left; LONG top; LONG right; LONG bottom; };
+    struct POINT { LONG x; LONG y; };
+    struct MARGINS { int cxLeftWidth; int cxRightWidth; int cyTopHeight; int cyBottomHeight; };
+#endif
+}
+
+// バックエンドごとのOS呼び出し回数
+struct WINDOWTRANSPARENCY_API FWindowTransparencyOSCallCounts
+{
+    int32 GetStyle = 0;
+    int32 SetStyle = 0;
+    int32 SetPosition = 0;
+    int32 GetParent = 0;
+    int32 SetParent = 0;
+    int32 Repaint = 0;
+    int32 ExtendFrame = 0;
+    int32 QueryGeometry = 0;
+    int32 FindWorkerW = 0;
+
+    /** Calls that change window state (style, position, parent, DWM frame, repaint). */
+    int32 GetMutatingCallCount() const { return SetStyle + SetPosition + SetParent + Repaint + ExtendFrame; }
+};
+
+/**
+ * The OS calls made by UWindowTransparencyHelper's window-state logic. The helper uses the Win32 backend by default;
+ * FWindowTransparencySimulatedBackend keeps the same state in memory so toggle sequences can be replayed and OS calls counted.
+ */
+class WINDOWTRANSPARENCY_API IWindowTransparencyOSBackend
+{
+public:
+    virtual ~IWindowTransparencyOSBackend() = default;
+
+    virtual WindowTransparencyOS::LONG_PTR GetWindowStyle(WindowTransparencyOS::HWND Hwnd, int Index) = 0;
+    virtual WindowTransparencyOS::LONG_PTR SetWindowStyle(WindowTransparencyOS::HWND Hwnd, int Index, WindowTransparencyOS::LONG_PTR NewStyle) = 0;
+    virtual bool SetWindowPosition(WindowTransparencyOS::HWND Hwnd, WindowTransparencyOS::HWND InsertAfter, int X, int Y, int Width, int Height, WindowTransparencyOS::UINT Flags) = 0;
+    virtual WindowTransparencyOS::HWND GetParentWindow(WindowTransparencyOS::HWND Hwnd) = 0;
+    virtual WindowTransparencyOS::HWND SetParentWindow(WindowTransparencyOS::HWND Hwnd, WindowTransparencyOS::HWND NewParent) = 0;
+    virtual bool IsValidWindow(WindowTransparencyOS::HWND Hwnd) = 0;
+    virtual void RepaintWindow(WindowTransparencyOS::HWND Hwnd) = 0;
+    virtual WindowTransparencyOS::HRESULT ExtendFrameIntoClientArea(WindowTransparencyOS::HWND Hwnd, const WindowTransparencyOS::MARGINS& Margins) = 0;
+    virtual bool GetCursorScreenPosition(WindowTransparencyOS::POINT& OutPoint) = 0;
+    virtual bool GetWindowScreenRect(WindowTransparencyOS::HWND Hwnd, WindowTransparencyOS::RECT& OutRect) = 0;
+    virtual bool GetClientAreaRect(WindowTransparencyOS::HWND Hwnd, WindowTransparencyOS::RECT& OutRect) = 0;
+    /** Screen position of the top-left corner of the client area (ClientToScreen of 0,0). */
+    virtual bool GetClientScreenOrigin(WindowTransparencyOS::HWND Hwnd, WindowTransparencyOS::POINT& OutPoint) = 0;
+    virtual WindowTransparencyOS::HWND FindDesktopWorkerW() = 0;
+    /** Error code of the last failed call on this thread (GetLastError for Win32). Read it right after the call that failed. */
+    virtual WindowTransparencyOS::DWORD GetLastErrorCode() const = 0;
+
+    /** Game window to use instead of the one found through Slate. nullptr means the Slate game window is used. */
+    virtual WindowTransparencyOS::HWND GetGameWindowOverride() const { return nullptr; }
+
+    /** Snapshot of the call counts. Calls are counted atomically, since the input thread and the WorkerW discovery task use the backend too. */
+    FWindowTransparencyOSCallCounts GetCallCounts() const;
+    void ResetCallCounts();
+
+protected:
+    enum class ECall : uint8
+    {
+        GetStyle,
+        SetStyle,
+        SetPosition,
+        GetParent,
+        SetParent,
+        Repaint,
+        ExtendFrame,
+        QueryGeometry,
+        FindWorkerW,
+        Num
+    };
+    void CountCall(ECall Call) { CallCounters[static_cast<int32>(Call)].fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    std::atomic<int32> CallCounters[static_cast<int32>(ECall::Num)] = {};
+};
+
+#if PLATFORM_WINDOWS
+// 実際のWin32 API を呼ぶバックエンド
+class WINDOWTRANSPARENCY_API FWindowTransparencyWin32Backend : public IWindowTransparencyOSBackend
+{
+public:
+    virtual WindowTransparencyOS::LONG_PTR GetWindowStyle(WindowTransparencyOS::HWND Hwnd, int Index) override;
+    virtual WindowTransparencyOS::LONG_PTR SetWindowStyle(WindowTransparencyOS::HWND Hwnd, int Index, WindowTransparencyOS::LONG_PTR NewStyle) override;
+    virtual bool SetWindowPosition(WindowTransparencyOS::HWND Hwnd, WindowTransparencyOS::HWND InsertAfter, int X, int Y, int Width, int Height, WindowTransparencyOS::UINT Flags) override;
+    virtual WindowTransparencyOS::HWND GetParentWindow(WindowTransparencyOS::HWND Hwnd) override;
+    virtual WindowTransparencyOS::HWND SetParentWindow(WindowTransparencyOS::HWND Hwnd, WindowTransparencyOS::HWND NewParent) override;
+    virtual bool IsValidWindow(WindowTransparencyOS::HWND Hwnd) override;
+    virtual void RepaintWindow(WindowTransparencyOS::HWND Hwnd) override;
+    virtual WindowTransparencyOS::HRESULT ExtendFrameIntoClientArea(WindowTransparencyOS::HWND Hwnd, const WindowTransparencyOS::MARGINS& Margins) override;
+    virtual bool GetCursorScreenPosition(WindowTransparencyOS::POINT& OutPoint) override;
+    virtual bool GetWindowScreenRect(WindowTransparencyOS::HWND Hwnd, WindowTransparencyOS::RECT& OutRect) override;
+    virtual bool GetClientAreaRect(WindowTransparencyOS::HWND Hwnd, WindowTransparencyOS::RECT& OutRect) override;
+    virtual bool GetClientScreenOrigin(WindowTransparencyOS::HWND Hwnd, WindowTransparencyOS::POINT& OutPoint) override;
+    virtual WindowTransparencyOS::HWND FindDesktopWorkerW() override;
+    virtual WindowTransparencyOS::DWORD GetLastErrorCode() const override;
+};
+#endif // PLATFORM_WINDOWS
+
+/**
+ * In-memory window manager. It owns a game window and a desktop WorkerW, applies style / parent / position changes to them
+ * and counts every call, without touching real windows. Calls are serialized, so the input thread can drive it too.
+ */
+class WINDOWTRANSPARENCY_API FWindowTransparencySimulatedBackend : public IWindowTransparencyOSBackend
+{
+public:
+    struct FSimulatedWindow
+    {
+        WindowTransparencyOS::LONG_PTR Style = 0;
+        WindowTransparencyOS::LONG_PTR ExStyle = 0;
+        WindowTransparencyOS::HWND Parent = nullptr;
+        WindowTransparencyOS::RECT Rect = { 0, 0, 0, 0 };
+        WindowTransparencyOS::MARGINS Frame = { 0, 0, 0, 0 };
+        bool bTopmost = false;
+        WindowTransparencyOS::UINT LastPositionFlags = 0;
+    };
+
+    FWindowTransparencySimulatedBackend();
+
+    WindowTransparencyOS::HWND CreateSimulatedWindow(WindowTransparencyOS::LONG_PTR Style, WindowTransparencyOS::LONG_PTR ExStyle, const WindowTransparencyOS::RECT& Rect);
+    void DestroySimulatedWindow(WindowTransparencyOS::HWND Hwnd);
+    /** The returned window is not locked. Read it only while no other thread is using the backend. */
+    const FSimulatedWindow* FindSimulatedWindow(WindowTransparencyOS::HWND Hwnd) const;
+
+    WindowTransparencyOS::HWND GetSimulatedGameWindow() const { return GameWindow; }
+    WindowTransparencyOS::HWND GetSimulatedWorkerW() const { return DesktopWorkerW; }
+
+    /** nullptr simulates a desktop where no WorkerW can be found. */
+    void SetSimulatedWorkerW(WindowTransparencyOS::HWND Hwnd);
+    void SetCursorScreenPosition(int32 X, int32 Y);
+    /** While set, SetParentWindow fails and GetLastErrorCode reports ERROR_ACCESS_DENIED, as for a window owned by another process. */
+    void SetFailSetParent(bool bFail) { bFailSetParent = bFail; }
+
+    virtual WindowTransparencyOS::LONG_PTR GetWindowStyle(WindowTransparencyOS::HWND Hwnd, int Index) override;
+    virtual WindowTransparencyOS::LONG_PTR SetWindowStyle(WindowTransparencyOS::HWND Hwnd, int Index, WindowTransparencyOS::LONG_PTR NewStyle) override;
+    virtual bool SetWindowPosition(WindowTransparencyOS::HWND Hwnd, WindowTransparencyOS::HWND InsertAfter, int X, int Y, int Width, int Height, WindowTransparencyOS::UINT Flags) override;
+    virtual WindowTransparencyOS::HWND GetParentWindow(WindowTransparencyOS::HWND Hwnd) override;
+    virtual WindowTransparencyOS::HWND SetParentWindow(WindowTransparencyOS::HWND Hwnd, WindowTransparencyOS::HWND NewParent) override;
+    virtual bool IsValidWindow(WindowTransparencyOS::HWND Hwnd) override;
+    virtual void RepaintWindow(WindowTransparencyOS::HWND Hwnd) override;
+    virtual WindowTransparencyOS::HRESULT ExtendFrameIntoClientArea(WindowTransparencyOS::HWND Hwnd, const WindowTransparencyOS::MARGINS& Margins) override;
+    virtual bool GetCursorScreenPosition(WindowTransparencyOS::POINT& OutPoint) override;
+    virtual bool GetWindowScreenRect(WindowTransparencyOS::HWND Hwnd, WindowTransparencyOS::RECT& OutRect) override;
+    virtual bool GetClientAreaRect(WindowTransparencyOS::HWND Hwnd, WindowTransparencyOS::RECT& OutRect) override;
+    virtual bool GetClientScreenOrigin(WindowTransparencyOS::HWND Hwnd, WindowTransparencyOS::POINT& OutPoint) override;
+    virtual WindowTransparencyOS::HWND FindDesktopWorkerW() override;
+    virtual WindowTransparencyOS::DWORD GetLastErrorCode() const override { return LastErrorCode; }
+    virtual WindowTransparencyOS::HWND GetGameWindowOverride() const override { return GameWindow; }
+
+private:
+    mutable FCriticalSection WindowsLock;
+    TMap<WindowTransparencyOS::HWND, FSimulatedWindow> Windows;
+    WindowTransparencyOS::HWND GameWindow;
+    WindowTransparencyOS::HWND DesktopWorkerW;
+    WindowTransparencyOS::POINT CursorPosition;
+    UPTRINT NextHandleValue;
+    bool bFailSetParent;
+    WindowTransparencyOS::DWORD LastErrorCode;
+};
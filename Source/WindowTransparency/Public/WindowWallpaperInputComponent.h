@@ -0,0 +1,41 @@
+﻿// WindowWallpaperInputComponent.h
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "WindowTransparencyHelper.h"
+#include "WindowWallpaperInputComponent.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnWindowWallpaperMouseEvents, const TArray<FWindowWallpaperMouseEvent>&, Events);
+
+/**
+ * Receives mouse input while the window is the desktop background. The wallpaper window gets no mouse messages of its own,
+ * so the WindowTransparency helper reads raw mouse input over the desktop on a background thread and this component
+ * forwards it in batches, already mapped to window coordinates and hit tested. No polling from Blueprint is needed.
+ */
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class WINDOWTRANSPARENCY_API UWindowWallpaperInputComponent : public UActorComponent
+{
+    GENERATED_BODY()
+
+public:
+    UWindowWallpaperInputComponent();
+
+    /** Called on the game thread with the input received since the last call, in order. Consecutive moves are merged. */
+    UPROPERTY(BlueprintAssignable, Category = "Window Transparency|Wallpaper")
+    FOnWindowWallpaperMouseEvents OnWallpaperMouseEvents;
+
+    /** If false, Move events are dropped and only batches with clicks or wheel input are delivered. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Window Transparency|Wallpaper")
+    bool bReceiveMoveEvents;
+
+protected:
+    virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+    void HandleWallpaperMouseEvents(const TArray<FWindowWallpaperMouseEvent>& Events);
+
+    FDelegateHandle WallpaperMouseEventsHandle;
+    TWeakObjectPtr<UWindowTransparencyHelper> BoundHelper;
+};
@@ -4,8 +4,23 @@
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
 #include "ProceduralMeshComponent.h"
+#include "WindowTransparencyHelper.h"
 #include "WindowsRepresentationComponent.generated.h"
 
+class UBoxComponent;
+class UInstancedStaticMeshComponent;
+class UStaticMesh;
+struct FWindowMeshBuildRequest;
+struct FWindowMeshBuildResult;
+
+// ウィンドウのコリジョン生成方法
+UENUM(BlueprintType)
+enum class EWindowCollisionMode : uint8
+{
+    ConvexMesh      UMETA(DisplayName = "Convex Mesh"),
+    BoxPrimitive    UMETA(DisplayName = "Box Primitive")
+};
+
 USTRUCT(BlueprintType)
 struct FWindowPoints
 {
@@ -36,6 +51,29 @@ struct FWindowPoints
     }
 };
 
+// 差分更新用: セクションを生成したときの入力。ハッシュではなく値をそのまま比べる
+struct FWindowSectionSource
+{
+    FVector Points[4] = { FVector::ZeroVector, FVector::ZeroVector, FVector::ZeroVector, FVector::ZeroVector };
+    float Thickness = 0.0f;
+    bool bWithVertexColors = false;
+
+    bool operator==(const FWindowSectionSource& Other) const
+    {
+        return Points[0] == Other.Points[0] && Points[1] == Other.Points[1] && Points[2] == Other.Points[2] && Points[3] == Other.Points[3] &&
+            Thickness == Other.Thickness && bWithVertexColors == Other.bWithVertexColors;
+    }
+    bool operator!=(const FWindowSectionSource& Other) const { return !(*this == Other); }
+};
+
+// ウィンドウの描画方法
+UENUM(BlueprintType)
+enum class EWindowRenderMode : uint8
+{
+    ProceduralMesh  UMETA(DisplayName = "Procedural Mesh"),
+    InstancedCube   UMETA(DisplayName = "Instanced Cube")
+};
+
 UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
 class WINDOWTRANSPARENCY_API UWindowsRepresentationComponent : public UActorComponent
 {
@@ -47,6 +85,9 @@ public:
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
     TObjectPtr<UProceduralMeshComponent> ProceduralMeshComponent; // UE5 スタイル: TObjectPtr
 
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components")
+    TObjectPtr<UInstancedStaticMeshComponent> InstancedMeshComponent;
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Window Settings", Meta = (TitleProperty = "WindowName")) // TitlePropertyをWindowNameに
         TArray<FWindowPoints> WindowPointSets;
 
@@ -59,14 +100,108 @@ public:
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Window Settings")
     bool bCreateCollision;
 
+    /**
+     * How window collision is built. BoxPrimitive represents each rectangular window as an oriented box body that is
+     * moved by transform, so no convex cooking happens; non-rectangular quads still fall back to convex meshes.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Window Settings", meta = (EditCondition = "bCreateCollision"))
+    EWindowCollisionMode CollisionMode;
+
+    /**
+     * How windows are rendered. InstancedCube draws every rectangular window as one instance of InstanceCubeMesh, so moving or
+     * resizing it only updates an instance transform. Skewed quads always fall back to the procedural mesh.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Window Settings")
+    EWindowRenderMode RenderMode;
+
+    /** Cube mesh used by InstancedCube mode. Its bounds are treated as the size of one window at scale 1. Per-instance custom data holds Width, Height, Thickness. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Window Settings", meta = (EditCondition = "RenderMode == EWindowRenderMode::InstancedCube"))
+    TObjectPtr<UStaticMesh> InstanceCubeMesh;
+
+    /** If true, an all-white vertex color stream is generated for each window. Materials that ignore vertex color do not need it. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Window Settings")
+    bool bGenerateVertexColors;
+
+    /** If true, UpdateWindows calls made during a frame are merged into a single rebuild at the end of the frame. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Window Settings")
+    bool bCoalesceUpdates;
+
+    /**
+     * If true, vertex and collision data are generated on a worker task from a copy of WindowPointSets and applied on the
+     * game thread in one step. Only one build runs at a time; updates made meanwhile are merged into the next build, which
+     * starts from the latest state as soon as the running one has been applied. Collision is cooked asynchronously while
+     * this is on, and bUseAsyncCooking is restored when it is turned off again.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Window Settings")
+    bool bAsyncMeshGeneration;
+
     UFUNCTION(BlueprintCallable, Category = "Procedural Window")
     void UpdateWindows(const TArray<FWindowPoints>& NewPointSets, float NewThickness);
 
+    /** Rebuilds the mesh sections of windows whose points or thickness changed since the last rebuild. */
     UFUNCTION(BlueprintCallable, Category = "Procedural Window")
     void RegenerateMesh();
 
+    /** Number of windows whose mesh section was rebuilt by the last RegenerateMesh. */
+    UFUNCTION(BlueprintPure, Category = "Procedural Window")
+    int32 GetLastRebuiltWindowCount() const { return LastRebuiltWindowCount; }
+
+    /** Game-thread time in milliseconds spent updating instances by the last update in InstancedCube mode. */
+    UFUNCTION(BlueprintPure, Category = "Procedural Window")
+    float GetLastInstanceUpdateMilliseconds() const { return static_cast<float>(LastInstanceUpdateSeconds * 1000.0); }
+
+    /**
+     * If true, WindowPointSets is driven directly by the external-window snapshot of the WindowTransparency helper.
+     * Each external window's screen rect is deprojected onto the projection plane and only windows that moved are rebuilt.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Window Settings|External Windows")
+    bool bBindToExternalWindows;
+
+    /** Interval in seconds between external-window snapshots while bound. The snapshot is shared by all bound components. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Window Settings|External Windows", meta = (ClampMin = "0.0"))
+    float ExternalWindowUpdateInterval;
+
+    /** Index of the local player whose camera is used to deproject external window rects. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Window Settings|External Windows", meta = (ClampMin = "0"))
+    int32 ProjectionPlayerIndex;
+
+    /** Distance from the camera of the camera-facing plane windows are projected onto (when no custom plane is used). */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Window Settings|External Windows", meta = (ClampMin = "1.0"))
+    float ProjectionDistance;
+
+    /** If true, windows are projected onto the world-space plane given by ProjectionPlaneOrigin / ProjectionPlaneNormal. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Window Settings|External Windows")
+    bool bUseCustomProjectionPlane;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Window Settings|External Windows", meta = (EditCondition = "bUseCustomProjectionPlane"))
+    FVector ProjectionPlaneOrigin;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Window Settings|External Windows", meta = (EditCondition = "bUseCustomProjectionPlane"))
+    FVector ProjectionPlaneNormal;
+
+    /** If true, bound windows move smoothly towards their latest projected position instead of snapping. */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Window Settings|External Windows")
+    bool bInterpolateExternalWindows;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Window Settings|External Windows", meta = (ClampMin = "0.0", EditCondition = "bInterpolateExternalWindows"))
+    float ExternalWindowInterpSpeed;
+
+    /** Starts or stops driving WindowPointSets from the external-window snapshot. */
+    UFUNCTION(BlueprintCallable, Category = "Procedural Window")
+    void SetBindToExternalWindows(bool bEnable);
+
+    /**
+     * Updates WindowPointSets from an external-window snapshot as the binding does, but with the given view instead of the
+     * player's. GameWindowRect is the desktop rect the view is drawn into. Only windows whose rect changed are projected
+     * again, or all of them when the view or GameWindowRect changed. Returns true if any window moved, appeared or went away.
+     */
+    bool ApplyExternalWindowsSnapshotWithView(const TArray<FOtherWindowInfo>& Snapshot, const FIntRect& GameWindowRect, const FIntRect& ViewRect, const FMatrix& ViewProjectionMatrix, const FPlane& ProjectionPlane);
+
+    virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
 protected:
     virtual void BeginPlay() override;
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
     virtual void OnComponentDestroyed(bool bDestroyingHierarchy) override;
 
 #if WITH_EDITOR
@@ -74,18 +209,67 @@ protected:
 #endif
 
 private:
-    void AddCuboidFromPoints(
-        const FWindowPoints& Points,
-        float CuboidThickness,
-        TArray<FVector>& Vertices,
-        TArray<int32>& Triangles,
-        TArray<FVector>& Normals,
-        TArray<FVector2D>& UVs0,
-        TArray<FLinearColor>& VertexColors,
-        TArray<FProcMeshTangent>& Tangents,
-        TArray<FVector>& OutConvexVertices
-    );
+    FWindowSectionSource MakeSectionSource(const FWindowPoints& Points) const;
+    void ResetSectionCache();
+    void CollectDirtyWindows(FWindowMeshBuildRequest& OutRequest);
+    void ApplyMeshBuildResult(const FWindowMeshBuildResult& Result);
+    void UpdateWindowBox(FName WindowName, const FTransform& BoxTransform, const FVector& BoxExtent);
+    void ReleaseWindowBox(FName WindowName);
+    void ReleaseAllWindowBoxes();
+    void UpdateWindowInstance(FName WindowName, const FTransform& BoxTransform, const FVector& BoxExtent);
+    void ReleaseWindowInstance(FName WindowName);
 
     TMap<FName, int32> WindowSectionMap;
     int32 NextAvailableSectionIndex;
+
+    // 差分更新用: ウィンドウごとの生成済みの入力とコリジョン頂点
+    TMap<FName, FWindowSectionSource> WindowSourceMap;
+    TMap<FName, TArray<FVector>> WindowConvexMap;
+    TWeakObjectPtr<UMaterialInterface> AppliedWindowMaterial;
+    bool bCollisionBuilt;
+    bool bConvexCollisionApplied;
+    EWindowCollisionMode AppliedCollisionMode;
+
+    // 非同期生成の世代。ResetSectionCache で進め、これと一致しない結果は古いものとして破棄する
+    uint32 MeshBuildGeneration;
+    TSharedPtr<FWindowMeshBuildResult> SyncBuildResult;
+    // 非同期生成は常に1つだけ実行し、実行中に来た要求は完了後に最新の状態でまとめて生成し直す
+    bool bMeshBuildInFlight;
+    bool bMeshBuildQueued;
+    // 非同期生成を有効にする前の bUseAsyncCooking。同期に戻すときに復元する
+    bool bAsyncCookingOverridden;
+    bool bSavedUseAsyncCooking;
+    void OnAsyncMeshBuildCompleted(const FWindowMeshBuildResult& Result);
+
+    // BoxPrimitiveモードで使用するボックスコリジョン（再利用のためプールする）
+    UPROPERTY(Transient)
+    TMap<FName, TObjectPtr<UBoxComponent>> WindowBoxMap;
+
+    UPROPERTY(Transient)
+    TArray<TObjectPtr<UBoxComponent>> FreeWindowBoxes;
+
+    // InstancedCubeモード: ウィンドウ名とインスタンス番号の対応
+    TMap<FName, int32> WindowInstanceMap;
+    TArray<FName> InstanceWindowNames;
+    EWindowRenderMode AppliedRenderMode;
+    double LastInstanceUpdateSeconds;
+
+    bool bRegeneratePending;
+    int32 LastRebuiltWindowCount;
+
+    // 外部ウィンドウとのバインド
+    void BindExternalWindows();
+    void UnbindExternalWindows();
+    void OnExternalWindowsSnapshot(const TArray<FOtherWindowInfo>& Snapshot);
+    void ApplyExternalWindowsSnapshot();
+    void InterpolateExternalWindows(float DeltaTime);
+
+    FDelegateHandle ExternalWindowsHandle;
+    bool bExternalWindowsBound;
+    bool bExternalSnapshotPending;
+    TArray<FOtherWindowInfo> PendingExternalSnapshot;
+    TMap<FName, FIntRect> LastExternalWindowRects;
+    TMap<FName, FWindowPoints> ExternalWindowTargets;
+    FMatrix LastViewProjectionMatrix;
+    FIntRect LastGameWindowRect;
 };
\ No newline at end of file
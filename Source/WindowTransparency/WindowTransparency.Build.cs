@@ -38,7 +38,12 @@ public class WindowTransparency : ModuleRules
                 "SlateCore",
                 "ApplicationCore",
                 "InputCore",
-                "ProceduralMeshComponent"
+                "ProceduralMeshComponent",
+                "Json",
+                "RenderCore",
+                "Renderer",
+                "RHI",
+                "WindowTransparencyShaders"
                 // ... add private dependencies here ...
             }
             );
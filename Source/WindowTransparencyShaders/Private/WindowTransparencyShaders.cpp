@@ -0,0 +1,56 @@
+﻿// WindowTransparencyShaders.cpp
+#include "WindowStencilPickPass.h"
+#include "Modules/ModuleManager.h"
+#include "Interfaces/IPluginManager.h"
+#include "Misc/Paths.h"
+#include "ShaderCore.h"
+#include "GlobalShader.h"
+#include "ShaderParameterStruct.h"
+#include "RenderGraphBuilder.h"
+#include "RenderGraphUtils.h"
+
+class FWindowTransparencyShadersModule : public IModuleInterface
+{
+public:
+    virtual void StartupModule() override
+    {
+        const TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("WindowTransparency"));
+        if (Plugin.IsValid())
+        {
+            AddShaderSourceDirectoryMapping(TEXT("/Plugin/WindowTransparency"), FPaths::Combine(Plugin->GetBaseDir(), TEXT("Shaders")));
+        }
+    }
+};
+
+IMPLEMENT_MODULE(FWindowTransparencyShadersModule, WindowTransparencyShaders)
+
+// カーソル位置のカスタムステンシル値を1つだけ書き出す
+class FWindowStencilPickCS : public FGlobalShader
+{
+    DECLARE_GLOBAL_SHADER(FWindowStencilPickCS);
+    SHADER_USE_PARAMETER_STRUCT(FWindowStencilPickCS, FGlobalShader);
+
+    BEGIN_SHADER_PARAMETER_STRUCT(FParameters, )
+        SHADER_PARAMETER_RDG_TEXTURE_SRV(Texture2D<uint2>, CustomStencilTexture)
+        SHADER_PARAMETER(FIntPoint, PickPosition)
+        SHADER_PARAMETER_RDG_BUFFER_UAV(RWBuffer<uint>, OutStencil)
+    END_SHADER_PARAMETER_STRUCT()
+
+    static bool ShouldCompilePermutation(const FGlobalShaderPermutationParameters& Parameters)
+    {
+        return IsFeatureLevelSupported(Parameters.Platform, ERHIFeatureLevel::SM5);
+    }
+};
+
+IMPLEMENT_GLOBAL_SHADER(FWindowStencilPickCS, "/Plugin/WindowTransparency/Private/WindowStencilPick.usf", "MainCS", SF_Compute);
+
+void AddWindowStencilPickPass(FRDGBuilder& GraphBuilder, FGlobalShaderMap* ShaderMap, FRDGTextureSRVRef CustomStencilTexture, FIntPoint PickPosition, FRDGBufferRef OutStencilBuffer)
+{
+    FWindowStencilPickCS::FParameters* Parameters = GraphBuilder.AllocParameters<FWindowStencilPickCS::FParameters>();
+    Parameters->CustomStencilTexture = CustomStencilTexture;
+    Parameters->PickPosition = PickPosition;
+    Parameters->OutStencil = GraphBuilder.CreateUAV(OutStencilBuffer, PF_R32_UINT);
+
+    TShaderMapRef<FWindowStencilPickCS> ComputeShader(ShaderMap);
+    FComputeShaderUtils::AddPass(GraphBuilder, RDG_EVENT_NAME("WindowStencilPick"), ComputeShader, Parameters, FIntVector(1, 1, 1));
+}
@@ -0,0 +1,13 @@
+﻿// WindowStencilPickPass.h
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RenderGraphDefinitions.h"
+
+class FGlobalShaderMap;
+
+/**
+ * Copies the CustomStencil value at PickPosition (render-target pixels) into the first element of OutStencilBuffer,
+ * which must hold at least one uint32. The buffer is meant to be read back asynchronously.
+ */
+WINDOWTRANSPARENCYSHADERS_API void AddWindowStencilPickPass(FRDGBuilder& GraphBuilder, FGlobalShaderMap* ShaderMap, FRDGTextureSRVRef CustomStencilTexture, FIntPoint PickPosition, FRDGBufferRef OutStencilBuffer);
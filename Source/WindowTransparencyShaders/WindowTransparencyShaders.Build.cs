@@ -0,0 +1,26 @@
+using UnrealBuildTool;
+
+// グローバルシェーダーは PostConfigInit で読み込む必要があるため、本体とは別モジュールにしている
+public class WindowTransparencyShaders : ModuleRules
+{
+    public WindowTransparencyShaders(ReadOnlyTargetRules Target) : base(Target)
+    {
+        PCHUsage = ModuleRules.PCHUsageMode.UseExplicitOrSharedPCHs;
+
+        PublicDependencyModuleNames.AddRange(
+            new string[]
+            {
+                "Core",
+                "RenderCore",
+                "RHI"
+            }
+            );
+
+        PrivateDependencyModuleNames.AddRange(
+            new string[]
+            {
+                "Projects"
+            }
+            );
+    }
+}